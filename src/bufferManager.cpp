@@ -2,130 +2,609 @@
 
 BufferManager::BufferManager()
 {
-	logger.log("BufferManager::BufferManager");
+	LOG_DEBUG("BufferManager::BufferManager");
+	this->policy.reset(new FIFOPolicy());
+}
+
+BufferManager::~BufferManager()
+{
+	{
+		lock_guard<mutex> lock(this->prefetchMutex);
+		this->stopping = true;
+	}
+	this->prefetchRequested.notify_all();
+	if (this->prefetchThread.joinable())
+		this->prefetchThread.join();
+}
+
+/**
+ * @brief Switches to the replacement policy named policyName. Only meant to be
+ * called at startup, before any page has been read.
+ *
+ * @param policyName one of FIFO, LRU, CLOCK, 2Q
+ * @return true if the policy exists
+ */
+bool BufferManager::setReplacementPolicy(const string &policyName)
+{
+	LOG_DEBUG("BufferManager::setReplacementPolicy");
+	ReplacementPolicy *newPolicy = createReplacementPolicy(policyName, BLOCK_COUNT);
+	if (!newPolicy)
+		return false;
+	this->policy.reset(newPolicy);
+	return true;
+}
+
+/**
+ * @brief Prints the active policy and its hit/miss/eviction counters.
+ *
+ */
+void BufferManager::printStatistics()
+{
+	LOG_DEBUG("BufferManager::printStatistics");
+	long long accesses = this->hitCount + this->missCount;
+	cout << "Policy: " << this->policy->getName() << endl;
+	int dirtyFrames = 0;
+	for (auto &[key, frame] : this->pageTable)
+		dirtyFrames += this->frames[frame].dirty;
+	cout << "Frames: " << this->pageTable.size() << " in use (" << dirtyFrames << " dirty), " << BLOCK_COUNT << " configured" << endl;
+	cout << "Hits: " << this->hitCount << endl;
+	cout << "Misses: " << this->missCount << endl;
+	cout << "Evictions: " << this->evictionCount << endl;
+	cout << "Dirty write-backs: " << this->writeBackCount << endl;
+	cout << "Mapped page reads: " << this->mappedReadCount << endl;
+	cout << "Prefetched pages: " << this->prefetchIssuedCount << " issued, " << this->prefetchUsedCount << " used, " << this->prefetchWastedCount << " dropped" << endl;
+	ostringstream hitRatio;
+	hitRatio << fixed << setprecision(2) << (accesses ? 100.0 * this->hitCount / accesses : 0.0);
+	cout << "Hit ratio: " << hitRatio.str() << "%" << endl;
+}
+
+/**
+ * @brief Builds the pool key for a page, interning the table name if this is
+ * the first time the buffer manager sees it.
+ *
+ * @param tableName
+ * @param pageIndex
+ * @return PageKey
+ */
+PageKey BufferManager::makeKey(const string &tableName, int pageIndex)
+{
+	auto it = this->tableIds.find(tableName);
+	uint32_t tableId;
+	if (it == this->tableIds.end())
+	{
+		tableId = this->tableIds.size();
+		this->tableIds[tableName] = tableId;
+	}
+	else
+		tableId = it->second;
+	return ((PageKey)tableId << 32) | (uint32_t)pageIndex;
 }
 
 /**
  * @brief Function called to read a page from the buffer manager. If the page is
  * not present in the pool, the page is read and then inserted into the pool.
+ * The returned handle keeps the page pinned until it is destroyed.
  *
  * @param tableName
  * @param pageIndex
- * @return Page
+ * @return PageHandle
  */
-Page BufferManager::getPage(string tableName, int pageIndex)
+PageHandle BufferManager::getPage(string tableName, int pageIndex)
 {
-	logger.log("BufferManager::getPage");
-	string pageName = "../data/temp/" + tableName + "_Page" + to_string(pageIndex);
-	if (this->inPool(pageName))
-		return this->getFromPool(pageName);
-	else
-		return this->insertIntoPool(tableName, pageIndex);
+	LOG_DEBUG("BufferManager::getPage");
+	PageKey key = this->makeKey(tableName, pageIndex);
+	int frame = this->findFrame(key);
+	if (frame != -1)
+	{
+		this->hitCount++;
+		this->policy->recordAccess(frame);
+		return PageHandle(frame, &this->frames[frame]);
+	}
+	this->missCount++;
+	return this->insertIntoPool(tableName, pageIndex, key);
 }
 
 /**
- * @brief Checks to see if a page exists in the pool
+ * @brief Asks the read-ahead thread to read pages fromPage..toPage of tableName
+ * (at most READ_AHEAD of them, and never more than the pool holds) that are
+ * neither in the pool nor already requested. Called by cursors once they see
+ * sequential access. At most BLOCK_COUNT page images are staged at a time; to
+ * make room, the oldest finished images outside this window are dropped.
  *
- * @param pageName
- * @return true
- * @return false
+ * @param tableName
+ * @param fromPage
+ * @param toPage last page of the table
  */
-bool BufferManager::inPool(string pageName)
+void BufferManager::readAhead(const string &tableName, int fromPage, int toPage)
 {
-	logger.log("BufferManager::inPool");
-	for (auto page : this->pages)
+	if (READ_AHEAD == 0 || TEXT_PAGES)
+		return;
+	toPage = min(toPage, fromPage + (int)min(READ_AHEAD, BLOCK_COUNT) - 1);
+	if (toPage < fromPage)
+		return;
+	bool issued = false;
 	{
-		if (pageName == page.pageName)
-			return true;
+		lock_guard<mutex> lock(this->prefetchMutex);
+		PageKey firstKey = this->makeKey(tableName, fromPage);
+		PageKey lastKey = this->makeKey(tableName, toPage);
+		for (PageKey key = firstKey; key <= lastKey; key++)
+		{
+			if (this->findFrame(key) != -1 || this->prefetches.count(key))
+				continue;
+			if (this->prefetches.size() >= BLOCK_COUNT && !this->makeRoomForPrefetch(firstKey, lastKey))
+				break;
+			int pageIndex = key & 0xFFFFFFFF;
+			Prefetch &prefetch = this->prefetches[key];
+			prefetch.tableName = tableName;
+			prefetch.pageIndex = pageIndex;
+			prefetch.ticket = ++this->nextTicket;
+			this->prefetchQueue.push_back(key);
+			this->prefetchIssuedCount++;
+			issued = true;
+		}
 	}
-	return false;
+	if (!issued)
+		return;
+	if (!this->prefetchThread.joinable())
+		this->prefetchThread = thread(&BufferManager::prefetchWorker, this);
+	this->prefetchRequested.notify_one();
 }
 
 /**
- * @brief If the page is present in the pool, then this function returns the
- * page. Note that this function will fail if the page is not present in the
- * pool.
+ * @brief Drops the oldest staged page image that has finished reading and is
+ * not one of the pages firstKey..lastKey being requested. Called with
+ * prefetchMutex held.
  *
- * @param pageName
- * @return Page
+ * @param firstKey
+ * @param lastKey
+ * @return false if there is no such image
  */
-Page BufferManager::getFromPool(string pageName)
+bool BufferManager::makeRoomForPrefetch(PageKey firstKey, PageKey lastKey)
 {
-	logger.log("BufferManager::getFromPool");
-	for (auto page : this->pages)
-		if (pageName == page.pageName)
-			return page;
+	auto oldest = this->prefetches.end();
+	for (auto it = this->prefetches.begin(); it != this->prefetches.end(); it++)
+		if (it->second.ready && (it->first < firstKey || it->first > lastKey) && (oldest == this->prefetches.end() || it->second.ticket < oldest->second.ticket))
+			oldest = it;
+	if (oldest == this->prefetches.end())
+		return false;
+	this->prefetches.erase(oldest);
+	this->prefetchWastedCount++;
+	return true;
 }
 
 /**
- * @brief Inserts page indicated by tableName and pageIndex into pool. If the
- * pool is full, the pool ejects the oldest inserted page from the pool and adds
- * the current page at the end. It naturally follows a queue data structure.
+ * @brief Body of the read-ahead thread: takes requests off the queue and reads
+ * them through the storage manager, without holding prefetchMutex during the
+ * read. A request that was dropped while being read is thrown away.
+ *
+ */
+void BufferManager::prefetchWorker()
+{
+	unique_lock<mutex> lock(this->prefetchMutex);
+	while (true)
+	{
+		this->prefetchRequested.wait(lock, [this]
+									 { return this->stopping || !this->prefetchQueue.empty(); });
+		if (this->stopping)
+			return;
+		PageKey key = this->prefetchQueue.front();
+		this->prefetchQueue.pop_front();
+		auto it = this->prefetches.find(key);
+		if (it == this->prefetches.end() || it->second.reading || it->second.ready)
+			continue;
+		it->second.reading = true;
+		string tableName = it->second.tableName;
+		int pageIndex = it->second.pageIndex;
+		uint64_t ticket = it->second.ticket;
+
+		lock.unlock();
+		vector<char> buffer;
+		bool found = storageManager.readPage(tableName, pageIndex, buffer);
+		lock.lock();
+
+		it = this->prefetches.find(key);
+		if (it != this->prefetches.end() && it->second.ticket == ticket)
+		{
+			it->second.ready = true;
+			it->second.found = found;
+			it->second.buffer = move(buffer);
+		}
+		this->prefetchDone.notify_all();
+	}
+}
+
+/**
+ * @brief Hands over the staged image of the page identified by key. Waits if
+ * the read-ahead thread is reading it right now; a request that has not been
+ * picked up yet is cancelled and the caller reads the page itself.
+ *
+ * @param key
+ * @param buffer receives the page image
+ * @return true if buffer holds the page
+ */
+bool BufferManager::takePrefetched(PageKey key, vector<char> &buffer)
+{
+	unique_lock<mutex> lock(this->prefetchMutex);
+	auto it = this->prefetches.find(key);
+	if (it == this->prefetches.end())
+		return false;
+	uint64_t ticket = it->second.ticket;
+	if (it->second.reading && !it->second.ready)
+	{
+		this->prefetchDone.wait(lock, [&]
+								{
+			it = this->prefetches.find(key);
+			return it == this->prefetches.end() || it->second.ticket != ticket || it->second.ready; });
+		if (it == this->prefetches.end() || it->second.ticket != ticket)
+			return false;
+	}
+	bool found = it->second.ready && it->second.found;
+	if (found)
+	{
+		buffer = move(it->second.buffer);
+		this->prefetchUsedCount++;
+	}
+	else
+		this->prefetchWastedCount++;
+	this->prefetches.erase(it);
+	return found;
+}
+
+/**
+ * @brief Forgets any staged or requested image of the page identified by key.
+ * If the read-ahead thread is reading it, the result is thrown away.
+ *
+ * @param key
+ */
+void BufferManager::dropPrefetch(PageKey key)
+{
+	lock_guard<mutex> lock(this->prefetchMutex);
+	if (this->prefetches.erase(key))
+		this->prefetchWastedCount++;
+}
+
+/**
+ * @brief Returns the frame holding the page identified by key, or -1 if the
+ * page is not in the pool.
+ *
+ * @param key
+ * @return int
+ */
+int BufferManager::findFrame(PageKey key)
+{
+	auto it = this->pageTable.find(key);
+	if (it == this->pageTable.end())
+		return -1;
+	return it->second;
+}
+
+/**
+ * @brief Finds a frame for the page identified by key and registers it in the
+ * pool. If the pool is full, the replacement policy picks an unpinned frame
+ * whose page is ejected (written back first if dirty) and the frame is reused.
+ * The caller fills in the frame's page.
+ *
+ * @param key
+ * @return int the frame
+ */
+int BufferManager::allocateFrame(PageKey key)
+{
+	int frame = -1;
+	if (!this->freeFrames.empty())
+	{
+		frame = this->freeFrames.back();
+		this->freeFrames.pop_back();
+	}
+	else if (this->frames.size() >= BLOCK_COUNT)
+	{
+		frame = this->policy->chooseVictim([this](int candidate)
+										   { return this->frames[candidate].pinCount == 0; });
+		if (frame != -1)
+		{
+			this->writeBack(this->frames[frame]);
+			this->pageTable.erase(this->frames[frame].key);
+			this->evictionCount++;
+		}
+		else
+			LOG_DEBUG("BufferManager::allocateFrame - All " + to_string(this->frames.size()) + " frames pinned, growing pool");
+	}
+	if (frame == -1)
+	{
+		frame = this->frames.size();
+		this->frames.emplace_back();
+	}
+
+	// The page is resident from now on, so a staged copy of it could only go stale
+	this->dropPrefetch(key);
+
+	Frame &slot = this->frames[frame];
+	slot.key = key;
+	slot.dirty = false;
+	slot.orphaned = false;
+	this->pageTable[key] = frame;
+	this->policy->recordLoad(frame, key);
+	return frame;
+}
+
+/**
+ * @brief Inserts page indicated by tableName and pageIndex into pool, reading
+ * it from its file unless the read-ahead thread already has.
  *
  * @param tableName
  * @param pageIndex
- * @return Page
+ * @param key
+ * @return PageHandle
  */
-Page BufferManager::insertIntoPool(string tableName, int pageIndex)
+PageHandle BufferManager::insertIntoPool(string tableName, int pageIndex, PageKey key)
 {
-	logger.log("BufferManager::insertIntoPool");
-	Page page(tableName, pageIndex);
-	if (this->pages.size() >= BLOCK_COUNT)
-		pages.pop_front();
-	pages.push_back(page);
-	return page;
+	LOG_DEBUG("BufferManager::insertIntoPool");
+	vector<char> buffer;
+	bool prefetched = this->takePrefetched(key, buffer);
+	int frame = this->allocateFrame(key);
+	if (prefetched)
+		this->frames[frame].page = Page(tableName, pageIndex, buffer);
+	else
+		this->frames[frame].page = Page(tableName, pageIndex);
+	return PageHandle(frame, &this->frames[frame]);
+}
+
+/**
+ * @brief Writes the frame's page to its file if it is dirty.
+ *
+ * @param frame
+ */
+void BufferManager::writeBack(Frame &frame)
+{
+	if (!frame.dirty)
+		return;
+	frame.page.writePage();
+	frame.dirty = false;
+	this->writeBackCount++;
+}
+
+/**
+ * @brief Drops the page identified by key from the pool (if present). The
+ * frame goes on the free list straight away unless it is still pinned, in
+ * which case it is released by the last unpin.
+ *
+ * @param key
+ */
+void BufferManager::evict(PageKey key)
+{
+	int frame = this->findFrame(key);
+	if (frame == -1)
+		return;
+	this->pageTable.erase(key);
+	this->policy->remove(frame);
+	this->frames[frame].dirty = false;
+	if (this->frames[frame].pinCount > 0)
+	{
+		this->frames[frame].orphaned = true;
+		return;
+	}
+	this->frames[frame].page = Page();
+	this->freeFrames.push_back(frame);
+}
+
+/**
+ * @brief Called by PageHandle when it lets go of a frame.
+ *
+ * @param frameId
+ */
+void BufferManager::unpin(int frameId)
+{
+	Frame &frame = this->frames[frameId];
+	frame.pinCount--;
+	if (frame.pinCount == 0 && frame.orphaned)
+	{
+		frame.orphaned = false;
+		frame.dirty = false;
+		frame.page = Page();
+		this->freeFrames.push_back(frameId);
+	}
 }
 
 /**
  * @brief The buffer manager is also responsible for writing pages. This is
- * called when new tables are created using assignment statements.
+ * called when new tables are created using assignment statements. The page is
+ * placed in the pool (taking a frame if it is not already resident) and marked
+ * dirty; the file itself is written later, see writeBack.
  *
  * @param tableName
  * @param pageIndex
- * @param rows
+ * @param values the rows, row-major (only the first rowCount rows are used)
  * @param rowCount
+ * @param columnCount
+ * @param layout how the page is laid out when it reaches its file
  */
-void BufferManager::writePage(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount)
+void BufferManager::writePage(string tableName, int pageIndex, vector<int> values, int rowCount, int columnCount, PageLayout layout)
 {
-	logger.log("BufferManager::writePage");
-	Page page(tableName, pageIndex, rows, rowCount);
-	page.writePage();
+	LOG_DEBUG("BufferManager::writePage");
+	PageKey key = this->makeKey(tableName, pageIndex);
+	this->unmapTable(key >> 32);
+	int frame = this->findFrame(key);
+	if (frame == -1)
+		frame = this->allocateFrame(key);
+	this->frames[frame].page = Page(tableName, pageIndex, move(values), rowCount, columnCount, layout);
+	this->frames[frame].dirty = true;
+}
 
-	string pageName = "../data/temp/" + tableName + "_Page" + to_string(pageIndex);
-	for (auto &p : this->pages)
-	{
-		if (p.pageName == pageName)
-		{
-			p = page; // Now in-memory copy is also updated
-			break;
-		}
-	}
+/**
+ * @brief Writes back every dirty page of tableName that is in the pool.
+ *
+ * @param tableName
+ */
+void BufferManager::flushTable(const string &tableName)
+{
+	LOG_DEBUG("BufferManager::flushTable");
+	auto it = this->tableIds.find(tableName);
+	if (it == this->tableIds.end())
+		return;
+	for (auto &[key, frame] : this->pageTable)
+		if ((key >> 32) == it->second)
+			this->writeBack(this->frames[frame]);
+}
+
+/**
+ * @brief Switches tableName to the memory mapped read path. Its dirty pages are
+ * written back first so the segment file holds the whole table. Does nothing
+ * with TEXT_PAGES, where there is no segment to map.
+ *
+ * @param tableName
+ * @return true if the table is now mapped
+ */
+bool BufferManager::mapTable(const string &tableName)
+{
+	LOG_DEBUG("BufferManager::mapTable");
+	if (TEXT_PAGES)
+		return false;
+	this->flushTable(tableName);
+	this->mappedTables.insert(this->makeKey(tableName, 0) >> 32);
+	return true;
+}
+
+/**
+ * @brief Sends the table back to the pool, called on the first write to a
+ * mapped table. Pages in the pool are still current, they were written back
+ * before mapping and the mapping never changes them.
+ *
+ * @param tableId
+ */
+void BufferManager::unmapTable(uint32_t tableId)
+{
+	if (this->mappedTables.erase(tableId))
+		LOG_DEBUG("BufferManager::unmapTable - Table " + to_string(tableId) + " modified, reading it through the pool");
+}
+
+/**
+ * @brief If tableName is mapped, fills view with page pageIndex straight out
+ * of the mapped segment. Callers fall back to getPage when this returns false.
+ *
+ * @param tableName
+ * @param pageIndex
+ * @param view
+ * @return true if the page was mapped
+ */
+bool BufferManager::getMappedPage(const string &tableName, int pageIndex, PageView &view)
+{
+	auto it = this->tableIds.find(tableName);
+	if (it == this->tableIds.end() || !this->mappedTables.count(it->second))
+		return false;
+	if (!viewPage(tableName, pageIndex, view))
+		return false;
+	this->mappedReadCount++;
+	return true;
+}
+
+/**
+ * @brief Writes back every dirty page in the pool.
+ *
+ */
+void BufferManager::flush()
+{
+	LOG_DEBUG("BufferManager::flush");
+	for (auto &[key, frame] : this->pageTable)
+		this->writeBack(this->frames[frame]);
 }
 
 /**
- * @brief Deletes file names fileName
+ * @brief Deletes file names fileName. Page names of the form
+ * "../data/temp/<table>_Page<i>" are treated as deleteFile(table, i); anything
+ * else is removed from the file system.
  *
  * @param fileName
  */
 void BufferManager::deleteFile(string fileName)
 {
+	const string prefix = "../data/temp/";
+	size_t pagePos = fileName.rfind("_Page");
+	if (fileName.compare(0, prefix.size(), prefix) == 0 && pagePos != string::npos &&
+		pagePos + 5 < fileName.size() &&
+		all_of(fileName.begin() + pagePos + 5, fileName.end(), ::isdigit))
+	{
+		this->deleteFile(fileName.substr(prefix.size(), pagePos - prefix.size()), stoi(fileName.substr(pagePos + 5)));
+		return;
+	}
 
 	if (remove(fileName.c_str()))
-		logger.log("BufferManager::deleteFile: Err");
+		LOG_ERROR("BufferManager::deleteFile: Err");
 	else
-		logger.log("BufferManager::deleteFile: Success");
+		LOG_DEBUG("BufferManager::deleteFile: Success");
 }
 
 /**
- * @brief Overloaded function that calls deleteFile(fileName) by constructing
- * the fileName from the tableName and pageIndex.
+ * @brief Deallocates page pageIndex of tableName: the page is dropped from the
+ * pool (without being written back) and its slot in the table's segment is
+ * freed for reuse.
  *
  * @param tableName
  * @param pageIndex
  */
 void BufferManager::deleteFile(string tableName, int pageIndex)
 {
-	logger.log("BufferManager::deleteFile");
-	string fileName = "../data/temp/" + tableName + "_Page" + to_string(pageIndex);
-	this->deleteFile(fileName);
-}
\ No newline at end of file
+	LOG_DEBUG("BufferManager::deleteFile");
+	auto it = this->tableIds.find(tableName);
+	if (it != this->tableIds.end())
+	{
+		PageKey key = ((PageKey)it->second << 32) | (uint32_t)pageIndex;
+		this->unmapTable(it->second);
+		this->dropPrefetch(key);
+		this->evict(key);
+	}
+	storageManager.freePage(tableName, pageIndex);
+}
+
+PageHandle::PageHandle(int frameId, Frame *frame) : frameId(frameId), frame(frame)
+{
+	this->frame->pinCount++;
+}
+
+PageHandle::PageHandle(const PageHandle &other) : frameId(other.frameId), frame(other.frame)
+{
+	if (this->frame)
+		this->frame->pinCount++;
+}
+
+PageHandle::PageHandle(PageHandle &&other) noexcept : frameId(other.frameId), frame(other.frame)
+{
+	other.frameId = -1;
+	other.frame = nullptr;
+}
+
+PageHandle &PageHandle::operator=(PageHandle other)
+{
+	swap(this->frameId, other.frameId);
+	swap(this->frame, other.frame);
+	return *this;
+}
+
+PageHandle::~PageHandle()
+{
+	this->release();
+}
+
+/**
+ * @brief Gives write access to the pinned page and marks its frame dirty, so
+ * the change is written back to the page file later.
+ *
+ * @return Page&
+ */
+Page &PageHandle::modify()
+{
+	bufferManager.unmapTable(this->frame->key >> 32);
+	this->frame->dirty = true;
+	return this->frame->page;
+}
+
+/**
+ * @brief Unpins the frame early. The handle is empty afterwards.
+ *
+ */
+void PageHandle::release()
+{
+	if (!this->frame)
+		return;
+	bufferManager.unpin(this->frameId);
+	this->frameId = -1;
+	this->frame = nullptr;
+}
@@ -3,6 +3,7 @@
 
 #pragma once
 #include "page.h"
+#include "replacementPolicy.h"
 
 /**
  * @brief The BufferManager is responsible for reading pages to the main memory.
@@ -16,29 +17,167 @@
  * same.
  *
  * <p>
- * The buffer can hold multiple pages quantified by BLOCK_COUNT. The
- * buffer manager follows the FIFO replacement policy i.e. the first block to be
- * read in is replaced by the new incoming block. This replacement policy should
- * be transparent to the executors i.e. the executor should not know if a block
- * was previously present in the buffer or was read in from the disk.
+ * The buffer can hold multiple pages quantified by BLOCK_COUNT. Which page is
+ * replaced when a new one is read in is decided by a ReplacementPolicy (FIFO by
+ * default, or LRU, CLOCK or 2Q chosen at startup). This replacement policy
+ * should be transparent to the executors i.e. the executor should not know if a
+ * block was previously present in the buffer or was read in from the disk.
+ * </p>
+ *
+ * <p>
+ * Pages are looked up through a hash map keyed on (table id, page index), so
+ * the cost of a lookup does not grow with BLOCK_COUNT. Table names are interned
+ * to ids the first time they are seen.
+ * </p>
+ *
+ * <p>
+ * getPage hands out a PageHandle that pins the frame instead of a copy of the
+ * page. Pinned frames are skipped when looking for a page to replace; if every
+ * frame is pinned the pool temporarily grows past BLOCK_COUNT.
+ * </p>
+ *
+ * <p>
+ * Writes are deferred: writePage (and PageHandle::modify) only update the page
+ * held in the pool and mark its frame dirty. The page file is written when the
+ * frame is reused for another page, on FLUSH, on QUIT and when a table is
+ * exported. A page that is deleted while dirty is simply dropped.
+ * </p>
+ *
+ * <p>
+ * Tables produced by assignment statements are never changed after they are
+ * written, so they can be mapped (mapTable): their pages are flushed and
+ * cursors then scan them through getMappedPage, straight out of a memory
+ * mapping of the segment, bypassing the pool. The first write to a mapped
+ * table (writePage, PageHandle::modify or deleteFile) unmaps it and it is
+ * read through the pool again from then on.
+ * </p>
+ *
+ * <p>
+ * Cursors that move from one page to the next call readAhead, which queues the
+ * following READ_AHEAD pages for a background thread to read. The thread only
+ * does the I/O: the page images wait in a staging area (at most BLOCK_COUNT of
+ * them) until getPage misses on one of them and turns it into a Page in a
+ * frame. Everything else in the buffer manager is only touched by the main
+ * thread.
  * </p>
  *
  */
+/**
+ * @brief Compact pool key: the interned table id in the upper 32 bits and the
+ * page index in the lower 32 bits.
+ */
+typedef uint64_t PageKey;
+
+/**
+ * @brief A slot in the buffer pool. A frame with a non-zero pin count is in use
+ * by some PageHandle and is never chosen for replacement.
+ */
+struct Frame
+{
+	Page page;
+	PageKey key = 0;
+	int pinCount = 0;
+	bool dirty = false;	   // page differs from its file and must be written before the frame is reused
+	bool orphaned = false; // page was deleted while the frame was still pinned
+};
+
+/**
+ * @brief A page image requested by readAhead. The ticket tells the read-ahead
+ * thread whether the request it finished is still wanted: a request that was
+ * dropped (and maybe issued again) meanwhile has a different ticket.
+ */
+struct Prefetch
+{
+	string tableName;
+	int pageIndex = -1;
+	uint64_t ticket = 0;
+	bool reading = false; // picked up by the read-ahead thread
+	bool ready = false;	  // buffer holds the page (or found is false)
+	bool found = false;
+	vector<char> buffer;
+};
+
+/**
+ * @brief Pinned reference to a page held in a buffer pool frame. Rows are read
+ * straight out of the frame, so handing a page to an executor or a cursor does
+ * not copy it. The frame stays pinned for as long as any copy of the handle is
+ * alive and is unpinned automatically when the last one goes out of scope.
+ */
+class PageHandle
+{
+	int frameId = -1;
+	Frame *frame = nullptr;
+
+public:
+	PageHandle() {}
+	PageHandle(int frameId, Frame *frame);
+	PageHandle(const PageHandle &other);
+	PageHandle(PageHandle &&other) noexcept;
+	PageHandle &operator=(PageHandle other);
+	~PageHandle();
+	void release();
+	bool isValid() const { return this->frame != nullptr; }
+	const Page &operator*() const { return this->frame->page; }
+	const Page *operator->() const { return &this->frame->page; }
+	Page &modify();
+};
+
 class BufferManager
 {
+	friend class PageHandle;
+
+	deque<Frame> frames;					  // frame storage, grows up to BLOCK_COUNT; deque keeps frames in place
+	vector<int> freeFrames;					  // frames released by deleteFile
+	unordered_map<PageKey, int> pageTable;	  // key -> frame holding that page
+	unordered_map<string, uint32_t> tableIds; // table name -> interned id
+	unordered_set<uint32_t> mappedTables;	  // ids of tables read through getMappedPage
+	unique_ptr<ReplacementPolicy> policy;
+	long long hitCount = 0;
+	long long missCount = 0;
+	long long evictionCount = 0;
+	long long writeBackCount = 0;
+	long long mappedReadCount = 0;
+
+	// Read-ahead state, shared with prefetchThread and guarded by prefetchMutex
+	thread prefetchThread;
+	mutex prefetchMutex;
+	condition_variable prefetchRequested;
+	condition_variable prefetchDone;
+	unordered_map<PageKey, Prefetch> prefetches;
+	deque<PageKey> prefetchQueue;
+	uint64_t nextTicket = 0;
+	bool stopping = false;
+	long long prefetchIssuedCount = 0;
+	long long prefetchUsedCount = 0;
+	long long prefetchWastedCount = 0;
 
-	deque<Page> pages;
-	bool inPool(string pageName);
-	Page getFromPool(string pageName);
-	Page insertIntoPool(string tableName, int pageIndex);
+	PageKey makeKey(const string &tableName, int pageIndex);
+	void unmapTable(uint32_t tableId);
+	int findFrame(PageKey key);
+	void evict(PageKey key);
+	void unpin(int frameId);
+	void writeBack(Frame &frame);
+	int allocateFrame(PageKey key);
+	PageHandle insertIntoPool(string tableName, int pageIndex, PageKey key);
+	void prefetchWorker();
+	bool takePrefetched(PageKey key, vector<char> &buffer);
+	void dropPrefetch(PageKey key);
+	bool makeRoomForPrefetch(PageKey firstKey, PageKey lastKey);
 
 public:
 	BufferManager();
-	Page getPage(string tableName, int pageIndex);
-	void writePage(string pageName, vector<vector<int>> rows);
+	~BufferManager();
+	bool setReplacementPolicy(const string &policyName);
+	void printStatistics();
+	PageHandle getPage(string tableName, int pageIndex);
+	void readAhead(const string &tableName, int fromPage, int toPage);
 	void deleteFile(string tableName, int pageIndex);
 	void deleteFile(string fileName);
-	void writePage(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount);
+	void writePage(string tableName, int pageIndex, vector<int> values, int rowCount, int columnCount, PageLayout layout = ROW_LAYOUT);
+	void flushTable(const string &tableName);
+	bool mapTable(const string &tableName);
+	bool getMappedPage(const string &tableName, int pageIndex, PageView &view);
+	void flush();
 };
 
 #endif
\ No newline at end of file
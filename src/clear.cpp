@@ -7,7 +7,7 @@
 
 bool syntacticParseCLEAR()
 {
-	logger.log("syntacticParseCLEAR");
+	LOG_DEBUG("syntacticParseCLEAR");
 	if (tokenizedQuery.size() != 2)
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -20,7 +20,7 @@ bool syntacticParseCLEAR()
 
 bool semanticParseCLEAR()
 {
-	logger.log("semanticParseCLEAR");
+	LOG_DEBUG("semanticParseCLEAR");
 	// Table should exist
 	if (tableCatalogue.isTable(parsedQuery.clearRelationName))
 		return true;
@@ -30,7 +30,7 @@ bool semanticParseCLEAR()
 
 void executeCLEAR()
 {
-	logger.log("executeCLEAR");
+	LOG_DEBUG("executeCLEAR");
 	// Deleting table from the catalogue deletes all temporary files
 	tableCatalogue.deleteTable(parsedQuery.clearRelationName);
 	return;
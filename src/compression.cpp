@@ -0,0 +1,239 @@
+#include "global.h"
+
+/**
+ * @brief Number of bits needed to hold every value in [0, range].
+ */
+static int bitsNeeded(uint64_t range)
+{
+	int bits = 0;
+	while (range)
+	{
+		bits++;
+		range >>= 1;
+	}
+	return bits;
+}
+
+/**
+ * @brief Bytes taken by count values packed in bitWidth bits each. Packed
+ * values go into whole 64 bit words.
+ */
+static size_t packedSize(size_t count, int bitWidth)
+{
+	return (count * bitWidth + 63) / 64 * 8;
+}
+
+/**
+ * @brief Appends count values, each bitWidth bits wide, to out as a little
+ * endian stream of 64 bit words. Value i starts at bit i * bitWidth.
+ *
+ * @param offsets
+ * @param count
+ * @param bitWidth 0 to 32
+ * @param out
+ */
+static void packBits(const vector<uint32_t> &offsets, size_t count, int bitWidth, vector<char> &out)
+{
+	vector<uint64_t> words(packedSize(count, bitWidth) / 8, 0);
+	for (size_t position = 0; bitWidth && position < count; position++)
+	{
+		size_t bit = position * bitWidth;
+		size_t word = bit >> 6;
+		int shift = bit & 63;
+		words[word] |= (uint64_t)offsets[position] << shift;
+		if (shift + bitWidth > 64)
+			words[word + 1] |= (uint64_t)offsets[position] >> (64 - shift);
+	}
+	const char *bytes = (const char *)words.data();
+	out.insert(out.end(), bytes, bytes + words.size() * 8);
+}
+
+/**
+ * @brief Reads value position back out of a stream written by packBits.
+ */
+static inline uint32_t unpackBits(const char *data, size_t position, int bitWidth)
+{
+	if (bitWidth == 0)
+		return 0;
+	size_t bit = position * bitWidth;
+	int shift = bit & 63;
+	uint64_t word;
+	memcpy(&word, data + (bit >> 6) * 8, 8);
+	uint64_t value = word >> shift;
+	if (shift + bitWidth > 64)
+	{
+		memcpy(&word, data + ((bit >> 6) + 1) * 8, 8);
+		value |= word << (64 - shift);
+	}
+	return value & ((1ULL << bitWidth) - 1);
+}
+
+/**
+ * @brief Appends one column of a page to out, in whichever of the
+ * ColumnEncodings takes the fewest bytes (ties go to the one that is cheaper
+ * to decode, in the order of the enum).
+ *
+ * @param values first value of the column
+ * @param stride distance between consecutive values of the column
+ * @param rowCount
+ * @param out
+ */
+void encodeColumn(const int *values, size_t stride, int rowCount, vector<char> &out)
+{
+	int64_t minimum = 0, maximum = 0, minimumDelta = 0, maximumDelta = 0;
+	size_t runCount = 0;
+	for (int rowCounter = 0; rowCounter < rowCount; rowCounter++)
+	{
+		int64_t value = values[rowCounter * stride];
+		if (rowCounter == 0)
+		{
+			minimum = maximum = value;
+			runCount = 1;
+			continue;
+		}
+		int64_t previous = values[(rowCounter - 1) * stride];
+		minimum = min(minimum, value);
+		maximum = max(maximum, value);
+		int64_t delta = value - previous;
+		if (rowCounter == 1)
+			minimumDelta = maximumDelta = delta;
+		minimumDelta = min(minimumDelta, delta);
+		maximumDelta = max(maximumDelta, delta);
+		if (value != previous)
+			runCount++;
+	}
+
+	ColumnHeader header = {COLUMN_PLAIN, 0, 0, 0, (uint32_t)(rowCount * sizeof(int32_t))};
+	int forWidth = bitsNeeded(maximum - minimum);
+	if (packedSize(rowCount, forWidth) < header.length)
+		header = {COLUMN_FOR, (uint8_t)forWidth, 0, (int32_t)minimum, (uint32_t)packedSize(rowCount, forWidth)};
+	// Deltas of int32s span up to 33 bits, only use them when they fit
+	if (rowCount > 1 && maximumDelta - minimumDelta <= UINT32_MAX && minimumDelta >= INT32_MIN && minimumDelta <= INT32_MAX)
+	{
+		int deltaWidth = bitsNeeded(maximumDelta - minimumDelta);
+		size_t deltaLength = sizeof(int32_t) + packedSize(rowCount - 1, deltaWidth);
+		if (deltaLength < header.length)
+			header = {COLUMN_DELTA, (uint8_t)deltaWidth, 0, values[0], (uint32_t)deltaLength};
+	}
+	if (runCount * 2 * sizeof(int32_t) < header.length)
+		header = {COLUMN_RLE, 0, 0, 0, (uint32_t)(runCount * 2 * sizeof(int32_t))};
+
+	const char *headerBytes = (const char *)&header;
+	out.insert(out.end(), headerBytes, headerBytes + sizeof(ColumnHeader));
+	size_t start = out.size();
+	if (header.encoding == COLUMN_PLAIN)
+	{
+		for (int rowCounter = 0; rowCounter < rowCount; rowCounter++)
+		{
+			int32_t value = values[rowCounter * stride];
+			out.insert(out.end(), (const char *)&value, (const char *)&value + sizeof(int32_t));
+		}
+	}
+	else if (header.encoding == COLUMN_FOR)
+	{
+		vector<uint32_t> offsets(rowCount);
+		for (int rowCounter = 0; rowCounter < rowCount; rowCounter++)
+			offsets[rowCounter] = (int64_t)values[rowCounter * stride] - minimum;
+		packBits(offsets, rowCount, header.bitWidth, out);
+	}
+	else if (header.encoding == COLUMN_DELTA)
+	{
+		int32_t firstDelta = minimumDelta;
+		out.insert(out.end(), (const char *)&firstDelta, (const char *)&firstDelta + sizeof(int32_t));
+		vector<uint32_t> offsets(rowCount - 1);
+		for (int rowCounter = 1; rowCounter < rowCount; rowCounter++)
+			offsets[rowCounter - 1] = (int64_t)values[rowCounter * stride] - values[(rowCounter - 1) * stride] - minimumDelta;
+		packBits(offsets, rowCount - 1, header.bitWidth, out);
+	}
+	else
+	{
+		int rowCounter = 0;
+		while (rowCounter < rowCount)
+		{
+			int32_t run[2] = {values[rowCounter * stride], 0};
+			while (rowCounter < rowCount && values[rowCounter * stride] == run[0])
+			{
+				run[1]++;
+				rowCounter++;
+			}
+			out.insert(out.end(), (const char *)run, (const char *)run + sizeof(run));
+		}
+	}
+	if (out.size() - start != header.length)
+		LOG_ERROR("encodeColumn - ERROR: Encoded " + to_string(out.size() - start) + " bytes, expected " + to_string(header.length));
+}
+
+/**
+ * @brief Decodes one column written by encodeColumn and moves data past it.
+ *
+ * @param data start of the column's ColumnHeader
+ * @param end end of the page image
+ * @param rowCount
+ * @param values where the first value goes
+ * @param stride distance between consecutive values of the column in values
+ * @return false if the column is corrupt
+ */
+bool decodeColumn(const char *&data, const char *end, int rowCount, int *values, size_t stride)
+{
+	ColumnHeader header;
+	if (end - data < (ptrdiff_t)sizeof(ColumnHeader))
+		return false;
+	memcpy(&header, data, sizeof(ColumnHeader));
+	data += sizeof(ColumnHeader);
+	if (end - data < (ptrdiff_t)header.length || header.bitWidth > 32)
+		return false;
+	const char *payload = data;
+	data += header.length;
+
+	switch (header.encoding)
+	{
+	case COLUMN_PLAIN:
+		if (header.length < rowCount * sizeof(int32_t))
+			return false;
+		for (int rowCounter = 0; rowCounter < rowCount; rowCounter++)
+			memcpy(&values[rowCounter * stride], payload + rowCounter * sizeof(int32_t), sizeof(int32_t));
+		return true;
+	case COLUMN_FOR:
+		if (header.length < packedSize(rowCount, header.bitWidth))
+			return false;
+		for (int rowCounter = 0; rowCounter < rowCount; rowCounter++)
+			values[rowCounter * stride] = (int64_t)header.base + unpackBits(payload, rowCounter, header.bitWidth);
+		return true;
+	case COLUMN_DELTA:
+	{
+		if (rowCount == 0)
+			return true;
+		if (header.length < sizeof(int32_t) + packedSize(rowCount - 1, header.bitWidth))
+			return false;
+		int32_t minimumDelta;
+		memcpy(&minimumDelta, payload, sizeof(int32_t));
+		payload += sizeof(int32_t);
+		int64_t value = header.base;
+		values[0] = value;
+		for (int rowCounter = 1; rowCounter < rowCount; rowCounter++)
+		{
+			value += minimumDelta + (int64_t)unpackBits(payload, rowCounter - 1, header.bitWidth);
+			values[rowCounter * stride] = value;
+		}
+		return true;
+	}
+	case COLUMN_RLE:
+	{
+		int rowCounter = 0;
+		for (const char *run = payload; run + 2 * sizeof(int32_t) <= payload + header.length; run += 2 * sizeof(int32_t))
+		{
+			int32_t value;
+			uint32_t length;
+			memcpy(&value, run, sizeof(int32_t));
+			memcpy(&length, run + sizeof(int32_t), sizeof(uint32_t));
+			if (length > (uint32_t)(rowCount - rowCounter))
+				return false;
+			for (uint32_t repeat = 0; repeat < length; repeat++)
+				values[(rowCounter++) * stride] = value;
+		}
+		return rowCounter == rowCount;
+	}
+	default:
+		return false;
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#pragma once
+#include "logger.h"
+
+/**
+ * @brief How one column of a compressed page is stored.
+ *
+ * COLUMN_PLAIN	every value as an int32.
+ * COLUMN_FOR	frame of reference: each value minus the column minimum (base),
+ *				bit-packed in bitWidth bits.
+ * COLUMN_DELTA	base is the first value, followed by an int32 minimum delta and
+ *				the differences between consecutive values minus that minimum,
+ *				bit-packed in bitWidth bits. Wins on sorted columns.
+ * COLUMN_RLE	(int32 value, uint32 run length) pairs. Wins on columns with
+ *				long runs of one value.
+ */
+enum ColumnEncoding : uint8_t
+{
+	COLUMN_PLAIN,
+	COLUMN_FOR,
+	COLUMN_DELTA,
+	COLUMN_RLE
+};
+
+/**
+ * @brief Precedes the encoded values of every column in a compressed page.
+ * length is the number of bytes that follow it for this column.
+ */
+struct ColumnHeader
+{
+	uint8_t encoding;
+	uint8_t bitWidth;
+	uint16_t reserved;
+	int32_t base;
+	uint32_t length;
+};
+
+void encodeColumn(const int *values, size_t stride, int rowCount, vector<char> &out);
+bool decodeColumn(const char *&data, const char *end, int rowCount, int *values, size_t stride);
+
+#endif
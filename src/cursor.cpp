@@ -2,70 +2,194 @@
 
 Cursor::Cursor(string tableName, int pageIndex)
 {
-	logger.log("Cursor::Cursor");
-	this->page = bufferManager.getPage(tableName, pageIndex);
-	this->pagePointer = 0;
+	LOG_DEBUG("Cursor::Cursor");
 	this->tableName = tableName;
+	this->loadPage(pageIndex);
+	this->pagePointer = 0;
 	this->pageIndex = pageIndex;
 }
 
+/**
+ * @brief Makes pageIndex the current page, either as a view into the mapped
+ * segment or, if the table is not mapped, pinned in the buffer pool.
+ *
+ * @param pageIndex
+ */
+void Cursor::loadPage(int pageIndex)
+{
+	this->mapped = bufferManager.getMappedPage(this->tableName, pageIndex, this->view);
+	if (this->mapped)
+		this->page.release();
+	else
+		this->page = bufferManager.getPage(this->tableName, pageIndex);
+}
+
+/**
+ * @brief Restricts the cursor to the pages pageFilter accepts; the others are
+ * skipped without being read. If the current page is rejected and nothing has
+ * been read from it yet, it is skipped too.
+ *
+ * @param pageFilter called with a page index
+ */
+void Cursor::setPageFilter(function<bool(int)> pageFilter)
+{
+	this->pageFilter = move(pageFilter);
+	if (this->pageFilter && this->pagePointer == 0 && !this->pageFilter(this->pageIndex))
+		this->pagePointer = this->pageRowCount();
+}
+
+/**
+ * @brief First page from pageIndex on that the page filter accepts.
+ *
+ * @param pageIndex
+ * @param blockCount
+ * @return int blockCount if there is none
+ */
+int Cursor::nextWantedPage(int pageIndex, int blockCount) const
+{
+	while (this->pageFilter && pageIndex < blockCount && !this->pageFilter(pageIndex))
+		pageIndex++;
+	return pageIndex;
+}
+
+/**
+ * @brief Moves on to the next page while the current one is exhausted (or
+ * empty), so that pagePointer points at an unread row.
+ *
+ * @return false if the table has no rows left
+ */
+bool Cursor::seekRow()
+{
+	while (this->pagePointer >= this->pageRowCount())
+	{
+		Table *table = tableCatalogue.getTable(this->tableName);
+		if (!table)
+		{
+			LOG_ERROR("Cursor::seekRow - ERROR: Table " + this->tableName + " not found in catalogue.");
+			return false;
+		}
+		int nextPageIndex = this->nextWantedPage(this->pageIndex + 1, table->blockCount);
+		if (nextPageIndex >= (int)table->blockCount)
+			return false;
+		this->nextPage(nextPageIndex);
+	}
+	return true;
+}
+
 /**
  * @brief This function reads the next row from the page. The index of the
  * current row read from the page is indicated by the pagePointer(points to row
  * in page the cursor is pointing to).
  *
- * @return vector<int>
+ * @return vector<int> empty once the table is exhausted
  */
 vector<int> Cursor::getNext()
 {
-    logger.log("Cursor::geNext");
-    
-    // Loop to find the next valid row
-    while (true) {
-        // Attempt to get a row from the current page
-        if (this->pagePointer < this->page.getRowCount()) {
-            vector<int> result = this->page.getRow(this->pagePointer);
-            this->pagePointer++;
-            if (!result.empty()) {
-                logger.log("Cursor::geNext - Successfully fetched row from page " + to_string(this->pageIndex) + " at row index " + to_string(this->pagePointer -1));
-                return result; // Found a valid row
-            } else {
-                 // This case (empty row within supposedly valid range) might indicate data corruption or an issue in Page::getRow or Page loading
-                 logger.log("Cursor::geNext - WARNING: page.getRow returned empty for a supposedly valid pointer. Page: " + to_string(this->pageIndex) + ", Pointer: " + to_string(this->pagePointer-1) + ", PageRowCount: " + to_string(this->page.getRowCount()));
-                 // Continue to try advancing page, as this row is effectively invalid
-            }
-        }
+	while (this->seekRow())
+	{
+		int rowIndex = this->pagePointer++;
+		if (this->mapped && this->view.layout == PAX_LAYOUT)
+		{
+			vector<int> row(this->view.columnCount);
+			for (int columnCounter = 0; columnCounter < this->view.columnCount; columnCounter++)
+				row[columnCounter] = this->view.values[(size_t)columnCounter * this->view.rowCount + rowIndex];
+			return row;
+		}
+		if (this->mapped)
+		{
+			const int *row = this->view.values + (size_t)rowIndex * this->view.columnCount;
+			return vector<int>(row, row + this->view.columnCount);
+		}
+		RowSpan result = this->page->getRowRef(rowIndex);
+		if (!result.empty())
+			return result.toVector();
+		LOG_WARNING("Cursor::getNext - WARNING: Empty row " + to_string(rowIndex) + " in page " + to_string(this->pageIndex) + " of " + this->tableName);
+	}
+	return {};
+}
 
-        // Current page is exhausted or was empty to begin with, move to the next page
-        Table* table = tableCatalogue.getTable(this->tableName);
-        if (!table) {
-            logger.log("Cursor::geNext - ERROR: Table " + this->tableName + " not found in catalogue.");
-            return {}; // Return empty vector
-        }
+/**
+ * @brief Hands out all rows of the current page that have not been read yet
+ * as one block, moving on to the next page first if the current one is
+ * exhausted. The block points straight into the page: into the pinned
+ * frame's buffer for pages in the pool, or into the mapping (column-major for
+ * PAX pages) for mapped tables.
+ *
+ * @param block receives the rows, valid until the cursor is moved again
+ * @return false once the table is exhausted
+ */
+bool Cursor::getNextBlock(RowBlock &block)
+{
+	LOG_DEBUG("Cursor::getNextBlock");
+	if (!this->seekRow())
+		return false;
+	int rowCount = this->pageRowCount() - this->pagePointer;
+	if (this->mapped && this->view.layout == PAX_LAYOUT)
+	{
+		block.values = this->view.values + this->pagePointer;
+		block.columnCount = this->view.columnCount;
+		block.rowStride = 1;
+		block.columnStride = this->view.rowCount;
+	}
+	else if (this->mapped)
+	{
+		block.values = this->view.values + (size_t)this->pagePointer * this->view.columnCount;
+		block.columnCount = this->view.columnCount;
+		block.rowStride = this->view.columnCount;
+		block.columnStride = 1;
+	}
+	else
+	{
+		int columnCount = this->page->getColumnCount();
+		block.values = this->page->getValues() + (size_t)this->pagePointer * columnCount;
+		block.columnCount = columnCount;
+		block.rowStride = columnCount;
+		block.columnStride = 1;
+	}
+	block.rowCount = rowCount;
+	this->pagePointer += rowCount;
+	return true;
+}
 
-        // Check if there is a next page in the table's metadata
-        if (this->pageIndex < table->blockCount - 1) {
-            logger.log("Cursor::geNext - Current page " + to_string(this->pageIndex) + " exhausted. Attempting to load next page.");
-            this->nextPage(this->pageIndex + 1); // nextPage resets pagePointer to 0
-            // Loop will continue, and the next iteration will try to getRow from the new page
-        } else {
-            // No more pages in the table
-            logger.log("Cursor::geNext - No more pages in table " + this->tableName + ". End of cursor.");
-            return {}; // Return empty vector, indicating end of table
-        }
-    }
+/**
+ * @brief Copies row rowIndex of the block into row.
+ *
+ * @param rowIndex
+ * @param row
+ */
+void RowBlock::copyRow(int rowIndex, vector<int> &row) const
+{
+	row.resize(this->columnCount);
+	for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+		row[columnCounter] = this->value(rowIndex, columnCounter);
 }
+
 /**
  * @brief Function that loads Page indicated by pageIndex. Now the cursor starts
- * reading from the new page.
+ * reading from the new page. Moving to the next page the page filter accepts
+ * counts as sequential; read-ahead then stops at the first page the filter
+ * rejects.
  *
  * @param pageIndex
  */
 void Cursor::nextPage(int pageIndex)
 {
-	logger.log("Cursor::nextPage for page index " + to_string(pageIndex)); // Added specific page index
-	this->page = bufferManager.getPage(this->tableName, pageIndex);
-    logger.log("Cursor::nextPage - Loaded page " + to_string(pageIndex) + " for table " + this->tableName + ". New page.rowCount: " + to_string(this->page.getRowCount())); // Added log for rowCount
+	LOG_DEBUG("Cursor::nextPage for page index " + to_string(pageIndex)); // Added specific page index
+	Table *table = tableCatalogue.getTable(this->tableName);
+	bool sequential = table && pageIndex == this->nextWantedPage(this->pageIndex + 1, table->blockCount);
+	this->loadPage(pageIndex);
+	if (sequential && !this->mapped)
+	{
+		int lastPageIndex = (int)table->blockCount - 1;
+		if (this->pageFilter)
+		{
+			lastPageIndex = pageIndex;
+			while (lastPageIndex + 1 < (int)table->blockCount && lastPageIndex - pageIndex < (int)READ_AHEAD && this->pageFilter(lastPageIndex + 1))
+				lastPageIndex++;
+		}
+		bufferManager.readAhead(this->tableName, pageIndex + 1, lastPageIndex);
+	}
+    LOG_DEBUG("Cursor::nextPage - Loaded page " + to_string(pageIndex) + " for table " + this->tableName + ". New page.rowCount: " + to_string(this->pageRowCount())); // Added log for rowCount
 	this->pageIndex = pageIndex;
 	this->pagePointer = 0;
 }
\ No newline at end of file
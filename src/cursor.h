@@ -3,24 +3,64 @@
 
 #pragma once
 #include "bufferManager.h"
+
+/**
+ * @brief A batch of rows handed out by Cursor::getNextBlock: rowCount rows of
+ * columnCount ints each. Value (r, c) lives at values[r * rowStride + c *
+ * columnStride], which covers both row-major blocks and the column minipages
+ * of a PAX page, so loops that go through value() only touch the columns they
+ * ask for. The block is only valid until the cursor is moved again.
+ */
+struct RowBlock
+{
+	const int *values = nullptr;
+	int rowCount = 0;
+	int columnCount = 0;
+	size_t rowStride = 0;
+	size_t columnStride = 1;
+	int value(int rowIndex, int columnIndex) const { return this->values[rowIndex * this->rowStride + columnIndex * this->columnStride]; }
+	void copyRow(int rowIndex, vector<int> &row) const;
+};
+
 /**
  * @brief The cursor is an important component of the system. To read from a
  * table, you need to initialize a cursor. The cursor reads rows from a page one
- * at a time.
+ * at a time with getNext, or the rest of the current page at once with
+ * getNextBlock.
+ *
+ * Pages of mapped tables (see BufferManager::mapTable) are scanned in place
+ * through a PageView instead of being pinned in the buffer pool; whether a page
+ * is mapped is decided again every time the cursor moves to a new page.
+ * Moving on to the page right after the current one counts as a sequential
+ * scan and has the buffer manager read the next pages ahead.
+ *
+ * A page filter (setPageFilter) makes the cursor skip the pages it rejects
+ * without reading them, which is how scans use the table's zone maps.
  *
  */
 class Cursor
 {
 public:
-	Page page;
+	PageHandle page;
+	PageView view;
+	bool mapped = false;
 	int pageIndex;
 	string tableName;
 	int pagePointer;
+	function<bool(int)> pageFilter; // pages it returns false for are skipped
 
 public:
 	Cursor(string tableName, int pageIndex);
 	vector<int> getNext();
+	bool getNextBlock(RowBlock &block);
 	void nextPage(int pageIndex);
+	void setPageFilter(function<bool(int)> pageFilter);
+
+private:
+	void loadPage(int pageIndex);
+	bool seekRow();
+	int nextWantedPage(int pageIndex, int blockCount) const;
+	int pageRowCount() const { return this->mapped ? this->view.rowCount : this->page->getRowCount(); }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -83,6 +83,15 @@ void executeCommand()
 	case SEARCH:
 		executeSEARCH();
 		break;
+	case FLUSH:
+		executeFLUSH();
+		break;
+	case ANALYZE:
+		executeANALYZE();
+		break;
+	case EXPLAIN:
+		executeEXPLAIN();
+		break;
 	case QUIT:
 	  executeQUIT();
     break;
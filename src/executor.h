@@ -3,6 +3,8 @@
 
 #pragma once
 #include "semanticParser.h"
+#include "planner.h"
+#include "externalSort.h"
 
 void executeCommand();
 
@@ -32,9 +34,19 @@ void executeINSERT();
 void executeUPDATE();
 void executeDELETE();
 void executeSEARCH();
+void executeFLUSH();
+void executeANALYZE();
+void executeEXPLAIN();
 void executeQUIT();
 
 bool evaluateBinOp(int value1, int value2, BinaryOperator binaryOperator);
+bool pageMayMatch(const Table *table, int pageIndex, int columnIndex, BinaryOperator binaryOperator, int value);
+bool pageMayMatch(const Table *table, int pageIndex, const vector<Condition> &conditions);
+bool conditionsHold(const RowBlock &block, int rowIndex, const vector<Condition> &conditions);
+bool conditionsHold(const vector<int> &row, const vector<Condition> &conditions);
+bool parseConditions(const vector<string> &tokens, vector<Condition> &conditions);
+bool resolveConditions(const string &relationName, vector<Condition> &conditions);
+bool searchBuildsIndex(const Table *table, const vector<Condition> &conditions);
 void printRowCount(int rowCount);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "../global.h"
+/**
+ * @brief
+ * SYNTAX: ANALYZE relation_name
+ *
+ * Samples the relation's pages and builds, for every column, a list of its
+ * most common values and an equi-depth histogram of the rest (see
+ * ColumnStatistics). The statistics are kept with the table and written to
+ * "<relation_name>.stats" next to its csv, from where LOAD picks them up
+ * again as long as the csv has not changed since.
+ */
+bool syntacticParseANALYZE()
+{
+	LOG_DEBUG("syntacticParseANALYZE");
+	if (tokenizedQuery.size() != 2)
+	{
+		cout << "SYNTAX ERROR" << endl;
+		return false;
+	}
+	parsedQuery.queryType = ANALYZE;
+	parsedQuery.analyzeRelationName = tokenizedQuery[1];
+	return true;
+}
+
+bool semanticParseANALYZE()
+{
+	LOG_DEBUG("semanticParseANALYZE");
+	if (!tableCatalogue.isTable(parsedQuery.analyzeRelationName))
+	{
+		cout << "SEMANTIC ERROR: Relation doesn't exist" << endl;
+		return false;
+	}
+	return true;
+}
+
+void executeANALYZE()
+{
+	LOG_DEBUG("executeANALYZE");
+	Table *table = tableCatalogue.getTable(parsedQuery.analyzeRelationName);
+	int sampledPages = table->analyze();
+	cout << "Analyzed " << table->tableName << ": sampled " << sampledPages << " of " << table->blockCount << " pages" << endl;
+	for (int columnCounter = 0; columnCounter < table->columnCount; columnCounter++)
+	{
+		const ColumnStatistics &statistics = table->columnStatistics[columnCounter];
+		cout << table->columns[columnCounter] << ": " << statistics.distinctCount << " distinct values";
+		if (!statistics.mostCommonValues.empty())
+		{
+			ostringstream mostCommon;
+			mostCommon << fixed << setprecision(1);
+			for (auto &[value, fraction] : statistics.mostCommonValues)
+				mostCommon << " " << value << " (" << 100 * fraction << "%)";
+			cout << ", most common" << mostCommon.str();
+		}
+		if (statistics.histogramBounds.size() > 1)
+			cout << ", " << statistics.histogramBounds.size() - 1 << " histogram buckets over [" << statistics.histogramBounds.front() << ", " << statistics.histogramBounds.back() << "]";
+		cout << endl;
+	}
+}
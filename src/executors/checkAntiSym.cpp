@@ -10,7 +10,7 @@
 
 bool syntacticParseCHECKANTISYM()
 {
-    logger.log("syntacticParseCHECKANTISYM");
+    LOG_DEBUG("syntacticParseCHECKANTISYM");
 
     if (tokenizedQuery.size() != 3)
     {
@@ -26,7 +26,7 @@ bool syntacticParseCHECKANTISYM()
 
 bool semanticParseCHECKANTISYM()
 {
-    logger.log("semanticParseCHECKANTISYM");
+    LOG_DEBUG("semanticParseCHECKANTISYM");
     if (!matrixCatalogue.isMatrix(parsedQuery.checkAntiSymMatrixName1) ||
         !matrixCatalogue.isMatrix(parsedQuery.checkAntiSymMatrixName2))
     {
@@ -45,7 +45,7 @@ bool semanticParseCHECKANTISYM()
 
 void executeCHECKANTISYM()
 {
-    logger.log("executeCHECKANTISYM");
+    LOG_DEBUG("executeCHECKANTISYM");
     string mat1 = parsedQuery.checkAntiSymMatrixName1;
     string mat2 = parsedQuery.checkAntiSymMatrixName2;
 
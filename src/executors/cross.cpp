@@ -6,7 +6,7 @@
  */
 bool syntacticParseCROSS()
 {
-	logger.log("syntacticParseCROSS");
+	LOG_DEBUG("syntacticParseCROSS");
 	if (tokenizedQuery.size() != 5)
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -21,7 +21,7 @@ bool syntacticParseCROSS()
 
 bool semanticParseCROSS()
 {
-	logger.log("semanticParseCROSS");
+	LOG_DEBUG("semanticParseCROSS");
 	if (tableCatalogue.isTable(parsedQuery.crossResultRelationName))
 	{
 		cout << "SEMANTIC ERROR: Resultant relation already exists" << endl;
@@ -38,10 +38,10 @@ bool semanticParseCROSS()
 
 void executeCROSS()
 {
-	logger.log("executeCROSS");
+	LOG_DEBUG("executeCROSS");
 
-	Table table1 = *(tableCatalogue.getTable(parsedQuery.crossFirstRelationName));
-	Table table2 = *(tableCatalogue.getTable(parsedQuery.crossSecondRelationName));
+	Table &table1 = *(tableCatalogue.getTable(parsedQuery.crossFirstRelationName));
+	Table &table2 = *(tableCatalogue.getTable(parsedQuery.crossSecondRelationName));
 
 	vector<string> columns;
 
@@ -97,5 +97,6 @@ void executeCROSS()
 	}
 	resultantTable->blockify();
 	tableCatalogue.insertTable(resultantTable);
+	bufferManager.mapTable(resultantTable->tableName);
 	return;
 }
\ No newline at end of file
@@ -30,7 +30,7 @@ static void transposeMatrixInPlace(const string &matrixName)
 
 bool syntacticParseCROSSTRANSPOSE()
 {
-	logger.log("syntacticParseCROSSTRANSPOSE");
+	LOG_DEBUG("syntacticParseCROSSTRANSPOSE");
 
 	if (tokenizedQuery.size() != 3)
 	{
@@ -46,7 +46,7 @@ bool syntacticParseCROSSTRANSPOSE()
 
 bool semanticParseCROSSTRANSPOSE()
 {
-	logger.log("semanticParseCROSSTRANSPOSE");
+	LOG_DEBUG("semanticParseCROSSTRANSPOSE");
 	if (!matrixCatalogue.isMatrix(parsedQuery.crossTransposeMatrixName1) ||
 		!matrixCatalogue.isMatrix(parsedQuery.crossTransposeMatrixName2))
 	{
@@ -65,7 +65,7 @@ bool semanticParseCROSSTRANSPOSE()
 
 void executeCROSSTRANSPOSE()
 {
-	logger.log("executeCROSSTRANSPOSE");
+	LOG_DEBUG("executeCROSSTRANSPOSE");
 	string mat1 = parsedQuery.crossTransposeMatrixName1;
 	string mat2 = parsedQuery.crossTransposeMatrixName2;
 
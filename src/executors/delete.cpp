@@ -37,7 +37,7 @@ static bool parseBinOp(const string &tok, BinaryOperator &op)
 
 bool syntacticParseDELETE()
 {
-	logger.log("syntacticParseDELETE");
+	LOG_DEBUG("syntacticParseDELETE");
 	if (tokenizedQuery.size() != 7 ||
 		tokenizedQuery[1] != "FROM" ||
 		tokenizedQuery[3] != "WHERE")
@@ -69,7 +69,7 @@ bool syntacticParseDELETE()
 /* keep semantic & executor dummy */
 bool semanticParseDELETE()
 {
-	logger.log("semanticParseDELETE");
+	LOG_DEBUG("semanticParseDELETE");
 
 	if (!tableCatalogue.isTable(parsedQuery.deleteRelationName))
 	{
@@ -98,9 +98,54 @@ static void writeIntRow(ofstream &fout, const vector<int> &row)
 	fout << '\n';
 }
 
+// Past this many index entry changes per table row, bulk loading an index
+// again is cheaper than changing its entries one by one
+static const double INDEX_REBUILD_CHANGE_RATIO = 0.25;
+
+/**
+ * @brief A row whose index entries a DELETE changes: a deleted row
+ * (toRowIndex -1) or a kept row that rewriting its page moved up to
+ * toRowIndex.
+ */
+struct ChangedRow
+{
+	RecordPointer from;
+	int toRowIndex;
+	vector<int> row;
+};
+
+/**
+ * @brief Brings one index up to date after a DELETE: removes the entries of
+ * the deleted rows, then points the entries of moved rows at their new
+ * position. Deleted entries go first and moved rows follow in page and row
+ * order, so an entry is never added for a position another entry of the same
+ * key still holds.
+ *
+ * @param index
+ * @param deletedRows
+ * @param movedRows
+ */
+static void updateIndexEntries(Index *index, const vector<ChangedRow> &deletedRows, const vector<ChangedRow> &movedRows)
+{
+	int keyColumnCount = index->getKeyColumns().size();
+	for (const ChangedRow &deleted : deletedRows)
+	{
+		IndexKey key = index->keyOf(deleted.row);
+		if (!index->deleteEntry(key, deleted.from))
+			LOG_WARNING("executeDELETE: WARNING - No entry for key " + key.toString(keyColumnCount) + " at {" + to_string(deleted.from.first) + "," + to_string(deleted.from.second) + "} in index '" + index->getIndexName() + "'");
+	}
+	for (const ChangedRow &moved : movedRows)
+	{
+		IndexKey key = index->keyOf(moved.row);
+		if (!index->deleteEntry(key, moved.from))
+			LOG_WARNING("executeDELETE: WARNING - No entry for key " + key.toString(keyColumnCount) + " at {" + to_string(moved.from.first) + "," + to_string(moved.from.second) + "} in index '" + index->getIndexName() + "'");
+		index->insertKey(key, {moved.from.first, moved.toRowIndex});
+	}
+}
+
 void executeDELETE()
 {
-    logger.log("executeDELETE");
+    LOG_DEBUG("executeDELETE");
     Table *table = tableCatalogue.getTable(parsedQuery.deleteRelationName);
     if (!table)
     {
@@ -108,77 +153,23 @@ void executeDELETE()
         return;
     }
 
-    vector<RecordPointer> pointersToDelete; // Store {pageIdx, rowIdxInPage}
-    map<RecordPointer, vector<int>> deletedRowData; // Store actual data for index maintenance {ptr -> rowData}
+    RowBitmap rowsToDelete = pointerBitmap(table); // Marks {pageIdx, rowIdxInPage} of every row to delete
     bool indexUsed = false;
-    BTree *indexToUse = nullptr; // Pointer to the specific index if used
+    Index *indexToUse = nullptr; // Pointer to the specific index if used
 
     // --- 1. Find Rows to Delete ---
-	// Conditions to use index: WHERE column is indexed, operator is EQUAL
-	if (parsedQuery.deleteCondOperator == EQUAL && table->isIndexed(parsedQuery.deleteCondColumn))
+	// The planner decides between the condition column's index (if any) and a scan
+	AccessPlan plan = planAccess(table, table->getColumnIndex(parsedQuery.deleteCondColumn), parsedQuery.deleteCondOperator, parsedQuery.deleteCondValue);
+	if (plan.method != TABLE_SCAN)
 	{
-		indexToUse = table->getIndex(parsedQuery.deleteCondColumn); // Get index for the condition column
-		if (indexToUse != nullptr) // Check if index object actually exists
-		{
-			// ** Use Index Lookup **
-			logger.log("executeDELETE: Using index on column '" + parsedQuery.deleteCondColumn + "' to find rows where key == " + to_string(parsedQuery.deleteCondValue));
-			pointersToDelete = indexToUse->searchKey(parsedQuery.deleteCondValue);
-			indexUsed = true;
-			logger.log("executeDELETE: Index search returned " + to_string(pointersToDelete.size()) + " potential rows.");
-
-			// ** Integrated Pointer Validation Step **
-			size_t originalPointerCount = pointersToDelete.size();
-			pointersToDelete.erase(
-				std::remove_if(pointersToDelete.begin(), pointersToDelete.end(),
-								[&](const RecordPointer &p)
-								{
-									// Check basic bounds: page index valid? row index non-negative?
-									if (p.first < 0 || p.first >= table->blockCount || p.second < 0)
-									{
-										logger.log("executeDELETE: Validation - Removing invalid pointer {page=" + to_string(p.first) + ", row=" + to_string(p.second) + "} (Basic bounds check failed).");
-										return true; // Remove this pointer
-									}
-									// Check if row index is within the bounds for that *specific* page using table metadata
-									if (p.first >= table->rowsPerBlockCount.size())
-									{
-										logger.log("executeDELETE: Validation - Removing invalid pointer {page=" + to_string(p.first) + ", row=" + to_string(p.second) + "} (Page index out of bounds for rowsPerBlockCount lookup).");
-										return true; // Remove this pointer
-									}
-									if (p.second >= table->rowsPerBlockCount[p.first])
-									{
-										logger.log("executeDELETE: Validation - Removing invalid pointer {page=" + to_string(p.first) + ", row=" + to_string(p.second) + "} (Row index >= rows in page " + to_string(table->rowsPerBlockCount[p.first]) + ").");
-										return true; // Remove this pointer
-									}
-									return false; // Keep this pointer
-								}),
-				pointersToDelete.end());
-
-			if (pointersToDelete.size() < originalPointerCount)
-			{
-				logger.log("executeDELETE: Validation - Removed " + to_string(originalPointerCount - pointersToDelete.size()) + " invalid pointers. Valid pointers count: " + to_string(pointersToDelete.size()));
-			}
-			// ** End of Integrated Pointer Validation Step **
-
-			// Fetch row data for valid pointers found via index
-			for (const auto &ptr : pointersToDelete)
-			{
-				Page page = bufferManager.getPage(table->tableName, ptr.first);
-				vector<int> row = page.getRow(ptr.second);
-				if (!row.empty())
-				{
-					deletedRowData[ptr] = row;
-				}
-				else
-				{
-					logger.log("executeDELETE: Warning - Could not fetch row data for pointer {" + to_string(ptr.first) + "," + to_string(ptr.second) + "} found via index. Index might be stale.");
-					// Keep the pointer in pointersToDelete, but it won't have data in deletedRowData for index maintenance.
-				}
-			}
-		}
-		else
-		{
-			logger.log("executeDELETE: Column '" + parsedQuery.deleteCondColumn + "' marked as indexed, but index object is null. Falling back to scan.");
-		}
+		indexToUse = plan.index;
+		LOG_DEBUG("executeDELETE: " + accessMethodName(plan.method) + " on column '" + parsedQuery.deleteCondColumn + "' to find matching rows.");
+		vector<RecordPointer> pointers = indexLookup(plan);
+		// Rows are read when their page is rewritten, so whichever index method
+		// was picked, the pointers only need marking
+		rowsToDelete = pointerBitmap(table, pointers);
+		indexUsed = true;
+		LOG_DEBUG("executeDELETE: Index search returned " + to_string(pointers.size()) + " pointers, " + to_string(rowsToDelete.getRowCount()) + " valid.");
 	}
 
 	// Fallback to Full Table Scan if index not used or not applicable
@@ -186,11 +177,11 @@ void executeDELETE()
 	{
 		if (!table->indexes.empty())
 		{ // Log only if indexes exist but weren't used
-			logger.log("executeDELETE: Index(es) exist but cannot be used for this query (Column='" + parsedQuery.deleteCondColumn + "', Operator=" + to_string(parsedQuery.deleteCondOperator) + "). Performing table scan.");
+			LOG_DEBUG("executeDELETE: Index(es) exist but a scan is cheaper or no index fits this query (Column='" + parsedQuery.deleteCondColumn + "', Operator=" + to_string(parsedQuery.deleteCondOperator) + "). Performing table scan.");
 		}
 		else
 		{
-			logger.log("executeDELETE: Table not indexed or index not usable. Performing table scan.");
+			LOG_DEBUG("executeDELETE: Table not indexed or index not usable. Performing table scan.");
 		}
 
 		int condColIndex = table->getColumnIndex(parsedQuery.deleteCondColumn);
@@ -201,6 +192,8 @@ void executeDELETE()
 		}
 
 		Cursor cursor = table->getCursor();
+		cursor.setPageFilter([&](int pageIndex)
+							 { return pageMayMatch(table, pageIndex, condColIndex, parsedQuery.deleteCondOperator, parsedQuery.deleteCondValue); });
 		vector<int> row = cursor.getNext();
 
 		while (!row.empty())
@@ -214,7 +207,7 @@ void executeDELETE()
 			{
 				if (!(currentPageIndex == 0 && cursor.pagePointer == 1 && currentRowInPage == 0))
 				{
-					logger.log("executeDELETE: Warning - Invalid pointer calculation during scan (Page=" + to_string(currentPageIndex) + ", RowPtr=" + to_string(cursor.pagePointer) + ", RowIdx=" + to_string(currentRowInPage) + "). Skipping row check.");
+					LOG_WARNING("executeDELETE: Warning - Invalid pointer calculation during scan (Page=" + to_string(currentPageIndex) + ", RowPtr=" + to_string(cursor.pagePointer) + ", RowIdx=" + to_string(currentRowInPage) + "). Skipping row check.");
 					row = cursor.getNext();
 					continue;
 				}
@@ -223,87 +216,77 @@ void executeDELETE()
 			// Check row size before accessing column
 			if (condColIndex >= row.size())
 			{
-				logger.log("executeDELETE: Error - Row size mismatch during scan. Row size=" + to_string(row.size()) + ", Cond Idx=" + to_string(condColIndex) + ". Skipping row.");
+				LOG_ERROR("executeDELETE: Error - Row size mismatch during scan. Row size=" + to_string(row.size()) + ", Cond Idx=" + to_string(condColIndex) + ". Skipping row.");
 				row = cursor.getNext();
 				continue;
 			}
 
 			if (evaluateBinOp(row[condColIndex], parsedQuery.deleteCondValue, parsedQuery.deleteCondOperator))
-			{
-				RecordPointer ptr = {currentPageIndex, currentRowInPage};
-				pointersToDelete.push_back(ptr);
-				deletedRowData[ptr] = row; // Store row data for index maintenance
-			}
+				rowsToDelete.set(currentPageIndex, currentRowInPage);
 			row = cursor.getNext();
 		}
-		logger.log("executeDELETE: Scan complete. Found " + to_string(pointersToDelete.size()) + " rows matching criteria.");
+		LOG_DEBUG("executeDELETE: Scan complete. Found " + to_string(rowsToDelete.getRowCount()) + " rows matching criteria.");
 	}
 
     // --- If no rows to delete, exit early ---
-    if (pointersToDelete.empty())
+    if (rowsToDelete.getRowCount() == 0)
     {
         cout << "No rows matched the criteria. 0 rows deleted from table '" << table->tableName << "'." << endl;
-        logger.log("executeDELETE: No rows to delete.");
+        LOG_DEBUG("executeDELETE: No rows to delete.");
         return;
     }
 
-    // --- 2. Group Deletions by Page ---
-    map<int, vector<int>> rowsToDeleteByPage;
-    for (const auto &pointer : pointersToDelete)
-    {
-        rowsToDeleteByPage[pointer.first].push_back(pointer.second);
-    }
-
-    // Sort row indices within each page's list for efficient processing (ascending order)
-    for (auto &pair : rowsToDeleteByPage)
-    {
-        sort(pair.second.begin(), pair.second.end()); // Sort ascending
-    }
-
-    // --- 3. Process Deletions Page by Page ---
-    logger.log("executeDELETE: Processing deletions page by page...");
+    // --- 2. Process Deletions Page by Page, in page order, each page read once ---
+    LOG_DEBUG("executeDELETE: Processing deletions page by page...");
     long long totalRowsDeleted = 0;
     vector<uint> newRowsPerBlockCount = table->rowsPerBlockCount; // Copy to update safely
     bool pageRewriteErrorOccurred = false; // Flag to track if any page failed
+    // Rewriting a page moves every row after a deleted one up, so the index
+    // entries of those rows change along with those of the deleted rows
+    bool trackIndexEntries = !table->indexes.empty();
+    vector<ChangedRow> deletedRows, movedRows;
 
-    for (auto const &[pageIndex, rowIndicesToDelete] : rowsToDeleteByPage)
+    for (int pageIndex : rowsToDelete.getPages())
     {
-        Page page = bufferManager.getPage(table->tableName, pageIndex);
-        int originalRowCount = page.getRowCount(); // Use getter
+        PageHandle page = bufferManager.getPage(table->tableName, pageIndex);
+        int originalRowCount = page->getRowCount(); // Use getter
         if (originalRowCount < 0)
         { // Basic check if getRowCount failed
-            logger.log("executeDELETE: Error - Failed to get row count for page " + to_string(pageIndex) + ". Skipping page.");
+            LOG_ERROR("executeDELETE: Error - Failed to get row count for page " + to_string(pageIndex) + ". Skipping page.");
             pageRewriteErrorOccurred = true; // Mark error and skip this page
             continue;
         }
 
-        vector<vector<int>> keptRows;
-        keptRows.reserve(originalRowCount); // Reserve based on original count
+        vector<int> keptRows; // row-major
+        int keptRowCount = 0;
+        keptRows.reserve((size_t)originalRowCount * table->columnCount); // Reserve based on original count
         bool readErrorOnPage = false;
 
-        int deletePtr = 0; // Pointer into the sorted rowIndicesToDelete vector
+        int deletedOnPage = 0;
+        vector<ChangedRow> deletedOnPageRows, movedOnPageRows;
         for (int i = 0; i < originalRowCount; ++i)
         { // Iterate using row count
-            bool deleteThisRow = false;
-            if (deletePtr < rowIndicesToDelete.size() && i == rowIndicesToDelete[deletePtr])
+            if (rowsToDelete.test(pageIndex, i))
             {
-                // This row index matches the next one in the ascending list to delete
-                deleteThisRow = true;
-                deletePtr++;
+                deletedOnPage++;
+                if (trackIndexEntries)
+                    deletedOnPageRows.push_back({{pageIndex, i}, -1, page->getRowRef(i).toVector()});
             }
-
-            if (!deleteThisRow)
+            else
             {
-                vector<int> currentRow = page.getRow(i); // Use getter
+                RowSpan currentRow = page->getRowRef(i); // Use getter
                 if (currentRow.empty() && i < originalRowCount)
                 { // Check if getRow failed unexpectedly
-                    logger.log("executeDELETE: Error - Failed to get row " + to_string(i) + " from page " + to_string(pageIndex) + " while rebuilding. Skipping page.");
+                    LOG_ERROR("executeDELETE: Error - Failed to get row " + to_string(i) + " from page " + to_string(pageIndex) + " while rebuilding. Skipping page.");
                     readErrorOnPage = true; // Mark error for this page
                     break;					// Stop processing this page
                 }
                 if (!currentRow.empty())
                 { // Only add if row was successfully retrieved
-                    keptRows.push_back(currentRow);
+                    if (trackIndexEntries && keptRowCount != i)
+                        movedOnPageRows.push_back({{pageIndex, i}, keptRowCount, currentRow.toVector()});
+                    keptRows.insert(keptRows.end(), currentRow.begin(), currentRow.end());
+                    keptRowCount++;
                 }
             }
         }
@@ -311,28 +294,31 @@ void executeDELETE()
         // If a read error occurred while processing rows for this page, skip writing it back
         if (readErrorOnPage)
         {
-            logger.log("executeDELETE: Aborting rewrite for page " + to_string(pageIndex) + " due to previous getRow error.");
+            LOG_DEBUG("executeDELETE: Aborting rewrite for page " + to_string(pageIndex) + " due to previous getRow error.");
             pageRewriteErrorOccurred = true; // Mark that an error occurred
             continue;						 // Skip writing this page and updating metadata for it
         }
 
         // Write the modified page back (only if no error occurred for this page)
-        bufferManager.writePage(table->tableName, pageIndex, keptRows, keptRows.size());
-        logger.log("executeDELETE: Rewrote page " + to_string(pageIndex) + " with " + to_string(keptRows.size()) + " rows (deleted " + to_string(rowIndicesToDelete.size()) + ").");
+        bufferManager.writePage(table->tableName, pageIndex, keptRows, keptRowCount, table->columnCount, table->pageLayout);
+        table->setZoneMap(pageIndex, keptRows.data(), keptRowCount);
+        LOG_DEBUG("executeDELETE: Rewrote page " + to_string(pageIndex) + " with " + to_string(keptRowCount) + " rows (deleted " + to_string(deletedOnPage) + ").");
 
         // Update the count for this block in our temporary vector
         if (pageIndex < newRowsPerBlockCount.size())
         {
-            newRowsPerBlockCount[pageIndex] = keptRows.size();
+            newRowsPerBlockCount[pageIndex] = keptRowCount;
         }
         else
         {
-            logger.log("executeDELETE: Error - pageIndex " + to_string(pageIndex) + " out of bounds for newRowsPerBlockCount during update.");
+            LOG_ERROR("executeDELETE: Error - pageIndex " + to_string(pageIndex) + " out of bounds for newRowsPerBlockCount during update.");
             pageRewriteErrorOccurred = true; // Mark error
                                              // This indicates a serious issue if it happens.
         }
         // Accumulate deleted count only if page processing was successful
-        totalRowsDeleted += rowIndicesToDelete.size();
+        totalRowsDeleted += deletedOnPage;
+        move(deletedOnPageRows.begin(), deletedOnPageRows.end(), back_inserter(deletedRows));
+        move(movedOnPageRows.begin(), movedOnPageRows.end(), back_inserter(movedRows));
     }
 
     // --- 4. Update Table Metadata (Only if no page rewrite errors occurred) ---
@@ -347,65 +333,38 @@ void executeDELETE()
     else
     {
         cout << "ERROR: One or more pages could not be processed correctly during delete. Table metadata may be inconsistent." << endl;
-        logger.log("executeDELETE: Errors occurred during page processing. Table metadata update skipped.");
+        LOG_DEBUG("executeDELETE: Errors occurred during page processing. Table metadata update skipped.");
         // Do not update table->rowCount or table->rowsPerBlockCount if errors occurred
         // Index maintenance should also be skipped or handled carefully
     }
 
-    // --- 5. Index Maintenance: Delete entries from ALL indexes (Only if no page rewrite errors) ---
+    // --- 5. Index Maintenance (Only if no page rewrite errors) ---
+    // Every index loses the entries of the deleted rows and has those of the
+    // moved rows pointed at their new position. When that is a large part of
+    // the table, the index is bulk loaded again instead.
     if (totalRowsDeleted > 0 && !table->indexes.empty() && !pageRewriteErrorOccurred)
     {
-        logger.log("executeDELETE: Performing index maintenance for " + to_string(totalRowsDeleted) + " deleted rows...");
-
-        // Iterate through each row that was successfully marked for deletion
-        for (const auto &pointer : pointersToDelete)
+        size_t entryChanges = deletedRows.size() + 2 * movedRows.size();
+        bool rebuild = entryChanges > INDEX_REBUILD_CHANGE_RATIO * (table->rowCount + totalRowsDeleted);
+        LOG_DEBUG("executeDELETE: " + string(rebuild ? "Rebuilding" : "Updating") + " indexes for " + to_string(deletedRows.size()) + " deleted and " + to_string(movedRows.size()) + " moved rows...");
+        for (const auto &[colName, indexPtr] : table->indexes)
         {
-            auto dataIt = deletedRowData.find(pointer);
-            if (dataIt == deletedRowData.end())
-            {
-                logger.log("executeDELETE: Warning - Row data not found for deleted pointer {" + to_string(pointer.first) + "," + to_string(pointer.second) + "}. Skipping index maintenance for this row.");
-                continue; // Skip if we couldn't store the row data earlier
-            }
-            const vector<int> &deletedRow = dataIt->second;
-
-            // Iterate through all indexes on the table
-            for (const auto &[colName, indexPtr] : table->indexes)
-            {
-                if (indexPtr)
-                {
-                    int idx = table->getColumnIndex(colName);
-                    if (idx >= 0 && idx < deletedRow.size())
-                    {
-                        int key = deletedRow[idx];
-
-                        // Use BTree::deleteKey(key) - This removes ALL entries for this key.
-                        // IMPORTANT: BTree::deleteKey needs to handle the case where the key
-                        // might have multiple pointers and only remove the specific one if possible,
-                        // or remove the key entirely if that's the intended behavior.
-                        // Assuming BTree::deleteKey(key) removes the key and all associated pointers.
-                        logger.log("executeDELETE: Calling index->deleteKey(" + to_string(key) + ") for index '" + indexPtr->getIndexName() + "' due to deletion of row at {" + to_string(pointer.first) + "," + to_string(pointer.second) + "}");
-                        if (!indexPtr->deleteKey(key))
-                        {
-                            // This might just mean the key wasn't found (e.g., if index was already inconsistent)
-                            // logger.log("executeDELETE: Info - BTree deleteKey returned false for key " + to_string(key) + " in index '" + indexPtr->getIndexName() + "' (Key might not have been present)."); // Can be verbose
-                        }
-                    }
-                    else
-                    {
-                        logger.log("executeDELETE: Warning - Could not get key for indexed column '" + colName + "' (index " + to_string(idx) + ") from deleted row data.");
-                    }
-                }
-            }
+            if (!indexPtr)
+                continue;
+            if (!rebuild)
+                updateIndexEntries(indexPtr, deletedRows, movedRows);
+            else if (!indexPtr->buildIndex(table))
+                LOG_ERROR("executeDELETE: ERROR - Could not rebuild index '" + indexPtr->getIndexName() + "' on column '" + colName + "'.");
         }
-        logger.log("executeDELETE: Finished index maintenance.");
+        LOG_DEBUG("executeDELETE: Finished index maintenance.");
     }
     else if (totalRowsDeleted > 0 && !pageRewriteErrorOccurred)
     {
-        logger.log("executeDELETE: No indexes found on table '" + table->tableName + "'. Skipping index maintenance.");
+        LOG_DEBUG("executeDELETE: No indexes found on table '" + table->tableName + "'. Skipping index maintenance.");
     }
     else if (pageRewriteErrorOccurred)
     {
-        logger.log("executeDELETE: Skipping index maintenance due to errors during page processing.");
+        LOG_DEBUG("executeDELETE: Skipping index maintenance due to errors during page processing.");
     }
     // --- End Index Maintenance ---
 
@@ -6,7 +6,7 @@
  */
 bool syntacticParseDISTINCT()
 {
-	logger.log("syntacticParseDISTINCT");
+	LOG_DEBUG("syntacticParseDISTINCT");
 	if (tokenizedQuery.size() != 4)
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -20,7 +20,7 @@ bool syntacticParseDISTINCT()
 
 bool semanticParseDISTINCT()
 {
-	logger.log("semanticParseDISTINCT");
+	LOG_DEBUG("semanticParseDISTINCT");
 	// The resultant table shouldn't exist and the table argument should
 	if (tableCatalogue.isTable(parsedQuery.distinctResultRelationName))
 	{
@@ -38,6 +38,6 @@ bool semanticParseDISTINCT()
 
 void executeDISTINCT()
 {
-	logger.log("executeDISTINCT");
+	LOG_DEBUG("executeDISTINCT");
 	return;
 }
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "../global.h"
+/**
+ * @brief
+ * SYNTAX: EXPLAIN query
+ *
+ * query is a SEARCH, DELETE or UPDATE statement. Instead of running it, shows
+ * how its WHERE condition would find the rows (see planAccess): the estimated
+ * number of matching rows, the cost of every access method that could be
+ * used and the one picked. With several conditions, or an index on several
+ * columns, it also shows which conditions the index answers. A SEARCH that
+ * would build an index before running (see searchBuildsIndex) says so.
+ */
+bool syntacticParseEXPLAIN()
+{
+	LOG_DEBUG("syntacticParseEXPLAIN");
+	tokenizedQuery.erase(tokenizedQuery.begin());
+	if (tokenizedQuery.empty() || !syntacticParse())
+		return false;
+	if (parsedQuery.queryType != SEARCH && parsedQuery.queryType != DELETE && parsedQuery.queryType != UPDATE)
+	{
+		cout << "SYNTAX ERROR: EXPLAIN takes a SEARCH, DELETE or UPDATE statement" << endl;
+		return false;
+	}
+	parsedQuery.explainQueryType = parsedQuery.queryType;
+	parsedQuery.queryType = EXPLAIN;
+	return true;
+}
+
+bool semanticParseEXPLAIN()
+{
+	LOG_DEBUG("semanticParseEXPLAIN");
+	if (parsedQuery.explainQueryType == SEARCH)
+		return semanticParseSEARCH();
+	if (parsedQuery.explainQueryType == DELETE)
+		return semanticParseDELETE();
+	return semanticParseUPDATE();
+}
+
+static string binaryOperatorSymbol(BinaryOperator binaryOperator)
+{
+	switch (binaryOperator)
+	{
+	case LESS_THAN:
+		return "<";
+	case GREATER_THAN:
+		return ">";
+	case LEQ:
+		return "<=";
+	case GEQ:
+		return ">=";
+	case EQUAL:
+		return "==";
+	default:
+		return "!=";
+	}
+}
+
+static string conditionsText(const vector<Condition> &conditions)
+{
+	string text;
+	for (const Condition &condition : conditions)
+		text += (text.empty() ? "" : " AND ") + condition.columnName + " " + binaryOperatorSymbol(condition.binaryOperator) + " " + to_string(condition.value);
+	return text;
+}
+
+static void printCost(ostream &out, const AccessPlan &plan, AccessMethod method, double cost)
+{
+	out << (plan.method == method ? "  * " : "    ") << accessMethodName(method) << ": cost " << cost << endl;
+}
+
+void executeEXPLAIN()
+{
+	LOG_DEBUG("executeEXPLAIN");
+	string relationName;
+	vector<Condition> conditions(1);
+	if (parsedQuery.explainQueryType == SEARCH)
+	{
+		relationName = parsedQuery.searchRelationName;
+		conditions = parsedQuery.searchConditions;
+	}
+	else if (parsedQuery.explainQueryType == DELETE)
+	{
+		relationName = parsedQuery.deleteRelationName;
+		conditions[0].columnName = parsedQuery.deleteCondColumn;
+		conditions[0].binaryOperator = parsedQuery.deleteCondOperator;
+		conditions[0].value = parsedQuery.deleteCondValue;
+	}
+	else
+	{
+		relationName = parsedQuery.updateRelationName;
+		conditions[0].columnName = parsedQuery.updateCondColumn;
+		conditions[0].binaryOperator = parsedQuery.updateCondOperator;
+		conditions[0].value = parsedQuery.updateCondValue;
+	}
+
+	Table *table = tableCatalogue.getTable(relationName);
+	if (parsedQuery.explainQueryType == SEARCH && searchBuildsIndex(table, conditions))
+		cout << "SEARCH would first build a B+ Tree index on column '" << conditions[0].columnName << "', which the plan below does not have yet" << endl;
+	AccessPlan plan = planAccess(table, conditions);
+	string columnName = conditions.size() == 1 ? conditions[0].columnName : "any of the columns";
+
+	// Formatting goes to a string stream so cout keeps its own settings
+	ostringstream explanation;
+	explanation << fixed << setprecision(2);
+	explanation << "Condition: " << conditionsText(conditions) << " on " << relationName << endl;
+	explanation << "Estimated rows: " << plan.matchingRows << " of " << table->rowCount << " (" << 100 * plan.selectivity << "%, "
+				<< (plan.fromStatistics ? "from ANALYZE statistics" : "from zone maps and distinct counts") << ")" << endl;
+	explanation << "Pages: " << plan.candidatePages << " of " << table->blockCount << " not ruled out by zone maps, about " << plan.matchingPages << " holding matching rows" << endl;
+	if (plan.probeCost >= 0 && (conditions.size() > 1 || plan.index->getKeyColumns().size() > 1))
+		explanation << "Index: " << (plan.index->getStrategy() == HASH ? "hash" : "B+ Tree") << " index on " << plan.index->getColumnName() << " answers "
+					<< conditionsText(plan.indexConditions) << ", about " << plan.indexRows << " rows to fetch" << endl;
+	printCost(explanation, plan, TABLE_SCAN, plan.scanCost);
+	if (plan.index == nullptr)
+		explanation << "    " << accessMethodName(INDEX_PROBE) << ", " << accessMethodName(BITMAP_HEAP_SCAN) << ": no index on " << columnName << endl;
+	else if (plan.probeCost < 0)
+		explanation << "    " << accessMethodName(INDEX_PROBE) << ", " << accessMethodName(BITMAP_HEAP_SCAN) << ": the hash index on " << columnName << " only answers ==" << endl;
+	else
+	{
+		printCost(explanation, plan, INDEX_PROBE, plan.probeCost);
+		printCost(explanation, plan, BITMAP_HEAP_SCAN, plan.bitmapScanCost);
+	}
+	explanation << "Plan: " << accessMethodName(plan.method) << endl;
+	cout << explanation.str();
+}
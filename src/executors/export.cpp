@@ -7,7 +7,7 @@
 
 bool syntacticParseEXPORT()
 {
-	logger.log("syntacticParseEXPORT");
+	LOG_DEBUG("syntacticParseEXPORT");
 	if (tokenizedQuery.size() != 2)
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -20,7 +20,7 @@ bool syntacticParseEXPORT()
 
 bool semanticParseEXPORT()
 {
-	logger.log("semanticParseEXPORT");
+	LOG_DEBUG("semanticParseEXPORT");
 	// Table should exist
 	if (tableCatalogue.isTable(parsedQuery.exportRelationName))
 		return true;
@@ -30,7 +30,7 @@ bool semanticParseEXPORT()
 
 void executeEXPORT()
 {
-	logger.log("executeEXPORT");
+	LOG_DEBUG("executeEXPORT");
 	Table *table = tableCatalogue.getTable(parsedQuery.exportRelationName);
 	table->makePermanent();
 	return;
@@ -6,7 +6,7 @@
  */
 void executeEXPORTMATRIX()
 {
-	logger.log("executeEXPORTMATRIX");
+	LOG_DEBUG("executeEXPORTMATRIX");
 	Matrix *matrix = matrixCatalogue.getMatrix(parsedQuery.exportMatrixName);
 	matrix->makePermanent();
 	cout << "Exported matrix " << matrix->matrixName << " to file: "
@@ -15,7 +15,7 @@ void executeEXPORTMATRIX()
 
 bool syntacticParseEXPORTMATRIX()
 {
-	logger.log("syntacticParseEXPORTMATRIX");
+	LOG_DEBUG("syntacticParseEXPORTMATRIX");
 	if (tokenizedQuery.size() != 3 || tokenizedQuery[1] != "MATRIX")
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -29,7 +29,7 @@ bool syntacticParseEXPORTMATRIX()
 
 bool semanticParseEXPORTMATRIX()
 {
-	logger.log("semanticParseEXPORTMATRIX");
+	LOG_DEBUG("semanticParseEXPORTMATRIX");
 
 	if (!matrixCatalogue.isMatrix(parsedQuery.exportMatrixName))
 	{
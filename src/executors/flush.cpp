@@ -0,0 +1,31 @@
+#include "../global.h"
+/**
+ * @brief
+ * SYNTAX: FLUSH
+ *
+ * Writes every dirty page held by the buffer manager back to its page file.
+ */
+bool syntacticParseFLUSH()
+{
+	LOG_DEBUG("syntacticParseFLUSH");
+	if (tokenizedQuery.size() != 1)
+	{
+		cout << "SYNTAX ERROR" << endl;
+		return false;
+	}
+	parsedQuery.queryType = FLUSH;
+	return true;
+}
+
+bool semanticParseFLUSH()
+{
+	LOG_DEBUG("semanticParseFLUSH");
+	return true;
+}
+
+void executeFLUSH()
+{
+	LOG_DEBUG("executeFLUSH");
+	bufferManager.flush();
+	cout << "Flushed dirty pages to disk." << endl;
+}
@@ -23,7 +23,7 @@ string getAggregateFunctionName(AggregateFunction func) {
 }
 
 bool syntacticParseGROUPBY() {
-    logger.log("syntacticParseGROUPBY");
+    LOG_DEBUG("syntacticParseGROUPBY");
 
     if (tokenizedQuery.size() < 13) {
         cout << "SYNTAX ERROR: Too few arguments for GROUP BY" << endl;
@@ -129,7 +129,7 @@ bool syntacticParseGROUPBY() {
 }
 
 bool semanticParseGROUPBY() {
-    logger.log("semanticParseGROUPBY");
+    LOG_DEBUG("semanticParseGROUPBY");
 
     // 1) Check if the result table already exists
     if (tableCatalogue.isTable(parsedQuery.groupByResultRelationName)) {
@@ -221,7 +221,7 @@ struct Aggregator {
 };
 
 void executeGROUPBY() {
-    logger.log("executeGROUPBY");
+    LOG_DEBUG("executeGROUPBY");
 
     // 1) Sort the source table on groupByAttribute (in ASC),
     auto oldQuery = parsedQuery;
@@ -248,58 +248,54 @@ void executeGROUPBY() {
 
     Table* resultTable = new Table(parsedQuery.groupByResultRelationName, resultCols);
 
-    // 4) Read rows 1 at a time. If none, done.
+    // 4) Scan the sorted rows a block at a time, touching only the grouping,
+    //    HAVING and RETURN columns. If there are none, done.
     Cursor cursor = sourceTable->getCursor();
-    vector<int> row = cursor.getNext();
-    if (row.empty())
-    {
-        cout << "Empty source table" << endl;
-        delete resultTable;
-        return;
-    }
-
     Aggregator havingAgg(parsedQuery.groupByHavingFunc);
     Aggregator returnAgg(parsedQuery.groupByReturnFunc);
-
-    // track the current group
-    int currentGroupVal = row[groupColIndex];
-
-    // update aggregator
-    havingAgg.update(row[havingColIndex]);
-    returnAgg.update(row[returnColIndex]);
+    bool sawRow = false;
+    int currentGroupVal = 0; // track the current group
 
     // 5) Keep reading
-    row = cursor.getNext();
-    while (!row.empty())
+    RowBlock block;
+    while (cursor.getNextBlock(block))
     {
-        int thisGroupVal = row[groupColIndex];
-        if (thisGroupVal != currentGroupVal)
+        for (int rowCounter = 0; rowCounter < block.rowCount; rowCounter++)
         {
-            // group boundary => finalize old group
-            int havingResult = havingAgg.getFinal();
-            if (evaluateBinaryOperator(havingResult,
-                                       parsedQuery.groupByHavingValue,
-                                       parsedQuery.groupByHavingOperator))
+            int thisGroupVal = block.value(rowCounter, groupColIndex);
+            if (sawRow && thisGroupVal != currentGroupVal)
             {
-                // pass => compute return aggregator
-                int returnResult = returnAgg.getFinal();
-
-                // write row: [groupVal, aggregatedVal]
-                vector<int> outRow = { currentGroupVal, returnResult };
-                resultTable->writeRow<int>(outRow);
+                // group boundary => finalize old group
+                int havingResult = havingAgg.getFinal();
+                if (evaluateBinaryOperator(havingResult,
+                                           parsedQuery.groupByHavingValue,
+                                           parsedQuery.groupByHavingOperator))
+                {
+                    // pass => compute return aggregator
+                    int returnResult = returnAgg.getFinal();
+
+                    // write row: [groupVal, aggregatedVal]
+                    vector<int> outRow = { currentGroupVal, returnResult };
+                    resultTable->writeRow<int>(outRow);
+                }
+
+                // start new group
+                havingAgg = Aggregator(parsedQuery.groupByHavingFunc);
+                returnAgg = Aggregator(parsedQuery.groupByReturnFunc);
             }
-
-            // start new group
+            sawRow = true;
             currentGroupVal = thisGroupVal;
-            havingAgg = Aggregator(parsedQuery.groupByHavingFunc);
-            returnAgg = Aggregator(parsedQuery.groupByReturnFunc);
-        }
-
-        // always update aggregator
-        havingAgg.update(row[havingColIndex]);
-        returnAgg.update(row[returnColIndex]);
 
-        row = cursor.getNext();
+            // always update aggregator
+            havingAgg.update(block.value(rowCounter, havingColIndex));
+            returnAgg.update(block.value(rowCounter, returnColIndex));
+        }
+    }
+    if (!sawRow)
+    {
+        cout << "Empty source table" << endl;
+        delete resultTable;
+        return;
     }
 
     // 6) flush last group
@@ -318,6 +314,7 @@ void executeGROUPBY() {
     // 7) blockify + insert
     if (resultTable->blockify()) {
         tableCatalogue.insertTable(resultTable);
+        bufferManager.mapTable(resultTable->tableName);
         cout << "Group By operation successful" << endl;
     } else {
         cout << "Empty Result. No groups matched the HAVING condition." << endl;
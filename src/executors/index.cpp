@@ -1,34 +1,36 @@
 #include "../global.h"
 #include "../table.h" // Make sure Table definition is included
-#include "../index.h" // Make sure BTree definition is included
+#include "../index.h" // Make sure Index definition is included
 #include <memory>
 
 /**
  * @brief
- * SYNTAX: INDEX ON column_name FROM relation_name USING indexing_strategy
+ * SYNTAX: INDEX ON column_name[, column_name ...] FROM relation_name USING indexing_strategy
  * indexing_strategy: BTREE | HASH | NOTHING
+ *
+ * A B+ tree on several columns is keyed on them in the order listed (see
+ * IndexKey); it is known by the list, so INDEX ON a, b ... USING NOTHING
+ * removes it again.
  */
 bool syntacticParseINDEX()
 {
-	logger.log("syntacticParseINDEX");
-	if (tokenizedQuery.size() != 7 || tokenizedQuery[1] != "ON" || tokenizedQuery[3] != "FROM" || tokenizedQuery[5] != "USING")
+	LOG_DEBUG("syntacticParseINDEX");
+	int size = tokenizedQuery.size();
+	if (size < 7 || tokenizedQuery[1] != "ON" || tokenizedQuery[size - 4] != "FROM" || tokenizedQuery[size - 2] != "USING")
 	{
 		cout << "SYNTAX ERROR: Invalid INDEX syntax." << endl;
-        cout << "Expected: INDEX ON <col> FROM <relation> USING <BTREE|HASH|NOTHING>" << endl;
+        cout << "Expected: INDEX ON <col>[, <col> ...] FROM <relation> USING <BTREE|HASH|NOTHING>" << endl;
 		return false;
 	}
 	parsedQuery.queryType = INDEX;
-	parsedQuery.indexColumnName = tokenizedQuery[2];
-	parsedQuery.indexRelationName = tokenizedQuery[4];
-	string indexingStrategy = tokenizedQuery[6];
+	parsedQuery.indexColumnNames.assign(tokenizedQuery.begin() + 2, tokenizedQuery.end() - 4);
+	parsedQuery.indexColumnName = Index::columnListName(parsedQuery.indexColumnNames);
+	parsedQuery.indexRelationName = tokenizedQuery[size - 3];
+	string indexingStrategy = tokenizedQuery[size - 1];
 	if (indexingStrategy == "BTREE")
 		parsedQuery.indexingStrategy = BTREE;
 	else if (indexingStrategy == "HASH")
-	    // parsedQuery.indexingStrategy = HASH; // HASH not implemented yet
-        {
-            cout << "SYNTAX ERROR: HASH indexing strategy not implemented." << endl;
-		    return false;
-        }
+		parsedQuery.indexingStrategy = HASH;
 	else if (indexingStrategy == "NOTHING")
 		parsedQuery.indexingStrategy = NOTHING;
 	else
@@ -41,20 +43,36 @@ bool syntacticParseINDEX()
 
 bool semanticParseINDEX()
 {
-	logger.log("semanticParseINDEX");
+	LOG_DEBUG("semanticParseINDEX");
 	if (!tableCatalogue.isTable(parsedQuery.indexRelationName))
 	{
 		cout << "SEMANTIC ERROR: Relation '" << parsedQuery.indexRelationName << "' doesn't exist." << endl;
 		return false;
 	}
     Table *table = tableCatalogue.getTable(parsedQuery.indexRelationName);
-    int colIndex = table->getColumnIndex(parsedQuery.indexColumnName); // Check existence and get index
-	if (colIndex < 0) // getColumnIndex returns -1 if not found
-	{
-		// Error message already printed by getColumnIndex
-		cout << "SEMANTIC ERROR: Column '" << parsedQuery.indexColumnName << "' doesn't exist in relation '" << parsedQuery.indexRelationName << "'." << endl;
-		return false;
-	}
+    for (const string &columnName : parsedQuery.indexColumnNames)
+    {
+        if (!table->isColumn(columnName))
+        {
+            cout << "SEMANTIC ERROR: Column '" << columnName << "' doesn't exist in relation '" << parsedQuery.indexRelationName << "'." << endl;
+            return false;
+        }
+        if (count(parsedQuery.indexColumnNames.begin(), parsedQuery.indexColumnNames.end(), columnName) > 1)
+        {
+            cout << "SEMANTIC ERROR: Column '" << columnName << "' is listed more than once." << endl;
+            return false;
+        }
+    }
+    if (parsedQuery.indexColumnNames.size() > 1 && parsedQuery.indexingStrategy == HASH)
+    {
+        cout << "SEMANTIC ERROR: A hash index is on a single column; use BTREE for an index on several columns." << endl;
+        return false;
+    }
+    if (parsedQuery.indexColumnNames.size() > IndexKey::MAX_COLUMNS)
+    {
+        cout << "SEMANTIC ERROR: An index can be on at most " << IndexKey::MAX_COLUMNS << " columns." << endl;
+        return false;
+    }
 
     // Check if an index already exists *on this specific column*
     bool indexExistsOnColumn = table->isIndexed(parsedQuery.indexColumnName);
@@ -82,7 +100,7 @@ bool semanticParseINDEX()
 
 void executeINDEX()
 {
-    logger.log("executeINDEX");
+    LOG_DEBUG("executeINDEX");
 
     Table* table = tableCatalogue.getTable(parsedQuery.indexRelationName);
     if (!table) {
@@ -90,36 +108,40 @@ void executeINDEX()
         cout << "FATAL ERROR: Table '" << parsedQuery.indexRelationName << "' not found during execution." << endl;
         return;
     }
-    int columnIndex = table->getColumnIndex(parsedQuery.indexColumnName);
-    if (columnIndex < 0) {
-        // Semantic parse should prevent this
-        cout << "FATAL ERROR: Column '" << parsedQuery.indexColumnName << "' not found during execution." << endl;
-        return;
+    vector<int> keyColumns;
+    for (const string &columnName : parsedQuery.indexColumnNames) {
+        int columnIndex = table->getColumnIndex(columnName);
+        if (columnIndex < 0) {
+            // Semantic parse should prevent this
+            cout << "FATAL ERROR: Column '" << columnName << "' not found during execution." << endl;
+            return;
+        }
+        keyColumns.push_back(columnIndex);
     }
+    string columns = (keyColumns.size() > 1 ? "columns '" : "column '") + parsedQuery.indexColumnName + "'";
 
-    // std::unique_ptr<BTree> newIndex; // OLD
-    BTree* newIndexPtr = nullptr; // NEW: Use raw pointer, initialize to nullptr
+    Index* newIndexPtr = nullptr;
+    string strategyName = parsedQuery.indexingStrategy == HASH ? "hash" : "B+ Tree";
 
     switch (parsedQuery.indexingStrategy)
     {
         case BTREE:
+        case HASH:
             if (table->isIndexed(parsedQuery.indexColumnName)) {
-                 cout << "Error: executeINDEX called to create BTREE on already indexed column '" << parsedQuery.indexColumnName << "'." << endl;
+                 cout << "Error: executeINDEX called to create an index on already indexed " << columns << "." << endl;
                  return;
             }
-            cout << "Building B+ Tree index on column '" << parsedQuery.indexColumnName
-                 << "' for table '" << parsedQuery.indexRelationName << "'..." << endl;
+            cout << "Building " << strategyName << " index on " << columns
+                 << " for table '" << parsedQuery.indexRelationName << "'..." << endl;
 
-            // Create the B+ Tree object using new
-            // newIndex = std::make_unique<BTree>(table->tableName, parsedQuery.indexColumnName, columnIndex); // OLD
-            newIndexPtr = new BTree(table->tableName, parsedQuery.indexColumnName, columnIndex); // NEW
+            // Create the index object (BTree or HashIndex) using new
+            newIndexPtr = Index::create(parsedQuery.indexingStrategy, table->tableName, parsedQuery.indexColumnName, keyColumns);
 
             // Build the index using data from the table
             if (newIndexPtr->buildIndex(table)) {
                 // Add the successfully built index to the table's map
-                // if (table->addIndex(parsedQuery.indexColumnName, std::move(newIndex))) { // OLD
-                if (table->addIndex(parsedQuery.indexColumnName, newIndexPtr)) { // NEW: Pass raw pointer
-                    cout << "Successfully created B+ Tree index on column '" << parsedQuery.indexColumnName << "'." << endl;
+                if (table->addIndex(parsedQuery.indexColumnName, newIndexPtr)) {
+                    cout << "Successfully created " << strategyName << " index on " << columns << "." << endl;
                     // newIndexPtr is now owned by the table, do not delete here.
                 } else {
                     // This should ideally not happen if semantic check passed
@@ -131,7 +153,7 @@ void executeINDEX()
                     }
                 }
             } else {
-                 cout << "Error: Failed to build B+ Tree index for column '" << parsedQuery.indexColumnName << "'." << endl;
+                 cout << "Error: Failed to build " << strategyName << " index for " << columns << "." << endl;
                  // buildIndex failed, clean up the allocated object
                  if(newIndexPtr) {
                     // dropIndex might have been called internally by buildIndex on failure,
@@ -142,25 +164,29 @@ void executeINDEX()
             }
             break;
 
-        case HASH:
-             cout << "Error: HASH index strategy not implemented." << endl;
-             break;
-
         case NOTHING: // This corresponds to removing an index
              if (!table->isIndexed(parsedQuery.indexColumnName)) {
-                 cout << "Error: executeINDEX called to remove index from non-indexed column '" << parsedQuery.indexColumnName << "'." << endl;
+                 cout << "Error: executeINDEX called to remove index from non-indexed " << columns << "." << endl;
                  return; // Should be caught by semantic parse
              }
 
-             cout << "Removing index on column '" << parsedQuery.indexColumnName
-                  << "' from table '" << parsedQuery.indexRelationName << "'..." << endl;
+             cout << "Removing index on " << columns
+                  << " from table '" << parsedQuery.indexRelationName << "'..." << endl;
+
+             // An index saved by EXPORT would otherwise come back on the next LOAD
+             {
+                 string savedIndexFile = table->getIndex(parsedQuery.indexColumnName)->persistentFileName();
+                 struct stat savedIndexStat;
+                 if (stat(savedIndexFile.c_str(), &savedIndexStat) == 0)
+                     bufferManager.deleteFile(savedIndexFile);
+             }
 
              // Remove the index using the table's method (which now handles deletion)
              if (table->removeIndex(parsedQuery.indexColumnName)) {
-                 cout << "Successfully removed index from column '" << parsedQuery.indexColumnName << "'." << endl;
+                 cout << "Successfully removed index from " << columns << "." << endl;
              } else {
                  // Should not happen if semantic check passed
-                 cout << "Error: Failed to remove index from column '" << parsedQuery.indexColumnName << "' (not found?)." << endl;
+                 cout << "Error: Failed to remove index from " << columns << " (not found?)." << endl;
              }
              break;
 
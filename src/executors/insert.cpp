@@ -15,7 +15,7 @@
 
 bool syntacticParseINSERT()
 {
-	logger.log("syntacticParseINSERT");
+	LOG_DEBUG("syntacticParseINSERT");
 
 	/* Expected token pattern:
 	   0 1     2           3 4 ... n‑2 n‑1
@@ -83,7 +83,7 @@ bool syntacticParseINSERT()
 
 bool semanticParseINSERT()
 {
-	logger.log("semanticParseINSERT");
+	LOG_DEBUG("semanticParseINSERT");
 
 	if (!tableCatalogue.isTable(parsedQuery.insertRelationName))
 	{
@@ -123,7 +123,7 @@ static void buildRow(const Table *table,
 
 void executeINSERT()
 {
-	logger.log("executeINSERT");
+	LOG_DEBUG("executeINSERT");
 
 	Table *table = tableCatalogue.getTable(parsedQuery.insertRelationName);
 	if (!table)
@@ -156,7 +156,7 @@ void executeINSERT()
 	if (table->blockCount == 0)
 	{
 		// Table is currently empty, need to create the first page
-		logger.log("executeINSERT: Table empty, creating first page.");
+		LOG_DEBUG("executeINSERT: Table empty, creating first page.");
 		targetPageIndex = 0;
 		newPageCreated = true;
 	}
@@ -168,14 +168,14 @@ void executeINSERT()
 		if (lastPageIndex >= table->rowsPerBlockCount.size())
 		{
 			cout << "FATAL ERROR: Table metadata mismatch - blockCount inconsistent with rowsPerBlockCount size." << endl;
-			logger.log("executeINSERT: ERROR - Metadata mismatch blockCount=" + to_string(table->blockCount) + " rowsPerBlockCount.size=" + to_string(table->rowsPerBlockCount.size()));
+			LOG_ERROR("executeINSERT: ERROR - Metadata mismatch blockCount=" + to_string(table->blockCount) + " rowsPerBlockCount.size=" + to_string(table->rowsPerBlockCount.size()));
 			return;
 		}
 
 		if (table->rowsPerBlockCount[lastPageIndex] >= table->maxRowsPerBlock)
 		{
 			// Last page is full according to metadata, need a new page
-			logger.log("executeINSERT: Last page full (metadata count " + to_string(table->rowsPerBlockCount[lastPageIndex]) + "), creating new page.");
+			LOG_DEBUG("executeINSERT: Last page full (metadata count " + to_string(table->rowsPerBlockCount[lastPageIndex]) + "), creating new page.");
 			targetPageIndex = table->blockCount; // Index for the new page will be current blockCount
 			newPageCreated = true;
 		}
@@ -183,7 +183,7 @@ void executeINSERT()
 		{
 			// Last page has space according to metadata
 			targetPageIndex = lastPageIndex;
-			logger.log("executeINSERT: Appending to existing page " + to_string(targetPageIndex));
+			LOG_DEBUG("executeINSERT: Appending to existing page " + to_string(targetPageIndex));
 			newPageCreated = false;
 		}
 	}
@@ -191,11 +191,9 @@ void executeINSERT()
 	// 3. Perform the Page Write
 	if (newPageCreated)
 	{
-		// Prepare data for a new page with only the new row
-		vector<vector<int>> newPageData;
-		newPageData.push_back(newRow); // Start with just the new row
-
-		bufferManager.writePage(table->tableName, targetPageIndex, newPageData, 1); // Write 1 row
+		// A new page with only the new row
+		bufferManager.writePage(table->tableName, targetPageIndex, newRow, 1, table->columnCount, table->pageLayout); // Write 1 row
+		table->setZoneMap(targetPageIndex, newRow.data(), 1);
 		rowIndexInPage = 0;															// It's the first row (index 0) in the new page
 
 		// Update table metadata for the new page
@@ -208,118 +206,89 @@ void executeINSERT()
 		else
 		{
 			// This case shouldn't happen if newPageCreated is true based on prior logic
-			logger.log("executeINSERT: Warning - newPageCreated true but targetPageIndex was within bounds. Overwriting rowsPerBlockCount.");
+			LOG_WARNING("executeINSERT: Warning - newPageCreated true but targetPageIndex was within bounds. Overwriting rowsPerBlockCount.");
 			table->rowsPerBlockCount[targetPageIndex] = 1;
 		}
 	}
 	else
 	{
 		// Append to existing page (targetPageIndex is already set)
-		Page page = bufferManager.getPage(table->tableName, targetPageIndex);
+		PageHandle page = bufferManager.getPage(table->tableName, targetPageIndex);
 
 		// *** USE GETTER HERE ***
-		int loadedRowCount = page.getRowCount();
+		int loadedRowCount = page->getRowCount();
 		if (loadedRowCount < 0)
 		{ // Basic check if getRowCount failed or page invalid
 			cout << "FATAL ERROR: Failed to load or get row count for page " << targetPageIndex << "." << endl;
-			logger.log("executeINSERT: Error loading page or getting row count for page " + to_string(targetPageIndex));
+			LOG_ERROR("executeINSERT: Error loading page or getting row count for page " + to_string(targetPageIndex));
 			return;
 		}
 		// Check consistency again (optional, but good practice)
 		if (loadedRowCount >= table->maxRowsPerBlock)
 		{
 			cout << "INTERNAL ERROR: Metadata indicated space, but loaded page reports full." << endl;
-			logger.log("executeINSERT: ERROR - Metadata/Page inconsistency for page " + to_string(targetPageIndex));
+			LOG_ERROR("executeINSERT: ERROR - Metadata/Page inconsistency for page " + to_string(targetPageIndex));
 			// Maybe try creating a new page instead? For now, error out.
 			return;
 		}
 
-		// Need to read all existing rows, append the new one, and write back
-		vector<vector<int>> currentPageData;
-		currentPageData.reserve(loadedRowCount + 1); // Reserve space
-
-		// *** USE GETTER IN LOOP CONDITION (via loadedRowCount) ***
-		for (int i = 0; i < loadedRowCount; ++i)
-		{
-			vector<int> currentRow = page.getRow(i);
-			if (currentRow.empty() && i < loadedRowCount)
-			{ // Handle potential issue where getRow returns empty unexpectedly
-				cout << "FATAL ERROR: Failed to read row " << i << " from page " << targetPageIndex << "." << endl;
-				logger.log("executeINSERT: Error reading row " + to_string(i) + " from page " + to_string(targetPageIndex));
-				return; // Abort if page data seems corrupt
-			}
-			if (!currentRow.empty())
-			{ // Append only if getRow returned something valid
-				currentPageData.push_back(currentRow);
-			}
-		}
-
-		// *** USE GETTER TO DETERMINE INDEX ***
+		// Append in place; the frame is marked dirty and written back by the buffer manager
 		rowIndexInPage = loadedRowCount; // The index where the new row goes (0-based)
-		currentPageData.push_back(newRow);
-
-		bufferManager.writePage(table->tableName, targetPageIndex, currentPageData, currentPageData.size());
+		page.modify().appendRow(newRow);
+		table->widenZoneMap(targetPageIndex, newRow);
 
 		// Update table metadata for the modified page
 		// Ensure the index exists before accessing
 		if (targetPageIndex >= table->rowsPerBlockCount.size())
 		{
 			cout << "FATAL ERROR: Metadata inconsistency - trying to update rowsPerBlockCount for out-of-bounds index " << targetPageIndex << endl;
-			logger.log("executeINSERT: Error updating metadata for existing page - index out of bounds.");
+			LOG_ERROR("executeINSERT: Error updating metadata for existing page - index out of bounds.");
 			return;
 		}
-		table->rowsPerBlockCount[targetPageIndex] = currentPageData.size();
+		table->rowsPerBlockCount[targetPageIndex] = page->getRowCount();
 	}
 
-	// 4. Update total row count for the table
+	// 4. Update total row count and distinct value counts for the table
 	table->rowCount++;
+	table->addDistinctValues(newRow);
+	table->refreshDistinctCounts();
 
 	// 5. Index Maintenance: Update ALL indexes for this table
     if (!table->indexes.empty()) // Check if there are any indexes at all
     {
-        logger.log("executeINSERT: Updating indexes for table '" + table->tableName + "'...");
+        LOG_DEBUG("executeINSERT: Updating indexes for table '" + table->tableName + "'...");
         RecordPointer recordPointer = {targetPageIndex, rowIndexInPage};
 
         // Iterate through all indexes associated with the table
         for (auto const& [columnName, indexPtr] : table->indexes)
         {
             if (indexPtr) { // Check if the unique_ptr holds a valid BTree object
-                logger.log("executeINSERT: Updating index for column '" + columnName + "'");
-                int indexedColIdx = table->getColumnIndex(columnName); // Get index for the column this index is for
-
-                if (indexedColIdx < 0)
-                {
-                    // This indicates an inconsistency between the indexes map and table columns
-                    cout << "INTERNAL ERROR: Column '" << columnName << "' for existing index not found in table schema during INSERT." << endl;
-                    logger.log("executeINSERT: ERROR - Column for index '" + columnName + "' not found.");
-                    // Decide whether to continue updating other indexes or abort. Continuing might be okay.
-                    continue;
-                }
-
-                // Ensure the row has enough columns before accessing
-                if (indexedColIdx >= newRow.size())
+                LOG_DEBUG("executeINSERT: Updating index for column '" + columnName + "'");
+                // Ensure the row has every column of the key before accessing
+                const vector<int> &keyColumns = indexPtr->getKeyColumns();
+                if (*max_element(keyColumns.begin(), keyColumns.end()) >= (int)newRow.size())
                 {
                     cout << "INTERNAL ERROR: Row size mismatch when accessing indexed column '" << columnName << "'." << endl;
-                    logger.log("executeINSERT: ERROR - Row size (" + to_string(newRow.size()) + ") too small for indexed column index (" + to_string(indexedColIdx) + ")");
+                    LOG_ERROR("executeINSERT: ERROR - Row size (" + to_string(newRow.size()) + ") too small for the key columns of index '" + indexPtr->getIndexName() + "'");
                     continue; // Skip updating this index
                 }
 
-                int key = newRow[indexedColIdx];
+                IndexKey key = indexPtr->keyOf(newRow);
                 // Call insertKey on the specific BTree object
-                logger.log("executeINSERT: Calling index->insertKey(" + to_string(key) + ", {" + to_string(recordPointer.first) + "," + to_string(recordPointer.second) + "}) for index on column '" + columnName + "'");
+                LOG_DEBUG("executeINSERT: Calling index->insertKey(" + key.toString(keyColumns.size()) + ", {" + to_string(recordPointer.first) + "," + to_string(recordPointer.second) + "}) for index on column '" + columnName + "'");
                 if (!indexPtr->insertKey(key, recordPointer)) {
-                    logger.log("executeINSERT: Warning - Failed to insert key " + std::to_string(key) + " into index for column '" + columnName + "'.");
+                    LOG_ERROR("executeINSERT: Warning - Failed to insert key " + key.toString(keyColumns.size()) + " into index for column '" + columnName + "'.");
                     // Index might become inconsistent. Consider how to handle this.
                 } else {
-                     // logger.log("executeINSERT: Successfully inserted key " + std::to_string(key) + " into index for column '" + columnName + "'."); // Can be verbose
+                     // LOG_DEBUG("executeINSERT: Successfully inserted key " + key.toString(keyColumns.size()) + " into index for column '" + columnName + "'."); // Can be verbose
                 }
             } else {
-                 logger.log("executeINSERT: Warning - Found null index pointer in map for column '" + columnName + "'. Skipping update.");
+                 LOG_WARNING("executeINSERT: Warning - Found null index pointer in map for column '" + columnName + "'. Skipping update.");
             }
         }
-        logger.log("executeINSERT: Finished updating indexes.");
+        LOG_DEBUG("executeINSERT: Finished updating indexes.");
     } else {
-         logger.log("executeINSERT: No indexes to update for table '" + table->tableName + "'.");
+         LOG_DEBUG("executeINSERT: No indexes to update for table '" + table->tableName + "'.");
     }
 
 	// 6. Print Success Message
@@ -9,7 +9,10 @@
  *   <newRelation> <- JOIN <table1>, <table2> ON <col1> <bin_op> <col2>
  *
  * Implementation:
- * - Partition Hash Join for EQUI (=) condition.
+ * - EQUI (==) condition: Index Nested Loop Join when one side has an index on
+ *   its join column and probing it once per row of the other side is
+ *   estimated to be cheaper than partitioning both; Partition Hash Join
+ *   otherwise.
  * - Nested Loop Join for other conditions (<, >, <=, >=, !=).
  */
 
@@ -84,15 +87,34 @@ static vector<vector<int>> readBucketIntoMemory(const string &bucketFileName, in
         if (success && ss.rdbuf()->in_avail() == 0) { // Ensure no trailing characters
              result.push_back(row);
         } else if (success && ss.rdbuf()->in_avail() != 0) {
-            //logger.log("readBucketIntoMemory: Warning - Trailing characters found in line: " + line);
+            //LOG_WARNING("readBucketIntoMemory: Warning - Trailing characters found in line: " + line);
         } else if (!line.empty()){ // Log if line was not empty but parsing failed
-           // logger.log("readBucketIntoMemory: Warning - Could not parse line: " + line);
+           // LOG_ERROR("readBucketIntoMemory: Warning - Could not parse line: " + line);
         }
     }
 	fin.close();
 	return result;
 }
 
+/**
+ * @brief Estimated cost (in the planner's units) of joining by reading outer
+ * once and looking up each of its rows in the index on inner's join column,
+ * fetching every matching row of inner by its record pointer. Negative if
+ * that column has no index.
+ */
+static double indexNestedLoopJoinCost(Table *outer, Table *inner, int innerColIdx)
+{
+	Index *index = inner->getIndex(inner->columns[innerColIdx]);
+	if (index == nullptr)
+		return -1;
+	double distinctCount = 1;
+	if (innerColIdx < (int)inner->distinctValuesPerColumnCount.size())
+		distinctCount = max<double>(1, inner->distinctValuesPerColumnCount[innerColIdx]);
+	double matchesPerProbe = inner->rowCount / distinctCount;
+	double probeReads = index->estimateLookupPages(inner->rowCount, matchesPerProbe) + matchesPerProbe;
+	return outer->blockCount * SEQUENTIAL_PAGE_COST + outer->rowCount * (probeReads * RANDOM_PAGE_COST + CPU_OPERATOR_COST);
+}
+
 // Helper function to parse binary operators
 static bool parseJoinBinOp(const string &tok, BinaryOperator &op)
 {
@@ -117,7 +139,7 @@ static bool parseJoinBinOp(const string &tok, BinaryOperator &op)
 
 bool syntacticParseJOIN()
 {
-	logger.log("syntacticParseJOIN");
+	LOG_DEBUG("syntacticParseJOIN");
 
 	// Expect 9 tokens: R <- JOIN T1, T2 ON col1 bin_op col2
 	if (tokenizedQuery.size() != 9 || tokenizedQuery[1] != "<-" || tokenizedQuery[2] != "JOIN" || tokenizedQuery[5] != "ON")
@@ -145,7 +167,7 @@ bool syntacticParseJOIN()
 
 bool semanticParseJOIN()
 {
-	logger.log("semanticParseJOIN");
+	LOG_DEBUG("semanticParseJOIN");
 
 	// result must not exist
 	if (tableCatalogue.isTable(parsedQuery.joinResultRelationName))
@@ -175,10 +197,10 @@ bool semanticParseJOIN()
 	return true;
 }
 
-// ============== EXECUTE: PARTITION HASH JOIN (for EQUAL) or NESTED LOOP JOIN ==============
+// ============== EXECUTE: INDEX NESTED LOOP OR PARTITION HASH JOIN (for EQUAL), or NESTED LOOP JOIN ==============
 void executeJOIN()
 {
-	logger.log("executeJOIN");
+	LOG_DEBUG("executeJOIN");
 
 	Table *table1 = tableCatalogue.getTable(parsedQuery.joinFirstRelationName);
 	Table *table2 = tableCatalogue.getTable(parsedQuery.joinSecondRelationName);
@@ -210,9 +232,42 @@ void executeJOIN()
     }
 	Table *resultTable = new Table(parsedQuery.joinResultRelationName, resultColumnNames);
 
-	if (parsedQuery.joinBinaryOperator == EQUAL)
+	// Partitioning reads both tables, writes them out again and reads them back
+	double hashJoinCost = 3 * (table1->blockCount + table2->blockCount) * SEQUENTIAL_PAGE_COST;
+	double probeTable1Cost = indexNestedLoopJoinCost(table2, table1, colIdx1);
+	double probeTable2Cost = indexNestedLoopJoinCost(table1, table2, colIdx2);
+	bool probeTable1 = probeTable1Cost >= 0 && (probeTable2Cost < 0 || probeTable1Cost < probeTable2Cost);
+	double indexJoinCost = probeTable1 ? probeTable1Cost : probeTable2Cost;
+
+	if (parsedQuery.joinBinaryOperator == EQUAL && indexJoinCost >= 0 && indexJoinCost < hashJoinCost)
+	{
+		// The indexed side is the inner relation, looked up once per row of the other
+		Table *outer = probeTable1 ? table2 : table1;
+		Table *inner = probeTable1 ? table1 : table2;
+		int outerColIdx = probeTable1 ? colIdx2 : colIdx1;
+		Index *index = inner->getIndex(inner->columns[probeTable1 ? colIdx1 : colIdx2]);
+		LOG_DEBUG("executeJOIN: Using Index Nested Loop Join on " + index->getIndexName() + " (cost " + to_string(indexJoinCost) +
+				  ", hash join " + to_string(hashJoinCost) + ").");
+
+		Cursor cursor = outer->getCursor();
+		vector<int> outerRow = cursor.getNext();
+		while (!outerRow.empty())
+		{
+			vector<RecordPointer> pointers = index->searchKey(outerRow[outerColIdx]);
+			fetchRows(inner, pointers, INDEX_PROBE, [&](const RecordPointer &, const vector<int> &innerRow)
+					  {
+				// Columns of table1 come first whichever side was probed
+				vector<int> outRow = probeTable1 ? innerRow : outerRow;
+				const vector<int> &row2 = probeTable1 ? outerRow : innerRow;
+				outRow.insert(outRow.end(), row2.begin(), row2.end());
+				resultTable->writeRow<int>(outRow); });
+			outerRow = cursor.getNext();
+		}
+		cout << "Index Nested Loop Join complete." << endl;
+	}
+	else if (parsedQuery.joinBinaryOperator == EQUAL)
 	{
-		logger.log("executeJOIN: Using Partition Hash Join for EQUI-JOIN.");
+		LOG_DEBUG("executeJOIN: Using Partition Hash Join for EQUI-JOIN.");
 		// We'll say 10 blocks => 9 buckets
 		const int MAX_BUFFER_BLOCKS_FOR_JOIN = 10; // Kept original constant for minimal change here
 		int numBuckets = MAX_BUFFER_BLOCKS_FOR_JOIN - 1;
@@ -270,7 +325,7 @@ void executeJOIN()
 	}
 	else // Non-equi-join, use Nested Loop Join
 	{
-		logger.log("executeJOIN: Using Nested Loop Join for NON-EQUI-JOIN.");
+		LOG_DEBUG("executeJOIN: Using Nested Loop Join for NON-EQUI-JOIN.");
 		Cursor cursor1 = table1->getCursor();
 		vector<int> row1 = cursor1.getNext();
 
@@ -282,7 +337,7 @@ void executeJOIN()
 			{
                 // Ensure column indices are valid for the rows
                 if (colIdx1 < 0 || colIdx1 >= row1.size() || colIdx2 < 0 || colIdx2 >= row2.size()) {
-                    logger.log("executeJOIN (NLJ): Column index out of bounds. Skipping row comparison.");
+                    LOG_DEBUG("executeJOIN (NLJ): Column index out of bounds. Skipping row comparison.");
                     // This indicates a severe issue, possibly caught by semantic checks or earlier.
                     // For safety, skip this pair.
                     row2 = cursor2.getNext();
@@ -307,6 +362,7 @@ void executeJOIN()
 	// finalize
 	if (resultTable->blockify()) {
 	    tableCatalogue.insertTable(resultTable);
+	    bufferManager.mapTable(resultTable->tableName);
         cout << "JOIN operation successful. New table \"" << parsedQuery.joinResultRelationName << "\" created." << endl;
     } else {
         cout << "JOIN operation resulted in an empty table or failed to blockify." << endl;
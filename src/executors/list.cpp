@@ -2,27 +2,32 @@
 /**
  * @brief
  * SYNTAX: LIST TABLES
+ *         LIST BUFFER
  */
 bool syntacticParseLIST()
 {
-	logger.log("syntacticParseLIST");
-	if (tokenizedQuery.size() != 2 || tokenizedQuery[1] != "TABLES")
+	LOG_DEBUG("syntacticParseLIST");
+	if (tokenizedQuery.size() != 2 || (tokenizedQuery[1] != "TABLES" && tokenizedQuery[1] != "BUFFER"))
 	{
 		cout << "SYNTAX ERROR" << endl;
 		return false;
 	}
 	parsedQuery.queryType = LIST;
+	parsedQuery.listTarget = tokenizedQuery[1];
 	return true;
 }
 
 bool semanticParseLIST()
 {
-	logger.log("semanticParseLIST");
+	LOG_DEBUG("semanticParseLIST");
 	return true;
 }
 
 void executeLIST()
 {
-	logger.log("executeLIST");
-	tableCatalogue.print();
+	LOG_DEBUG("executeLIST");
+	if (parsedQuery.listTarget == "BUFFER")
+		bufferManager.printStatistics();
+	else
+		tableCatalogue.print();
 }
\ No newline at end of file
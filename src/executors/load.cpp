@@ -1,24 +1,34 @@
 #include "../global.h"
 /**
  * @brief
- * SYNTAX: LOAD relation_name
+ * SYNTAX: LOAD relation_name [USING ROW|PAX]
  */
 bool syntacticParseLOAD()
 {
-	logger.log("syntacticParseLOAD");
-	if (tokenizedQuery.size() != 2)
+	LOG_DEBUG("syntacticParseLOAD");
+	if (tokenizedQuery.size() != 2 && (tokenizedQuery.size() != 4 || tokenizedQuery[2] != "USING"))
 	{
 		cout << "SYNTAX ERROR" << endl;
 		return false;
 	}
 	parsedQuery.queryType = LOAD;
 	parsedQuery.loadRelationName = tokenizedQuery[1];
+	if (tokenizedQuery.size() == 4)
+	{
+		if (tokenizedQuery[3] == "PAX")
+			parsedQuery.loadPageLayout = PAX_LAYOUT;
+		else if (tokenizedQuery[3] != "ROW")
+		{
+			cout << "SYNTAX ERROR: Page layout must be ROW or PAX" << endl;
+			return false;
+		}
+	}
 	return true;
 }
 
 bool semanticParseLOAD()
 {
-	logger.log("semanticParseLOAD");
+	LOG_DEBUG("semanticParseLOAD");
 	if (tableCatalogue.isTable(parsedQuery.loadRelationName))
 	{
 		cout << "SEMANTIC ERROR: Relation already exists" << endl;
@@ -35,14 +45,30 @@ bool semanticParseLOAD()
 
 void executeLOAD()
 {
-	logger.log("executeLOAD");
+	LOG_DEBUG("executeLOAD");
 
 	Table *table = new Table(parsedQuery.loadRelationName);
+	table->pageLayout = parsedQuery.loadPageLayout;
 	if (table->load())
 	{
+		vector<LoadedIndex> loadedIndexes = table->loadIndexes(); // indexes saved by an earlier EXPORT
 		tableCatalogue.insertTable(table);
+		// Scans of a PAX table read the columns they need straight out of the
+		// mapped pages; the first change to the table puts it back on the pool
+		if (table->pageLayout == PAX_LAYOUT)
+			bufferManager.mapTable(table->tableName);
 		cout << "Loaded Table. Column Count: " << table->columnCount
 			 << " Row Count: " << table->rowCount << endl;
+		for (const LoadedIndex &loaded : loadedIndexes)
+		{
+			Index *index = loaded.index;
+			string indexText = string(index->getStrategy() == HASH ? "hash" : "B+ Tree") + " index on " +
+							   (index->getKeyColumns().size() > 1 ? "columns '" : "column '") + index->getColumnName() + "'";
+			if (loaded.rebuilt)
+				cout << "Rebuilt " << indexText << ": the copy saved by EXPORT no longer matches the table." << endl;
+			else
+				cout << "Loaded " << indexText << " saved by EXPORT." << endl;
+		}
 	}
 	return;
 }
\ No newline at end of file
@@ -7,7 +7,7 @@
 
 bool syntacticParseLOADMATRIX()
 {
-	logger.log("syntacticParseLOADMATRIX");
+	LOG_DEBUG("syntacticParseLOADMATRIX");
 	if (tokenizedQuery.size() != 3)
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -20,7 +20,7 @@ bool syntacticParseLOADMATRIX()
 
 bool semanticParseLOADMATRIX()
 {
-	logger.log("semanticParseLOADMATRIX");
+	LOG_DEBUG("semanticParseLOADMATRIX");
 	if (matrixCatalogue.isMatrix(parsedQuery.loadMatrixName))
 	{
 		cout << "SEMANTIC ERROR: Matrix already exists" << endl;
@@ -36,7 +36,7 @@ bool semanticParseLOADMATRIX()
 
 void executeLOADMATRIX()
 {
-	logger.log("executeLOADMATRIX");
+	LOG_DEBUG("executeLOADMATRIX");
 
 	Matrix *matrix = new Matrix(parsedQuery.loadMatrixName);
 
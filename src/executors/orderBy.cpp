@@ -15,7 +15,7 @@ extern void executeSORT(); // We'll re-use the code in sort.cpp
 
 void executeORDERBY()
 {
-	logger.log("executeORDERBY");
+	LOG_DEBUG("executeORDERBY");
 
 	// Get source table
 	Table *sourceTable = tableCatalogue.getTable(parsedQuery.orderByRelationName);
@@ -86,6 +86,7 @@ void executeORDERBY()
 
 	// Add final table to catalogue
 	tableCatalogue.insertTable(resultTable);
+	bufferManager.mapTable(resultTable->tableName);
 
 	// Cleanup temp table
 	tableCatalogue.deleteTable(tempTableName);
@@ -98,7 +99,7 @@ void executeORDERBY()
 
 bool syntacticParseORDERBY()
 {
-	logger.log("syntacticParseORDERBY");
+	LOG_DEBUG("syntacticParseORDERBY");
 
 	// Parse ORDER BY syntax: <newTable> <- ORDER BY <columnName> ASC|DESC ON <oldTable>
 	if (tokenizedQuery.size() != 8)
@@ -135,7 +136,7 @@ bool syntacticParseORDERBY()
 
 bool semanticParseORDERBY()
 {
-	logger.log("semanticParseORDERBY");
+	LOG_DEBUG("semanticParseORDERBY");
 
 	// Verify result table doesn't exist
 	if (tableCatalogue.isTable(parsedQuery.orderByResultRelationName))
@@ -5,7 +5,7 @@
  */
 bool syntacticParsePRINT()
 {
-	logger.log("syntacticParsePRINT");
+	LOG_DEBUG("syntacticParsePRINT");
 	if (tokenizedQuery.size() != 2)
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -18,7 +18,7 @@ bool syntacticParsePRINT()
 
 bool semanticParsePRINT()
 {
-	logger.log("semanticParsePRINT");
+	LOG_DEBUG("semanticParsePRINT");
 	if (!tableCatalogue.isTable(parsedQuery.printRelationName))
 	{
 		cout << "SEMANTIC ERROR: Relation doesn't exist" << endl;
@@ -29,7 +29,7 @@ bool semanticParsePRINT()
 
 void executePRINT()
 {
-	logger.log("executePRINT");
+	LOG_DEBUG("executePRINT");
 	Table *table = tableCatalogue.getTable(parsedQuery.printRelationName);
 	table->print();
 	return;
@@ -2,7 +2,7 @@
 
 bool semanticParsePRINTMATRIX()
 {
-	logger.log("semanticParsePRINTMATRIX");
+	LOG_DEBUG("semanticParsePRINTMATRIX");
 	if (!matrixCatalogue.isMatrix(parsedQuery.printMatrixName))
 	{
 		cout << "SEMANTIC ERROR: Matrix doesn't exist" << endl;
@@ -13,14 +13,14 @@ bool semanticParsePRINTMATRIX()
 
 void executePRINTMATRIX()
 {
-	logger.log("executePRINTMATRIX");
+	LOG_DEBUG("executePRINTMATRIX");
 	Matrix *matrix = matrixCatalogue.getMatrix(parsedQuery.printMatrixName);
 	matrix->print();
 }
 
 bool syntacticParsePRINTMATRIX()
 {
-	logger.log("syntacticParsePRINTMATRIX");
+	LOG_DEBUG("syntacticParsePRINTMATRIX");
 	if (tokenizedQuery.size() != 3)
 	{
 		cout << "SYNTAX ERROR" << endl;
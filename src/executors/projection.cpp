@@ -5,7 +5,7 @@
  */
 bool syntacticParsePROJECTION()
 {
-	logger.log("syntacticParsePROJECTION");
+	LOG_DEBUG("syntacticParsePROJECTION");
 	if (tokenizedQuery.size() < 5 || *(tokenizedQuery.end() - 2) != "FROM")
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -21,7 +21,7 @@ bool syntacticParsePROJECTION()
 
 bool semanticParsePROJECTION()
 {
-	logger.log("semanticParsePROJECTION");
+	LOG_DEBUG("semanticParsePROJECTION");
 
 	if (tableCatalogue.isTable(parsedQuery.projectionResultRelationName))
 	{
@@ -35,7 +35,7 @@ bool semanticParsePROJECTION()
 		return false;
 	}
 
-	Table table = *tableCatalogue.getTable(parsedQuery.projectionRelationName);
+	Table &table = *tableCatalogue.getTable(parsedQuery.projectionRelationName);
 	for (auto col : parsedQuery.projectionColumnList)
 	{
 		if (!table.isColumn(col))
@@ -49,29 +49,29 @@ bool semanticParsePROJECTION()
 
 void executePROJECTION()
 {
-	logger.log("executePROJECTION");
+	LOG_DEBUG("executePROJECTION");
 	Table *resultantTable = new Table(parsedQuery.projectionResultRelationName, parsedQuery.projectionColumnList);
-	Table table = *tableCatalogue.getTable(parsedQuery.projectionRelationName);
+	Table &table = *tableCatalogue.getTable(parsedQuery.projectionRelationName);
+	resultantTable->pageLayout = table.pageLayout;
 	Cursor cursor = table.getCursor();
 	vector<int> columnIndices;
 	for (int columnCounter = 0; columnCounter < parsedQuery.projectionColumnList.size(); columnCounter++)
 	{
 		columnIndices.emplace_back(table.getColumnIndex(parsedQuery.projectionColumnList[columnCounter]));
 	}
-	vector<int> row = cursor.getNext();
 	vector<int> resultantRow(columnIndices.size(), 0);
-
-	while (!row.empty())
+	RowBlock block;
+	while (cursor.getNextBlock(block))
 	{
-
-		for (int columnCounter = 0; columnCounter < columnIndices.size(); columnCounter++)
+		for (int rowCounter = 0; rowCounter < block.rowCount; rowCounter++)
 		{
-			resultantRow[columnCounter] = row[columnIndices[columnCounter]];
+			for (int columnCounter = 0; columnCounter < columnIndices.size(); columnCounter++)
+				resultantRow[columnCounter] = block.value(rowCounter, columnIndices[columnCounter]);
+			resultantTable->writeRow<int>(resultantRow);
 		}
-		resultantTable->writeRow<int>(resultantRow);
-		row = cursor.getNext();
 	}
 	resultantTable->blockify();
 	tableCatalogue.insertTable(resultantTable);
+	bufferManager.mapTable(resultantTable->tableName);
 	return;
 }
\ No newline at end of file
@@ -5,7 +5,7 @@
  */
 bool syntacticParseQUIT()
 {
-	logger.log("syntacticParseQUIT");
+	LOG_DEBUG("syntacticParseQUIT");
 	if (tokenizedQuery.size() != 1)
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -18,13 +18,14 @@ bool syntacticParseQUIT()
 
 bool semanticParseQUIT()
 {
-	logger.log("semanticParseQUIT");
+	LOG_DEBUG("semanticParseQUIT");
 	return true;
 }
 
 void executeQUIT()
 {
-	logger.log("executeQUIT");
+	LOG_DEBUG("executeQUIT");
+	bufferManager.flush();
 	exit(0);
 	return;
 }
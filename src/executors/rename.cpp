@@ -5,7 +5,7 @@
  */
 bool syntacticParseRENAME()
 {
-	logger.log("syntacticParseRENAME");
+	LOG_DEBUG("syntacticParseRENAME");
 	if (tokenizedQuery.size() != 6 || tokenizedQuery[2] != "TO" || tokenizedQuery[4] != "FROM")
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -20,7 +20,7 @@ bool syntacticParseRENAME()
 
 bool semanticParseRENAME()
 {
-	logger.log("semanticParseRENAME");
+	LOG_DEBUG("semanticParseRENAME");
 
 	if (!tableCatalogue.isTable(parsedQuery.renameRelationName))
 	{
@@ -44,7 +44,7 @@ bool semanticParseRENAME()
 
 void executeRENAME()
 {
-	logger.log("executeRENAME");
+	LOG_DEBUG("executeRENAME");
 	Table *table = tableCatalogue.getTable(parsedQuery.renameRelationName);
 	table->renameColumn(parsedQuery.renameFromColumnName, parsedQuery.renameToColumnName);
 	return;
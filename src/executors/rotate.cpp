@@ -3,7 +3,7 @@
 
 bool syntacticParseROTATEMATRIX()
 {
-	logger.log("syntacticParseROTATEMATRIX");
+	LOG_DEBUG("syntacticParseROTATEMATRIX");
 	if (tokenizedQuery.size() != 2)
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -16,7 +16,7 @@ bool syntacticParseROTATEMATRIX()
 
 bool semanticParseROTATEMATRIX()
 {
-	logger.log("semanticParseROTATEMATRIX");
+	LOG_DEBUG("semanticParseROTATEMATRIX");
 	if (!matrixCatalogue.isMatrix(parsedQuery.rotateMatrixName))
 	{
 		cout << "SEMANTIC ERROR: No such matrix loaded" << endl;
@@ -27,7 +27,7 @@ bool semanticParseROTATEMATRIX()
 
 void executeROTATEMATRIX()
 {
-	logger.log("executeROTATEMATRIX");
+	LOG_DEBUG("executeROTATEMATRIX");
 	Matrix *matrix = matrixCatalogue.getMatrix(parsedQuery.rotateMatrixName);
 	int n = matrix->dimension;
 
@@ -2,10 +2,28 @@
 /**
  * @brief
  * SYNTAX: R <- SELECT column_name bin_op [column_name | int_literal] FROM relation_name
+ *         R <- SELECT column_name bin_op int_literal AND column_name bin_op int_literal [AND ...] FROM relation_name
+ *
+ * Conditions against literals, one or several joined by AND, are planned
+ * like those of SEARCH (see planAccess), so an index answering some of them
+ * is used to find the rows when that is cheaper than scanning. A comparison
+ * of two columns is tested on every row.
  */
 bool syntacticParseSELECTION()
 {
-	logger.log("syntacticParseSELECTION");
+	LOG_DEBUG("syntacticParseSELECTION");
+	int size = tokenizedQuery.size();
+	if (size > 8 && tokenizedQuery[size - 2] == "FROM")
+	{
+		parsedQuery.queryType = SELECTION;
+		parsedQuery.selectType = INT_LITERAL;
+		parsedQuery.selectionResultRelationName = tokenizedQuery[0];
+		parsedQuery.selectionRelationName = tokenizedQuery[size - 1];
+		if (!parseConditions(vector<string>(tokenizedQuery.begin() + 3, tokenizedQuery.end() - 2), parsedQuery.selectionConditions))
+			return false;
+		parsedQuery.selectionFirstColumnName = parsedQuery.selectionConditions[0].columnName;
+		return true;
+	}
 	if (tokenizedQuery.size() != 8 || tokenizedQuery[6] != "FROM")
 	{
 		cout << "SYNTAC ERROR" << endl;
@@ -40,6 +58,12 @@ bool syntacticParseSELECTION()
 	{
 		parsedQuery.selectType = INT_LITERAL;
 		parsedQuery.selectionIntLiteral = stoi(secondArgument);
+		// Planned like any conjunction of conditions against literals
+		Condition condition;
+		condition.columnName = parsedQuery.selectionFirstColumnName;
+		condition.binaryOperator = parsedQuery.selectionBinaryOperator;
+		condition.value = parsedQuery.selectionIntLiteral;
+		parsedQuery.selectionConditions = {condition};
 	}
 	else
 	{
@@ -51,7 +75,7 @@ bool syntacticParseSELECTION()
 
 bool semanticParseSELECTION()
 {
-	logger.log("semanticParseSELECTION");
+	LOG_DEBUG("semanticParseSELECTION");
 
 	if (tableCatalogue.isTable(parsedQuery.selectionResultRelationName))
 	{
@@ -65,11 +89,13 @@ bool semanticParseSELECTION()
 		return false;
 	}
 
-	if (!tableCatalogue.isColumnFromTable(parsedQuery.selectionFirstColumnName, parsedQuery.selectionRelationName))
+	if (parsedQuery.selectionConditions.size() <= 1 && !tableCatalogue.isColumnFromTable(parsedQuery.selectionFirstColumnName, parsedQuery.selectionRelationName))
 	{
 		cout << "SEMANTIC ERROR: Column doesn't exist in relation" << endl;
 		return false;
 	}
+	if (!resolveConditions(parsedQuery.selectionRelationName, parsedQuery.selectionConditions))
+		return false;
 
 	if (parsedQuery.selectType == COLUMN)
 	{
@@ -103,15 +129,81 @@ bool evaluateBinOp(int value1, int value2, BinaryOperator binaryOperator)
 	}
 }
 
+/**
+ * @brief Whether any row of page pageIndex of table can satisfy "column
+ * binaryOperator value", going by the page's zone map. Pages without a zone
+ * map always can.
+ *
+ * @param table
+ * @param pageIndex
+ * @param columnIndex
+ * @param binaryOperator
+ * @param value
+ * @return false if the page can be skipped
+ */
+bool pageMayMatch(const Table *table, int pageIndex, int columnIndex, BinaryOperator binaryOperator, int value)
+{
+	if (pageIndex < 0 || pageIndex >= table->zoneMaps.size() || columnIndex < 0 || columnIndex >= table->zoneMaps[pageIndex].size())
+		return true;
+	const ZoneMap &zoneMap = table->zoneMaps[pageIndex][columnIndex];
+	if (zoneMap.minimum > zoneMap.maximum)
+		return false; // no rows
+	switch (binaryOperator)
+	{
+	case LESS_THAN:
+		return zoneMap.minimum < value;
+	case GREATER_THAN:
+		return zoneMap.maximum > value;
+	case LEQ:
+		return zoneMap.minimum <= value;
+	case GEQ:
+		return zoneMap.maximum >= value;
+	case EQUAL:
+		return zoneMap.minimum <= value && value <= zoneMap.maximum;
+	case NOT_EQUAL:
+		return zoneMap.minimum != value || zoneMap.maximum != value;
+	default:
+		return true;
+	}
+}
+
+/**
+ * @brief Whether any row of page pageIndex of table can satisfy all the
+ * conditions, going by the page's zone map.
+ */
+bool pageMayMatch(const Table *table, int pageIndex, const vector<Condition> &conditions)
+{
+	for (const Condition &condition : conditions)
+		if (!pageMayMatch(table, pageIndex, condition.columnIndex, condition.binaryOperator, condition.value))
+			return false;
+	return true;
+}
+
+bool conditionsHold(const RowBlock &block, int rowIndex, const vector<Condition> &conditions)
+{
+	for (const Condition &condition : conditions)
+		if (!evaluateBinOp(block.value(rowIndex, condition.columnIndex), condition.value, condition.binaryOperator))
+			return false;
+	return true;
+}
+
+bool conditionsHold(const vector<int> &row, const vector<Condition> &conditions)
+{
+	for (const Condition &condition : conditions)
+		if (!evaluateBinOp(row[condition.columnIndex], condition.value, condition.binaryOperator))
+			return false;
+	return true;
+}
+
 void executeSELECTION()
 {
-	logger.log("executeSELECTION");
+	LOG_DEBUG("executeSELECTION");
     Table* table_ptr = tableCatalogue.getTable(parsedQuery.selectionRelationName); // Renamed to avoid conflict
     if (table_ptr) {
-        logger.log("executeSELECTION: Source table '" + table_ptr->tableName + "' info:");
-        logger.log("  rowCount: " + to_string(table_ptr->rowCount));
-        logger.log("  blockCount: " + to_string(table_ptr->blockCount));
-        logger.log("  columnCount: " + to_string(table_ptr->columnCount));
+        LOG_DEBUG("executeSELECTION: Source table '" + table_ptr->tableName + "' info:");
+        LOG_DEBUG("  rowCount: " + to_string(table_ptr->rowCount));
+        LOG_DEBUG("  blockCount: " + to_string(table_ptr->blockCount));
+        LOG_DEBUG("  columnCount: " + to_string(table_ptr->columnCount));
         string rpb_str = "  rowsPerBlockCount: ";
         for(size_t i=0; i < table_ptr->rowsPerBlockCount.size(); ++i) {
             rpb_str += to_string(i) + ":" + to_string(table_ptr->rowsPerBlockCount[i]) + " ";
@@ -120,9 +212,9 @@ void executeSELECTION()
                 i = table_ptr->rowsPerBlockCount.size() - 6;
             }
         }
-        logger.log(rpb_str);
+        LOG_DEBUG(rpb_str);
     } else {
-        logger.log("executeSELECTION: Source table '" + parsedQuery.selectionRelationName + "' not found in catalogue!");
+        LOG_DEBUG("executeSELECTION: Source table '" + parsedQuery.selectionRelationName + "' not found in catalogue!");
         // If table not found, we probably should not proceed.
         // Create an empty resultant table and return, or just return.
         // For now, let's ensure a resultantTable object is created if needed by other logic,
@@ -139,45 +231,61 @@ void executeSELECTION()
         return; 
     }
 
-	Table table = *table_ptr; // Use the fetched pointer
-	Table *resultantTable = new Table(parsedQuery.selectionResultRelationName, table.columns);
-	Cursor cursor = table.getCursor();
-    logger.log("executeSELECTION: About to call cursor.getNext() for the first time.");
-	vector<int> row = cursor.getNext();
-    if(row.empty()) {
-        logger.log("executeSELECTION: First call to cursor.getNext() returned an EMPTY row.");
-    } else {
-        string row_str_log_first = "executeSELECTION: First call to cursor.getNext() returned row: "; // Changed variable name
-        for(size_t i=0; i<row.size(); ++i) row_str_log_first += (i==0?"":", ") + to_string(row[i]);
-        logger.log(row_str_log_first);
-    }
-
-	int firstColumnIndex = table.getColumnIndex(parsedQuery.selectionFirstColumnName);
-	int secondColumnIndex;
-	if (parsedQuery.selectType == COLUMN)
-		secondColumnIndex = table.getColumnIndex(parsedQuery.selectionSecondColumnName);
-	while (!row.empty())
+	// Work on the catalogued table itself; a copy would free its indexes when it goes out of scope
+	Table *table = table_ptr;
+	Table *resultantTable = new Table(parsedQuery.selectionResultRelationName, table->columns);
+	resultantTable->pageLayout = table->pageLayout;
+	// Conditions against literals may be answered through an index, comparisons
+	// of two columns always scan
+	const vector<Condition> &conditions = parsedQuery.selectionConditions;
+	AccessPlan plan;
+	if (!conditions.empty())
 	{
-        string row_str_log = "executeSELECTION: Processing row: ";
-        for(size_t i=0; i<row.size(); ++i) row_str_log += (i==0?"":", ") + to_string(row[i]);
-        logger.log(row_str_log);
-
-		int value1 = row[firstColumnIndex];
-		int value2;
-		if (parsedQuery.selectType == INT_LITERAL)
-			value2 = parsedQuery.selectionIntLiteral;
+		plan = planAccess(table, conditions);
+		LOG_DEBUG("executeSELECTION: " + accessMethodName(plan.method) + " planned for about " + to_string((long long)plan.matchingRows) + " row(s).");
+	}
+	if (plan.method != TABLE_SCAN)
+	{
+		// The rows the index finds are tested for the conditions it does not answer
+		fetchRows(table, indexLookup(plan), plan.method, [&](const RecordPointer &, const vector<int> &row)
+				  {
+					  if (conditionsHold(row, conditions))
+						  resultantTable->writeRow<int>(row); });
+	}
+	else
+	{
+		Cursor cursor = table->getCursor();
+		int firstColumnIndex = table->getColumnIndex(parsedQuery.selectionFirstColumnName);
+		int secondColumnIndex = -1;
+		if (parsedQuery.selectType == COLUMN)
+			secondColumnIndex = table->getColumnIndex(parsedQuery.selectionSecondColumnName);
 		else
-			value2 = row[secondColumnIndex];
-		
-        bool eval_res = evaluateBinOp(value1, value2, parsedQuery.selectionBinaryOperator);
-        logger.log("executeSELECTION: Cond Col Val1: " + to_string(value1) + ", Literal/Col Val2: " + to_string(value2) + ", Op: " + to_string(parsedQuery.selectionBinaryOperator) + ", Result: " + (eval_res ? "true" : "false"));
-
-		if (eval_res) // Use the stored result
-			resultantTable->writeRow<int>(row);
-		row = cursor.getNext();
+			cursor.setPageFilter([&](int pageIndex)
+								 { return pageMayMatch(table, pageIndex, conditions); });
+		RowBlock block;
+		vector<int> resultantRow;
+		while (cursor.getNextBlock(block))
+		{
+			for (int rowCounter = 0; rowCounter < block.rowCount; rowCounter++)
+			{
+				bool selected;
+				if (parsedQuery.selectType == COLUMN)
+					selected = evaluateBinOp(block.value(rowCounter, firstColumnIndex), block.value(rowCounter, secondColumnIndex), parsedQuery.selectionBinaryOperator);
+				else
+					selected = conditionsHold(block, rowCounter, conditions);
+				if (selected)
+				{
+					block.copyRow(rowCounter, resultantRow);
+					resultantTable->writeRow<int>(resultantRow);
+				}
+			}
+		}
 	}
 	if (resultantTable->blockify())
+	{
 		tableCatalogue.insertTable(resultantTable);
+		bufferManager.mapTable(resultantTable->tableName);
+	}
 	else
 	{
 		cout << "Empty Table" << endl;
@@ -13,7 +13,7 @@
  */
 
 bool syntacticParseSORT() {
-    logger.log("syntacticParseSORT");
+    LOG_DEBUG("syntacticParseSORT");
 
     // Ensure syntactic correctness
     if (tokenizedQuery.size() < 5 || tokenizedQuery[0] != "SORT" ||
@@ -91,7 +91,7 @@ bool syntacticParseSORT() {
 }
 
 bool semanticParseSORT() {
-    logger.log("semanticParseSORT");
+    LOG_DEBUG("semanticParseSORT");
 
     // no table :(
     if (!tableCatalogue.isTable(parsedQuery.sortRelationName)) {
@@ -112,164 +112,27 @@ bool semanticParseSORT() {
 }
 
 void executeSORT() {
-    logger.log("executeSORT");
+    LOG_DEBUG("executeSORT");
 
     // Get table pointer
     Table *table = tableCatalogue.getTable(parsedQuery.sortRelationName);
 
     // Convert column names to indices and get sort directions
-    vector<int> columnIndices;
-    vector<string> sortDirections;
-
-    for (auto &pair : parsedQuery.sortColumns) {
-        columnIndices.push_back(table->getColumnIndex(pair.first));
-        sortDirections.push_back(pair.second);
-    }
-
-    // buffer of 10
-    const int MAX_BUFFER_BLOCKS = 10;
-
-    // to store sorted runs
-    vector<string> runs;
-    int runCounter = 0;
+    vector<SortKey> sortKeys;
+    for (auto &pair : parsedQuery.sortColumns)
+        sortKeys.push_back({table->getColumnIndex(pair.first), pair.second == "ASC"});
 
     // get a cursor to read rows from the table
     Cursor cursor = table->getCursor();
-
-    // max rows that will fit in buffer
-    int maxRowsInMemory = MAX_BUFFER_BLOCKS * table->maxRowsPerBlock;
-
-    // now we sort the chunks
-    vector<int> row = cursor.getNext();
-    while (!row.empty()){
-        vector<vector<int>> memoryRows;
-
-        while (!row.empty() && memoryRows.size() < maxRowsInMemory){
-            memoryRows.push_back(row);
-            row = cursor.getNext();
-        }
-
-        // no rows :(
-        if (!memoryRows.size())
-            continue;
-
-        // rows! :) Now sort the rows 
-        sort(memoryRows.begin(), memoryRows.end(),
-             [&columnIndices, &sortDirections](const vector<int> &a, const vector<int> &b){
-                 for (size_t i = 0; i < columnIndices.size(); i++){
-                     int col = columnIndices[i];
-                     if (a[col] != b[col])
-                         return sortDirections[i] == "ASC" ? a[col] < b[col] : a[col] > b[col];
-                 }
-                 return false;
-             });
-
-        // store runs in a temp file
-        string runName = table->tableName + "_run_" + to_string(runCounter++);
-        runs.push_back(runName);
-
-        // also store them in a temp table
-        Table *runTable = new Table(runName, table->columns);
-        tableCatalogue.insertTable(runTable);
-
-        for (const auto &sortedRow : memoryRows) {
-            runTable->writeRow<int>(sortedRow);
-        }
-
-        runTable->blockify();
-    }
+    string sortedRunName = externalSort(table->tableName, table->columns, sortKeys, [&cursor]()
+                                        { return cursor.getNext(); });
 
     // no runs :(
-    if (runs.empty()) {
+    if (sortedRunName.empty()) {
         cout << "Table " << table->tableName << " is empty or already sorted" << endl;
         return;
     }
 
-    // mergers & acquisitions
-    while (runs.size() > 1) {
-        vector<string> newRuns;
-
-        // merge MAX_BUFFER_BLOCKS-1 runs at a time (one block reserved for output)
-        for (size_t i = 0; i < runs.size(); i += (MAX_BUFFER_BLOCKS - 1)) {
-            // which runs to merge?
-            vector<string> runsToMerge;
-            for (size_t j = i; j < runs.size() && j < i + (MAX_BUFFER_BLOCKS - 1); j++)
-                runsToMerge.push_back(runs[j]);
-
-            // just go ahead if only one run
-            if (runsToMerge.size() == 1) {
-                newRuns.push_back(runsToMerge[0]);
-                continue;
-            }
-
-            // create merged run table 
-            string mergedRunName = table->tableName + "_run_" + to_string(runCounter++);
-            Table *mergedRunTable = new Table(mergedRunName, table->columns);
-            tableCatalogue.insertTable(mergedRunTable);
-
-            // open cursors for all runs to merge
-            vector<Cursor> cursors;
-            vector<vector<int>> currentRows;
-
-            for (const string &run : runsToMerge) {
-                cursors.emplace_back(run, 0);
-                currentRows.push_back(cursors.back().getNext());
-            }
-
-            // merger
-            while (true) {
-                // find the run with min/max row (depending on sort order)
-                int minRunIndex = -1;
-
-                for (size_t j = 0; j < currentRows.size(); j++) {
-                    if (currentRows[j].empty())
-                        continue;
-
-                    if (minRunIndex == -1)
-                        minRunIndex = j;
-
-                    else {
-                        bool isSmaller = true;
-                        for (size_t k = 0; k < columnIndices.size(); k++) {
-                            int col = columnIndices[k];
-                            if (currentRows[j][col] != currentRows[minRunIndex][col]) {
-                                isSmaller = sortDirections[k] == "ASC" ? currentRows[j][col] < currentRows[minRunIndex][col] : currentRows[j][col] > currentRows[minRunIndex][col];
-                                break;
-                            }
-                        }
-
-                        if (isSmaller)
-                            minRunIndex = j;
-                    }
-                }
-
-                // no more rows :(
-                if (minRunIndex == -1)
-                    break;
-
-                // write min row to the merged run
-                mergedRunTable->writeRow<int>(currentRows[minRunIndex]);
-
-                // get next row from the same run
-                currentRows[minRunIndex] = cursors[minRunIndex].getNext();
-            }
-
-            // blockify the merged run
-            mergedRunTable->blockify();
-
-            // add to new runs
-            newRuns.push_back(mergedRunName);
-
-            // delete the merged runs (except the one just created)
-            for (const string &run : runsToMerge) {
-                tableCatalogue.deleteTable(run);
-            }
-        }
-
-        // Replace old runs with new runs for next pass
-        runs = newRuns;
-    }
-    
     // clear all existing blocks
     for (int i = 0; i < table->blockCount; i++)
         bufferManager.deleteFile(table->tableName, i);
@@ -277,26 +140,27 @@ void executeSORT() {
     // reset all block metadata for table
     table->blockCount = 0;
     table->rowsPerBlockCount.clear();
+    table->zoneMaps.clear();
 
     // write sorted data directly to blocks
     int pageCounter = 0;
-    vector<int> emptyRow(table->columnCount, 0);
-    vector<vector<int>> rowsInPage(table->maxRowsPerBlock, emptyRow);
+    vector<int> rowsInPage((size_t)table->maxRowsPerBlock * table->columnCount);
 
     // get cursor to the sorted run
-    Cursor sortedCursor(runs[0], 0);
+    Cursor sortedCursor(sortedRunName, 0);
     vector<int> sortedRow = sortedCursor.getNext();
 
     while (!sortedRow.empty()) {
 
         for (int colCounter = 0; colCounter < table->columnCount; colCounter++)
-              rowsInPage[pageCounter][colCounter] = sortedRow[colCounter];
+              rowsInPage[(size_t)pageCounter * table->columnCount + colCounter] = sortedRow[colCounter];
 
         pageCounter++;
 
         // if page is full or this was the last row in the current page, write it
         if (pageCounter == table->maxRowsPerBlock || sortedCursor.pagePointer == 0) {
-            bufferManager.writePage(table->tableName, table->blockCount, rowsInPage, pageCounter);
+            bufferManager.writePage(table->tableName, table->blockCount, rowsInPage, pageCounter, table->columnCount, table->pageLayout);
+            table->setZoneMap(table->blockCount, rowsInPage.data(), pageCounter);
             table->blockCount++;
             table->rowsPerBlockCount.emplace_back(pageCounter);
             pageCounter = 0;
@@ -307,13 +171,19 @@ void executeSORT() {
 
     // write any remaining rows in a final block
     if (pageCounter > 0) {
-        bufferManager.writePage(table->tableName, table->blockCount, rowsInPage, pageCounter);
+        bufferManager.writePage(table->tableName, table->blockCount, rowsInPage, pageCounter, table->columnCount, table->pageLayout);
+        table->setZoneMap(table->blockCount, rowsInPage.data(), pageCounter);
         table->blockCount++;
         table->rowsPerBlockCount.emplace_back(pageCounter);
     }
 
     // remove the temp sorted run
-    tableCatalogue.deleteTable(runs[0]);
+    tableCatalogue.deleteTable(sortedRunName);
+
+    // every row has moved, so the indexes point at the old positions
+    for (const auto &[columnName, index] : table->indexes)
+        if (index && !index->buildIndex(table))
+            LOG_ERROR("executeSORT: ERROR - Could not rebuild index '" + index->getIndexName() + "' on column '" + columnName + "'.");
 
     cout << "Table " << table->tableName << " sorted successfully" << endl;
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 
 bool syntacticParseSOURCE()
 {
-	logger.log("syntacticParseSOURCE");
+	LOG_DEBUG("syntacticParseSOURCE");
 	if (tokenizedQuery.size() != 2)
 	{
 		cout << "SYNTAX ERROR" << endl;
@@ -15,7 +15,7 @@ bool syntacticParseSOURCE()
 
 bool semanticParseSOURCE()
 {
-	logger.log("semanticParseSOURCE");
+	LOG_DEBUG("semanticParseSOURCE");
 	if (!isQueryFile(parsedQuery.sourceFileName))
 	{
 		cout << "SEMANTIC ERROR: File doesn't exist" << endl;
@@ -26,7 +26,7 @@ bool semanticParseSOURCE()
 
 void executeSOURCE()
 {
-	logger.log("executeSOURCE");
+	LOG_DEBUG("executeSOURCE");
 
 	string fileName = "../data/" + parsedQuery.sourceFileName + ".ra";
 	ifstream fin(fileName);
@@ -42,7 +42,7 @@ void executeSOURCE()
 
 	while (getline(fin, command))
 	{
-		logger.log(command);
+		LOG_DEBUG(command);
 
 		tokenizedQuery.clear();
 		parsedQuery.clear();
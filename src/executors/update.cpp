@@ -33,7 +33,7 @@ static bool parseBinOp(const string &tok, BinaryOperator &op)
 
 bool syntacticParseUPDATE()
 {
-	logger.log("syntacticParseUPDATE");
+	LOG_DEBUG("syntacticParseUPDATE");
 
 	/* Grammar we accept:
 	   UPDATE table_name WHERE col1 <binop> int_literal SET col2 = int_literal
@@ -113,7 +113,7 @@ bool syntacticParseUPDATE()
 /* semantic & executor remain dummy */
 bool semanticParseUPDATE()
 {
-	logger.log("semanticParseUPDATE");
+	LOG_DEBUG("semanticParseUPDATE");
 
 	/* table must exist */
 	if (!tableCatalogue.isTable(parsedQuery.updateRelationName))
@@ -153,7 +153,7 @@ static void writeIntRow(ofstream &fout, const vector<int> &row)
 
 void executeUPDATE()
 {
-    logger.log("executeUPDATE");
+    LOG_DEBUG("executeUPDATE");
 
     Table *table = tableCatalogue.getTable(parsedQuery.updateRelationName);
     if (!table)
@@ -183,77 +183,41 @@ void executeUPDATE()
     }
 
     long long rowsUpdatedCounter = 0;
-    vector<RecordPointer> pointersToUpdate; // Store {pageIdx, rowIdxInPage}
+    RowBitmap rowsToUpdate = pointerBitmap(table); // Marks {pageIdx, rowIdxInPage} of every row to update
     bool indexUsedForLookup = false;
-    BTree* indexToUse = nullptr; // Pointer to the specific index if used
+    Index* indexToUse = nullptr; // Pointer to the specific index if used
 
     // --- 1. Find Rows to Update ---
-    logger.log("executeUPDATE: Scanning table to find matching rows...");
+    LOG_DEBUG("executeUPDATE: Scanning table to find matching rows...");
 
-    // Conditions to use index for lookup: WHERE column is indexed, operator is EQUAL
-    if (parsedQuery.updateCondOperator == EQUAL && table->isIndexed(parsedQuery.updateCondColumn))
+    // The planner decides between the condition column's index (if any) and a scan
+    AccessPlan plan = planAccess(table, condColIndex, parsedQuery.updateCondOperator, parsedQuery.updateCondValue);
+    if (plan.method != TABLE_SCAN)
     {
-        indexToUse = table->getIndex(parsedQuery.updateCondColumn); // Get index for the condition column
-        if (indexToUse != nullptr) // Check if index object actually exists
-        {
-            // ** Use Index Lookup **
-            logger.log("executeUPDATE: Using index on column '" + parsedQuery.updateCondColumn + "' to find rows where key == " + to_string(parsedQuery.updateCondValue));
-            pointersToUpdate = indexToUse->searchKey(parsedQuery.updateCondValue);
-            indexUsedForLookup = true;
-            logger.log("executeUPDATE: Index search returned " + to_string(pointersToUpdate.size()) + " potential rows.");
-
-            // ** Integrated Pointer Validation Step **
-            size_t originalPointerCount = pointersToUpdate.size();
-            pointersToUpdate.erase(
-                std::remove_if(pointersToUpdate.begin(), pointersToUpdate.end(),
-                               [&](const RecordPointer &p)
-                               {
-                                   // Check basic bounds: page index valid? row index non-negative?
-                                   if (p.first < 0 || p.first >= table->blockCount || p.second < 0)
-                                   {
-                                       logger.log("executeUPDATE: Validation - Removing invalid pointer {page=" + to_string(p.first) + ", row=" + to_string(p.second) + "} (Basic bounds check failed).");
-                                       return true; // Remove this pointer
-                                   }
-                                   // Check if row index is within the bounds for that *specific* page using table metadata
-                                   if (p.first >= table->rowsPerBlockCount.size())
-                                   {
-                                       logger.log("executeUPDATE: Validation - Removing invalid pointer {page=" + to_string(p.first) + ", row=" + to_string(p.second) + "} (Page index out of bounds for rowsPerBlockCount lookup).");
-                                       return true; // Remove this pointer
-                                   }
-                                   if (p.second >= table->rowsPerBlockCount[p.first])
-                                   {
-                                       logger.log("executeUPDATE: Validation - Removing invalid pointer {page=" + to_string(p.first) + ", row=" + to_string(p.second) + "} (Row index >= rows in page " + to_string(table->rowsPerBlockCount[p.first]) + ").");
-                                       return true; // Remove this pointer
-                                   }
-                                   return false; // Keep this pointer
-                               }),
-                pointersToUpdate.end());
-
-            if (pointersToUpdate.size() < originalPointerCount)
-            {
-                logger.log("executeUPDATE: Validation - Removed " + to_string(originalPointerCount - pointersToUpdate.size()) + " invalid pointers. Valid pointers count: " + to_string(pointersToUpdate.size()));
-            }
-            else
-            {
-                // logger.log("executeUPDATE: Validation - All pointers returned by index seem valid based on metadata."); // Can be verbose
-            }
-            // ** End of Integrated Pointer Validation Step **
-        } else {
-             logger.log("executeUPDATE: Column '" + parsedQuery.updateCondColumn + "' marked as indexed, but index object is null. Falling back to scan.");
-        }
+        indexToUse = plan.index;
+        // ** Use Index Lookup **
+        LOG_DEBUG("executeUPDATE: " + accessMethodName(plan.method) + " on column '" + parsedQuery.updateCondColumn + "' to find matching rows.");
+        vector<RecordPointer> pointers = indexLookup(plan);
+        // Rows are updated page by page in storage order, so whichever index
+        // method was picked, the pointers only need marking
+        rowsToUpdate = pointerBitmap(table, pointers);
+        indexUsedForLookup = true;
+        LOG_DEBUG("executeUPDATE: Index search returned " + to_string(pointers.size()) + " pointers, " + to_string(rowsToUpdate.getRowCount()) + " valid.");
     }
     else
     {
         // ** Fallback to Full Table Scan **
         if (!table->indexes.empty()) { // Log only if indexes exist but weren't used
-             logger.log("executeUPDATE: Index(es) exist but cannot be used for this query (Column='" + parsedQuery.updateCondColumn + "', Operator=" + to_string(parsedQuery.updateCondOperator) + "). Performing table scan.");
+             LOG_DEBUG("executeUPDATE: Index(es) exist but a scan is cheaper or no index fits this query (Column='" + parsedQuery.updateCondColumn + "', Operator=" + to_string(parsedQuery.updateCondOperator) + "). Performing table scan.");
         } else {
-             logger.log("executeUPDATE: Table not indexed or index object missing. Performing table scan.");
+             LOG_DEBUG("executeUPDATE: Table not indexed or index object missing. Performing table scan.");
         }
 
         // int condColIndex = table->getColumnIndex(parsedQuery.updateCondColumn); // Already calculated above
 
         Cursor cursor = table->getCursor();
+        cursor.setPageFilter([&](int pageIndex)
+                             { return pageMayMatch(table, pageIndex, condColIndex, parsedQuery.updateCondOperator, parsedQuery.updateCondValue); });
         vector<int> row = cursor.getNext();
 
         while (!row.empty())
@@ -268,7 +232,7 @@ void executeUPDATE()
                 // Check specific case of first row: pageIndex=0, pagePointer=1 -> currentRowInPage=0. This is valid.
                 if (!(currentPageIndex == 0 && cursor.pagePointer == 1 && currentRowInPage == 0))
                 {
-                    logger.log("executeUPDATE: Warning - Invalid pointer calculation during scan (Page=" + to_string(currentPageIndex) + ", RowPtr=" + to_string(cursor.pagePointer) + ", RowIdx=" + to_string(currentRowInPage) + "). Skipping row check.");
+                    LOG_WARNING("executeUPDATE: Warning - Invalid pointer calculation during scan (Page=" + to_string(currentPageIndex) + ", RowPtr=" + to_string(cursor.pagePointer) + ", RowIdx=" + to_string(currentRowInPage) + "). Skipping row check.");
                     row = cursor.getNext();
                     continue; // Skip processing this potentially invalid state
                 }
@@ -279,166 +243,136 @@ void executeUPDATE()
             // Check the WHERE condition
             if (condColIndex < 0)
             { // Check condition column index validity once
-                logger.log("executeUPDATE: Error - Condition column index invalid during scan setup.");
+                LOG_ERROR("executeUPDATE: Error - Condition column index invalid during scan setup.");
                 break; // Stop scan
             }
             if (condColIndex >= row.size())
             {
-                logger.log("executeUPDATE: Error - Row size mismatch during scan. Row size=" + to_string(row.size()) + ", Cond Idx=" + to_string(condColIndex));
+                LOG_ERROR("executeUPDATE: Error - Row size mismatch during scan. Row size=" + to_string(row.size()) + ", Cond Idx=" + to_string(condColIndex));
                 break; // Stop scan if schema mismatch detected
             }
 
             if (evaluateBinOp(row[condColIndex], parsedQuery.updateCondValue, parsedQuery.updateCondOperator))
-            {
-                pointersToUpdate.push_back({currentPageIndex, currentRowInPage});
-            }
+                rowsToUpdate.set(currentPageIndex, currentRowInPage);
             row = cursor.getNext();
         }
-        logger.log("executeUPDATE: Scan complete. Found " + to_string(pointersToUpdate.size()) + " rows matching criteria.");
+        LOG_DEBUG("executeUPDATE: Scan complete. Found " + to_string(rowsToUpdate.getRowCount()) + " rows matching criteria.");
         indexUsedForLookup = false; // Explicitly set for clarity
     }
 
-    // --- 2. Process Updates (Pointer by Pointer) ---
-    // Note: Updating page by page might be slightly more efficient if many rows
-    // are updated on the same page, but pointer by pointer is simpler to implement first.
+    // --- 2. Process Updates (Page by Page) ---
+    // Each marked page is fetched once, in page order, and all its marked rows
+    // are updated while it is pinned.
 
-    logger.log("executeUPDATE: Processing updates...");
-    for (const auto &pointer : pointersToUpdate)
+    LOG_DEBUG("executeUPDATE: Processing updates...");
+    for (int pageIndex : rowsToUpdate.getPages())
     {
-        int pageIndex = pointer.first;
-        int rowIndexInPage = pointer.second;
-
-        logger.log("executeUPDATE: Updating row at {" + to_string(pageIndex) + ", " + to_string(rowIndexInPage) + "}");
-
-        Page page = bufferManager.getPage(table->tableName, pageIndex);
-        int loadedRowCount = page.getRowCount();
-        if (loadedRowCount <= rowIndexInPage)
-        { // Check if row index is valid for the loaded page
-            cout << "ERROR: Row index " << rowIndexInPage << " out of bounds for page " << pageIndex << " (size " << loadedRowCount << ")." << endl;
-            logger.log("executeUPDATE: ERROR - Row index out of bounds for page " + to_string(pageIndex));
-            continue; // Skip this pointer
-        }
-
-        // Get original row data
-        vector<int> originalRow = page.getRow(rowIndexInPage);
-        if (originalRow.empty())
+        PageHandle page = bufferManager.getPage(table->tableName, pageIndex);
+        int loadedRowCount = page->getRowCount();
+        for (int rowIndexInPage = rowsToUpdate.nextRow(pageIndex, 0); rowIndexInPage != -1; rowIndexInPage = rowsToUpdate.nextRow(pageIndex, rowIndexInPage + 1))
         {
-            cout << "ERROR: Failed to read original row " << rowIndexInPage << " from page " << pageIndex << "." << endl;
-            logger.log("executeUPDATE: ERROR - Failed to read original row " + to_string(rowIndexInPage) + " page " + to_string(pageIndex));
-            continue; // Skip this pointer
-        }
+            RecordPointer pointer = {pageIndex, rowIndexInPage};
 
-        // --- Store old key values for ALL indexed columns BEFORE modification ---
-        std::map<string, int> oldIndexedValues; // Map columnName -> oldValue
-        if (!table->indexes.empty()) {
-            for (const auto& [colName, indexPtr] : table->indexes) {
-                if (indexPtr) {
-                    int idx = table->getColumnIndex(colName);
-                    if (idx >= 0 && idx < originalRow.size()) {
-                        oldIndexedValues[colName] = originalRow[idx];
-                    } else {
-                        logger.log("executeUPDATE: Warning - Could not get old value for indexed column '" + colName + "' (index " + to_string(idx) + ").");
-                    }
-                }
-            }
-        }
-        // --- End Store old key values ---
-
-        // Create modified row
-        vector<int> modifiedRow = originalRow;
-        modifiedRow[targetColIndex] = parsedQuery.updateLiteral; // Apply the update
-
-        // --- Get new key value for the TARGET column if it's indexed ---
-        int newTargetKeyValue = modifiedRow[targetColIndex];
-        // --- End Get new key value ---
-
-        // ** Rewrite the entire page **
-        // This is inefficient but necessary without a Page::updateRow method.
-        vector<vector<int>> pageRows;
-        pageRows.reserve(loadedRowCount);
-        bool readError = false;
-        for (int i = 0; i < loadedRowCount; ++i)
-        {
-            if (i == rowIndexInPage)
-            {
-                pageRows.push_back(modifiedRow); // Use the modified row
+            LOG_DEBUG("executeUPDATE: Updating row at {" + to_string(pageIndex) + ", " + to_string(rowIndexInPage) + "}");
+
+            if (loadedRowCount <= rowIndexInPage)
+            { // Check if row index is valid for the loaded page
+                cout << "ERROR: Row index " << rowIndexInPage << " out of bounds for page " << pageIndex << " (size " << loadedRowCount << ")." << endl;
+                LOG_ERROR("executeUPDATE: ERROR - Row index out of bounds for page " + to_string(pageIndex));
+                break; // The rest of the page's rows are out of bounds too
             }
-            else
+
+            // Get original row data
+            vector<int> originalRow = page->getRowRef(rowIndexInPage).toVector();
+            if (originalRow.empty())
             {
-                vector<int> currentRow = page.getRow(i);
-                if (currentRow.empty() && i < loadedRowCount)
-                {
-                    logger.log("executeUPDATE: Error reading row " + to_string(i) + " while rewriting page " + to_string(pageIndex));
-                    readError = true;
-                    break; // Stop processing this page
-                }
-                if (!currentRow.empty())
-                {
-                    pageRows.push_back(currentRow); // Use original row
-                }
+                cout << "ERROR: Failed to read original row " << rowIndexInPage << " from page " << pageIndex << "." << endl;
+                LOG_ERROR("executeUPDATE: ERROR - Failed to read original row " + to_string(rowIndexInPage) + " page " + to_string(pageIndex));
+                continue; // Skip this pointer
             }
-        }
-
-        if (readError)
-        {
-            logger.log("executeUPDATE: Aborting update for page " + to_string(pageIndex) + " due to read error.");
-            continue; // Skip to the next pointer
-        }
 
-        bufferManager.writePage(table->tableName, pageIndex, pageRows, loadedRowCount); // Row count doesn't change
-
-        // ** Index Maintenance: Update ALL affected indexes **
-        if (!table->indexes.empty()) {
-            logger.log("executeUPDATE: Performing index maintenance for updated row at {" + to_string(pageIndex) + "," + to_string(rowIndexInPage) + "}");
-            for (const auto& [colName, indexPtr] : table->indexes) {
-                if (indexPtr) {
-                    int idx = table->getColumnIndex(colName);
-                    if (idx < 0 || idx >= modifiedRow.size()) continue; // Skip if column index invalid
-
-                    int newKey = modifiedRow[idx];
-                    int oldKey = -1; // Default if not found
-                    auto oldValIt = oldIndexedValues.find(colName);
-                    if (oldValIt != oldIndexedValues.end()) {
-                        oldKey = oldValIt->second;
-                    } else {
-                        // This case should ideally not happen if we stored all old values correctly
-                        logger.log("executeUPDATE: Warning - Old key value not found for indexed column '" + colName + "' during maintenance.");
-                        // Attempt to fetch again? Or assume it didn't change? Assuming no change might be risky.
-                        // Let's assume if not found, it didn't change (or wasn't indexed before, which is wrong).
-                        // A safer approach might be to re-fetch the originalRow here if needed.
-                        // For now, we proceed assuming oldKey = newKey if not found in map.
-                        oldKey = newKey;
+            // --- Store old key values for ALL indexed columns BEFORE modification ---
+            std::map<string, IndexKey> oldIndexedValues; // Map index column list -> old key
+            if (!table->indexes.empty()) {
+                for (const auto& [colName, indexPtr] : table->indexes) {
+                    if (indexPtr) {
+                        oldIndexedValues[colName] = indexPtr->keyOf(originalRow);
                     }
-
-
-                    // Only update the index if the key value for *this specific index's column* changed
-                    if (oldKey != newKey) {
-                        logger.log("executeUPDATE: Value changed for indexed column '" + colName + "' (Old: " + to_string(oldKey) + ", New: " + to_string(newKey) + "). Updating index.");
-
-                        // Use BTree::deleteKey(key) - This removes ALL entries for the old key.
-                        logger.log("executeUPDATE: Calling index->deleteKey(" + to_string(oldKey) + ") for index '" + indexPtr->getIndexName() + "'");
-                        if (!indexPtr->deleteKey(oldKey)) {
-                            logger.log("executeUPDATE: WARNING - BTree deleteKey returned false for old key " + to_string(oldKey) + " in index '" + indexPtr->getIndexName() + "'");
-                            // Potential inconsistency: old entry might still be there.
+                }
+            }
+            // --- End Store old key values ---
+
+            // Create modified row
+            vector<int> modifiedRow = originalRow;
+            modifiedRow[targetColIndex] = parsedQuery.updateLiteral; // Apply the update
+
+            // --- Get new key value for the TARGET column if it's indexed ---
+            int newTargetKeyValue = modifiedRow[targetColIndex];
+            // --- End Get new key value ---
+
+            // ** Update the row in place **
+            // The frame is marked dirty, so several updates to one page cost a single write-back.
+            page.modify().setRow(rowIndexInPage, modifiedRow);
+            table->widenZoneMap(pageIndex, modifiedRow);
+            table->addDistinctValues(modifiedRow);
+
+            // ** Index Maintenance: Update ALL affected indexes **
+            if (!table->indexes.empty()) {
+                LOG_DEBUG("executeUPDATE: Performing index maintenance for updated row at {" + to_string(pageIndex) + "," + to_string(rowIndexInPage) + "}");
+                for (const auto& [colName, indexPtr] : table->indexes) {
+                    if (indexPtr) {
+                        // Keys not on the updated column stay as they are
+                        if (!indexPtr->hasKeyColumn(targetColIndex)) continue;
+                        int keyColumnCount = indexPtr->getKeyColumns().size();
+
+                        IndexKey newKey = indexPtr->keyOf(modifiedRow);
+                        IndexKey oldKey; // Default if not found
+                        auto oldValIt = oldIndexedValues.find(colName);
+                        if (oldValIt != oldIndexedValues.end()) {
+                            oldKey = oldValIt->second;
+                        } else {
+                            // This case should ideally not happen if we stored all old values correctly
+                            LOG_WARNING("executeUPDATE: Warning - Old key value not found for indexed column '" + colName + "' during maintenance.");
+                            // Attempt to fetch again? Or assume it didn't change? Assuming no change might be risky.
+                            // Let's assume if not found, it didn't change (or wasn't indexed before, which is wrong).
+                            // A safer approach might be to re-fetch the originalRow here if needed.
+                            // For now, we proceed assuming oldKey = newKey if not found in map.
+                            oldKey = newKey;
                         }
 
-                        // Use BTree::insertKey(key, pointer)
-                        logger.log("executeUPDATE: Calling index->insertKey(" + to_string(newKey) + ", {" + to_string(pageIndex) + "," + to_string(rowIndexInPage) + "}) for index '" + indexPtr->getIndexName() + "'");
-                        if (!indexPtr->insertKey(newKey, pointer)) {
-                            logger.log("executeUPDATE: WARNING - BTree insertKey returned false for new key " + to_string(newKey) + " in index '" + indexPtr->getIndexName() + "'");
-                            // Potential inconsistency: new entry might be missing.
+
+                        // Only update the index if the key value for *this specific index's column* changed
+                        if (oldKey != newKey) {
+                            LOG_DEBUG("executeUPDATE: Value changed for indexed column '" + colName + "' (Old: " + oldKey.toString(keyColumnCount) + ", New: " + newKey.toString(keyColumnCount) + "). Updating index.");
+
+                            // Only this row's entry goes, other rows with the old key keep theirs
+                            LOG_DEBUG("executeUPDATE: Calling index->deleteEntry(" + oldKey.toString(keyColumnCount) + ", {" + to_string(pageIndex) + "," + to_string(rowIndexInPage) + "}) for index '" + indexPtr->getIndexName() + "'");
+                            if (!indexPtr->deleteEntry(oldKey, pointer)) {
+                                LOG_WARNING("executeUPDATE: WARNING - deleteEntry returned false for old key " + oldKey.toString(keyColumnCount) + " in index '" + indexPtr->getIndexName() + "'");
+                                // Potential inconsistency: old entry might still be there.
+                            }
+
+                            // Use BTree::insertKey(key, pointer)
+                            LOG_DEBUG("executeUPDATE: Calling index->insertKey(" + newKey.toString(keyColumnCount) + ", {" + to_string(pageIndex) + "," + to_string(rowIndexInPage) + "}) for index '" + indexPtr->getIndexName() + "'");
+                            if (!indexPtr->insertKey(newKey, pointer)) {
+                                LOG_WARNING("executeUPDATE: WARNING - BTree insertKey returned false for new key " + newKey.toString(keyColumnCount) + " in index '" + indexPtr->getIndexName() + "'");
+                                // Potential inconsistency: new entry might be missing.
+                            }
+                        } else {
+                            // LOG_DEBUG("executeUPDATE: Value for indexed column '" + colName + "' did not change. No update needed for this index."); // Can be verbose
                         }
-                    } else {
-                        // logger.log("executeUPDATE: Value for indexed column '" + colName + "' did not change. No update needed for this index."); // Can be verbose
                     }
                 }
             }
-        }
-        // --- End Index Maintenance ---
+            // --- End Index Maintenance ---
 
-        rowsUpdatedCounter++;
+            rowsUpdatedCounter++;
+        }
     }
 
+    if (rowsUpdatedCounter > 0)
+        table->refreshDistinctCounts();
+
     // --- 3. Print Result ---
     cout << rowsUpdatedCounter << " row(s) updated in \"" << table->tableName << "\"." << endl;
     // table->rowCount remains unchanged.
@@ -0,0 +1,127 @@
+#include "global.h"
+
+static bool sortsBefore(const vector<int> &a, const vector<int> &b, const vector<SortKey> &sortKeys)
+{
+	for (const SortKey &sortKey : sortKeys)
+	{
+		int col = sortKey.columnIndex;
+		if (a[col] != b[col])
+			return sortKey.ascending ? a[col] < b[col] : a[col] > b[col];
+	}
+	return false;
+}
+
+/**
+ * @brief Writes rows out as the temporary table runName and returns it.
+ */
+static Table *writeRun(const string &runName, const vector<string> &columns, const vector<vector<int>> &rows)
+{
+	Table *runTable = new Table(runName, columns);
+	tableCatalogue.insertTable(runTable);
+	ofstream fout(runTable->sourceFileName, ios::app);
+	for (const auto &row : rows)
+		runTable->writeRow<int>(row, fout);
+	fout.close();
+	runTable->blockify();
+	return runTable;
+}
+
+string externalSort(const string &runPrefix, const vector<string> &columns, const vector<SortKey> &sortKeys, const function<vector<int>()> &nextRow)
+{
+	LOG_DEBUG("externalSort");
+	vector<string> runs;
+	int runCounter = 0;
+
+	// max rows that will fit in buffer
+	uint maxRowsPerBlock = max<uint>(1, (BLOCK_SIZE * 1000) / (sizeof(int) * columns.size()));
+	size_t maxRowsInMemory = (size_t)SORT_BUFFER_BLOCKS * maxRowsPerBlock;
+
+	// now we sort the chunks
+	vector<int> row = nextRow();
+	while (!row.empty())
+	{
+		vector<vector<int>> memoryRows;
+		while (!row.empty() && memoryRows.size() < maxRowsInMemory)
+		{
+			memoryRows.push_back(row);
+			row = nextRow();
+		}
+
+		sort(memoryRows.begin(), memoryRows.end(), [&sortKeys](const vector<int> &a, const vector<int> &b)
+			 { return sortsBefore(a, b, sortKeys); });
+
+		string runName = runPrefix + "_run_" + to_string(runCounter++);
+		writeRun(runName, columns, memoryRows);
+		runs.push_back(runName);
+	}
+
+	if (runs.empty())
+		return "";
+
+	// mergers & acquisitions
+	while (runs.size() > 1)
+	{
+		vector<string> newRuns;
+
+		// merge SORT_BUFFER_BLOCKS-1 runs at a time (one block reserved for output)
+		for (size_t i = 0; i < runs.size(); i += (SORT_BUFFER_BLOCKS - 1))
+		{
+			vector<string> runsToMerge;
+			for (size_t j = i; j < runs.size() && j < i + (SORT_BUFFER_BLOCKS - 1); j++)
+				runsToMerge.push_back(runs[j]);
+
+			// just go ahead if only one run
+			if (runsToMerge.size() == 1)
+			{
+				newRuns.push_back(runsToMerge[0]);
+				continue;
+			}
+
+			string mergedRunName = runPrefix + "_run_" + to_string(runCounter++);
+			Table *mergedRunTable = new Table(mergedRunName, columns);
+			tableCatalogue.insertTable(mergedRunTable);
+			ofstream fout(mergedRunTable->sourceFileName, ios::app);
+
+			// open cursors for all runs to merge
+			vector<Cursor> cursors;
+			vector<vector<int>> currentRows;
+			for (const string &run : runsToMerge)
+			{
+				cursors.emplace_back(run, 0);
+				currentRows.push_back(cursors.back().getNext());
+			}
+
+			while (true)
+			{
+				// find the run whose current row comes first (the last such run on ties)
+				int minRunIndex = -1;
+				for (size_t j = 0; j < currentRows.size(); j++)
+				{
+					if (currentRows[j].empty())
+						continue;
+					if (minRunIndex == -1 || !sortsBefore(currentRows[minRunIndex], currentRows[j], sortKeys))
+						minRunIndex = j;
+				}
+
+				// no more rows :(
+				if (minRunIndex == -1)
+					break;
+
+				mergedRunTable->writeRow<int>(currentRows[minRunIndex], fout);
+				currentRows[minRunIndex] = cursors[minRunIndex].getNext();
+			}
+			fout.close();
+			mergedRunTable->blockify();
+			newRuns.push_back(mergedRunName);
+
+			// the merged runs are no longer needed
+			cursors.clear();
+			for (const string &run : runsToMerge)
+				tableCatalogue.deleteTable(run);
+		}
+
+		// Replace old runs with new runs for next pass
+		runs = newRuns;
+	}
+	return runs[0];
+}
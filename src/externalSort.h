@@ -0,0 +1,32 @@
+#ifndef EXTERNALSORT_H
+#define EXTERNALSORT_H
+
+#pragma once
+#include "logger.h"
+#include <functional>
+
+// Pages of rows sorted in memory at a time, one of them kept for output while merging
+const int SORT_BUFFER_BLOCKS = 10;
+
+/**
+ * @brief One column to sort on and its direction.
+ */
+struct SortKey
+{
+	int columnIndex;
+	bool ascending = true;
+};
+
+/**
+ * @brief External merge sort of the rows handed out by nextRow (until it
+ * returns an empty row), shared by SORT and by B+ tree bulk loading.
+ *
+ * Runs of SORT_BUFFER_BLOCKS pages of rows are sorted in memory and written
+ * out as temporary tables named "<runPrefix>_run_<n>", which are then merged
+ * SORT_BUFFER_BLOCKS - 1 at a time until one is left. That table is in the
+ * catalogue and its name is returned; the caller reads it with a Cursor and
+ * deletes it. Returns "" if there were no rows.
+ */
+string externalSort(const string &runPrefix, const vector<string> &columns, const vector<SortKey> &sortKeys, const function<vector<int>()> &nextRow);
+
+#endif
@@ -9,9 +9,16 @@
 extern float BLOCK_SIZE;
 extern uint BLOCK_COUNT;
 extern uint PRINT_COUNT;
+extern bool TEXT_PAGES;
+extern bool COMPRESS_PAGES;
+extern uint READ_AHEAD;
+extern uint INDEX_FILL_FACTOR;
+extern bool EXACT_DISTINCT;
+extern int HLL_PRECISION;
 extern vector<string> tokenizedQuery;
 extern ParsedQuery parsedQuery;
 extern TableCatalogue tableCatalogue;
+extern StorageManager storageManager;
 extern BufferManager bufferManager;
 extern MatrixCatalogue matrixCatalogue;
 
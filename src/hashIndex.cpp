@@ -0,0 +1,336 @@
+#include "hashIndex.h"
+#include "global.h"
+
+// Layout of a bucket page: a header row followed by one row per entry
+static const int BUCKET_COLUMNS = 3; // key, pageIndex, rowIndex
+static const int LOCAL_DEPTH_OFFSET = 0;
+static const int ENTRY_COUNT_OFFSET = 1;
+static const int OVERFLOW_PAGE_OFFSET = 2;
+
+HashIndex::HashIndex(const std::string& tblName, const std::string& colName, const std::vector<int>& keyCols) :
+    Index(tblName, colName, keyCols, tblName + "_" + colName + "_hash"),
+    globalDepth(0),
+    pageCount(0)
+{
+    bucketCapacity = std::max(1, (int)(BLOCK_SIZE * 1000 / (BUCKET_COLUMNS * sizeof(int))) - 1);
+    LOG_DEBUG("HashIndex::HashIndex - Bucket capacity: " + std::to_string(bucketCapacity));
+}
+
+// Spreads keys that differ only in their high bits (or are multiples of a
+// power of two) over the low bits the directory is indexed with
+uint32_t HashIndex::hashKey(int key) {
+    uint32_t hash = (uint32_t)key;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+/**
+ * @brief Reads every entry of the bucket at bucketPageIndex and its overflow
+ * pages into entries, and the overflow page indices into overflowPages.
+ *
+ * @return the bucket's local depth
+ */
+int HashIndex::readChain(int bucketPageIndex, std::vector<std::vector<int>>& entries, std::vector<int>& overflowPages) {
+    int localDepth = 0;
+    for (int pageIndex = bucketPageIndex; pageIndex != -1;) {
+        PageHandle page = bufferManager.getPage(indexName, pageIndex);
+        RowSpan header = page->getRowRef(0);
+        if (header.size() != BUCKET_COLUMNS) {
+            LOG_ERROR("HashIndex::readChain - ERROR: Bucket page " + std::to_string(pageIndex) + " of " + indexName + " is unreadable");
+            break;
+        }
+        if (pageIndex == bucketPageIndex)
+            localDepth = header[LOCAL_DEPTH_OFFSET];
+        else
+            overflowPages.push_back(pageIndex);
+        for (int row = 1; row <= header[ENTRY_COUNT_OFFSET]; row++)
+            entries.push_back(page->getRowRef(row).toVector());
+        pageIndex = header[OVERFLOW_PAGE_OFFSET];
+    }
+    return localDepth;
+}
+
+/**
+ * @brief Writes entries as the bucket at bucketPageIndex with the given local
+ * depth, bucketCapacity entries per page. Entries that do not fit go to the
+ * pages in overflowPages (the chain the bucket had before) and then to new
+ * pages; pages of the old chain left over are freed.
+ */
+void HashIndex::writeChain(int bucketPageIndex, int localDepth, const std::vector<std::vector<int>>& entries, std::vector<int> overflowPages) {
+    size_t pagesNeeded = std::max<size_t>(1, (entries.size() + bucketCapacity - 1) / bucketCapacity);
+    std::vector<int> pages = {bucketPageIndex};
+    for (size_t i = 1; i < pagesNeeded; i++)
+        pages.push_back(i - 1 < overflowPages.size() ? overflowPages[i - 1] : pageCount++);
+    for (size_t i = pagesNeeded - 1; i < overflowPages.size(); i++)
+        bufferManager.deleteFile(indexName, overflowPages[i]);
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        size_t first = i * bucketCapacity;
+        size_t last = std::min(entries.size(), first + bucketCapacity);
+        std::vector<int> values = {localDepth, (int)(last - first), i + 1 < pages.size() ? pages[i + 1] : -1};
+        values.reserve((last - first + 1) * BUCKET_COLUMNS);
+        for (size_t entry = first; entry < last; entry++)
+            values.insert(values.end(), entries[entry].begin(), entries[entry].end());
+        bufferManager.writePage(indexName, pages[i], std::move(values), last - first + 1, BUCKET_COLUMNS);
+    }
+}
+
+/**
+ * @brief Splits the bucket directory[slot] points to on the next hash bit,
+ * doubling the directory first if the bucket already uses all of its bits.
+ *
+ * @return false if the directory is as large as it may get
+ */
+bool HashIndex::splitBucket(int slot) {
+    int bucketPageIndex = directory[slot];
+    std::vector<std::vector<int>> entries;
+    std::vector<int> overflowPages;
+    int localDepth = readChain(bucketPageIndex, entries, overflowPages);
+    if (localDepth == globalDepth) {
+        if (globalDepth == MAX_GLOBAL_DEPTH)
+            return false;
+        size_t size = directory.size();
+        for (size_t i = 0; i < size; i++)
+            directory.push_back(directory[i]);
+        globalDepth++;
+    }
+
+    int newBucketPageIndex = pageCount++;
+    std::vector<std::vector<int>> kept, moved;
+    for (auto& entry : entries)
+        ((hashKey(entry[0]) >> localDepth) & 1 ? moved : kept).push_back(std::move(entry));
+    for (size_t i = 0; i < directory.size(); i++)
+        if (directory[i] == bucketPageIndex && ((i >> localDepth) & 1))
+            directory[i] = newBucketPageIndex;
+    writeChain(bucketPageIndex, localDepth + 1, kept, overflowPages);
+    writeChain(newBucketPageIndex, localDepth + 1, moved, {});
+    LOG_DEBUG("HashIndex::splitBucket - Split bucket " + std::to_string(bucketPageIndex) + " into " + std::to_string(newBucketPageIndex) +
+              " at local depth " + std::to_string(localDepth + 1) + ", global depth " + std::to_string(globalDepth));
+    return true;
+}
+
+// Bulk load: the (key, page, row) entries of the table are sorted by the
+// directory slot they hash to with externalSort, for a directory large enough
+// that the average bucket is filled to INDEX_FILL_FACTOR percent. Each bucket
+// chain is then written once, instead of inserting (and splitting) row by row.
+bool HashIndex::buildIndex(Table* table) {
+    if (!table) { LOG_ERROR("HashIndex::buildIndex - Error: Null table pointer provided."); return false; }
+    LOG_DEBUG("HashIndex::buildIndex for table " + table->tableName + " on column " + columnName);
+    dropIndex();
+    if (columnIndex < 0 || columnIndex >= (int)table->columnCount) {
+        LOG_ERROR("HashIndex::buildIndex - Error: Invalid column index " + std::to_string(columnIndex));
+        return false;
+    }
+
+    double bucketFill = std::max(1.0, bucketCapacity * std::min<uint>(100, INDEX_FILL_FACTOR) / 100.0);
+    while (globalDepth < MAX_GLOBAL_DEPTH && (double)(1 << globalDepth) * bucketFill < table->rowCount)
+        globalDepth++;
+    pageCount = 1 << globalDepth;
+    for (int slot = 0; slot < pageCount; slot++)
+        directory.push_back(slot);
+
+    uint pageIndex = 0;
+    int rowIndex = 0;
+    PageHandle page;
+    auto nextEntry = [&]() -> std::vector<int> {
+        while (pageIndex < table->blockCount) {
+            if (!page.isValid()) page = bufferManager.getPage(table->tableName, pageIndex);
+            if (rowIndex < page->getRowCount()) {
+                int key = page->getRowRef(rowIndex)[columnIndex];
+                std::vector<int> entry = {directorySlot(key), key, (int)pageIndex, rowIndex};
+                rowIndex++;
+                return entry;
+            }
+            page.release();
+            pageIndex++;
+            rowIndex = 0;
+        }
+        return {};
+    };
+    // Entries of a bucket stay in storage order, as in a B+ tree leaf
+    std::string sortedName = externalSort(indexName, {"slot", "key", "pageIndex", "rowIndex"}, {{0, true}, {2, true}, {3, true}}, nextEntry);
+    page.release();
+
+    std::unique_ptr<Cursor> cursor;
+    std::vector<int> entry;
+    if (!sortedName.empty()) {
+        cursor.reset(new Cursor(sortedName, 0));
+        entry = cursor->getNext();
+    }
+    std::vector<std::vector<int>> bucketEntries;
+    for (int slot = 0; slot < (int)directory.size(); slot++) {
+        bucketEntries.clear();
+        for (; !entry.empty() && entry[0] == slot; entry = cursor->getNext())
+            bucketEntries.push_back({entry[1], entry[2], entry[3]});
+        writeChain(slot, globalDepth, bucketEntries, {});
+    }
+    if (cursor) {
+        cursor.reset(); // let go of its page before the sorted entries are deleted
+        tableCatalogue.deleteTable(sortedName);
+    }
+    LOG_DEBUG("HashIndex::buildIndex - Bulk loaded " + std::to_string(table->rowCount) + " entries into " + std::to_string(directory.size()) +
+              " buckets on " + std::to_string(pageCount) + " pages.");
+    return true;
+}
+
+bool HashIndex::dropIndex() {
+    LOG_DEBUG("HashIndex::dropIndex - Dropping index: " + indexName);
+    for (int i = 0; i < pageCount; ++i)
+        bufferManager.deleteFile(indexName, i);
+    directory.clear();
+    globalDepth = 0;
+    pageCount = 0;
+    return true;
+}
+
+/**
+ * @brief Adds an entry to the bucket the key hashes to. A full bucket is
+ * split (as often as it takes for the key's bucket to have room) unless every
+ * entry in it has the key's hash, which no split can separate; the entry then
+ * goes to the bucket's last overflow page, or a new one chained behind it.
+ */
+bool HashIndex::insertKey(const IndexKey& indexKey, RecordPointer recordPointer) {
+    int key = indexKey[0];
+    std::vector<int> entry = {key, recordPointer.first, recordPointer.second};
+    if (directory.empty()) {
+        directory.push_back(pageCount++);
+        writeChain(directory[0], 0, {}, {});
+    }
+
+    while (true) {
+        int slot = directorySlot(key);
+        PageHandle bucket = bufferManager.getPage(indexName, directory[slot]);
+        RowSpan header = bucket->getRowRef(0);
+        if (header.size() != BUCKET_COLUMNS) {
+            LOG_ERROR("HashIndex::insertKey - ERROR: Bucket page " + std::to_string(directory[slot]) + " of " + indexName + " is unreadable");
+            return false;
+        }
+        int entryCount = header[ENTRY_COUNT_OFFSET];
+        if (entryCount < bucketCapacity) {
+            Page& bucketPage = bucket.modify();
+            bucketPage.setRow(0, {header[LOCAL_DEPTH_OFFSET], entryCount + 1, header[OVERFLOW_PAGE_OFFSET]});
+            bucketPage.appendRow(entry);
+            return true;
+        }
+
+        const uint32_t hashMask = (1u << MAX_GLOBAL_DEPTH) - 1;
+        bool separable = false;
+        for (int row = 1; row <= entryCount && !separable; row++)
+            separable = ((hashKey(bucket->getRowRef(row)[0]) ^ hashKey(key)) & hashMask) != 0;
+        bucket.release();
+        if (separable && splitBucket(slot))
+            continue;
+
+        // Append to the last page of the overflow chain
+        int lastPageIndex = directory[slot];
+        PageHandle last = bufferManager.getPage(indexName, lastPageIndex);
+        while (last->getRowRef(0)[OVERFLOW_PAGE_OFFSET] != -1) {
+            lastPageIndex = last->getRowRef(0)[OVERFLOW_PAGE_OFFSET];
+            last = bufferManager.getPage(indexName, lastPageIndex);
+        }
+        RowSpan lastHeader = last->getRowRef(0);
+        if (lastHeader[ENTRY_COUNT_OFFSET] < bucketCapacity) {
+            Page& lastPage = last.modify();
+            lastPage.setRow(0, {lastHeader[LOCAL_DEPTH_OFFSET], lastHeader[ENTRY_COUNT_OFFSET] + 1, -1});
+            lastPage.appendRow(entry);
+        } else {
+            int overflowPageIndex = pageCount++;
+            std::vector<int> values = {lastHeader[LOCAL_DEPTH_OFFSET], 1, -1};
+            values.insert(values.end(), entry.begin(), entry.end());
+            last.modify().setRow(0, {lastHeader[LOCAL_DEPTH_OFFSET], lastHeader[ENTRY_COUNT_OFFSET], overflowPageIndex});
+            last.release();
+            bufferManager.writePage(indexName, overflowPageIndex, std::move(values), 2, BUCKET_COLUMNS);
+        }
+        return true;
+    }
+}
+
+bool HashIndex::deleteKey(const IndexKey& indexKey) {
+    int key = indexKey[0];
+    if (directory.empty()) return false;
+    int bucketPageIndex = directory[directorySlot(key)];
+    std::vector<std::vector<int>> entries;
+    std::vector<int> overflowPages;
+    int localDepth = readChain(bucketPageIndex, entries, overflowPages);
+    size_t entryCount = entries.size();
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [key](const std::vector<int>& entry) { return entry[0] == key; }), entries.end());
+    if (entries.size() == entryCount) {
+        LOG_DEBUG("HashIndex::deleteKey - Key " + std::to_string(key) + " not found.");
+        return false;
+    }
+    writeChain(bucketPageIndex, localDepth, entries, overflowPages);
+    return true;
+}
+
+bool HashIndex::deleteEntry(const IndexKey& indexKey, RecordPointer recordPointer) {
+    int key = indexKey[0];
+    if (directory.empty()) return false;
+    int bucketPageIndex = directory[directorySlot(key)];
+    std::vector<std::vector<int>> entries;
+    std::vector<int> overflowPages;
+    int localDepth = readChain(bucketPageIndex, entries, overflowPages);
+    std::vector<int> entry = {key, recordPointer.first, recordPointer.second};
+    auto it = std::find(entries.begin(), entries.end(), entry);
+    if (it == entries.end()) return false;
+    entries.erase(it);
+    writeChain(bucketPageIndex, localDepth, entries, overflowPages);
+    return true;
+}
+
+// Reads the key's bucket and its overflow pages straight out of the pool
+std::vector<RecordPointer> HashIndex::searchKey(const IndexKey& indexKey) {
+    int key = indexKey[0];
+    std::vector<RecordPointer> result;
+    if (directory.empty()) return result;
+    for (int pageIndex = directory[directorySlot(key)]; pageIndex != -1;) {
+        PageHandle page = bufferManager.getPage(indexName, pageIndex);
+        RowSpan header = page->getRowRef(0);
+        if (header.size() != BUCKET_COLUMNS) {
+            LOG_ERROR("HashIndex::searchKey - ERROR: Bucket page " + std::to_string(pageIndex) + " of " + indexName + " is unreadable");
+            break;
+        }
+        for (int row = 1; row <= header[ENTRY_COUNT_OFFSET]; row++) {
+            RowSpan entry = page->getRowRef(row);
+            if (entry[0] == key)
+                result.push_back({entry[1], entry[2]});
+        }
+        pageIndex = header[OVERFLOW_PAGE_OFFSET];
+    }
+    return result;
+}
+
+/**
+ * @brief Pages read by a lookup: the bucket the key hashes to, plus overflow
+ * pages when the matching entries alone fill more than one page. The
+ * directory is in memory.
+ */
+double HashIndex::estimateLookupPages(double tableRows, double matchingRows) const {
+    return std::max(1.0, std::ceil(matchingRows / bucketCapacity));
+}
+
+void HashIndex::writeMetadata(std::ostream& out) const {
+    int32_t metadata[4] = {bucketCapacity, globalDepth, pageCount, (int32_t)directory.size()};
+    out.write((const char*)metadata, sizeof(metadata));
+    out.write((const char*)directory.data(), directory.size() * sizeof(int));
+}
+
+bool HashIndex::readMetadata(std::istream& in) {
+    int32_t metadata[4];
+    if (!in.read((char*)metadata, sizeof(metadata)) || metadata[0] != bucketCapacity || metadata[1] < 0 || metadata[1] > MAX_GLOBAL_DEPTH ||
+        (metadata[3] != 0 && metadata[3] != 1 << metadata[1]))
+        return false;
+    std::vector<int> savedDirectory(metadata[3]);
+    if (!in.read((char*)savedDirectory.data(), savedDirectory.size() * sizeof(int)))
+        return false;
+    for (int bucketPageIndex : savedDirectory)
+        if (bucketPageIndex < 0 || bucketPageIndex >= metadata[2])
+            return false;
+    globalDepth = metadata[1];
+    pageCount = metadata[2];
+    directory.swap(savedDirectory);
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+#pragma once
+
+#include "index.h"
+
+/**
+ * @brief Extendible hash index on one integer column.
+ *
+ * Entries (key, pageIndex, rowIndex) live in bucket pages in the index's
+ * segment, read and written through the buffer pool like B+ tree nodes. Row 0
+ * of a bucket page is its header {localDepth, entryCount, overflowPageIndex}
+ * and every further row is one entry. The directory, 2^globalDepth page
+ * indices of buckets, is small and kept in memory; entry i of it is the
+ * bucket for keys whose hash ends in the bits of i.
+ *
+ * A bucket that fills up is split in two on the next hash bit, doubling the
+ * directory when the bucket already used all globalDepth bits, so a lookup of
+ * one key reads one bucket page. Only entries that splitting cannot separate
+ * (duplicates of one key, or keys whose hashes agree on MAX_GLOBAL_DEPTH
+ * bits) go to overflow pages chained behind the bucket. Buckets are never
+ * merged again, so the directory does not shrink after deletes.
+ *
+ * Keys are not kept in order, so the index only answers "column == value".
+ */
+class HashIndex : public Index {
+private:
+    static const int MAX_GLOBAL_DEPTH = 20; // directory of at most 2^20 buckets
+
+    int globalDepth;
+    std::vector<int> directory; // bucket page index for every combination of the low globalDepth hash bits
+    int pageCount; // page indices below this have been handed out
+    int bucketCapacity; // entries per bucket page
+
+    int getPageCount() const override { return pageCount; }
+    void writeMetadata(std::ostream& out) const override;
+    bool readMetadata(std::istream& in) override;
+
+    static uint32_t hashKey(int key);
+    int directorySlot(int key) const { return hashKey(key) & ((1u << globalDepth) - 1); }
+    int readChain(int bucketPageIndex, std::vector<std::vector<int>>& entries, std::vector<int>& overflowPages);
+    void writeChain(int bucketPageIndex, int localDepth, const std::vector<std::vector<int>>& entries, std::vector<int> overflowPages);
+    bool splitBucket(int slot);
+
+public:
+    HashIndex(const std::string& tableName, const std::string& columnName, const std::vector<int>& keyColumns);
+
+    IndexingStrategy getStrategy() const override { return HASH; }
+    bool isOrdered() const override { return false; }
+    double estimateLookupPages(double tableRows, double matchingRows) const override;
+
+    bool buildIndex(Table* table) override;
+    bool dropIndex() override;
+    // Keys are of one column, key[0]
+    bool insertKey(const IndexKey& key, RecordPointer recordPointer) override;
+    bool deleteKey(const IndexKey& key) override;
+    bool deleteEntry(const IndexKey& key, RecordPointer recordPointer) override;
+    std::vector<RecordPointer> searchKey(const IndexKey& key) override;
+};
+
+#endif // HASHINDEX_H
@@ -0,0 +1,63 @@
+#include "global.h"
+
+/**
+ * @brief 64 bit finaliser of MurmurHash3, spreads consecutive integers over
+ * the whole hash space.
+ */
+static uint64_t hashValue(int value)
+{
+	uint64_t hash = (uint32_t)value;
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+HyperLogLog::HyperLogLog(int precision)
+{
+	this->precision = max(MIN_PRECISION, min(MAX_PRECISION, precision));
+	this->registers.assign((size_t)1 << this->precision, 0);
+}
+
+/**
+ * @brief Adds value to the sketch. The top precision bits of its hash pick a
+ * register, which keeps the longest run of leading zeros (plus one) seen in
+ * the remaining bits.
+ *
+ * @param value
+ */
+void HyperLogLog::add(int value)
+{
+	uint64_t hash = hashValue(value);
+	size_t registerIndex = hash >> (64 - this->precision);
+	uint64_t remainder = hash << this->precision;
+	uint8_t rank = remainder ? __builtin_clzll(remainder) + 1 : 64 - this->precision + 1;
+	if (rank > this->registers[registerIndex])
+		this->registers[registerIndex] = rank;
+}
+
+/**
+ * @brief Estimated number of distinct values added so far. Small counts, where
+ * many registers are still empty, are estimated by linear counting instead.
+ *
+ * @return uint64_t
+ */
+uint64_t HyperLogLog::estimate() const
+{
+	double registerCount = this->registers.size();
+	double sum = 0;
+	int emptyRegisters = 0;
+	for (uint8_t rank : this->registers)
+	{
+		sum += ldexp(1.0, -rank);
+		if (rank == 0)
+			emptyRegisters++;
+	}
+	double alpha = registerCount == 16 ? 0.673 : registerCount == 32 ? 0.697 : registerCount == 64 ? 0.709 : 0.7213 / (1 + 1.079 / registerCount);
+	double estimate = alpha * registerCount * registerCount / sum;
+	if (estimate <= 2.5 * registerCount && emptyRegisters > 0)
+		estimate = registerCount * log(registerCount / emptyRegisters);
+	return llround(estimate);
+}
@@ -0,0 +1,31 @@
+#ifndef HYPERLOGLOG_H
+#define HYPERLOGLOG_H
+
+#pragma once
+#include "logger.h"
+
+/**
+ * @brief HyperLogLog sketch (Flajolet et al.) estimating the number of
+ * distinct values added to it in 2^precision one-byte registers, whatever the
+ * number of values. The standard error is about 1.04 / sqrt(2^precision), so
+ * the default precision of 12 (4 KB per sketch) is good to about 1.6%.
+ *
+ * Values can be added one at a time, so counts can be kept up to date as rows
+ * come in without ever rescanning a table.
+ */
+class HyperLogLog
+{
+	int precision = 0;
+	vector<uint8_t> registers;
+
+public:
+	static constexpr int MIN_PRECISION = 4;
+	static constexpr int MAX_PRECISION = 16;
+
+	HyperLogLog(int precision = 12);
+	void add(int value);
+	uint64_t estimate() const;
+	int getPrecision() const { return this->precision; }
+};
+
+#endif
@@ -1,31 +1,332 @@
 #include "index.h"
 #include "global.h" // Access bufferManager, tableCatalogue, BLOCK_SIZE etc.
+#include "hashIndex.h"
 #include <iostream>
 #include <vector>
 #include <cmath>   // For ceil
 #include <algorithm> // For lower_bound, sort, min, distance
 #include <cstring> // For memcpy potentially if optimizing serialization
 #include <climits> // For INT_MIN
+#include <fstream>
+
+//------------------------------------------------------------------------------
+// Posting lists
+//------------------------------------------------------------------------------
+
+// A posting list is stored as a stream of varints, 7 bits a byte: a pointer on
+// the same table page as the one before it is (row gap << 1), one on a later
+// page is ((page gap << 1) | 1) followed by its row. The list is sorted and
+// free of repeats, so gaps are small and most pointers take a single byte.
+static void appendVarint(std::vector<unsigned char>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(value);
+}
+
+static int varintBytes(uint32_t value) {
+    int bytes = 1;
+    while (value >= 0x80) { value >>= 7; bytes++; }
+    return bytes;
+}
+
+// Bytes one pointer takes following previous in the stream
+static int encodedPointerBytes(RecordPointer previous, RecordPointer pointer) {
+    if (pointer.first == previous.first)
+        return varintBytes((uint32_t)(pointer.second - previous.second - 1) << 1);
+    return varintBytes(((uint32_t)(pointer.first - previous.first) << 1) | 1) + varintBytes(pointer.second);
+}
+
+static const RecordPointer POSTING_START = {0, -1}; // what the first pointer of a list follows
+
+static void appendPointer(std::vector<unsigned char>& out, RecordPointer previous, RecordPointer pointer) {
+    if (pointer.first == previous.first) {
+        appendVarint(out, (uint32_t)(pointer.second - previous.second - 1) << 1);
+    } else {
+        appendVarint(out, ((uint32_t)(pointer.first - previous.first) << 1) | 1);
+        appendVarint(out, pointer.second);
+    }
+}
+
+static void encodePostings(const std::vector<RecordPointer>& pointers, std::vector<unsigned char>& out) {
+    RecordPointer previous = POSTING_START;
+    for (const RecordPointer& pointer : pointers) {
+        appendPointer(out, previous, pointer);
+        previous = pointer;
+    }
+}
+
+static size_t encodedPostingBytes(const PostingList& posting) {
+    size_t bytes = 0;
+    RecordPointer previous = POSTING_START;
+    for (const RecordPointer& pointer : posting.pointers) {
+        bytes += encodedPointerBytes(previous, pointer);
+        previous = pointer;
+    }
+    return bytes;
+}
+
+static bool readVarint(const unsigned char*& data, const unsigned char* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; data < end && shift < 35; shift += 7) {
+        unsigned char byte = *data++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static bool decodePostings(const unsigned char* data, size_t length, std::vector<RecordPointer>& out) {
+    const unsigned char* end = data + length;
+    RecordPointer previous = POSTING_START;
+    while (data < end) {
+        uint32_t gap, row;
+        if (!readVarint(data, end, gap)) return false;
+        if (gap & 1) {
+            if (!readVarint(data, end, row)) return false;
+            previous = {previous.first + (int)(gap >> 1), (int)row};
+        } else {
+            previous.second += (int)(gap >> 1) + 1;
+        }
+        out.push_back(previous);
+    }
+    return true;
+}
+
+// Page rows hold ints, so posting bytes are packed four to an int
+static int bytesToInts(size_t bytes) {
+    return (bytes + sizeof(int) - 1) / sizeof(int);
+}
+
+static std::vector<int> packBytes(const std::vector<unsigned char>& bytes) {
+    std::vector<int> ints(bytesToInts(bytes.size()), 0);
+    if (!bytes.empty()) memcpy(ints.data(), bytes.data(), bytes.size());
+    return ints;
+}
+
+//------------------------------------------------------------------------------
+// Node images
+//------------------------------------------------------------------------------
+
+// A node page is a single row of ints: the header (see BTreeNode), the key
+// offsets, the value offsets, the posting bytes of a leaf and one int of
+// padding. Keys are sorted, so each is stored as its offset from the first
+// key in just enough bits for the last one; below the root a node's keys span
+// a narrow range and several of them share an int, which raises the fan-out.
+// Values are the children of an internal node or, for a leaf, the end of each
+// key's posting list in the posting bytes, shifted left one with the low bit
+// set for a list kept in overflow pages (whose bytes then hold its first
+// overflow page as a varint), stored as offsets from the smallest the same
+// way. Offsets have one width per node, so they are read and compared in
+// place without decoding the node.
+//
+// A key of several columns is stored as one offset per column, next to each
+// other. The first column's offsets are from the first key as above; every
+// further column has its own base (its smallest value in the node) and
+// width, kept in a pair of ints right after the header.
+
+static const int COLUMN_HEADER_INTS = 2; // base and bits of a further key column
+
+static int bitsFor(uint32_t range) {
+    return range == 0 ? 0 : 32 - __builtin_clz(range);
+}
+
+static size_t bitsToInts(size_t bits) {
+    return (bits + 31) / 32;
+}
+
+// Smallest and largest value of each key column over a run of keys
+struct KeySpan {
+    IndexKey low, high;
+    bool empty = true;
+
+    void add(const IndexKey& key, int columns) {
+        for (int c = 0; c < columns; c++) {
+            low[c] = empty ? key[c] : std::min(low[c], key[c]);
+            high[c] = empty ? key[c] : std::max(high[c], key[c]);
+        }
+        empty = false;
+    }
+    void add(const KeySpan& other, int columns) {
+        if (other.empty) return;
+        add(other.low, columns);
+        add(other.high, columns);
+    }
+    // Bits one key takes in a node whose keys span this
+    int keyBits(int columns) const {
+        int bits = 0;
+        for (int c = 0; c < columns && !empty; c++) bits += bitsFor((uint32_t)high[c] - (uint32_t)low[c]);
+        return bits;
+    }
+};
+
+static KeySpan spanOf(const std::vector<IndexKey>& keys, int columns) {
+    KeySpan span;
+    for (const IndexKey& key : keys) span.add(key, columns);
+    return span;
+}
+
+static int nodeImageInts(size_t keyCount, int keyBits, int keyColumnCount, size_t valueCount, uint32_t valueRange, size_t postingBytes) {
+    return BTreeNode::HEADER_INTS + COLUMN_HEADER_INTS * (keyColumnCount - 1) + bitsToInts(keyCount * keyBits) +
+           bitsToInts(valueCount * bitsFor(valueRange)) + bytesToInts(postingBytes) + 1;
+}
+
+// Offsets are written and read through a 64-bit window over two ints; the
+// padding int at the end of the image keeps the window inside the row
+static void packBits(uint32_t* words, size_t bit, int width, uint32_t offset) {
+    if (width == 0) return;
+    uint64_t window = words[bit / 32] | (uint64_t)words[bit / 32 + 1] << 32;
+    window |= (uint64_t)offset << (bit % 32);
+    words[bit / 32] = (uint32_t)window;
+    words[bit / 32 + 1] = (uint32_t)(window >> 32);
+}
+
+static inline uint32_t unpackBits(const uint32_t* words, size_t bit, int width) {
+    if (width == 0) return 0;
+    uint64_t window = words[bit / 32] | (uint64_t)words[bit / 32 + 1] << 32;
+    return (window >> (bit % 32)) & ((1ull << width) - 1);
+}
+
+static void packOffset(uint32_t* words, size_t index, int width, uint32_t offset) {
+    packBits(words, index * width, width, offset);
+}
+
+static inline uint32_t unpackOffset(const uint32_t* words, size_t index, int width) {
+    return unpackBits(words, index * width, width);
+}
+
+// First i in [0, n) for which before(i) is false, before being true up to
+// some i and false from there on. Each step halves the range with a
+// conditional move rather than a jump, so there is no branch to mispredict
+// and every search of n keys does the same ceil(log2 n) + 1 comparisons.
+template <typename Before>
+static int partitionPoint(int n, Before before) {
+    if (n <= 0) return 0;
+    int first = 0;
+    while (n > 1) {
+        int half = n / 2;
+        first = before(first + half) ? first + half : first;
+        n -= half;
+    }
+    return first + before(first);
+}
+
+// A node read in place out of its pinned page, see parseNodeImage
+struct NodeImage {
+    bool isLeaf = false;
+    int keyCount = 0;
+    int valueCount = 0;
+    int parentPageIndex = -1;
+    int nextLeafPageIndex = -1;
+    int keyColumnCount = 1;
+    uint32_t keyBase = 0, valueBase = 0;
+    int keyBits = 0, valueBits = 0; // keyBits is of the first key column
+    uint32_t columnBases[IndexKey::MAX_COLUMNS] = {}; // the rest are of all key columns
+    int columnBits[IndexKey::MAX_COLUMNS] = {};
+    int columnBitOffsets[IndexKey::MAX_COLUMNS] = {};
+    int keyStride = 0; // bits per key
+    const uint32_t* keyWords = nullptr;
+    const uint32_t* valueWords = nullptr;
+    const unsigned char* postingBytes = nullptr;
+    size_t postingByteCount = 0;
+
+    int column(int i, int c) const { return (int)(columnBases[c] + unpackBits(keyWords, (size_t)i * keyStride + columnBitOffsets[c], columnBits[c])); }
+    IndexKey key(int i) const {
+        IndexKey result;
+        for (int c = 0; c < keyColumnCount; c++) result[c] = column(i, c);
+        return result;
+    }
+    int value(int i) const { return (int)(valueBase + unpackOffset(valueWords, i, valueBits)); }
+
+    // Key i against target, column by column: < 0, 0 or > 0
+    int compare(int i, const IndexKey& target) const {
+        for (int c = 0; c < keyColumnCount; c++) {
+            int value = column(i, c);
+            if (value != target[c]) return value < target[c] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    // Index of the first key >= target (lowerBound) or > target (upperBound).
+    // Keys of one column are compared as offsets, without adding the base back.
+    int lowerBound(const IndexKey& target) const {
+        if (keyColumnCount > 1) return partitionPoint(keyCount, [&](int i) { return compare(i, target) < 0; });
+        int64_t offset = (int64_t)target[0] - (int)keyBase;
+        if (offset <= 0) return 0;
+        if (offset > UINT32_MAX) return keyCount;
+        return partitionPoint(keyCount, [&](int i) { return unpackOffset(keyWords, i, keyBits) < (uint32_t)offset; });
+    }
+    int upperBound(const IndexKey& target) const {
+        if (keyColumnCount > 1) return partitionPoint(keyCount, [&](int i) { return compare(i, target) <= 0; });
+        int64_t offset = (int64_t)target[0] - (int)keyBase;
+        if (offset < 0) return 0;
+        if (offset > UINT32_MAX) return keyCount;
+        return partitionPoint(keyCount, [&](int i) { return unpackOffset(keyWords, i, keyBits) <= (uint32_t)offset; });
+    }
+
+    // Bytes [start, end) of posting list i of a leaf, and whether they hold an overflow page index
+    void postingRange(int i, size_t& start, size_t& end, bool& spilled) const {
+        start = i == 0 ? 0 : (uint32_t)value(i - 1) >> 1;
+        end = (uint32_t)value(i) >> 1;
+        spilled = value(i) & 1;
+    }
+};
+
+static bool parseNodeImage(RowSpan image, NodeImage& node) {
+    if (image.size() < BTreeNode::HEADER_INTS + 1) return false;
+    const int* header = image.begin();
+    node.isLeaf = header[BTreeNode::IS_LEAF_OFFSET] == 1;
+    node.keyCount = header[BTreeNode::KEY_COUNT_OFFSET];
+    node.valueCount = header[BTreeNode::VALUE_COUNT_OFFSET];
+    node.parentPageIndex = header[BTreeNode::PARENT_PAGE_INDEX_OFFSET];
+    node.nextLeafPageIndex = node.isLeaf ? header[BTreeNode::NEXT_LEAF_PAGE_INDEX_OFFSET] : -1;
+    node.keyBase = header[BTreeNode::KEY_BASE_OFFSET];
+    node.valueBase = header[BTreeNode::VALUE_BASE_OFFSET];
+    node.keyBits = header[BTreeNode::BIT_WIDTHS_OFFSET] & 0xFF;
+    node.valueBits = (header[BTreeNode::BIT_WIDTHS_OFFSET] >> 8) & 0xFF;
+    node.keyColumnCount = (header[BTreeNode::BIT_WIDTHS_OFFSET] >> 16) & 0xFF;
+    if (node.keyCount < 0 || node.valueCount < 0 || node.keyBits > 32 || node.valueBits > 32 ||
+        node.keyColumnCount < 1 || node.keyColumnCount > IndexKey::MAX_COLUMNS ||
+        (node.isLeaf && node.valueCount != node.keyCount)) return false;
+    size_t headerInts = BTreeNode::HEADER_INTS + COLUMN_HEADER_INTS * (node.keyColumnCount - 1);
+    if (headerInts + 1 > image.size()) return false;
+    node.columnBases[0] = node.keyBase;
+    node.columnBits[0] = node.keyBits;
+    for (int c = 1; c < node.keyColumnCount; c++) {
+        const int* columnHeader = header + BTreeNode::HEADER_INTS + COLUMN_HEADER_INTS * (c - 1);
+        node.columnBases[c] = columnHeader[0];
+        node.columnBits[c] = columnHeader[1];
+        if (node.columnBits[c] < 0 || node.columnBits[c] > 32) return false;
+    }
+    node.keyStride = 0;
+    for (int c = 0; c < node.keyColumnCount; c++) {
+        node.columnBitOffsets[c] = node.keyStride;
+        node.keyStride += node.columnBits[c];
+    }
+    size_t keyInts = bitsToInts((size_t)node.keyCount * node.keyStride);
+    size_t valueInts = bitsToInts((size_t)node.valueCount * node.valueBits);
+    if (headerInts + keyInts + valueInts + 1 > image.size()) return false;
+    node.keyWords = (const uint32_t*)(header + headerInts);
+    node.valueWords = node.keyWords + keyInts;
+    node.postingBytes = (const unsigned char*)(node.valueWords + valueInts);
+    node.postingByteCount = (image.size() - headerInts - keyInts - valueInts - 1) * sizeof(int);
+    return true;
+}
 
 //------------------------------------------------------------------------------
 // BTreeNode Implementation
 //------------------------------------------------------------------------------
 
 // Constructor for creating a new node
-BTreeNode::BTreeNode(int order, int leafOrder, bool leaf) :
+BTreeNode::BTreeNode(bool leaf, int keyColumns) :
     isLeaf(leaf),
+    keyColumnCount(keyColumns),
     nextLeafPageIndex(-1),
     parentPageIndex(-1),
     pageIndex(-1), // Will be assigned when allocated
 keyCount(0)
 {
-    int keyCapacity = isLeaf ? leafOrder : order - 1;
-    keys.reserve(keyCapacity);
-    if (isLeaf) {
-        recordPointers.reserve(leafOrder);
-    } else {
-        childrenPageIndices.reserve(order);
-    }
 }
 
 // Constructor for loading an existing node from a page object
@@ -44,11 +345,11 @@ keyCount(0)
 //                 // Extract substring after "Node" and convert to int
 //                 pageIndex = std::stoi(page->pageName.substr(lastNode + 4));
 //             } catch (const std::exception& e) {
-//                 logger.log("BTreeNode(Page*) - Error parsing pageIndex from pageName: " + page->pageName + " - " + e.what());
+//                 LOG_ERROR("BTreeNode(Page*) - Error parsing pageIndex from pageName: " + page->pageName + " - " + e.what());
 //                 pageIndex = -1; // Indicate error
 //             }
 //         } else {
-//             logger.log("BTreeNode(Page*) - Error: Could not find 'Node<ID>' suffix in pageName: " + page->pageName);
+//             LOG_ERROR("BTreeNode(Page*) - Error: Could not find 'Node<ID>' suffix in pageName: " + page->pageName);
 //             pageIndex = -1;
 //         }
 //     } else {
@@ -57,127 +358,140 @@ keyCount(0)
 // }
 
 // --- Node Serialization / Deserialization ---
-// Fills a rows vector suitable for BufferManager::writePage
-void BTreeNode::serialize(std::vector<std::vector<int>>& pageData, int order, int leafOrder) {
-    pageData.clear();
-
-    // Ensure keyCount reflects actual vector size before serializing metadata
-    // This is defensive coding; keyCount should ideally be correct already if managed properly.
-    keyCount = keys.size();
-
-    // Row 0: Metadata
-    std::vector<int> metadata;
-    metadata.push_back(isLeaf ? 1 : 0);
-    metadata.push_back(keyCount); // Use the actual key count
-    metadata.push_back(parentPageIndex);
-    if (isLeaf) {
-        metadata.push_back(nextLeafPageIndex);
-    }
-    // Pad metadata to ensure consistent size if needed
-    while (metadata.size() < BTreeNode::METADATA_INTS_LEAF) {
-        metadata.push_back(-1); // Pad with -1
-    }
-    pageData.push_back(metadata);
-
-    // Row 1: Keys
-    pageData.push_back(keys); // Push the actual keys vector
-
-    // Row 2: Pointers (Record or Child)
-    if (isLeaf) {
-        // Ensure consistency before writing pointers
-        if (recordPointers.size() != keyCount) {
-             logger.log("BTreeNode::serialize - ERROR: Leaf node key count (" + std::to_string(keyCount) + ") doesn't match record pointer count (" + std::to_string(recordPointers.size()) + ") before writing node " + std::to_string(pageIndex));
-             // This indicates a bug elsewhere, but we proceed by writing the pointers we have.
-        }
-        std::vector<int> flatPointers;
-        flatPointers.reserve(recordPointers.size() * 2);
-        for (const auto& rp : recordPointers) {
-            flatPointers.push_back(rp.first);
-            flatPointers.push_back(rp.second);
-        }
-        pageData.push_back(flatPointers);
-    } else {
-         // Ensure consistency for internal nodes
-         if (childrenPageIndices.size() != (keyCount + 1) && !(keyCount == 0 && childrenPageIndices.empty())) {
-              logger.log("BTreeNode::serialize - ERROR: Internal node key count (" + std::to_string(keyCount) + ") doesn't match children count (" + std::to_string(childrenPageIndices.size()) + ") before writing node " + std::to_string(pageIndex));
-         }
-        pageData.push_back(childrenPageIndices);
-    }
-}
-
-// Deserialize - TAKES const vector<vector<int>>& pageData now
-void BTreeNode::deserialize(const std::vector<std::vector<int>>& pageData, int order, int leafOrder) {
-    if (pageData.empty()) return; // Handle empty page data
-
-    // Clear existing node state before loading
-    keys.clear();
-    recordPointers.clear();
-    childrenPageIndices.clear();
-    // keyCount = 0; // Reset later based on actual data
-
-    // Row 0: Metadata
-    const std::vector<int>& metadata = pageData[0];
-    if (metadata.size() >= 3) { // Basic check
-        isLeaf = (metadata[IS_LEAF_OFFSET] == 1);
-        // keyCount = metadata[KEY_COUNT_OFFSET]; // DON'T read keyCount from metadata here
-        parentPageIndex = metadata[PARENT_PAGE_INDEX_OFFSET];
-        if (isLeaf && metadata.size() >= 4) {
-            nextLeafPageIndex = metadata[NEXT_LEAF_PAGE_INDEX_OFFSET];
+// Posting lists of a leaf as they are laid out in its image: the bytes and
+// where each list ends, see "Node images"
+static void layOutPostings(const std::vector<PostingList>& postings, std::vector<unsigned char>& bytes, std::vector<uint32_t>& ends) {
+    for (const PostingList& posting : postings) {
+        if (posting.overflowPageIndex >= 0) {
+            appendVarint(bytes, posting.overflowPageIndex);
+            ends.push_back((uint32_t)bytes.size() << 1 | 1);
         } else {
-            nextLeafPageIndex = -1;
+            encodePostings(posting.pointers, bytes);
+            ends.push_back((uint32_t)bytes.size() << 1);
         }
-    } else {
-         logger.log("BTreeNode::deserialize - Error: Metadata row too short.");
-         isLeaf = false; // Default to prevent errors later? Or handle better?
-         parentPageIndex = -1;
-         nextLeafPageIndex = -1;
-         keyCount = 0; // Set explicitly on error
-         return;
     }
+}
 
-
-    // Row 1: Keys
-    if (pageData.size() > 1) {
-        keys = pageData[1]; // Assign keys directly
+// Fills the single row image of the node's page, see "Node images"
+void BTreeNode::serialize(std::vector<int>& image) const {
+    if (isLeaf && postings.size() != keys.size()) {
+         LOG_ERROR("BTreeNode::serialize - ERROR: Leaf node key count (" + std::to_string(keys.size()) + ") doesn't match posting list count (" + std::to_string(postings.size()) + ") before writing node " + std::to_string(pageIndex));
+    }
+    if (!isLeaf && childrenPageIndices.size() != (keys.size() + 1) && !(keys.empty() && childrenPageIndices.empty())) {
+         LOG_ERROR("BTreeNode::serialize - ERROR: Internal node key count (" + std::to_string(keys.size()) + ") doesn't match children count (" + std::to_string(childrenPageIndices.size()) + ") before writing node " + std::to_string(pageIndex));
     }
 
-
-    // Row 2: Pointers
-    if (pageData.size() > 2) {
-        if (isLeaf) {
-            const std::vector<int>& flatPointers = pageData[2];
-            recordPointers.reserve(flatPointers.size() / 2);
-            for (size_t i = 0; i + 1 < flatPointers.size(); i += 2) {
-                recordPointers.push_back({flatPointers[i], flatPointers[i + 1]});
-            }
-        } else {
-            childrenPageIndices = pageData[2]; // Assign child indices directly
+    std::vector<unsigned char> postingBytes;
+    std::vector<uint32_t> values;
+    if (isLeaf) layOutPostings(postings, postingBytes, values);
+    else values.assign(childrenPageIndices.begin(), childrenPageIndices.end());
+
+    // The first column is sorted, so its base is the first key's
+    KeySpan span = spanOf(keys, keyColumnCount);
+    uint32_t columnBases[IndexKey::MAX_COLUMNS] = {};
+    int columnBits[IndexKey::MAX_COLUMNS] = {};
+    int keyStride = 0;
+    for (int c = 0; c < keyColumnCount && !keys.empty(); c++) {
+        columnBases[c] = span.low[c];
+        columnBits[c] = bitsFor((uint32_t)span.high[c] - columnBases[c]);
+        keyStride += columnBits[c];
+    }
+    uint32_t valueBase = values.empty() ? 0 : *std::min_element(values.begin(), values.end()); // page indices and ends are never negative
+    uint32_t valueRange = 0;
+    for (uint32_t value : values) valueRange = std::max(valueRange, value - valueBase);
+    int valueBits = bitsFor(valueRange);
+
+    image.assign(nodeImageInts(keys.size(), keyStride, keyColumnCount, values.size(), valueRange, postingBytes.size()), 0);
+    image[IS_LEAF_OFFSET] = isLeaf ? 1 : 0;
+    image[KEY_COUNT_OFFSET] = keys.size();
+    image[PARENT_PAGE_INDEX_OFFSET] = parentPageIndex;
+    image[NEXT_LEAF_PAGE_INDEX_OFFSET] = isLeaf ? nextLeafPageIndex : -1;
+    image[KEY_BASE_OFFSET] = columnBases[0];
+    image[VALUE_COUNT_OFFSET] = values.size();
+    image[VALUE_BASE_OFFSET] = valueBase;
+    image[BIT_WIDTHS_OFFSET] = columnBits[0] | valueBits << 8 | keyColumnCount << 16;
+    for (int c = 1; c < keyColumnCount; c++) {
+        image[HEADER_INTS + COLUMN_HEADER_INTS * (c - 1)] = columnBases[c];
+        image[HEADER_INTS + COLUMN_HEADER_INTS * (c - 1) + 1] = columnBits[c];
+    }
+    uint32_t* keyWords = (uint32_t*)image.data() + HEADER_INTS + COLUMN_HEADER_INTS * (keyColumnCount - 1);
+    for (size_t i = 0; i < keys.size(); i++) {
+        size_t bit = i * keyStride;
+        for (int c = 0; c < keyColumnCount; c++) {
+            packBits(keyWords, bit, columnBits[c], (uint32_t)keys[i][c] - columnBases[c]);
+            bit += columnBits[c];
         }
     }
+    uint32_t* valueWords = keyWords + bitsToInts(keys.size() * keyStride);
+    for (size_t i = 0; i < values.size(); i++) packOffset(valueWords, i, valueBits, values[i] - valueBase);
+    if (!postingBytes.empty()) memcpy(valueWords + bitsToInts(values.size() * valueBits), postingBytes.data(), postingBytes.size());
+}
 
-    // Set keyCount based on the ACTUAL number of keys read from the file
+// Decodes the node out of its page image; false if the image is unreadable
+bool BTreeNode::deserialize(RowSpan image) {
+    NodeImage node;
+    if (!parseNodeImage(image, node)) {
+         LOG_ERROR("BTreeNode::deserialize - Error: Node image is unreadable.");
+         return false;
+    }
+    isLeaf = node.isLeaf;
+    keyColumnCount = node.keyColumnCount;
+    parentPageIndex = node.parentPageIndex;
+    nextLeafPageIndex = node.nextLeafPageIndex;
+    keys.resize(node.keyCount);
+    for (int i = 0; i < node.keyCount; i++) keys[i] = node.key(i);
     keyCount = keys.size();
+    postings.clear();
+    childrenPageIndices.clear();
+    if (!isLeaf) {
+        childrenPageIndices.resize(node.valueCount);
+        for (int i = 0; i < node.valueCount; i++) childrenPageIndices[i] = node.value(i);
+        return true;
+    }
+    postings.resize(node.keyCount);
+    for (int i = 0; i < node.keyCount; i++) {
+        size_t start, end;
+        bool spilled;
+        node.postingRange(i, start, end, spilled);
+        uint32_t overflowPageIndex;
+        const unsigned char* data = node.postingBytes + start;
+        if (start > end || end > node.postingByteCount ||
+            (spilled ? !readVarint(data, node.postingBytes + end, overflowPageIndex) : !decodePostings(data, end - start, postings[i].pointers))) {
+            LOG_ERROR("BTreeNode::deserialize - Error: Posting list " + std::to_string(i) + " is corrupt.");
+            return false;
+        }
+        if (spilled) postings[i].overflowPageIndex = overflowPageIndex;
+    }
+    return true;
+}
 
-    // Optional Sanity checks (can be added if needed, but might hide prior errors)
-    // if (isLeaf && recordPointers.size() != keyCount) {
-    //      logger.log("BTreeNode::deserialize - Warning: Leaf node key count mismatch after load.");
-    // }
-    // if (!isLeaf && childrenPageIndices.size() != (keyCount + 1) && !(keyCount == 0 && childrenPageIndices.empty())) {
-    //      logger.log("BTreeNode::deserialize - Warning: Internal node pointer count mismatch after load.");
-    // }
+// Bytes a posting list takes in its leaf's image
+static size_t leafPostingBytes(const PostingList& posting) {
+    return posting.overflowPageIndex >= 0 ? varintBytes(posting.overflowPageIndex) : encodedPostingBytes(posting);
 }
 
-bool BTreeNode::isFull(int order, int leafOrder) const {
-    if (isLeaf) {
-        return keyCount >= leafOrder;
-    } else {
-        // Internal node is full if it has p-1 keys
-        return keyCount >= order - 1;
+int BTreeNode::imageInts() const {
+    int keyBits = spanOf(keys, keyColumnCount).keyBits(keyColumnCount);
+    if (!isLeaf) {
+        uint32_t valueRange = 0;
+        if (!childrenPageIndices.empty()) {
+            auto [low, high] = std::minmax_element(childrenPageIndices.begin(), childrenPageIndices.end());
+            valueRange = (uint32_t)*high - (uint32_t)*low;
+        }
+        return nodeImageInts(keys.size(), keyBits, keyColumnCount, childrenPageIndices.size(), valueRange, 0);
     }
+    size_t postingBytes = 0;
+    for (const PostingList& posting : postings) postingBytes += leafPostingBytes(posting);
+    // The largest end bounds the range of the ends, so the image may come out a little smaller
+    return nodeImageInts(keys.size(), keyBits, keyColumnCount, postings.size(), (uint32_t)postingBytes << 1 | 1, postingBytes);
+}
+
+bool BTreeNode::isFull(int pageInts) const {
+    return imageInts() >= pageInts;
 }
 
 // CORRECTED VERSION from previous step
-bool BTreeNode::isMinimal(int order, int leafOrder) const {
+bool BTreeNode::isMinimal(int pageInts) const {
     if (parentPageIndex == -1) { // Is it the root?
         if (isLeaf) {
             // Root leaf is minimal even if empty (keyCount=0 is allowed initially)
@@ -186,57 +500,48 @@ bool BTreeNode::isMinimal(int order, int leafOrder) const {
             // Root internal node must have at least 1 key (=> 2 children)
             return keyCount >= 1;
         }
-    } else { // Not the root
-        int minKeys;
-        if (isLeaf) {
-            // Minimum leaf keys = ceil(Pleaf / 2)
-            minKeys = std::ceil(static_cast<double>(leafOrder) / 2.0);
-        } else {
-            // Minimum internal keys = ceil(p / 2) - 1
-            minKeys = std::ceil(static_cast<double>(order) / 2.0) - 1;
-        }
-        return keyCount >= minKeys;
     }
+    // Other nodes have to be a quarter full. One key with its posting list
+    // can take up to half a leaf, so splits, borrows and merges go by size
+    return imageInts() >= pageInts / 4;
 }
 
-int BTreeNode::findKeyIndex(int key) const {
-    auto it = std::lower_bound(keys.begin(), keys.end(), key);
-    if (it != keys.end() && *it == key) {
-        return std::distance(keys.begin(), it);
+int BTreeNode::findKeyIndex(const IndexKey& key) const {
+    int pos = partitionPoint(keys.size(), [&](int i) { return keys[i] < key; });
+    if (pos < (int)keys.size() && keys[pos] == key) {
+        return pos;
     }
     return -1; // Key not found
 }
 
 // For internal nodes: find pointer index for a key
-int BTreeNode::findChildIndex(int key) const {
+int BTreeNode::findChildIndex(const IndexKey& key) const {
     if (isLeaf) return -1; // Only applicable for internal nodes
-    // Find the first key *strictly greater* than the search key
-    auto it = std::upper_bound(keys.begin(), keys.end(), key);
-    // The pointer index is the same as the index of the iterator found
-    return std::distance(keys.begin(), it);
+    // The pointer index is the index of the first key *strictly greater* than the search key
+    return partitionPoint(keys.size(), [&](int i) { return keys[i] <= key; });
 }
 
-void BTreeNode::insertLeafEntry(int key, RecordPointer pointer, int pos) {
+void BTreeNode::insertLeafEntry(const IndexKey& key, const PostingList& posting, int pos) {
     if (pos < 0 || pos > keyCount) return; // Basic bounds check
     keys.insert(keys.begin() + pos, key);
-    recordPointers.insert(recordPointers.begin() + pos, pointer);
+    postings.insert(postings.begin() + pos, posting);
     keyCount++;
 }
 
 void BTreeNode::removeLeafEntry(int pos) {
     if (pos >= 0 && pos < keyCount) {
         keys.erase(keys.begin() + pos);
-        recordPointers.erase(recordPointers.begin() + pos);
+        postings.erase(postings.begin() + pos);
         keyCount--;
     }
 }
 
-void BTreeNode::insertInternalEntry(int key, int childPageIndex, int pos) {
+void BTreeNode::insertInternalEntry(const IndexKey& key, int childPageIndex, int pos) {
      if (pos < 0 || pos > keyCount) return; // Basic bounds check
      keys.insert(keys.begin() + pos, key);
      // Child pointer goes *after* the key's position
      if (pos + 1 > childrenPageIndices.size()) { // Should not happen if called correctly
-          logger.log("BTreeNode::insertInternalEntry - Error: Child pointer index out of bounds.");
+          LOG_ERROR("BTreeNode::insertInternalEntry - Error: Child pointer index out of bounds.");
           // Rollback key insertion? Or just log? Let's log and proceed carefully.
           childrenPageIndices.push_back(childPageIndex); // Append if missing? Risky.
      } else {
@@ -253,7 +558,7 @@ void BTreeNode::removeInternalEntry(int pos) {
          if (pos + 1 < childrenPageIndices.size()) {
             childrenPageIndices.erase(childrenPageIndices.begin() + pos + 1);
          } else {
-             logger.log("BTreeNode::removeInternalEntry - Warning: Attempting to remove key at end without corresponding child pointer. Pointer vector size: " + std::to_string(childrenPageIndices.size()));
+             LOG_WARNING("BTreeNode::removeInternalEntry - Warning: Attempting to remove key at end without corresponding child pointer. Pointer vector size: " + std::to_string(childrenPageIndices.size()));
              // This might indicate an issue elsewhere if the structure is invalid
          }
          keyCount--;
@@ -263,11 +568,15 @@ void BTreeNode::removeInternalEntry(int pos) {
 void BTreeNode::printNode() const {
     std::cout << "Node Page: " << pageIndex << " (Parent: " << parentPageIndex << ") "
               << (isLeaf ? "[LEAF]" : "[INTERNAL]") << " Keys (" << keyCount << "): ";
-    for(int k : keys) std::cout << k << " ";
+    for(const IndexKey& k : keys) std::cout << k.toString(keyColumnCount) << " ";
 
     if(isLeaf) {
-        std::cout << " DataPtrs: [";
-         for(size_t i=0; i<recordPointers.size(); ++i) std::cout << "{" << recordPointers[i].first << "," << recordPointers[i].second << "}" << (i==recordPointers.size()-1?"":", ");
+        std::cout << " Postings: [";
+        for (size_t i = 0; i < postings.size(); ++i) {
+            if (postings[i].overflowPageIndex >= 0) std::cout << "overflow@" << postings[i].overflowPageIndex;
+            else std::cout << postings[i].pointers.size() << " ptrs";
+            std::cout << (i == postings.size() - 1 ? "" : ", ");
+        }
         std::cout << "] NextLeaf: " << nextLeafPageIndex;
     } else {
         std::cout << " ChildrenPtrs: ";
@@ -280,26 +589,20 @@ void BTreeNode::printNode() const {
 // BTree Implementation
 //------------------------------------------------------------------------------
 
-BTree::BTree(const std::string& tblName, const std::string& colName, int colIndex) :
-    tableName(tblName),
-    columnName(colName),
-    columnIndex(colIndex),
+BTree::BTree(const std::string& tblName, const std::string& colName, const std::vector<int>& keyCols) :
+    Index(tblName, colName, keyCols, tblName + "_" + colName + "_index"), // Unique name for buffer manager
     rootPageIndex(-1), // Initially empty tree
-    nodeCount(0)
+    nodeCount(0),
+    height(0),
+    keyColumnCount(std::min<int>(keyCols.size(), IndexKey::MAX_COLUMNS))
 {
-    indexName = tableName + "_" + columnName + "_index"; // Unique name for buffer manager
-    const int pointerSize = sizeof(int);
-    const int keySize = sizeof(int);
-    const int recordPointerSize = sizeof(RecordPointer);
-    const int metadataSize = BTreeNode::METADATA_INTS_LEAF * sizeof(int);
-    const int effectiveBlockSize = BLOCK_SIZE * 1000 - metadataSize;
-    order = floor((double)(effectiveBlockSize + keySize) / (pointerSize + keySize));
-    if (order < 3) order = 3;
-    leafOrder = floor((double)(effectiveBlockSize - pointerSize) / (keySize + recordPointerSize));
-    if (leafOrder < 1) leafOrder = 1;
-    logger.log("BTree::BTree - Calculated Order (p): " + std::to_string(order));
-    logger.log("BTree::BTree - Calculated Leaf Order (Pleaf): " + std::to_string(leafOrder));
-    // TODO: Load existing index metadata if it persists
+    // Nodes are sized by their page image rather than by a fixed order: how
+    // many keys fit depends on how narrow a range they span (see "Node images")
+    pageInts = std::max(BTreeNode::HEADER_INTS + 16, (int)(BLOCK_SIZE * 1000 / sizeof(int)));
+    maxInlinePostingBytes = (pageInts - BTreeNode::HEADER_INTS) * sizeof(int) / 2; // half of a leaf
+    // An overflow page is [nextOverflowPageIndex, byteCount, bytes...]
+    overflowPageBytes = (pageInts - 2) * sizeof(int);
+    LOG_DEBUG("BTree::BTree - Node page size (ints): " + std::to_string(pageInts));
 }
 
 BTree::~BTree() {
@@ -311,235 +614,706 @@ int BTree::allocateNewNodePage() {
     return nodeCount++;
 }
 
+// Node pages live in the buffer pool like table pages: reads pin the frame
+// only while the node is decoded, and writes just dirty the frame. Internal
+// nodes (the root and the levels below it) are also kept decoded in
+// nodeCache, so descending the tree only goes to the pool for the leaf. There
+// are about fan-out times fewer internal nodes than leaves, so the cache
+// stays small and is not bounded.
 BTreeNode* BTree::fetchNode(int pageIndex) {
     if (pageIndex < 0) return nullptr;
-    std::string nodeFileName = "../data/temp/" + indexName + "_Node" + std::to_string(pageIndex);
-
-    // Instead of BufferManager, read directly using ifstream
-    std::ifstream fin(nodeFileName);
-    if (!fin.is_open()) {
-        logger.log("BTree::fetchNode - Error: Could not open index node file: " + nodeFileName);
+    auto cached = nodeCache.find(pageIndex);
+    if (cached != nodeCache.end()) return new BTreeNode(cached->second);
+
+    PageHandle nodePage = bufferManager.getPage(indexName, pageIndex);
+    BTreeNode* node = new BTreeNode();
+    if (!node->deserialize(nodePage->getRowRef(0))) {
+        LOG_ERROR("BTree::fetchNode - Error: Deserialization failed for node " + std::to_string(pageIndex));
+        delete node;
         return nullptr;
     }
-
-    std::vector<std::vector<int>> pageData;
-    std::string line;
-    while (getline(fin, line)) {
-        std::vector<int> rowData;
-        std::stringstream ss(line);
-        int value;
-        while (ss >> value) {
-            rowData.push_back(value);
-        }
-        if (!rowData.empty()) { // Avoid adding empty vectors if blank lines exist
-             pageData.push_back(rowData);
-        }
-    }
-    fin.close();
-
-    if (pageData.empty()) {
-        logger.log("BTree::fetchNode - Warning: Index node file was empty or unreadable: " + nodeFileName);
-        // Return an empty node object but mark pageIndex? Or return nullptr?
-        // Returning nullptr is probably safer as the state is invalid.
-        return nullptr;
-    }
-
-    // Create a default node object
-    BTreeNode* node = new BTreeNode(order, leafOrder); // Pass order/leafOrder if needed by constructor
-    // Deserialize using the data read from the file
-    node->deserialize(pageData, order, leafOrder);
     // Set the page index for the node object
     node->pageIndex = pageIndex;
 
-     // Add a check after deserialization
-     if (node->keyCount < 0) { // Simple validity check based on deserialize logic
-          logger.log("BTree::fetchNode - Error: Deserialization failed for node " + std::to_string(pageIndex));
-          delete node;
-          return nullptr;
-     }
+    if (!node->isLeaf) nodeCache.emplace(pageIndex, *node);
+    return node;
+}
 
+// Internal node at pageIndex out of nodeCache, read into it on a miss. Returns
+// nullptr if the page holds a leaf (or cannot be read), leaving the leaf in
+// the pool for the caller to read next.
+const BTreeNode* BTree::internalNode(int pageIndex) {
+    auto cached = nodeCache.find(pageIndex);
+    if (cached != nodeCache.end()) return &cached->second;
+    if (pageIndex < 0) return nullptr;
+    {
+        PageHandle nodePage = bufferManager.getPage(indexName, pageIndex);
+        NodeImage image;
+        if (!parseNodeImage(nodePage->getRowRef(0), image) || image.isLeaf) return nullptr;
+    }
+    delete fetchNode(pageIndex); // decodes the node into nodeCache
+    cached = nodeCache.find(pageIndex);
+    return cached == nodeCache.end() ? nullptr : &cached->second;
+}
 
-    return node;
+void BTree::freeNodePage(int pageIndex) {
+    nodeCache.erase(pageIndex);
+    bufferManager.deleteFile(indexName, pageIndex);
 }
 
 void BTree::writeNode(BTreeNode* node) {
     if (!node || node->pageIndex < 0) return;
     // Added detailed logging before serialization
-    logger.log("BTree::writeNode - Preparing to write Node " + std::to_string(node->pageIndex) + " | In-memory keyCount: " + std::to_string(node->keyCount));
-    std::string keys_str = ""; for(int k : node->keys) keys_str += std::to_string(k) + " ";
-    logger.log("BTree::writeNode - In-memory Keys: [" + keys_str + "]");
-    if (node->isLeaf) {
-        std::string ptrs_str = ""; for(const auto& rp : node->recordPointers) ptrs_str += "{" + std::to_string(rp.first) + "," + std::to_string(rp.second) + "} ";
-        logger.log("BTree::writeNode - In-memory Record Pointers: [" + ptrs_str + "]");
-    } else {
-        std::string child_str = ""; for(int p : node->childrenPageIndices) child_str += std::to_string(p) + " ";
-        logger.log("BTree::writeNode - In-memory Child Pointers: [" + child_str + "]");
+    LOG_DEBUG("BTree::writeNode - Preparing to write Node " + std::to_string(node->pageIndex) + " | In-memory keyCount: " + std::to_string(node->keyCount));
+    if (logger.isEnabled(LOG_LEVEL_DEBUG)) {
+        std::string keys_str = ""; for(const IndexKey& k : node->keys) keys_str += k.toString(keyColumnCount) + " ";
+        LOG_DEBUG("BTree::writeNode - In-memory Keys: [" + keys_str + "]");
+        if (node->isLeaf) {
+            std::string ptrs_str = "";
+            for (const auto& posting : node->postings)
+                ptrs_str += posting.overflowPageIndex >= 0 ? "overflow@" + std::to_string(posting.overflowPageIndex) + " " : std::to_string(posting.pointers.size()) + " ";
+            LOG_DEBUG("BTree::writeNode - In-memory Posting List Sizes: [" + ptrs_str + "]");
+        } else {
+            std::string child_str = ""; for(int p : node->childrenPageIndices) child_str += std::to_string(p) + " ";
+            LOG_DEBUG("BTree::writeNode - In-memory Child Pointers: [" + child_str + "]");
+        }
     }
     // End of added logging
 
-    std::string nodeFileName = "../data/temp/" + indexName + "_Node" + std::to_string(node->pageIndex);
+    // Serialize the node's state into its page image
+    std::vector<int> image;
+    node->serialize(image);
+
+    // Deferred like any page write; the frame is written back when it is reused or flushed
+    int imageLength = image.size();
+    bufferManager.writePage(indexName, node->pageIndex, std::move(image), 1, imageLength);
+    if (node->isLeaf)
+        nodeCache.erase(node->pageIndex);
+    else
+        nodeCache.insert_or_assign(node->pageIndex, *node);
+     LOG_DEBUG("BTree::writeNode - Finished writing node " + std::to_string(node->pageIndex)); // Added Log
+}
 
-    // Serialize the node's state into the vector<vector<int>> format
-    std::vector<std::vector<int>> pageData;
-    node->serialize(pageData, order, leafOrder);
+// Long posting lists live in a chain of overflow pages, each page a row
+// [nextOverflowPageIndex, byteCount, encoded pointers...] whose pointers are
+// encoded on their own, so every page of the chain decodes by itself.
+void BTree::readOverflowChain(int headPageIndex, std::vector<RecordPointer>& pointers, std::vector<int>* pageIndices) {
+    for (int pageIndex = headPageIndex; pageIndex != -1;) {
+        PageHandle page = bufferManager.getPage(indexName, pageIndex);
+        RowSpan row = page->getRowRef(0);
+        if (row.size() < 2 || row[1] < 0 || (size_t)bytesToInts(row[1]) > row.size() - 2 ||
+            !decodePostings((const unsigned char*)(row.begin() + 2), row[1], pointers)) {
+            LOG_ERROR("BTree::readOverflowChain - ERROR: Overflow page " + std::to_string(pageIndex) + " of " + indexName + " is unreadable");
+            break;
+        }
+        if (pageIndices) pageIndices->push_back(pageIndex);
+        pageIndex = row[0];
+    }
+}
 
-    // Instead of BufferManager, write directly using ofstream
-    std::ofstream fout(nodeFileName, std::ios::trunc); // Truncate to overwrite
-    if (!fout.is_open()) {
-        logger.log("BTree::writeNode - Error: Could not open index node file for writing: " + nodeFileName);
-        return;
+// Writes pointers as an overflow chain, reusing the pages of the chain at
+// headPageIndex (and freeing those left over). Returns the chain's first page.
+int BTree::writeOverflowChain(const std::vector<RecordPointer>& pointers, int headPageIndex) {
+    std::vector<int> oldPages;
+    if (headPageIndex != -1) {
+        std::vector<RecordPointer> oldPointers;
+        readOverflowChain(headPageIndex, oldPointers, &oldPages);
     }
 
-    for (const auto& row : pageData) {
-        for (size_t i = 0; i < row.size(); ++i) {
-            fout << row[i] << (i == row.size() - 1 ? "" : " "); // Space separated
+    // Cut the list into pages first, so each page knows the one after it
+    std::vector<std::vector<unsigned char>> pageBytes(1);
+    RecordPointer previous = POSTING_START;
+    for (size_t i = 0; i < pointers.size(); i++) {
+        if (pageBytes.back().size() + encodedPointerBytes(previous, pointers[i]) > (size_t)overflowPageBytes) {
+            pageBytes.emplace_back();
+            previous = POSTING_START;
         }
-        fout << std::endl;
+        appendPointer(pageBytes.back(), previous, pointers[i]);
+        previous = pointers[i];
+    }
+
+    std::vector<int> pages = oldPages;
+    while (pages.size() < pageBytes.size()) pages.push_back(allocateNewNodePage());
+    for (size_t i = pageBytes.size(); i < pages.size(); i++) freeNodePage(pages[i]);
+    for (size_t i = 0; i < pageBytes.size(); i++) {
+        std::vector<int> row = {i + 1 < pageBytes.size() ? pages[i + 1] : -1, (int)pageBytes[i].size()};
+        std::vector<int> packed = packBytes(pageBytes[i]);
+        row.insert(row.end(), packed.begin(), packed.end());
+        int rowLength = row.size();
+        bufferManager.writePage(indexName, pages[i], std::move(row), 1, rowLength);
     }
-    fout.close();
-     logger.log("BTree::writeNode - Finished writing node " + std::to_string(node->pageIndex)); // Added Log
+    return pages[0];
+}
+
+void BTree::freeOverflowChain(int headPageIndex) {
+    std::vector<RecordPointer> pointers;
+    std::vector<int> pages;
+    readOverflowChain(headPageIndex, pointers, &pages);
+    for (int pageIndex : pages) freeNodePage(pageIndex);
+}
+
+void BTree::spillIfLong(PostingList& posting) {
+    if (posting.overflowPageIndex >= 0 || encodedPostingBytes(posting) <= (size_t)maxInlinePostingBytes) return;
+    posting.overflowPageIndex = writeOverflowChain(posting.pointers);
+    posting.pointers.clear();
+    posting.pointers.shrink_to_fit();
+}
+
+// Splits count items as evenly as possible over nodeCount nodes: node j gets
+// items [firstItem(j), firstItem(j + 1)), so no node ends up nearly empty.
+static long long firstItem(long long j, long long count, long long nodeCount) {
+    return j * count / nodeCount;
 }
 
+static long long nodeOfItem(long long i, long long count, long long nodeCount) {
+    return ((i + 1) * nodeCount - 1) / count;
+}
+
+// Bulk load: the (key columns..., page, row) entries of the table are sorted with
+// externalSort, so every key's posting list comes out in one piece and in
+// pointer order. A first pass over them sizes the lists and packs keys into
+// leaves filled to INDEX_FILL_FACTOR percent, the second writes the leaves
+// (and the overflow pages of long lists), and every internal level is then
+// written bottom-up from the first keys of the level below. Each page is
+// written once and never read back, instead of one descent and leaf rewrite
+// (plus splits) per row.
 bool BTree::buildIndex(Table* table) {
-    logger.log("BTree::buildIndex for table " + table->tableName + " on column " + columnName);
-    if (!table) { logger.log("BTree::buildIndex - Error: Null table pointer provided."); return false; }
+    if (!table) { LOG_ERROR("BTree::buildIndex - Error: Null table pointer provided."); return false; }
+    LOG_DEBUG("BTree::buildIndex for table " + table->tableName + " on column " + columnName);
     dropIndex();
-    Cursor cursor = table->getCursor();
-    std::vector<int> row = cursor.getNext();
-    long long rowsProcessed = 0;
-    while (!row.empty()) {
-         if (columnIndex < 0 || columnIndex >= row.size()) { // Check index validity
-             logger.log("BTree::buildIndex - Error: Invalid column index " + std::to_string(columnIndex) + " for row size " + std::to_string(row.size()) + ". Skipping row.");
-             row = cursor.getNext(); rowsProcessed++; continue;
-         }
-         int key = row[columnIndex];
-         int currentPageIndex = cursor.pageIndex;
-         int currentRowInPage = cursor.pagePointer - 1; // pagePointer is 1-based index of *next* row to read
-
-         if (cursor.pagePointer == 0) { // Handle page boundary wrap-around
-             if (currentPageIndex > 0) {
-                 Table* currentTable = tableCatalogue.getTable(tableName);
-                 if (currentTable && currentPageIndex - 1 < currentTable->rowsPerBlockCount.size()) {
-                     int rowsInPrevPage = currentTable->rowsPerBlockCount[currentPageIndex - 1];
-                     currentRowInPage = rowsInPrevPage - 1; // 0-based index
-                     currentPageIndex = currentPageIndex - 1; // Point to the actual page it came from
-                 } else { currentRowInPage = -1; } // Mark invalid if previous page info unavailable
-             } else { currentRowInPage = -1; } // Mark invalid if first page wrap (shouldn't happen)
-         }
+    for (int column : keyColumns) {
+        if (column < 0 || column >= (int)table->columnCount) {
+            LOG_ERROR("BTree::buildIndex - Error: Invalid column index " + std::to_string(column));
+            return false;
+        }
+    }
 
-         RecordPointer rp = {currentPageIndex, currentRowInPage};
-         if (rp.first >= 0 && rp.second >= 0) {
-             if (!insertKey(key, rp)) { logger.log("BTree::buildIndex - Failed to insert key: " + std::to_string(key) + " for row " + std::to_string(rowsProcessed)); }
-         } else { logger.log("BTree::buildIndex - Skipping row " + std::to_string(rowsProcessed) + " due to invalid pointer calculation."); }
+    std::vector<std::string> entryColumns;
+    std::vector<SortKey> sortKeys;
+    for (int c = 0; c < keyColumnCount + 2; c++) {
+        entryColumns.push_back(c < keyColumnCount ? "key" + std::to_string(c) : c == keyColumnCount ? "pageIndex" : "rowIndex");
+        sortKeys.push_back({c, true});
+    }
+    uint pageIndex = 0;
+    int rowIndex = 0;
+    PageHandle page;
+    auto nextEntry = [&]() -> std::vector<int> {
+        while (pageIndex < table->blockCount) {
+            if (!page.isValid()) page = bufferManager.getPage(table->tableName, pageIndex);
+            if (rowIndex < page->getRowCount()) {
+                RowSpan row = page->getRowRef(rowIndex);
+                std::vector<int> entry;
+                for (int column : keyColumns) entry.push_back(row[column]);
+                entry.push_back(pageIndex);
+                entry.push_back(rowIndex);
+                rowIndex++;
+                return entry;
+            }
+            page.release();
+            pageIndex++;
+            rowIndex = 0;
+        }
+        return {};
+    };
+    std::string sortedName = externalSort(indexName, entryColumns, sortKeys, nextEntry);
+    page.release();
+    if (sortedName.empty()) {
+        LOG_DEBUG("BTree::buildIndex - Table is empty, index left empty.");
+        return true;
+    }
 
-         row = cursor.getNext();
-         rowsProcessed++;
-         if (rowsProcessed % 5000 == 0 && rowsProcessed > 0) { logger.log("BTree::buildIndex - Processed " + std::to_string(rowsProcessed) + " rows..."); }
+    // The sorted entries, read back one key and its posting list at a time
+    std::unique_ptr<Cursor> cursor;
+    std::vector<int> entry;
+    auto rewind = [&]() {
+        cursor.reset(new Cursor(sortedName, 0));
+        entry = cursor->getNext();
+    };
+    auto entryKey = [&]() {
+        IndexKey key;
+        for (int c = 0; c < keyColumnCount; c++) key[c] = entry[c];
+        return key;
+    };
+    auto nextPosting = [&](IndexKey& key, PostingList& posting) {
+        posting = PostingList();
+        if (entry.empty()) return false;
+        key = entryKey();
+        while (!entry.empty() && entryKey() == key) {
+            posting.pointers.push_back({entry[keyColumnCount], entry[keyColumnCount + 1]});
+            entry = cursor->getNext();
+        }
+        return true;
+    };
+
+    // Keys per leaf: a leaf is closed when the next key would take its image past the fill factor
+    int targetInts = std::max(1, std::min(pageInts, (int)(pageInts * INDEX_FILL_FACTOR / 100)));
+    std::vector<long long> leafKeyCounts;
+    long long keyCount = 0, keysInLeaf = 0;
+    size_t bytesInLeaf = 0;
+    IndexKey key;
+    KeySpan treeSpan, leafSpan;
+    PostingList posting;
+    rewind();
+    while (nextPosting(key, posting)) {
+        size_t bytes = encodedPostingBytes(posting);
+        if (bytes > (size_t)maxInlinePostingBytes) bytes = 5; // only its overflow page index (a varint) stays in the leaf
+        KeySpan grown = leafSpan;
+        grown.add(key, keyColumnCount);
+        if (keysInLeaf > 0 && nodeImageInts(keysInLeaf + 1, grown.keyBits(keyColumnCount), keyColumnCount, keysInLeaf + 1, (uint32_t)(bytesInLeaf + bytes) << 1 | 1, bytesInLeaf + bytes) > targetInts) {
+            leafKeyCounts.push_back(keysInLeaf);
+            keysInLeaf = 0;
+            bytesInLeaf = 0;
+            grown = KeySpan();
+            grown.add(key, keyColumnCount);
+        }
+        leafSpan = grown;
+        treeSpan.add(key, keyColumnCount);
+        keysInLeaf++;
+        bytesInLeaf += bytes;
+        keyCount++;
+    }
+    leafKeyCounts.push_back(keysInLeaf);
+
+    // Children per internal node: as many as fit the fill factor with keys
+    // spanning the whole key range, the widest any node's keys can span
+    int treeKeyBits = treeSpan.keyBits(keyColumnCount);
+    int fanout = 2;
+    while (nodeImageInts(fanout, treeKeyBits, keyColumnCount, fanout + 1, fanout, 0) <= targetInts)
+        fanout++;
+
+    // Nodes per level (leaves first) and the page index each level starts at
+    std::vector<long long> levelSizes = {(long long)leafKeyCounts.size()};
+    while (levelSizes.back() > 1)
+        levelSizes.push_back((levelSizes.back() + fanout - 1) / fanout);
+    std::vector<long long> levelStarts = {0};
+    for (size_t level = 0; level + 1 < levelSizes.size(); level++)
+        levelStarts.push_back(levelStarts.back() + levelSizes[level]);
+    auto parentOf = [&](size_t level, long long node) {
+        if (level + 1 == levelSizes.size()) return -1;
+        return (int)(levelStarts[level + 1] + nodeOfItem(node, levelSizes[level], levelSizes[level + 1]));
+    };
+    // Overflow pages are handed out after the nodes
+    nodeCount = levelStarts.back() + levelSizes.back();
+    rootPageIndex = nodeCount - 1;
+    height = levelSizes.size();
+
+    // Leaves, straight from the sorted entries
+    std::vector<IndexKey> firstKeys; // smallest key under each node of the level just written
+    rewind();
+    for (long long leafNumber = 0; leafNumber < levelSizes[0]; leafNumber++) {
+        BTreeNode leaf(/*isLeaf=*/true, keyColumnCount);
+        leaf.pageIndex = levelStarts[0] + leafNumber;
+        leaf.parentPageIndex = parentOf(0, leafNumber);
+        leaf.nextLeafPageIndex = leafNumber + 1 < levelSizes[0] ? leaf.pageIndex + 1 : -1;
+        for (long long i = 0; i < leafKeyCounts[leafNumber]; i++) {
+            if (!nextPosting(key, posting)) { LOG_ERROR("BTree::buildIndex - Error: Sorted entries ended early."); break; }
+            spillIfLong(posting);
+            leaf.keys.push_back(key);
+            leaf.postings.push_back(std::move(posting));
+        }
+        leaf.keyCount = leaf.keys.size();
+        firstKeys.push_back(leaf.keys.empty() ? IndexKey(INT_MIN) : leaf.keys[0]);
+        writeNode(&leaf);
+    }
+    long long entryCount = tableCatalogue.getTable(sortedName)->rowCount;
+    cursor.reset(); // let go of its page before the sorted entries are deleted
+    tableCatalogue.deleteTable(sortedName);
+
+    // Internal levels, bottom-up: a child's separator is the smallest key under it
+    for (size_t level = 1; level < levelSizes.size(); level++) {
+        std::vector<IndexKey> levelFirstKeys;
+        for (long long nodeNumber = 0; nodeNumber < levelSizes[level]; nodeNumber++) {
+            BTreeNode node(/*isLeaf=*/false, keyColumnCount);
+            node.pageIndex = levelStarts[level] + nodeNumber;
+            node.parentPageIndex = parentOf(level, nodeNumber);
+            long long firstChild = firstItem(nodeNumber, levelSizes[level - 1], levelSizes[level]);
+            long long lastChild = firstItem(nodeNumber + 1, levelSizes[level - 1], levelSizes[level]);
+            for (long long child = firstChild; child < lastChild; child++) {
+                if (child > firstChild) node.keys.push_back(firstKeys[child]);
+                node.childrenPageIndices.push_back(levelStarts[level - 1] + child);
+            }
+            node.keyCount = node.keys.size();
+            levelFirstKeys.push_back(firstKeys[firstChild]);
+            writeNode(&node);
+        }
+        firstKeys.swap(levelFirstKeys);
     }
-    logger.log("BTree::buildIndex - Completed processing " + std::to_string(rowsProcessed) + " rows.");
+
+    LOG_DEBUG("BTree::buildIndex - Bulk loaded " + std::to_string(entryCount) + " entries of " + std::to_string(keyCount) + " keys into " + std::to_string(levelStarts.back() + levelSizes.back()) + " nodes (" + std::to_string(levelSizes.size()) + " level(s)) and " + std::to_string(nodeCount - rootPageIndex - 1) + " overflow pages.");
     return true;
 }
 
 bool BTree::dropIndex() {
-    logger.log("BTree::dropIndex - Dropping index: " + indexName);
+    LOG_DEBUG("BTree::dropIndex - Dropping index: " + indexName);
     for (int i = 0; i < nodeCount; ++i) {
-        std::string nodePageFileName = "../data/temp/" + indexName + "_Node" + std::to_string(i);
-        bufferManager.deleteFile(nodePageFileName);
+        freeNodePage(i);
     }
     rootPageIndex = -1;
     nodeCount = 0;
+    height = 0;
+    return true;
+}
+
+/**
+ * @brief Pages read by a lookup: one node per level on the way down to the
+ * first leaf and then the leaves (or overflow pages) holding the posting
+ * lists of the matching entries.
+ */
+double BTree::estimateLookupPages(double tableRows, double matchingRows) const {
+    double pageBytes = pageInts * sizeof(int);
+    return std::max(1, height) + std::ceil(matchingRows * ESTIMATED_POINTER_BYTES / pageBytes);
+}
+
+// {pageInts, root, nodeCount, height, keyColumnCount, key columns (padded with -1)}
+void BTree::writeMetadata(std::ostream& out) const {
+    int32_t metadata[5 + IndexKey::MAX_COLUMNS] = {pageInts, rootPageIndex, nodeCount, height, keyColumnCount};
+    for (int c = 0; c < IndexKey::MAX_COLUMNS; c++) metadata[5 + c] = c < keyColumnCount ? keyColumns[c] : -1;
+    out.write((const char*)metadata, sizeof(metadata));
+}
+
+bool BTree::readMetadata(std::istream& in) {
+    int32_t metadata[5 + IndexKey::MAX_COLUMNS];
+    if (!in.read((char*)metadata, sizeof(metadata)) || metadata[0] != pageInts || metadata[4] != keyColumnCount)
+        return false;
+    for (int c = 0; c < keyColumnCount; c++)
+        if (metadata[5 + c] != keyColumns[c]) return false;
+    rootPageIndex = metadata[1];
+    nodeCount = metadata[2];
+    height = metadata[3];
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Index Implementation
+//------------------------------------------------------------------------------
+
+Index::Index(const std::string& tblName, const std::string& colName, const std::vector<int>& keyCols, const std::string& idxName) :
+    indexName(idxName),
+    tableName(tblName),
+    columnName(colName),
+    keyColumns(keyCols),
+    columnIndex(keyCols.empty() ? -1 : keyCols[0])
+{
+}
+
+/**
+ * @brief Creates an empty index of the given kind on the key columns (one,
+ * or several for a B+ tree), nullptr for NOTHING.
+ */
+Index* Index::create(IndexingStrategy strategy, const std::string& tableName, const std::string& columnName, const std::vector<int>& keyColumns) {
+    switch (strategy) {
+        case BTREE:
+            return new BTree(tableName, columnName, keyColumns);
+        case HASH:
+            return new HashIndex(tableName, columnName, keyColumns);
+        default:
+            return nullptr;
+    }
+}
+
+std::string Index::columnListName(const std::vector<std::string>& columns) {
+    std::string name;
+    for (size_t i = 0; i < columns.size(); i++)
+        name += (i ? "," : "") + columns[i];
+    return name;
+}
+
+std::string IndexKey::toString(int columnCount) const {
+    if (columnCount == 1) return std::to_string(values[0]);
+    std::string text = "(";
+    for (int c = 0; c < columnCount; c++)
+        text += (c ? ", " : "") + std::to_string(values[c]);
+    return text + ")";
+}
+
+//------------------------------------------------------------------------------
+// Persistence
+//------------------------------------------------------------------------------
+
+const uint32_t INDEX_FILE_MAGIC = 0x58444E49; // "INDX" on little-endian machines
+const uint32_t INDEX_FILE_VERSION = 6;
+const int INDEX_CHECK_SAMPLE_ROWS = 64; // rows of the table matchesPages looks up
+
+/**
+ * @brief Start of a persisted index file. pageChecksum is that of the table's
+ * pages when the index was saved (see Table::pageChecksum). It is followed by
+ * the rowsPerBlockCount of the table the index was saved for (blockCount
+ * uint32s), the metadata of the kind of index (see writeMetadata) and then by
+ * pageCount pages, each an int32 page index, a uint32 length and the raw page
+ * image as StorageManager stores it.
+ */
+struct IndexFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t strategy;
+    int32_t columnIndex;
+    int32_t textPages; // page images are only readable in the mode they were written in
+    int64_t rowCount;
+    int32_t blockCount;
+    int32_t pageCount;
+    uint64_t pageChecksum;
+};
+
+// Lives next to the table's csv in the data folder
+std::string Index::persistentFileName() const {
+    return "../data/" + indexName + ".idx";
+}
+
+/**
+ * @brief Looks up rows spread evenly over the table and checks that the index
+ * points at each of them under its key. An index that missed a rewrite of the
+ * table's pages points at rows that have since moved and fails this.
+ *
+ * @return true if every sampled row was found
+ */
+bool Index::matchesPages(const Table* table) {
+    long long rowCount = table->rowCount;
+    long long sampleRows = std::min<long long>(INDEX_CHECK_SAMPLE_ROWS, rowCount);
+    uint pageIndex = 0;
+    long long pageStart = 0; // rows in the pages before pageIndex
+    for (long long sample = 0; sample < sampleRows; ++sample) {
+        long long row = sample * rowCount / sampleRows;
+        while (pageIndex < table->blockCount && row >= pageStart + table->rowsPerBlockCount[pageIndex])
+            pageStart += table->rowsPerBlockCount[pageIndex++];
+        if (pageIndex == table->blockCount)
+            return false;
+        RecordPointer pointer = {(int)pageIndex, (int)(row - pageStart)};
+        PageHandle page = bufferManager.getPage(table->tableName, pageIndex);
+        std::vector<RecordPointer> pointers = searchKey(keyOf(page->getRowRef(pointer.second)));
+        if (std::find(pointers.begin(), pointers.end(), pointer) == pointers.end())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the index (its metadata and the raw images of its pages) to
+ * persistentFileName so restore can attach it again after the table is next
+ * loaded. The rows per page of the table and the checksum of its pages are
+ * saved with it: record pointers only stay valid if the table is laid out the
+ * same way again.
+ *
+ * @return true on success
+ */
+bool Index::save(const Table* table, uint64_t pageChecksum) {
+    LOG_DEBUG("Index::save - Saving index " + indexName + " to " + persistentFileName());
+    bufferManager.flushTable(indexName); // pages still dirty in the pool
+
+    std::vector<std::pair<int, std::vector<char>>> pages;
+    for (int i = 0; i < getPageCount(); ++i) {
+        std::vector<char> buffer;
+        if (storageManager.readPage(indexName, i, buffer)) // pages freed since are gone
+            pages.emplace_back(i, std::move(buffer));
+    }
+
+    std::ofstream fout(persistentFileName(), std::ios::binary | std::ios::trunc);
+    if (!fout.is_open()) {
+        LOG_ERROR("Index::save - ERROR: Could not open " + persistentFileName());
+        return false;
+    }
+    IndexFileHeader header = {INDEX_FILE_MAGIC, INDEX_FILE_VERSION, getStrategy(), columnIndex,
+                              TEXT_PAGES, table->rowCount, (int32_t)table->blockCount, (int32_t)pages.size(), pageChecksum};
+    fout.write((const char*)&header, sizeof(header));
+    fout.write((const char*)table->rowsPerBlockCount.data(), table->blockCount * sizeof(uint));
+    writeMetadata(fout);
+    for (const auto& [pageIndex, buffer] : pages) {
+        int32_t index = pageIndex;
+        uint32_t length = buffer.size();
+        fout.write((const char*)&index, sizeof(index));
+        fout.write((const char*)&length, sizeof(length));
+        fout.write(buffer.data(), length);
+    }
+    return fout.good();
+}
+
+/**
+ * @brief Attaches the index saved in persistentFileName, copying its pages
+ * into the index's segment as they are, without decoding or sorting anything.
+ * The file is refused if it is older than the table's csv or does not match
+ * the table as loaded (row count, rows per page, checksum of its pages), the
+ * column or the kind and page sizes of the index, in which case the index has
+ * to be built again.
+ *
+ * @return true if the saved index was attached
+ */
+bool Index::restore(const Table* table, uint64_t pageChecksum) {
+    struct stat indexStat, sourceStat;
+    std::string fileName = persistentFileName();
+    if (stat(fileName.c_str(), &indexStat) || stat(table->sourceFileName.c_str(), &sourceStat) ||
+        std::make_pair(indexStat.st_mtim.tv_sec, indexStat.st_mtim.tv_nsec) < std::make_pair(sourceStat.st_mtim.tv_sec, sourceStat.st_mtim.tv_nsec)) {
+        LOG_DEBUG("Index::restore - " + fileName + " is missing or older than " + table->sourceFileName);
+        return false;
+    }
+    std::ifstream fin(fileName, std::ios::binary);
+    IndexFileHeader header;
+    if (!fin.read((char*)&header, sizeof(header)) || header.magic != INDEX_FILE_MAGIC || header.version != INDEX_FILE_VERSION ||
+        header.strategy != getStrategy() || header.columnIndex != columnIndex || header.textPages != TEXT_PAGES ||
+        header.rowCount != table->rowCount || header.blockCount != (int32_t)table->blockCount || header.pageChecksum != pageChecksum) {
+        LOG_WARNING("Index::restore - " + fileName + " does not match table " + table->tableName);
+        return false;
+    }
+    std::vector<uint> rowsPerBlockCount(header.blockCount);
+    if (!fin.read((char*)rowsPerBlockCount.data(), header.blockCount * sizeof(uint)) || rowsPerBlockCount != table->rowsPerBlockCount) {
+        LOG_WARNING("Index::restore - " + fileName + " was saved for a different page layout of " + table->tableName);
+        return false;
+    }
+
+    dropIndex();
+    if (!readMetadata(fin)) {
+        LOG_WARNING("Index::restore - " + fileName + " was saved with different page sizes");
+        dropIndex();
+        return false;
+    }
+    std::vector<char> buffer;
+    for (int i = 0; i < header.pageCount; ++i) {
+        int32_t pageIndex;
+        uint32_t length;
+        if (!fin.read((char*)&pageIndex, sizeof(pageIndex)) || !fin.read((char*)&length, sizeof(length)) || pageIndex < 0 || pageIndex >= getPageCount()) {
+            LOG_ERROR("Index::restore - ERROR: Corrupt page entry in " + fileName);
+            dropIndex();
+            return false;
+        }
+        buffer.resize(length);
+        if (!fin.read(buffer.data(), length) || !storageManager.writePage(indexName, pageIndex, buffer.data(), length)) {
+            LOG_ERROR("Index::restore - ERROR: Could not restore page " + std::to_string(pageIndex) + " from " + fileName);
+            dropIndex();
+            return false;
+        }
+    }
+    LOG_DEBUG("Index::restore - Attached " + std::to_string(header.pageCount) + " pages of " + indexName + " from " + fileName);
     return true;
 }
 
-int BTree::findLeafNodePageIndex(int key, int currentRootPageIndex) {
+int BTree::findLeafNodePageIndex(const IndexKey& key, int currentRootPageIndex) {
      if (currentRootPageIndex < 0) { return -1; }
      int currentPageIndex = currentRootPageIndex;
-     BTreeNode* node = fetchNode(currentPageIndex);
-     while (node && !node->isLeaf) {
+     while (const BTreeNode* node = internalNode(currentPageIndex)) {
          int childPointerFollowIndex = node->findChildIndex(key);
          if (childPointerFollowIndex < 0 || childPointerFollowIndex >= node->childrenPageIndices.size()) {
-             logger.log("BTree::findLeafNodePageIndex - Error: Invalid child pointer index " + std::to_string(childPointerFollowIndex) + " calculated in node " + std::to_string(node->pageIndex) + " for key " + std::to_string(key));
-             delete node; return -1;
+             LOG_ERROR("BTree::findLeafNodePageIndex - Error: Invalid child pointer index " + std::to_string(childPointerFollowIndex) + " calculated in node " + std::to_string(node->pageIndex) + " for key " + key.toString(keyColumnCount));
+             return -1;
          }
-         int nextPageIndex = node->childrenPageIndices[childPointerFollowIndex];
-         currentPageIndex = nextPageIndex;
-         delete node;
-         node = fetchNode(nextPageIndex);
+         currentPageIndex = node->childrenPageIndices[childPointerFollowIndex];
      }
-      if (!node) { logger.log("BTree::findLeafNodePageIndex - Error: Failed to fetch leaf node at page index " + std::to_string(currentPageIndex)); return -1; }
-     delete node;
      return currentPageIndex;
 }
 
-void BTree::startNewTree(int key, RecordPointer pointer) {
+void BTree::startNewTree(const IndexKey& key, RecordPointer pointer) {
     rootPageIndex = allocateNewNodePage();
-    BTreeNode* rootNode = new BTreeNode(order, leafOrder, /*isLeaf=*/true);
+    BTreeNode* rootNode = new BTreeNode(/*isLeaf=*/true, keyColumnCount);
     rootNode->pageIndex = rootPageIndex;
     rootNode->parentPageIndex = -1;
-    rootNode->insertLeafEntry(key, pointer, 0); // Use helper
+    PostingList posting;
+    posting.pointers.push_back(pointer);
+    rootNode->insertLeafEntry(key, posting, 0); // Use helper
     rootNode->nextLeafPageIndex = -1;
     writeNode(rootNode);
     delete rootNode;
-    logger.log("BTree::startNewTree - Created new root (leaf) at page " + std::to_string(rootPageIndex));
+    height = 1;
+    LOG_DEBUG("BTree::startNewTree - Created new root (leaf) at page " + std::to_string(rootPageIndex));
 }
 
-void BTree::insertIntoLeaf(int leafPageIndex, int key, RecordPointer pointer) {
-    logger.log("BTree::insertIntoLeaf - Called for Key: " + std::to_string(key) + " Pointer: {" + std::to_string(pointer.first) + "," + std::to_string(pointer.second) + "} into Page: " + std::to_string(leafPageIndex)); // Added Log
+// Adds pointer to the posting list of key, adding the key to the leaf if it is
+// new there. A leaf that no longer fits its page is split by size, so both
+// halves hold about as many bytes; every key stays in exactly one leaf.
+void BTree::insertIntoLeaf(int leafPageIndex, const IndexKey& key, RecordPointer pointer) {
+    LOG_DEBUG("BTree::insertIntoLeaf - Called for Key: " + key.toString(keyColumnCount) + " Pointer: {" + std::to_string(pointer.first) + "," + std::to_string(pointer.second) + "} into Page: " + std::to_string(leafPageIndex)); // Added Log
     BTreeNode* leaf = fetchNode(leafPageIndex);
-    if (!leaf) { logger.log("BTree::insertIntoLeaf - Error: Could not fetch leaf node " + std::to_string(leafPageIndex)); return; }
-    logger.log("BTree::insertIntoLeaf - Fetched node " + std::to_string(leafPageIndex) + ". Current keyCount: " + std::to_string(leaf->keyCount)); // Added Log
+    if (!leaf) { LOG_ERROR("BTree::insertIntoLeaf - Error: Could not fetch leaf node " + std::to_string(leafPageIndex)); return; }
     auto it = std::lower_bound(leaf->keys.begin(), leaf->keys.end(), key);
     int insertPos = std::distance(leaf->keys.begin(), it);
-    logger.log("BTree::insertIntoLeaf - Page " + std::to_string(leafPageIndex) + " InsertPos: " + std::to_string(insertPos)); // Added Log
 
-    if (!leaf->isFull(order, leafOrder)) {
-        logger.log("BTree::insertIntoLeaf - Inserting into non-full leaf."); // Added Log
-        leaf->insertLeafEntry(key, pointer, insertPos);
-        logger.log("BTree::insertIntoLeaf - After insertLeafEntry, keyCount: " + std::to_string(leaf->keyCount) + ". Calling writeNode."); // Added Log
+    if (it != leaf->keys.end() && *it == key) {
+        PostingList& posting = leaf->postings[insertPos];
+        if (posting.overflowPageIndex >= 0) {
+            // The leaf only holds where the chain starts, which stays where it is
+            std::vector<RecordPointer> pointers;
+            readOverflowChain(posting.overflowPageIndex, pointers);
+            auto at = std::lower_bound(pointers.begin(), pointers.end(), pointer);
+            if (at == pointers.end() || *at != pointer) {
+                pointers.insert(at, pointer);
+                writeOverflowChain(pointers, posting.overflowPageIndex);
+            }
+            delete leaf;
+            return;
+        }
+        auto at = std::lower_bound(posting.pointers.begin(), posting.pointers.end(), pointer);
+        if (at != posting.pointers.end() && *at == pointer) { delete leaf; return; } // already indexed
+        posting.pointers.insert(at, pointer);
+        spillIfLong(posting);
+    } else {
+        PostingList posting;
+        posting.pointers.push_back(pointer);
+        leaf->insertLeafEntry(key, posting, insertPos);
+    }
+
+    if (leaf->imageInts() <= pageInts) {
         writeNode(leaf);
     } else {
-        logger.log("BTree::insertIntoLeaf - Leaf is full. Splitting."); // Added Log
-        std::vector<int> tempKeys = leaf->keys;
-        std::vector<RecordPointer> tempPointers = leaf->recordPointers;
-        tempKeys.insert(tempKeys.begin() + insertPos, key);
-        tempPointers.insert(tempPointers.begin() + insertPos, pointer);
+        LOG_DEBUG("BTree::insertIntoLeaf - Leaf is full. Splitting."); // Added Log
+        // Split where the larger half's image is smallest; with no entry over
+        // half a leaf, both halves then fit in one
+        std::vector<size_t> leftBytes = {0}; // posting bytes of the first i entries
+        for (const PostingList& posting : leaf->postings)
+            leftBytes.push_back(leftBytes.back() + leafPostingBytes(posting));
+        // Spans of the keys before i (prefixSpans[i]) and from i on (suffixSpans[i])
+        std::vector<KeySpan> prefixSpans(leaf->keyCount + 1), suffixSpans(leaf->keyCount + 1);
+        for (int i = 0; i < leaf->keyCount; i++) {
+            prefixSpans[i + 1] = prefixSpans[i];
+            prefixSpans[i + 1].add(leaf->keys[i], keyColumnCount);
+        }
+        for (int i = leaf->keyCount - 1; i >= 0; i--) {
+            suffixSpans[i] = suffixSpans[i + 1];
+            suffixSpans[i].add(leaf->keys[i], keyColumnCount);
+        }
+        auto imageOf = [&](int first, int last) {
+            size_t bytes = leftBytes[last] - leftBytes[first];
+            const KeySpan& span = first == 0 ? prefixSpans[last] : suffixSpans[first];
+            return nodeImageInts(last - first, span.keyBits(keyColumnCount), keyColumnCount, last - first, (uint32_t)bytes << 1 | 1, bytes);
+        };
+        int midPoint = 1, midPointInts = std::max(imageOf(0, 1), imageOf(1, leaf->keyCount));
+        for (int i = 2; i < leaf->keyCount; i++) {
+            int ints = std::max(imageOf(0, i), imageOf(i, leaf->keyCount));
+            if (ints < midPointInts) { midPoint = i; midPointInts = ints; }
+        }
+
         int newRightNodePageIndex = allocateNewNodePage();
-        BTreeNode* rightNode = new BTreeNode(order, leafOrder, /*isLeaf=*/true);
+        BTreeNode* rightNode = new BTreeNode(/*isLeaf=*/true, keyColumnCount);
         rightNode->pageIndex = newRightNodePageIndex;
         rightNode->parentPageIndex = leaf->parentPageIndex;
-        int midPoint = (leafOrder + 1) / 2;
-        int splitKey = tempKeys[midPoint];
+        IndexKey splitKey = leaf->keys[midPoint];
         // Assign data to new right node
-        rightNode->keys.assign(tempKeys.begin() + midPoint, tempKeys.end());
-        rightNode->recordPointers.assign(tempPointers.begin() + midPoint, tempPointers.end());
+        rightNode->keys.assign(leaf->keys.begin() + midPoint, leaf->keys.end());
+        rightNode->postings.assign(leaf->postings.begin() + midPoint, leaf->postings.end());
         rightNode->keyCount = rightNode->keys.size();
         // Update original left node
-        leaf->keys.assign(tempKeys.begin(), tempKeys.begin() + midPoint);
-        leaf->recordPointers.assign(tempPointers.begin(), tempPointers.begin() + midPoint);
+        leaf->keys.resize(midPoint);
+        leaf->postings.resize(midPoint);
         leaf->keyCount = midPoint;
         // Update linked list pointers
         rightNode->nextLeafPageIndex = leaf->nextLeafPageIndex;
         leaf->nextLeafPageIndex = newRightNodePageIndex;
 
-        logger.log("BTree::insertIntoLeaf - Writing split nodes. Left (" + std::to_string(leaf->pageIndex) + ") keyCount: " + std::to_string(leaf->keyCount) + ". Right (" + std::to_string(rightNode->pageIndex) + ") keyCount: " + std::to_string(rightNode->keyCount)); // Added Log
+        LOG_DEBUG("BTree::insertIntoLeaf - Writing split nodes. Left (" + std::to_string(leaf->pageIndex) + ") keyCount: " + std::to_string(leaf->keyCount) + ". Right (" + std::to_string(rightNode->pageIndex) + ") keyCount: " + std::to_string(rightNode->keyCount)); // Added Log
         writeNode(leaf);
         writeNode(rightNode);
         insertIntoParent(leaf->pageIndex, splitKey, newRightNodePageIndex);
         delete rightNode;
     }
     delete leaf;
-    logger.log("BTree::insertIntoLeaf - Finished for Key: " + std::to_string(key)); // Added Log
+    LOG_DEBUG("BTree::insertIntoLeaf - Finished for Key: " + key.toString(keyColumnCount)); // Added Log
 }
 
-void BTree::insertIntoParent(int leftChildPageIndex, int key, int rightChildPageIndex) {
+void BTree::insertIntoParent(int leftChildPageIndex, const IndexKey& key, int rightChildPageIndex) {
     BTreeNode* leftChild = fetchNode(leftChildPageIndex);
-    if (!leftChild) { logger.log("BTree::insertIntoParent - Error: Failed fetch left child " + std::to_string(leftChildPageIndex)); return; }
+    if (!leftChild) { LOG_ERROR("BTree::insertIntoParent - Error: Failed fetch left child " + std::to_string(leftChildPageIndex)); return; }
     int parentPageIndex = leftChild->parentPageIndex;
     delete leftChild;
 
     if (parentPageIndex == -1) { // Create new root
         int newRootPageIndex = allocateNewNodePage();
-        BTreeNode* newRoot = new BTreeNode(order, leafOrder, /*isLeaf=*/false);
+        BTreeNode* newRoot = new BTreeNode(/*isLeaf=*/false, keyColumnCount);
         newRoot->pageIndex = newRootPageIndex;
         newRoot->parentPageIndex = -1; // Root's parent is -1
 
@@ -556,7 +1330,7 @@ void BTree::insertIntoParent(int leftChildPageIndex, int key, int rightChildPage
         // newRoot->insertInternalEntry(key, rightChildPageIndex, 0); // This was causing issues
         // newRoot->childrenPageIndices[0] = leftChildPageIndex; // This was overwriting incorrectly
 
-        logger.log("BTree::insertIntoParent - Writing new root node " + std::to_string(newRootPageIndex)); // Added log for clarity
+        LOG_DEBUG("BTree::insertIntoParent - Writing new root node " + std::to_string(newRootPageIndex)); // Added log for clarity
         writeNode(newRoot); // Write the correctly formed root node
 
         // Update parent pointers of the children nodes to point to the new root
@@ -567,45 +1341,44 @@ void BTree::insertIntoParent(int leftChildPageIndex, int key, int rightChildPage
             writeNode(left);
             delete left;
         } else {
-            logger.log("BTree::insertIntoParent - WARNING: Could not fetch left child " + std::to_string(leftChildPageIndex) + " to update parent pointer.");
+            LOG_ERROR("BTree::insertIntoParent - WARNING: Could not fetch left child " + std::to_string(leftChildPageIndex) + " to update parent pointer.");
         }
         if(right) {
             right->parentPageIndex = newRootPageIndex;
             writeNode(right);
             delete right;
         } else {
-             logger.log("BTree::insertIntoParent - WARNING: Could not fetch right child " + std::to_string(rightChildPageIndex) + " to update parent pointer.");
+             LOG_ERROR("BTree::insertIntoParent - WARNING: Could not fetch right child " + std::to_string(rightChildPageIndex) + " to update parent pointer.");
         }
 
         rootPageIndex = newRootPageIndex; // Update the BTree's root page index
+        height++;
         // metadataManager.updateRootPage(rootPageIndex); // Assuming you have metadata persistence
         delete newRoot; // Delete the in-memory representation
-        logger.log("BTree::insertIntoParent - Created new root at page " + std::to_string(newRootPageIndex));
+        LOG_DEBUG("BTree::insertIntoParent - Created new root at page " + std::to_string(newRootPageIndex));
         return; // Finished creating the new root
     }
 
     BTreeNode* parentNode = fetchNode(parentPageIndex);
-    if (!parentNode) { logger.log("BTree::insertIntoParent - Error: Could not fetch parent node " + std::to_string(parentPageIndex)); return; }
+    if (!parentNode) { LOG_ERROR("BTree::insertIntoParent - Error: Could not fetch parent node " + std::to_string(parentPageIndex)); return; }
     auto it = std::lower_bound(parentNode->keys.begin(), parentNode->keys.end(), key);
     int insertPos = std::distance(parentNode->keys.begin(), it);
 
-    if (!parentNode->isFull(order, leafOrder)) { // Parent has space
-        parentNode->insertInternalEntry(key, rightChildPageIndex, insertPos);
+    parentNode->insertInternalEntry(key, rightChildPageIndex, insertPos);
+    if (parentNode->imageInts() <= pageInts) { // Parent has space
         writeNode(parentNode);
         BTreeNode* rightChild = fetchNode(rightChildPageIndex);
         if(rightChild) { rightChild->parentPageIndex = parentNode->pageIndex; writeNode(rightChild); delete rightChild; }
     } else { // Parent is full, split parent
-        std::vector<int> tempKeys = parentNode->keys;
+        std::vector<IndexKey> tempKeys = parentNode->keys;
         std::vector<int> tempChildren = parentNode->childrenPageIndices;
-        tempKeys.insert(tempKeys.begin() + insertPos, key);
-        tempChildren.insert(tempChildren.begin() + insertPos + 1, rightChildPageIndex);
         int newParentRightPageIndex = allocateNewNodePage();
-        BTreeNode* rightParentNode = new BTreeNode(order, leafOrder, /*isLeaf=*/false);
+        BTreeNode* rightParentNode = new BTreeNode(/*isLeaf=*/false, keyColumnCount);
         rightParentNode->pageIndex = newParentRightPageIndex;
         rightParentNode->parentPageIndex = parentNode->parentPageIndex;
-        int leftPointersCount = std::ceil(static_cast<double>(order + 1) / 2.0);
+        int leftPointersCount = (tempChildren.size() + 1) / 2;
         int keyUpIndex = leftPointersCount - 1;
-        int parentSplitKey = tempKeys[keyUpIndex];
+        IndexKey parentSplitKey = tempKeys[keyUpIndex];
         rightParentNode->keys.assign(tempKeys.begin() + keyUpIndex + 1, tempKeys.end());
         rightParentNode->childrenPageIndices.assign(tempChildren.begin() + leftPointersCount, tempChildren.end());
         rightParentNode->keyCount = rightParentNode->keys.size();
@@ -625,61 +1398,89 @@ void BTree::insertIntoParent(int leftChildPageIndex, int key, int rightChildPage
 }
 
 // --- Stubs and implementations for splitLeafNode, splitInternalNode ---
-void BTree::splitLeafNode(BTreeNode* leafNode, int& splitKey, int& newRightNodePageIndex) {
+void BTree::splitLeafNode(BTreeNode* leafNode, IndexKey& splitKey, int& newRightNodePageIndex) {
     // This logic is now integrated into insertIntoLeaf when node is full.
     // Keeping the signature might be useful for potential refactoring or direct calls.
-    logger.log("BTree::splitLeafNode - Note: Logic is handled within insertIntoLeaf.");
+    LOG_DEBUG("BTree::splitLeafNode - Note: Logic is handled within insertIntoLeaf.");
     // The actual splitting happens there based on temporary vectors.
 }
 
-void BTree::splitInternalNode(BTreeNode* internalNode, int& splitKey, int& newRightNodePageIndex) {
+void BTree::splitInternalNode(BTreeNode* internalNode, IndexKey& splitKey, int& newRightNodePageIndex) {
      // This logic is now integrated into insertIntoParent when node is full.
-    logger.log("BTree::splitInternalNode - Note: Logic is handled within insertIntoParent.");
+    LOG_DEBUG("BTree::splitInternalNode - Note: Logic is handled within insertIntoParent.");
 }
 
 // --- Deletion Implementation ---
-bool BTree::deleteKey(int key) {
-    logger.log("BTree::deleteKey - Attempting to delete key: " + std::to_string(key));
-    if (rootPageIndex == -1) { logger.log("BTree::deleteKey - Tree is empty."); return false; }
+// A key and all of its entries are in one leaf, so deleting it touches that
+// leaf (and the overflow pages of its posting list) only.
+bool BTree::deleteKey(const IndexKey& key) {
+    LOG_DEBUG("BTree::deleteKey - Attempting to delete key: " + key.toString(keyColumnCount));
+    if (rootPageIndex == -1) { LOG_DEBUG("BTree::deleteKey - Tree is empty."); return false; }
 
     int leafPageIndex = findLeafNodePageIndex(key, rootPageIndex);
-    if (leafPageIndex < 0) { logger.log("BTree::deleteKey - Key not found (leaf search failed)."); return false; }
+    if (leafPageIndex < 0) { LOG_ERROR("BTree::deleteKey - Key not found (leaf search failed)."); return false; }
 
     BTreeNode* leafNode = fetchNode(leafPageIndex);
-    if (!leafNode) { logger.log("BTree::deleteKey - Error fetching leaf node " + std::to_string(leafPageIndex)); return false; }
-
-    int initialKeyCount = leafNode->keyCount;
-    int deletionCount = 0;
+    if (!leafNode) { LOG_ERROR("BTree::deleteKey - Error fetching leaf node " + std::to_string(leafPageIndex)); return false; }
 
     int keyPos = leafNode->findKeyIndex(key);
-    while (keyPos != -1) { // Remove all occurrences
-        leafNode->removeLeafEntry(keyPos);
-        deletionCount++;
-        keyPos = leafNode->findKeyIndex(key); // Re-find after removal
+    if (keyPos == -1) {
+        LOG_DEBUG("BTree::deleteKey - Key " + key.toString(keyColumnCount) + " not found in leaf node " + std::to_string(leafPageIndex));
+        delete leafNode;
+        return false;
     }
+    if (leafNode->postings[keyPos].overflowPageIndex >= 0)
+        freeOverflowChain(leafNode->postings[keyPos].overflowPageIndex);
+    leafNode->removeLeafEntry(keyPos);
+    LOG_DEBUG("BTree::deleteKey - Removed key " + key.toString(keyColumnCount) + " from leaf " + std::to_string(leafPageIndex));
+    writeNode(leafNode);
+    if (!leafNode->isMinimal(pageInts) && leafNode->parentPageIndex != -1) {
+         LOG_DEBUG("BTree::deleteKey - Leaf node " + std::to_string(leafPageIndex) + " underflow detected. Handling...");
+         handleUnderflow(leafPageIndex);
+    }
+    delete leafNode;
+    adjustRoot(); // Check root AFTER potential underflow handling completes
+    return true;
+}
 
-    if (deletionCount > 0) {
-        logger.log("BTree::deleteKey - Removed " + std::to_string(deletionCount) + " instance(s) of key " + std::to_string(key) + " from leaf " + std::to_string(leafPageIndex));
-        writeNode(leafNode);
-        if (!leafNode->isMinimal(order, leafOrder) && leafNode->parentPageIndex != -1) {
-             logger.log("BTree::deleteKey - Leaf node " + std::to_string(leafPageIndex) + " underflow detected. Handling...");
-             handleUnderflow(leafPageIndex);
-        }
+bool BTree::deleteEntry(const IndexKey& key, RecordPointer recordPointer) {
+    if (rootPageIndex == -1) return false;
+    int leafPageIndex = findLeafNodePageIndex(key, rootPageIndex);
+    BTreeNode* leafNode = fetchNode(leafPageIndex);
+    if (!leafNode) { LOG_ERROR("BTree::deleteEntry - Error fetching leaf node " + std::to_string(leafPageIndex)); return false; }
+    int keyPos = leafNode->findKeyIndex(key);
+    if (keyPos == -1) { delete leafNode; return false; }
+
+    PostingList& posting = leafNode->postings[keyPos];
+    std::vector<RecordPointer> pointers;
+    if (posting.overflowPageIndex >= 0) readOverflowChain(posting.overflowPageIndex, pointers);
+    else pointers.swap(posting.pointers);
+    auto at = std::lower_bound(pointers.begin(), pointers.end(), recordPointer);
+    if (at == pointers.end() || *at != recordPointer) { delete leafNode; return false; }
+    pointers.erase(at);
+
+    if (pointers.empty()) {
+        // The last entry takes the key with it
         delete leafNode;
-        adjustRoot(); // Check root AFTER potential underflow handling completes
-        return true;
+        return deleteKey(key);
+    }
+    if (posting.overflowPageIndex >= 0) {
+        // A shrinking list stays in its overflow pages, so the leaf is unchanged
+        writeOverflowChain(pointers, posting.overflowPageIndex);
     } else {
-        logger.log("BTree::deleteKey - Key " + std::to_string(key) + " not found in leaf node " + std::to_string(leafPageIndex));
-        delete leafNode;
-        return false;
+        posting.pointers.swap(pointers);
+        writeNode(leafNode);
     }
+    delete leafNode;
+    return true;
 }
 
 void BTree::handleUnderflow(int nodePageIndex) {
-     // logger.log("BTree::handleUnderflow - Handling node " + std::to_string(nodePageIndex)); // Can be verbose
+     // LOG_DEBUG("BTree::handleUnderflow - Handling node " + std::to_string(nodePageIndex)); // Can be verbose
      BTreeNode* node = fetchNode(nodePageIndex);
      if (!node) return;
      if (node->parentPageIndex == -1) { delete node; return; } // Root handled by adjustRoot
+     if (node->isMinimal(pageInts)) { delete node; return; }
 
      BTreeNode* parent = fetchNode(node->parentPageIndex);
      if (!parent) { delete node; return; }
@@ -688,59 +1489,76 @@ void BTree::handleUnderflow(int nodePageIndex) {
      int siblingPageIndex = findSiblingPageIndex(nodePageIndex, node->parentPageIndex, isRightSibling);
 
      if (siblingPageIndex == -1) {
-          logger.log("BTree::handleUnderflow - No sibling found for node " + std::to_string(nodePageIndex) + " (Parent: " + std::to_string(node->parentPageIndex) + ")");
+          LOG_DEBUG("BTree::handleUnderflow - No sibling found for node " + std::to_string(nodePageIndex) + " (Parent: " + std::to_string(node->parentPageIndex) + ")");
           delete node; delete parent; return; // Cannot borrow or merge
      }
 
      BTreeNode* sibling = fetchNode(siblingPageIndex);
       if (!sibling) {
-          logger.log("BTree::handleUnderflow - Error fetching sibling node " + std::to_string(siblingPageIndex));
+          LOG_ERROR("BTree::handleUnderflow - Error fetching sibling node " + std::to_string(siblingPageIndex));
           delete node; delete parent; return;
      }
 
      // Calculate parentKeyIndex (index of key in parent separating node and sibling)
      int nodeIndexInParent = -1;
      for(size_t i = 0; i < parent->childrenPageIndices.size(); ++i) if(parent->childrenPageIndices[i] == nodePageIndex) nodeIndexInParent = i;
-     if(nodeIndexInParent == -1) { logger.log("BTree::handleUnderflow - Node not found in parent."); delete node; delete parent; delete sibling; return; }
+     if(nodeIndexInParent == -1) { LOG_DEBUG("BTree::handleUnderflow - Node not found in parent."); delete node; delete parent; delete sibling; return; }
      int parentKeyIndex = isRightSibling ? nodeIndexInParent : (nodeIndexInParent - 1);
-     if (parentKeyIndex < 0 || parentKeyIndex >= parent->keyCount) { logger.log("BTree::handleUnderflow - Invalid parent key index."); delete node; delete parent; delete sibling; return; }
+     if (parentKeyIndex < 0 || parentKeyIndex >= parent->keyCount) { LOG_DEBUG("BTree::handleUnderflow - Invalid parent key index."); delete node; delete parent; delete sibling; return; }
 
 
-     // Try to Borrow first
-     int minKeys = node->isLeaf ? std::ceil(static_cast<double>(leafOrder) / 2.0) : (std::ceil(static_cast<double>(order) / 2.0) - 1);
-     if (sibling->keyCount > minKeys) {
-         // logger.log("BTree::handleUnderflow - Attempting to borrow from sibling " + std::to_string(siblingPageIndex)); // Verbose
+     // Try to Borrow first, on copies: the sibling checks for itself whether
+     // it can spare a key, and a changed key can widen the offsets of the
+     // node or its parent past their page
+     {
+         // LOG_DEBUG("BTree::handleUnderflow - Attempting to borrow from sibling " + std::to_string(siblingPageIndex)); // Verbose
+         BTreeNode borrower = *node, lender = *sibling, newParent = *parent;
          bool borrowed = false;
-         if (node->isLeaf) borrowed = borrowFromLeafSibling(node, sibling, isRightSibling, parent);
-         else borrowed = borrowFromInternalSibling(node, sibling, isRightSibling, parent); // STUBBED
+         if (node->isLeaf) borrowed = borrowFromLeafSibling(&borrower, &lender, isRightSibling, &newParent);
+         else borrowed = borrowFromInternalSibling(&borrower, &lender, isRightSibling, &newParent);
 
-         if (borrowed) {
+         if (borrowed && borrower.imageInts() <= pageInts && newParent.imageInts() <= pageInts) {
+             *node = borrower; *sibling = lender; *parent = newParent;
              writeNode(node); writeNode(sibling); writeNode(parent);
-             // logger.log("BTree::handleUnderflow - Borrow successful."); // Verbose
+             if (!node->isLeaf) { // The borrowed child now hangs off node
+                 BTreeNode* child = fetchNode(isRightSibling ? node->childrenPageIndices.back() : node->childrenPageIndices.front());
+                 if (child) { child->parentPageIndex = node->pageIndex; writeNode(child); delete child; }
+             }
+             // LOG_DEBUG("BTree::handleUnderflow - Borrow successful."); // Verbose
              delete node; delete sibling; delete parent; return;
          }
      }
 
-     // Cannot borrow, must Merge
-     // logger.log("BTree::handleUnderflow - Cannot borrow, attempting to merge with sibling " + std::to_string(siblingPageIndex)); // Verbose
+     // Cannot borrow, must Merge. Two nodes that would not fit one page are
+     // left as they are; the underfull one is still a valid node.
+     {
+         BTreeNode merged = isRightSibling ? *node : *sibling;
+         const BTreeNode& right = isRightSibling ? *sibling : *node;
+         if (!merged.isLeaf) merged.keys.push_back(parent->keys[parentKeyIndex]);
+         merged.keys.insert(merged.keys.end(), right.keys.begin(), right.keys.end());
+         merged.postings.insert(merged.postings.end(), right.postings.begin(), right.postings.end());
+         merged.childrenPageIndices.insert(merged.childrenPageIndices.end(), right.childrenPageIndices.begin(), right.childrenPageIndices.end());
+         if (merged.imageInts() > pageInts) { delete node; delete sibling; delete parent; return; }
+     }
+     // LOG_DEBUG("BTree::handleUnderflow - Cannot borrow, attempting to merge with sibling " + std::to_string(siblingPageIndex)); // Verbose
      int pageToDelete = -1;
      if (isRightSibling) { // Merge right sibling into node
          if (node->isLeaf) mergeLeafNodes(node, sibling, parent, parentKeyIndex);
-         else mergeInternalNodes(node, sibling, parent, parentKeyIndex); // STUBBED
+         else mergeInternalNodes(node, sibling, parent, parentKeyIndex);
          pageToDelete = sibling->pageIndex;
      } else { // Merge node into left sibling
          if (node->isLeaf) mergeLeafNodes(sibling, node, parent, parentKeyIndex);
-         else mergeInternalNodes(sibling, node, parent, parentKeyIndex); // STUBBED
+         else mergeInternalNodes(sibling, node, parent, parentKeyIndex);
          pageToDelete = node->pageIndex;
      }
 
      // Delete the now-empty node's page file (sibling or node itself)
      if (pageToDelete != -1) {
-         bufferManager.deleteFile(indexName, pageToDelete);
-          logger.log("BTree::handleUnderflow - Deleted merged node page " + std::to_string(pageToDelete));
+         freeNodePage(pageToDelete);
+          LOG_DEBUG("BTree::handleUnderflow - Deleted merged node page " + std::to_string(pageToDelete));
           // A more robust system might add this page index to a free list instead of deleting immediately
      } else {
-          logger.log("BTree::handleUnderflow - Error: pageToDelete index was not set during merge.");
+          LOG_ERROR("BTree::handleUnderflow - Error: pageToDelete index was not set during merge.");
      }
 
      // Check parent for underflow recursively *after* cleaning up current level
@@ -762,49 +1580,48 @@ int BTree::findSiblingPageIndex(int nodePageIndex, int parentPageIndex, bool& is
         } else if (childIndex > 0) { // Try left sibling
             siblingPageIndex = parent->childrenPageIndices[childIndex - 1]; isRightSibling = false;
         }
-    } else { logger.log("BTree::findSiblingPageIndex - Error: node not found in parent."); }
+    } else { LOG_ERROR("BTree::findSiblingPageIndex - Error: node not found in parent."); }
     delete parent;
     return siblingPageIndex;
 }
 
+// Moves the nearest key of the sibling, with its posting list, into node,
+// unless that would take the sibling below a quarter full itself.
 bool BTree::borrowFromLeafSibling(BTreeNode* node, BTreeNode* sibling, bool isRightSibling, BTreeNode* parent) {
-     int keyToMove; RecordPointer pointerToMove;
      int parentKeyIndex;
 
       int nodeIndex = -1;
       for(size_t i=0; i<parent->childrenPageIndices.size(); ++i) if(parent->childrenPageIndices[i] == node->pageIndex) nodeIndex = i;
-      if(nodeIndex == -1) { logger.log("BorrowLeaf: Node not in parent"); return false; } // Should not happen
+      if(nodeIndex == -1) { LOG_DEBUG("BorrowLeaf: Node not in parent"); return false; } // Should not happen
+     if (sibling->keyCount <= 1) return false; // Cannot borrow the only key
+
+     int siblingPos = isRightSibling ? 0 : sibling->keyCount - 1;
+     BTreeNode lender = *sibling;
+     lender.removeLeafEntry(siblingPos);
+     if (!lender.isMinimal(pageInts)) return false;
 
      if (isRightSibling) { // Borrow first from right sibling
-         if (sibling->keyCount <= 0) return false; // Cannot borrow if empty
-         keyToMove = sibling->keys.front();
-         pointerToMove = sibling->recordPointers.front();
          parentKeyIndex = nodeIndex; // Key separating node from right sibling is parent->keys[nodeIndex]
-
-         node->insertLeafEntry(keyToMove, pointerToMove, node->keyCount); // Add to end of current node
+         node->insertLeafEntry(sibling->keys.front(), sibling->postings.front(), node->keyCount); // Add to end of current node
          sibling->removeLeafEntry(0); // Remove from start of sibling
          if (parentKeyIndex < parent->keyCount) { // Update parent key
             parent->keys[parentKeyIndex] = sibling->keys.front(); // New separating key is sibling's new first key
-         } else { logger.log("BorrowLeaf(Right): Invalid parent key index."); return false;}
+         } else { LOG_DEBUG("BorrowLeaf(Right): Invalid parent key index."); return false;}
      } else { // Borrow last from left sibling
-         if (sibling->keyCount <= 0) return false;
-         keyToMove = sibling->keys.back();
-         pointerToMove = sibling->recordPointers.back();
          parentKeyIndex = nodeIndex - 1; // Key separating left sibling from node is parent->keys[nodeIndex - 1]
-
-         node->insertLeafEntry(keyToMove, pointerToMove, 0); // Add to beginning of current node
+         node->insertLeafEntry(sibling->keys.back(), sibling->postings.back(), 0); // Add to beginning of current node
          sibling->removeLeafEntry(sibling->keyCount - 1); // Remove from end of sibling
          if (parentKeyIndex >= 0) { // Update parent key
             parent->keys[parentKeyIndex] = node->keys.front(); // New separating key is node's new first key
-         } else { logger.log("BorrowLeaf(Left): Invalid parent key index."); return false; }
+         } else { LOG_DEBUG("BorrowLeaf(Left): Invalid parent key index."); return false; }
      }
      return true;
 }
 
 void BTree::mergeLeafNodes(BTreeNode* leftNode, BTreeNode* rightNode, BTreeNode* parent, int parentKeyIndex) {
-    // logger.log("BTree::mergeLeafNodes - Merging node " + std::to_string(rightNode->pageIndex) + " into " + std::to_string(leftNode->pageIndex)); // Verbose
+    // LOG_DEBUG("BTree::mergeLeafNodes - Merging node " + std::to_string(rightNode->pageIndex) + " into " + std::to_string(leftNode->pageIndex)); // Verbose
     leftNode->keys.insert(leftNode->keys.end(), rightNode->keys.begin(), rightNode->keys.end());
-    leftNode->recordPointers.insert(leftNode->recordPointers.end(), rightNode->recordPointers.begin(), rightNode->recordPointers.end());
+    leftNode->postings.insert(leftNode->postings.end(), rightNode->postings.begin(), rightNode->postings.end());
     leftNode->keyCount = leftNode->keys.size(); // Update count based on vector size
     leftNode->nextLeafPageIndex = rightNode->nextLeafPageIndex;
     writeNode(leftNode);
@@ -818,133 +1635,176 @@ void BTree::adjustRoot() {
     BTreeNode* root = fetchNode(rootPageIndex);
     if (!root) return;
     if (!root->isLeaf && root->keyCount == 0) { // Internal root with no keys (only one child)
-         logger.log("BTree::adjustRoot - Root node " + std::to_string(rootPageIndex) + " is internal and empty. Adjusting root.");
+         LOG_DEBUG("BTree::adjustRoot - Root node " + std::to_string(rootPageIndex) + " is internal and empty. Adjusting root.");
          int oldRootIndex = rootPageIndex;
          if (root->childrenPageIndices.empty()) { // Should not happen, but check
-             logger.log("BTree::adjustRoot - Error: Empty internal root has no children!");
+             LOG_ERROR("BTree::adjustRoot - Error: Empty internal root has no children!");
              rootPageIndex = -1; // Tree is effectively empty/corrupt
              nodeCount = 0;
+             height = 0;
          } else {
              rootPageIndex = root->childrenPageIndices[0]; // The single child becomes new root
              BTreeNode* newRoot = fetchNode(rootPageIndex);
              if (newRoot) { newRoot->parentPageIndex = -1; writeNode(newRoot); delete newRoot; }
-             else { logger.log("BTree::adjustRoot - Error fetching new root node " + std::to_string(rootPageIndex)); rootPageIndex = -1; nodeCount = 0;} // Failed to update new root
+             else { LOG_ERROR("BTree::adjustRoot - Error fetching new root node " + std::to_string(rootPageIndex)); rootPageIndex = -1; nodeCount = 0; height = 0;} // Failed to update new root
          }
-         bufferManager.deleteFile(indexName, oldRootIndex); // Delete the old root's page file
-         if(rootPageIndex != -1) logger.log("BTree::adjustRoot - New root is now page " + std::to_string(rootPageIndex));
+         if (rootPageIndex != -1) height--;
+         freeNodePage(oldRootIndex); // Delete the old root's page file
+         if(rootPageIndex != -1) LOG_DEBUG("BTree::adjustRoot - New root is now page " + std::to_string(rootPageIndex));
     } else if (root->isLeaf && root->keyCount == 0 && nodeCount > 1) { // Empty leaf root (but tree wasn't initially empty)
-         logger.log("BTree::adjustRoot - Root node " + std::to_string(rootPageIndex) + " is leaf and empty. Tree is now empty.");
-         bufferManager.deleteFile(indexName, rootPageIndex);
-         rootPageIndex = -1; nodeCount = 0;
+         LOG_DEBUG("BTree::adjustRoot - Root node " + std::to_string(rootPageIndex) + " is leaf and empty. Tree is now empty.");
+         freeNodePage(rootPageIndex);
+         rootPageIndex = -1; nodeCount = 0; height = 0;
     } else if (root->isLeaf && root->keyCount == 0 && nodeCount <= 1) {
         // This is the valid state for an empty tree - root is an empty leaf. Do nothing.
-        // logger.log("BTree::adjustRoot - Root is leaf and empty, tree is empty. No adjustment needed.");
+        // LOG_DEBUG("BTree::adjustRoot - Root is leaf and empty, tree is empty. No adjustment needed.");
     }
     delete root;
 }
 
-// --- Stubs for Internal Node Borrow/Merge ---
+// --- Internal Node Borrow/Merge ---
+// Rotates the nearest child of the sibling into node through the parent: the
+// separator comes down into node and the sibling's nearest key goes up in its
+// place. The caller re-parents the moved child once the borrow is kept.
 bool BTree::borrowFromInternalSibling(BTreeNode* node, BTreeNode* sibling, bool isRightSibling, BTreeNode* parent) {
-    logger.log("BTree::borrowFromInternalSibling - Borrowing for internal node " + std::to_string(node->pageIndex) + " from sibling " + std::to_string(sibling->pageIndex));
-    cout << "WARNING: Internal node borrowing not fully implemented." << endl;
-    // TODO: Implement internal node borrowing
-    return false; // Placeholder
+    LOG_DEBUG("BTree::borrowFromInternalSibling - Borrowing for internal node " + std::to_string(node->pageIndex) + " from sibling " + std::to_string(sibling->pageIndex));
+    int nodeIndex = -1;
+    for (size_t i = 0; i < parent->childrenPageIndices.size(); ++i) if (parent->childrenPageIndices[i] == node->pageIndex) nodeIndex = i;
+    if (nodeIndex == -1) { LOG_DEBUG("BorrowInternal: Node not in parent"); return false; }
+    if (sibling->keyCount <= 1) return false; // Would leave the sibling with a single child
+
+    int parentKeyIndex = isRightSibling ? nodeIndex : nodeIndex - 1;
+    if (parentKeyIndex < 0 || parentKeyIndex >= parent->keyCount) return false;
+    if (isRightSibling) {
+        node->keys.push_back(parent->keys[parentKeyIndex]);
+        node->childrenPageIndices.push_back(sibling->childrenPageIndices.front());
+        parent->keys[parentKeyIndex] = sibling->keys.front();
+        sibling->keys.erase(sibling->keys.begin());
+        sibling->childrenPageIndices.erase(sibling->childrenPageIndices.begin());
+    } else {
+        node->keys.insert(node->keys.begin(), parent->keys[parentKeyIndex]);
+        node->childrenPageIndices.insert(node->childrenPageIndices.begin(), sibling->childrenPageIndices.back());
+        parent->keys[parentKeyIndex] = sibling->keys.back();
+        sibling->keys.pop_back();
+        sibling->childrenPageIndices.pop_back();
+    }
+    node->keyCount = node->keys.size();
+    sibling->keyCount = sibling->keys.size();
+    return sibling->isMinimal(pageInts);
 }
 
+// Pulls the separator down between the two nodes' keys and moves the right
+// node's children under the left one
 void BTree::mergeInternalNodes(BTreeNode* leftNode, BTreeNode* rightNode, BTreeNode* parent, int parentKeyIndex) {
-    logger.log("BTree::mergeInternalNodes - Merging internal node " + std::to_string(rightNode->pageIndex) + " into " + std::to_string(leftNode->pageIndex));
-    cout << "WARNING: Internal node merging not fully implemented." << endl;
-    // TODO: Implement internal node merging
-    // Conceptual: Pull parent key down, move right keys/children to left, remove parent entry.
+    LOG_DEBUG("BTree::mergeInternalNodes - Merging internal node " + std::to_string(rightNode->pageIndex) + " into " + std::to_string(leftNode->pageIndex));
+    leftNode->keys.push_back(parent->keys[parentKeyIndex]);
+    leftNode->keys.insert(leftNode->keys.end(), rightNode->keys.begin(), rightNode->keys.end());
+    leftNode->childrenPageIndices.insert(leftNode->childrenPageIndices.end(), rightNode->childrenPageIndices.begin(), rightNode->childrenPageIndices.end());
+    leftNode->keyCount = leftNode->keys.size();
+    writeNode(leftNode);
+    for (int childIdx : rightNode->childrenPageIndices) {
+        BTreeNode* child = fetchNode(childIdx);
+        if (child) { child->parentPageIndex = leftNode->pageIndex; writeNode(child); delete child; }
+    }
+    parent->removeInternalEntry(parentKeyIndex);
+    writeNode(parent);
+    // Caller (handleUnderflow) deletes the rightNode's page file
 }
 
 // --- Search Methods ---
-std::vector<RecordPointer> BTree::searchKey(int key) {
-    // logger.log("BTree::searchKey - Key: " + std::to_string(key)); // Verbose
+// Appends the pointers of the posting list of key i of a leaf image
+void BTree::appendPostings(const NodeImage& leaf, int i, std::vector<RecordPointer>& result) {
+    size_t start, end;
+    bool spilled;
+    leaf.postingRange(i, start, end, spilled);
+    const unsigned char* data = leaf.postingBytes + start;
+    uint32_t overflowPageIndex;
+    if (start > end || end > leaf.postingByteCount ||
+        (spilled ? !readVarint(data, leaf.postingBytes + end, overflowPageIndex) : !decodePostings(data, end - start, result))) {
+        LOG_ERROR("BTree::appendPostings - Error: Posting list of key " + leaf.key(i).toString(keyColumnCount) + " is corrupt.");
+        return;
+    }
+    if (spilled) readOverflowChain(overflowPageIndex, result);
+}
+
+// Every key is in one leaf, so this reads one node per level and the pages of its posting list
+std::vector<RecordPointer> BTree::searchKey(const IndexKey& key) {
     std::vector<RecordPointer> result;
     int leafPageIndex = findLeafNodePageIndex(key, rootPageIndex);
-    if (leafPageIndex < 0) { return result; } // Not found or tree empty
-    BTreeNode* leaf = fetchNode(leafPageIndex);
-    if (!leaf) { logger.log("BTree::searchKey - Error: Could not fetch leaf node " + std::to_string(leafPageIndex)); return result; }
-
-    auto it = std::lower_bound(leaf->keys.begin(), leaf->keys.end(), key);
-    int keyPos = std::distance(leaf->keys.begin(), it);
-
-    while (keyPos < leaf->keyCount && leaf->keys[keyPos] == key) {
-         if (keyPos < leaf->recordPointers.size()) { result.push_back(leaf->recordPointers[keyPos]); }
-         else { logger.log("BTree::searchKey - Error: Data pointer index out of bounds in leaf " + std::to_string(leaf->pageIndex) + " at key index " + std::to_string(keyPos)); }
-         keyPos++;
+    if (leafPageIndex < 0) return result;
+    PageHandle leafPage = bufferManager.getPage(indexName, leafPageIndex);
+    NodeImage leaf;
+    if (!parseNodeImage(leafPage->getRowRef(0), leaf) || !leaf.isLeaf) {
+        LOG_ERROR("BTree::searchKey - Error: Failed to read leaf node " + std::to_string(leafPageIndex));
+        return result;
     }
-    delete leaf;
-    // if (!result.empty()) { logger.log("BTree::searchKey - Found " + std::to_string(result.size()) + " record(s) for key " + std::to_string(key)); } // Verbose
+    int found = leaf.lowerBound(key);
+    if (found < leaf.keyCount && leaf.key(found) == key)
+        appendPostings(leaf, found, result);
     return result;
 }
 
-std::vector<RecordPointer> BTree::searchRange(int startKey, int endKey) {
-     logger.log("BTree::searchRange - Range: [" + std::to_string(startKey) + ", " + std::to_string(endKey) + "]");
+std::vector<RecordPointer> BTree::searchRange(const IndexKey& startKey, const IndexKey& endKey) {
+     LOG_DEBUG("BTree::searchRange - Range: [" + startKey.toString(keyColumnCount) + ", " + endKey.toString(keyColumnCount) + "]");
     std::vector<RecordPointer> result;
 
-    // fflush(stdout); // Ensure the print happens before potential crash
-
     int currentLeafPageIndex = findLeafNodePageIndex(startKey, rootPageIndex);
     if (currentLeafPageIndex < 0) {
-        logger.log("BTree::searchRange - Tree empty or range start not found.");
+        LOG_DEBUG("BTree::searchRange - Tree empty or range start not found.");
         return result;
     }
 
-    BTreeNode* currentNode = nullptr; // Initialize to null
-
     while (currentLeafPageIndex != -1) { // Loop while there's a valid leaf page index
-        currentNode = fetchNode(currentLeafPageIndex); // Fetch the current leaf node
-        if (!currentNode) {
-             logger.log("BTree::searchRange - Error: Failed to fetch leaf node " + std::to_string(currentLeafPageIndex));
+        // Leaves are read in place out of their pinned frame
+        PageHandle leafPage = bufferManager.getPage(indexName, currentLeafPageIndex);
+        NodeImage leaf;
+        if (!parseNodeImage(leafPage->getRowRef(0), leaf)) {
+             LOG_ERROR("BTree::searchRange - Error: Failed to fetch leaf node " + std::to_string(currentLeafPageIndex));
              break; // Stop if fetch fails
         }
-        if (!currentNode->isLeaf) { // Should not happen if findLeafNodePageIndex is correct
-             logger.log("BTree::searchRange - Error: Fetched node " + std::to_string(currentLeafPageIndex) + " is not a leaf!");
-             delete currentNode;
+        if (!leaf.isLeaf) { // Should not happen if findLeafNodePageIndex is correct
+             LOG_ERROR("BTree::searchRange - Error: Fetched node " + std::to_string(currentLeafPageIndex) + " is not a leaf!");
              break; // Stop if we somehow get an internal node
         }
 
-        bool continueToNextNode = true;
-        auto it = std::lower_bound(currentNode->keys.begin(), currentNode->keys.end(), startKey);
-        int startPos = std::distance(currentNode->keys.begin(), it);
-
-        for (int i = startPos; i < currentNode->keyCount; ++i) {
-            int currentKey = currentNode->keys[i];
-            if (currentKey <= endKey) {
-                 if (i < currentNode->recordPointers.size()) {
-                     result.push_back(currentNode->recordPointers[i]);
-                 } else {
-                     logger.log("BTree::searchRange - Error: Data pointer index out of bounds in leaf " + std::to_string(currentNode->pageIndex) + " at key index " + std::to_string(i));
-                 }
-            } else {
-                // Key is past the endKey, no need to check further in this node or subsequent nodes
-                continueToNextNode = false;
-                break;
-            }
-        }
-
-        int nextPageIndex = currentNode->nextLeafPageIndex; // Get next index BEFORE deleting
-        delete currentNode; // Delete the node we just processed
-        currentNode = nullptr; // Set to null after delete
+        int startPos = leaf.lowerBound(startKey);
+        int endPos = std::max(startPos, leaf.upperBound(endKey));
+        for (int i = startPos; i < endPos; ++i)
+            appendPostings(leaf, i, result);
 
-        if (!continueToNextNode) {
-            break; // Stop the outer loop if we passed endKey
+        if (endPos < leaf.keyCount) {
+            break; // Key is past the endKey, no need to check subsequent nodes
         }
 
-        currentLeafPageIndex = nextPageIndex; // Move to the next leaf page index for the next iteration
+        currentLeafPageIndex = leaf.nextLeafPageIndex; // Move to the next leaf page index for the next iteration
 
     } // End of while loop
 
-    // No need for final delete check as currentNode is set to nullptr after deletion or if loop finishes
-
-    logger.log("BTree::searchRange - Found " + std::to_string(result.size()) + " entries.");
+    LOG_DEBUG("BTree::searchRange - Found " + std::to_string(result.size()) + " entries.");
     return result;
 }
 
-bool BTree::insertKey(int key, RecordPointer recordPointer) {
-    // logger.log("BTree::insertKey - Key: " + std::to_string(key)); // Reduced verbosity
+/**
+ * @brief Entries whose key starts with the first prefixLength columns of
+ * prefix and has its next column in [low, high]: one range of the tree, from
+ * (prefix..., low, smallest...) to (prefix..., high, largest...). With
+ * prefixLength equal to the key's column count, low and high are ignored and
+ * this is searchKey.
+ */
+std::vector<RecordPointer> BTree::searchPrefixRange(const IndexKey& prefix, int prefixLength, int low, int high) {
+    if (prefixLength >= keyColumnCount) return searchKey(prefix);
+    IndexKey startKey = prefix, endKey = prefix;
+    startKey[prefixLength] = low;
+    endKey[prefixLength] = high;
+    for (int c = prefixLength + 1; c < keyColumnCount; c++) {
+        startKey[c] = INT_MIN;
+        endKey[c] = INT_MAX;
+    }
+    return searchRange(startKey, endKey);
+}
+
+bool BTree::insertKey(const IndexKey& key, RecordPointer recordPointer) {
+    // LOG_DEBUG("BTree::insertKey - Key: " + key.toString(keyColumnCount)); // Reduced verbosity
     if (rootPageIndex == -1) {
         // Tree is empty, create the first node (root is also a leaf)
         startNewTree(key, recordPointer);
@@ -952,7 +1812,7 @@ bool BTree::insertKey(int key, RecordPointer recordPointer) {
         // Find the appropriate leaf node page index
         int leafPageIndex = findLeafNodePageIndex(key, rootPageIndex);
         if (leafPageIndex < 0) {
-             logger.log("BTree::insertKey - Error: Could not find leaf node for key " + std::to_string(key));
+             LOG_ERROR("BTree::insertKey - Error: Could not find leaf node for key " + key.toString(keyColumnCount));
             return false; // Should not happen if root exists
         }
         // Insert into the found leaf node (handles splits internally)
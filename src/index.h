@@ -11,64 +11,114 @@
 #include <optional> // For optional return values
 #include <cmath>    // For ceil
 #include <algorithm> // For lower_bound etc.
+#include <unordered_map>
 
 class Table;
+struct NodeImage;
+
+enum IndexingStrategy
+{
+	BTREE,
+	HASH,
+	NOTHING
+};
 
 // Define a structure for data pointers in leaf nodes
 // pageIndex: The index of the page file in the TABLE's storage
 // rowIndex: The index of the row within that page
 using RecordPointer = std::pair<int, int>; // {pageIndex, rowIndex}
 
+/**
+ * @brief Key of an index entry: the values of the indexed columns, in the
+ * order the index lists them. Keys compare lexicographically, so in a B+ tree
+ * on (a, b) the entries of one value of a are next to each other, ordered by
+ * b. Values past the index's columns are left 0 and do not change the order.
+ * A single column index is keyed by the column's value alone.
+ */
+struct IndexKey {
+    static constexpr int MAX_COLUMNS = 4;
+    int values[MAX_COLUMNS] = {};
+
+    IndexKey() {}
+    IndexKey(int value) { values[0] = value; }
+
+    int operator[](int column) const { return values[column]; }
+    int& operator[](int column) { return values[column]; }
+    bool operator==(const IndexKey& other) const { return std::equal(values, values + MAX_COLUMNS, other.values); }
+    bool operator!=(const IndexKey& other) const { return !(*this == other); }
+    bool operator<(const IndexKey& other) const { return std::lexicographical_compare(values, values + MAX_COLUMNS, other.values, other.values + MAX_COLUMNS); }
+    bool operator>(const IndexKey& other) const { return other < *this; }
+    bool operator<=(const IndexKey& other) const { return !(other < *this); }
+    bool operator>=(const IndexKey& other) const { return !(*this < other); }
+
+    // "5" or "(5, 7)", for logs
+    std::string toString(int columnCount) const;
+};
+
+/**
+ * @brief Record pointers of one key in a leaf, sorted by (pageIndex, rowIndex).
+ * A list too long to keep in the leaf is moved to a chain of overflow pages
+ * starting at overflowPageIndex, and pointers is then left empty.
+ */
+struct PostingList {
+    std::vector<RecordPointer> pointers;
+    int overflowPageIndex = -1;
+};
+
 /**
  * @brief Represents a node in the B+ Tree.
- * Each node corresponds to one page in the buffer manager.
+ * Each node corresponds to one page in the buffer manager. A leaf holds every
+ * key once, with the posting list of all rows that have it.
  */
 class BTreeNode {
 public:
     bool isLeaf;
-    std::vector<int> keys;
+    int keyColumnCount; // Values per key, see IndexKey
+    std::vector<IndexKey> keys;
     std::vector<int> childrenPageIndices; // Page indices of children (for internal nodes)
-    std::vector<RecordPointer> recordPointers; // Data pointers (for leaf nodes)
+    std::vector<PostingList> postings; // Record pointers of each key (for leaf nodes)
     int nextLeafPageIndex; // Page index of the next leaf node (-1 if none)
     int parentPageIndex; // Page index of the parent node (-1 if root)
     int pageIndex;       // Page index of this node itself
     int keyCount;        // Number of keys currently in the node
 
-    // --- Node Metadata stored within the page ---
-    // Offsets assume metadata is stored as the first "row" in the page's data vector
+    // --- Node header stored at the start of the page image (see serialize) ---
     static const int IS_LEAF_OFFSET = 0;
     static const int KEY_COUNT_OFFSET = 1;
     static const int PARENT_PAGE_INDEX_OFFSET = 2;
     static const int NEXT_LEAF_PAGE_INDEX_OFFSET = 3; // Only used if isLeaf = true
-    // Determine METADATA_INTS based on the maximum needed (leaf nodes need one more)
-    static const int METADATA_INTS_INTERNAL = 3; // isLeaf, keyCount, parentPageIndex
-    static const int METADATA_INTS_LEAF = 4;     // isLeaf, keyCount, parentPageIndex, nextLeafPageIndex
+    static const int KEY_BASE_OFFSET = 4; // First key, the others are stored as offsets from it
+    static const int VALUE_COUNT_OFFSET = 5; // Children, or posting lists of a leaf
+    static const int VALUE_BASE_OFFSET = 6; // Smallest child page index or posting list end
+    static const int BIT_WIDTHS_OFFSET = 7; // Bits per key offset | bits per value offset << 8 | key columns << 16
+    static const int HEADER_INTS = 8; // Followed by the base and the bits per offset of each further key column
 
 
     // Constructor for creating a new node
-    BTreeNode(int order, int leafOrder, bool leaf = false);
+    BTreeNode(bool leaf = false, int keyColumnCount = 1);
     // Constructor for loading an existing node from a page object
     // TAKES Page* now
     // BTreeNode(Page* page, int order, int leafOrder);
 
     // --- Serialization / Deserialization ---
-    // Fills a rows vector suitable for BufferManager::writePage
-    void serialize(std::vector<std::vector<int>>& pageData, int order, int leafOrder);
+    // Fills the single row image of the node's page
+    void serialize(std::vector<int>& image) const;
     // Parses data from a Page object read by BufferManager::getPage
     // TAKES Page* now
     // void deserialize(Page* page, int order, int leafOrder);
-    void deserialize(const std::vector<std::vector<int>>& pageData, int order, int leafOrder);
+    bool deserialize(RowSpan image);
 
     // --- Node Operations ---
-    bool isFull(int order, int leafOrder) const;
-    bool isMinimal(int order, int leafOrder) const;
-    int findKeyIndex(int key) const; // Helper to find exact key index
-    int findChildIndex(int key) const; // For internal nodes: find pointer index for a key
+    int imageInts() const; // Ints the node's page image takes, see serialize
+    bool isFull(int pageInts) const;
+    bool isMinimal(int pageInts) const;
+    int findKeyIndex(const IndexKey& key) const; // Helper to find exact key index
+    int findChildIndex(const IndexKey& key) const; // For internal nodes: find pointer index for a key
 
     // Helper methods for insertion/deletion within node
-    void insertLeafEntry(int key, RecordPointer pointer, int pos);
+    void insertLeafEntry(const IndexKey& key, const PostingList& posting, int pos);
     void removeLeafEntry(int pos);
-    void insertInternalEntry(int key, int childPageIndex, int pos);
+    void insertInternalEntry(const IndexKey& key, int childPageIndex, int pos);
     void removeInternalEntry(int pos); // Removes key[pos] and child[pos+1]
 
     // Debugging helper
@@ -77,35 +127,112 @@ public:
 
 
 /**
- * @brief The B+ Tree index implementation.
+ * @brief What every kind of index on integer columns offers: lookups of one
+ * key, maintenance as rows are inserted, updated and deleted, and saving next
+ * to an exported table. Which kinds of predicates an index can answer beyond
+ * "columns == values" depends on the kind (see isOrdered). Only a B+ tree can
+ * be built on more than one column.
  */
-class BTree {
-private:
+class Index {
+protected:
     std::string indexName; // Unique name, e.g., <tableName>_<columnName>_index
     std::string tableName;
-    std::string columnName;
-    int columnIndex;
+    std::string columnName; // The indexed column, or the columns joined by ',' (see columnListName)
+    std::vector<int> keyColumns; // Indices of the indexed columns, in key order
+    int columnIndex; // The first of them
+
+    // Page indices of the index's segment in use are all below this
+    virtual int getPageCount() const = 0;
+    // Kind specific part of the saved index, see save
+    virtual void writeMetadata(std::ostream& out) const = 0;
+    virtual bool readMetadata(std::istream& in) = 0;
+
+public:
+    Index(const std::string& tableName, const std::string& columnName, const std::vector<int>& keyColumns, const std::string& indexName);
+    virtual ~Index() {}
+    static Index* create(IndexingStrategy strategy, const std::string& tableName, const std::string& columnName, const std::vector<int>& keyColumns);
+    // Name an index on these columns is known by in Table::indexes, e.g. "a" or "a,b"
+    static std::string columnListName(const std::vector<std::string>& columns);
+
+    virtual IndexingStrategy getStrategy() const = 0;
+    // Whether keys can be walked in order, i.e. range predicates can use the index
+    virtual bool isOrdered() const = 0;
+    // Pages read to find the entries of matchingRows rows with one key or range, for the planner
+    virtual double estimateLookupPages(double tableRows, double matchingRows) const = 0;
+
+    virtual bool buildIndex(Table* table) = 0;
+    virtual bool dropIndex() = 0;
+    virtual bool insertKey(const IndexKey& key, RecordPointer recordPointer) = 0;
+    virtual bool deleteKey(const IndexKey& key) = 0; // Deletes *all* entries matching the key
+    virtual bool deleteEntry(const IndexKey& key, RecordPointer recordPointer) = 0; // Deletes the one entry of a row
+    virtual std::vector<RecordPointer> searchKey(const IndexKey& key) = 0;
+
+    std::string getIndexName() const { return indexName; }
+    std::string getColumnName() const { return columnName; }
+    const std::vector<int>& getKeyColumns() const { return keyColumns; }
+    bool hasKeyColumn(int column) const { return std::find(keyColumns.begin(), keyColumns.end(), column) != keyColumns.end(); }
+    // Key of a row of the table
+    template <typename Row>
+    IndexKey keyOf(const Row& row) const {
+        IndexKey key;
+        for (size_t i = 0; i < keyColumns.size(); i++) key[i] = row[keyColumns[i]];
+        return key;
+    }
+
+    // Whether a sample of the table's rows is found at its position in the index
+    bool matchesPages(const Table* table);
+
+    // Persisting the index next to an exported table, see save
+    std::string persistentFileName() const;
+    bool save(const Table* table, uint64_t pageChecksum);
+    bool restore(const Table* table, uint64_t pageChecksum);
+};
+
+/**
+ * @brief The B+ Tree index implementation.
+ */
+class BTree : public Index {
+private:
     int rootPageIndex;
-    int nodeCount; // Tracks the total number of nodes (used for allocating new page indices)
-    int order; // Max pointers in internal node (p)
-    int leafOrder; // Max record pointers in leaf node (Pleaf)
+    int nodeCount; // Tracks the total number of nodes and overflow pages (used for allocating new page indices)
+    int height; // Levels of nodes, 1 for a single leaf (0 when empty)
+    int keyColumnCount; // Columns in a key, see IndexKey
+    int pageInts; // Ints a node page holds; nodes are split when their image no longer fits
+    int maxInlinePostingBytes; // Longer posting lists go to overflow pages
+    int overflowPageBytes; // Encoded posting bytes per overflow page
+    static constexpr double ESTIMATED_POINTER_BYTES = 2; // average size of an encoded record pointer, for the planner
+    std::unordered_map<int, BTreeNode> nodeCache; // Decoded internal nodes by page index, see fetchNode
+
+    int getPageCount() const override { return nodeCount; }
+    void writeMetadata(std::ostream& out) const override;
+    bool readMetadata(std::istream& in) override;
 
     // --- Helper Methods ---
     BTreeNode* fetchNode(int pageIndex); // Reads node page from buffer manager - NOW PRIVATE
     void writeNode(BTreeNode* node); // Writes node page back to buffer manager - NOW PRIVATE
     int allocateNewNodePage(); // Gets the next available page index for a new node - NOW PRIVATE
+    const BTreeNode* internalNode(int pageIndex); // Cached internal node, nullptr for a leaf
+    void freeNodePage(int pageIndex); // Drops a node page from the pool, the cache and the segment
 
     // Recursive search to find the leaf node for a given key - NOW PRIVATE
-    int findLeafNodePageIndex(int key, int currentRootPageIndex);
+    int findLeafNodePageIndex(const IndexKey& key, int currentRootPageIndex);
+
+    // Posting lists kept in overflow pages
+    void readOverflowChain(int headPageIndex, std::vector<RecordPointer>& pointers, std::vector<int>* pageIndices = nullptr);
+    int writeOverflowChain(const std::vector<RecordPointer>& pointers, int headPageIndex = -1);
+    void freeOverflowChain(int headPageIndex);
+    void appendPostings(const NodeImage& leaf, int i, std::vector<RecordPointer>& result);
+    // Keeps an inline posting list short enough for its leaf, spilling it if not
+    void spillIfLong(PostingList& posting);
 
     // Insertion helpers - NOW PRIVATE
-    void startNewTree(int key, RecordPointer pointer);
-    void insertIntoLeaf(int leafPageIndex, int key, RecordPointer pointer);
-    void insertIntoParent(int leftChildPageIndex, int key, int rightChildPageIndex);
+    void startNewTree(const IndexKey& key, RecordPointer pointer);
+    void insertIntoLeaf(int leafPageIndex, const IndexKey& key, RecordPointer pointer);
+    void insertIntoParent(int leftChildPageIndex, const IndexKey& key, int rightChildPageIndex);
 
     // Splitting helpers - NOW PRIVATE
-    void splitLeafNode(BTreeNode* leafNode, int& splitKey, int& newRightNodePageIndex);
-    void splitInternalNode(BTreeNode* internalNode, int& splitKey, int& newRightNodePageIndex);
+    void splitLeafNode(BTreeNode* leafNode, IndexKey& splitKey, int& newRightNodePageIndex);
+    void splitInternalNode(BTreeNode* internalNode, IndexKey& splitKey, int& newRightNodePageIndex);
 
     // --- Deletion Helpers ---
     // Handles underflow after deletion - NOW PRIVATE
@@ -126,35 +253,44 @@ private:
 
 
 public:
-    // Constructor: Creates or loads a B+ tree index
-    BTree(const std::string& tableName, const std::string& columnName, int columnIndex);
+    // Constructor: Creates or loads a B+ tree index on the key columns, at most IndexKey::MAX_COLUMNS
+    BTree(const std::string& tableName, const std::string& columnName, const std::vector<int>& keyColumns);
     ~BTree(); // Destructor
 
+    IndexingStrategy getStrategy() const override { return BTREE; }
+    bool isOrdered() const override { return true; }
+    double estimateLookupPages(double tableRows, double matchingRows) const override;
+
     // --- Core Index Operations ---
 
     // Build the index from scratch based on the table data
-    bool buildIndex(Table* table);
+    bool buildIndex(Table* table) override;
 
     // Remove the index and its associated files
-    bool dropIndex();
+    bool dropIndex() override;
 
     // Insert a key-value pair (key, {pageIndex, rowIndex})
-    bool insertKey(int key, RecordPointer recordPointer);
+    bool insertKey(const IndexKey& key, RecordPointer recordPointer) override;
 
     // Delete *all* entries matching the key. Returns true if any deletion occurred.
-    bool deleteKey(int key);
+    bool deleteKey(const IndexKey& key) override;
+
+    // Delete the entry of one row, dropping the key with its last entry
+    bool deleteEntry(const IndexKey& key, RecordPointer recordPointer) override;
 
     // Search for a specific key, returns vector of record pointers
-    std::vector<RecordPointer> searchKey(int key);
+    std::vector<RecordPointer> searchKey(const IndexKey& key) override;
+
+    // Search for keys within a range [startKey, endKey] (compared lexicographically), returns vector of record pointers
+    std::vector<RecordPointer> searchRange(const IndexKey& startKey, const IndexKey& endKey);
 
-    // Search for keys within a range [startKey, endKey], returns vector of record pointers
-    std::vector<RecordPointer> searchRange(int startKey, int endKey);
+    // Search for keys whose first prefixLength columns equal prefix's and
+    // whose next column is in [low, high]
+    std::vector<RecordPointer> searchPrefixRange(const IndexKey& prefix, int prefixLength, int low, int high);
 
     // --- Getters ---
     int getRootPageIndex() const { return rootPageIndex; }
-    int getOrder() const { return order; }
-    int getLeafOrder() const { return leafOrder; }
-    std::string getIndexName() const { return indexName; }
+    int getHeight() const { return height; }
 
     // Debugging
     void printTree(); // Helper to print the tree structure (optional) - NOW PUBLIC
@@ -1,11 +1,108 @@
 #include "global.h"
 
-Logger::Logger()
+Logger::Logger() : cells(new Cell[QUEUE_SIZE])
 {
 	this->fout.open(this->logFile, ios::out);
+	for (size_t position = 0; position < QUEUE_SIZE; position++)
+		this->cells[position].sequence.store(position, memory_order_relaxed);
+	this->writer = thread(&Logger::writeLoop, this);
 }
 
-void Logger::log(string logString)
+Logger::~Logger()
 {
-	fout << logString << endl;
+	this->stopping.store(true, memory_order_release);
+	if (this->writer.joinable())
+		this->writer.join();
+}
+
+/**
+ * @brief Queues message for the writer thread. Does not check the level, the
+ * LOG_* macros do that before building the message. If the queue is full the
+ * caller yields until the writer has made room, so no message is lost.
+ *
+ * @param level
+ * @param message
+ */
+void Logger::log(LogLevel level, string message)
+{
+	size_t position = this->enqueuePosition.load(memory_order_relaxed);
+	while (true)
+	{
+		Cell &cell = this->cells[position & (QUEUE_SIZE - 1)];
+		size_t sequence = cell.sequence.load(memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+		if (difference == 0)
+		{
+			if (this->enqueuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+			{
+				cell.message = move(message);
+				cell.sequence.store(position + 1, memory_order_release);
+				return;
+			}
+		}
+		else if (difference < 0)
+		{
+			this_thread::yield(); // full
+			position = this->enqueuePosition.load(memory_order_relaxed);
+		}
+		else
+			position = this->enqueuePosition.load(memory_order_relaxed);
+	}
+}
+
+/**
+ * @brief Writes out every message queued so far. Only called by the writer.
+ *
+ * @return true if anything was written
+ */
+bool Logger::drain()
+{
+	bool wrote = false;
+	while (true)
+	{
+		Cell &cell = this->cells[this->dequeuePosition & (QUEUE_SIZE - 1)];
+		if (cell.sequence.load(memory_order_acquire) != this->dequeuePosition + 1)
+			break;
+		this->fout << cell.message << '\n';
+		cell.message.clear();
+		cell.sequence.store(this->dequeuePosition + QUEUE_SIZE, memory_order_release);
+		this->dequeuePosition++;
+		wrote = true;
+	}
+	if (wrote)
+		this->fout.flush();
+	return wrote;
+}
+
+/**
+ * @brief Body of the writer thread: drains the queue, napping briefly while
+ * it is empty, until the logger is destroyed.
+ *
+ */
+void Logger::writeLoop()
+{
+	while (!this->stopping.load(memory_order_acquire))
+		if (!this->drain())
+			this_thread::sleep_for(chrono::milliseconds(1));
+	this->drain();
+}
+
+/**
+ * @brief Parses a level name (DEBUG, INFO, WARNING, ERROR or OFF, case
+ * insensitive).
+ *
+ * @param name
+ * @param level
+ * @return false if the name is not a level
+ */
+bool parseLogLevel(const string &name, LogLevel &level)
+{
+	string upperName = name;
+	transform(upperName.begin(), upperName.end(), upperName.begin(), ::toupper);
+	const vector<string> names = {"DEBUG", "INFO", "WARNING", "ERROR", "OFF"};
+	auto it = find(names.begin(), names.end(), upperName);
+	if (it == names.end())
+		return false;
+	level = (LogLevel)(it - names.begin());
+	return true;
 }
@@ -9,17 +9,111 @@
 
 using namespace std;
 
+enum LogLevel
+{
+	LOG_LEVEL_DEBUG,
+	LOG_LEVEL_INFO,
+	LOG_LEVEL_WARNING,
+	LOG_LEVEL_ERROR,
+	LOG_LEVEL_OFF
+};
+
+/**
+ * @brief Levels below LOG_MIN_LEVEL are compiled out: their LOG_* macros
+ * expand to nothing, message arguments included. Set it from the Makefile,
+ * e.g. `make LOG_MIN_LEVEL=1` drops every LOG_DEBUG from the binary.
+ */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+/**
+ * @brief Writes log messages to the file "log". Messages below the runtime
+ * level (--log-level) are dropped before the message is even built, see the
+ * LOG_* macros. The rest are pushed onto a bounded lock-free queue (Vyukov's
+ * multi-producer ring buffer) and written out by a background thread, so the
+ * caller never waits for the file. The queue is drained when the logger is
+ * destroyed at exit.
+ */
 class Logger
 {
+	/**
+	 * @brief A ring buffer cell. sequence tells producers and the writer whose
+	 * turn the cell is: it equals the enqueue position when the cell is free and
+	 * position + 1 once a message has been stored in it.
+	 */
+	struct Cell
+	{
+		atomic<size_t> sequence;
+		string message;
+	};
+	static const size_t QUEUE_SIZE = 4096; // power of two
 
 	string logFile = "log";
 	ofstream fout;
+	LogLevel level = LOG_LEVEL_INFO;
+	unique_ptr<Cell[]> cells;
+	alignas(64) atomic<size_t> enqueuePosition{0};
+	alignas(64) size_t dequeuePosition = 0; // only touched by the writer
+	atomic<bool> stopping{false};
+	thread writer;
+
+	void writeLoop();
+	bool drain();
 
 public:
 	Logger();
-	void log(string logString);
+	~Logger();
+	void setLevel(LogLevel level) { this->level = level; }
+	bool isEnabled(LogLevel level) const { return level >= this->level; }
+	void log(LogLevel level, string message);
 };
 
 extern Logger logger;
 
-#endif
\ No newline at end of file
+bool parseLogLevel(const string &name, LogLevel &level);
+
+#define LOG_AT(logLevel, ...)                 \
+	do                                        \
+	{                                         \
+		if (logger.isEnabled(logLevel))       \
+			logger.log(logLevel, __VA_ARGS__); \
+	} while (0)
+
+#if LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) \
+	do                 \
+	{                  \
+	} while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= 1
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) \
+	do                \
+	{                 \
+	} while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= 2
+#define LOG_WARNING(...) LOG_AT(LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) \
+	do                   \
+	{                    \
+	} while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= 3
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) \
+	do                 \
+	{                  \
+	} while (0)
+#endif
+
+#endif
@@ -4,7 +4,7 @@
 
 Matrix::Matrix(string matrixName)
 {
-	logger.log("Matrix::Matrix");
+	LOG_DEBUG("Matrix::Matrix");
 	this->matrixName = matrixName;
 	this->sourceFileName = "../data/" + matrixName + ".csv";
 	this->dimension = 0;
@@ -20,7 +20,7 @@ Matrix::Matrix(string matrixName)
  */
 bool Matrix::load()
 {
-	logger.log("Matrix::load");
+	LOG_DEBUG("Matrix::load");
 
 	// Step 1: find the dimension from the CSV
 	if (!this->determineMatrixDimension())
@@ -36,7 +36,7 @@ bool Matrix::load()
  */
 bool Matrix::determineMatrixDimension()
 {
-	logger.log("Matrix::determineMatrixDimension");
+	LOG_DEBUG("Matrix::determineMatrixDimension");
 	ifstream fin(this->sourceFileName, ios::in);
 	if (!fin.is_open())
 	{
@@ -60,7 +60,7 @@ bool Matrix::determineMatrixDimension()
  */
 bool Matrix::blockify()
 {
-	logger.log("Matrix::blockify");
+	LOG_DEBUG("Matrix::blockify");
 	ifstream fin(this->sourceFileName, ios::in);
 	if (!fin.is_open())
 		return false;
@@ -73,9 +73,8 @@ bool Matrix::blockify()
 	if (this->maxRowsPerBlock == 0)
 		this->maxRowsPerBlock = 1;
 
-	// Prepare a buffer of row vectors
-	vector<int> singleRow(this->dimension, 0);
-	vector<vector<int>> rowsInPage(this->maxRowsPerBlock, singleRow);
+	// Prepare a row-major page buffer
+	vector<int> rowsInPage((size_t)this->maxRowsPerBlock * this->dimension);
 
 	int rowsInCurrentPage = 0;
 	this->blockCount = 0;
@@ -96,7 +95,7 @@ bool Matrix::blockify()
 				return false;
 			}
 
-			rowsInPage[rowsInCurrentPage][col] = stoi(word);
+			rowsInPage[(size_t)rowsInCurrentPage * this->dimension + col] = stoi(word);
 		}
 		rowsInCurrentPage++;
 
@@ -106,7 +105,8 @@ bool Matrix::blockify()
 				this->matrixName,
 				this->blockCount,
 				rowsInPage,
-				rowsInCurrentPage);
+				rowsInCurrentPage,
+				this->dimension);
 			this->blockCount++;
 			this->rowsPerBlockCount.push_back(rowsInCurrentPage);
 			rowsInCurrentPage = 0;
@@ -121,7 +121,8 @@ bool Matrix::blockify()
 			this->matrixName,
 			this->blockCount,
 			rowsInPage,
-			rowsInCurrentPage);
+			rowsInCurrentPage,
+			this->dimension);
 		this->blockCount++;
 		this->rowsPerBlockCount.push_back(rowsInCurrentPage);
 	}
@@ -131,7 +132,7 @@ bool Matrix::blockify()
 
 void Matrix::unload()
 {
-	logger.log("Matrix::unload");
+	LOG_DEBUG("Matrix::unload");
 	for (int page = 0; page < this->blockCount; page++)
 	{
 		bufferManager.deleteFile(this->matrixName, page);
@@ -140,7 +141,7 @@ void Matrix::unload()
 
 void Matrix::print()
 {
-	logger.log("Matrix::print");
+	LOG_DEBUG("Matrix::print");
 	int limit = min(dimension, 20); // dont print more than 20 rows
 
 	int rowsPrinted = 0;
@@ -148,11 +149,11 @@ void Matrix::print()
 	{
 		int rowsInThisBlock = this->rowsPerBlockCount[blockIndex];
 
-		Page page = bufferManager.getPage(this->matrixName, blockIndex);
+		PageHandle page = bufferManager.getPage(this->matrixName, blockIndex);
 
 		for (int r = 0; r < rowsInThisBlock && rowsPrinted < limit; r++)
 		{
-			vector<int> rowData = page.getRow(r);
+			RowSpan rowData = page->getRowRef(r);
 			for (int c = 0; c < limit; c++)
 			{
 				cout << rowData[c];
@@ -169,7 +170,7 @@ void Matrix::print()
 
 void Matrix::makePermanent()
 {
-	logger.log("Matrix::makePermanent");
+	LOG_DEBUG("Matrix::makePermanent");
 	string newSourceFile = "../data/" + this->matrixName + ".csv";
 	ofstream fout(newSourceFile, ios::out);
 	if (!fout.is_open())
@@ -181,12 +182,12 @@ void Matrix::makePermanent()
 	int totalBlocks = this->blockCount;
 	for (int blockIndex = 0; blockIndex < totalBlocks; blockIndex++)
 	{
-		Page page = bufferManager.getPage(this->matrixName, blockIndex);
+		PageHandle page = bufferManager.getPage(this->matrixName, blockIndex);
 		int rowsInThisBlock = this->rowsPerBlockCount[blockIndex];
 
 		for (int r = 0; r < rowsInThisBlock; r++)
 		{
-			vector<int> rowData = page.getRow(r);
+			RowSpan rowData = page->getRowRef(r);
 			for (int c = 0; c < this->dimension; c++)
 			{
 				fout << rowData[c];
@@ -198,4 +199,5 @@ void Matrix::makePermanent()
 	}
 
 	fout.close();
+	bufferManager.flushTable(this->matrixName);
 }
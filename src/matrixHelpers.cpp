@@ -7,9 +7,8 @@ int readMatrixElement(const std::string &matrixName, int row, int col)
 	int blockIndex = row / matrix->maxRowsPerBlock;
 	int offsetInBlock = row % matrix->maxRowsPerBlock;
 
-	Page page = bufferManager.getPage(matrixName, blockIndex);
-	vector<int> rowData = page.getRow(offsetInBlock);
-	return rowData[col];
+	PageHandle page = bufferManager.getPage(matrixName, blockIndex);
+	return page->getRowRef(offsetInBlock)[col];
 }
 
 void writeMatrixElement(const std::string &matrixName, int row, int col, int val)
@@ -18,14 +17,8 @@ void writeMatrixElement(const std::string &matrixName, int row, int col, int val
 	int blockIndex = row / matrix->maxRowsPerBlock;
 	int offsetInBlock = row % matrix->maxRowsPerBlock;
 
-	Page page = bufferManager.getPage(matrixName, blockIndex);
-	vector<vector<int>> data(matrix->maxRowsPerBlock,
-							 vector<int>(matrix->dimension, 0));
-	int actualRows = matrix->rowsPerBlockCount[blockIndex];
-
-	for (int r = 0; r < actualRows; r++)
-		data[r] = page.getRow(r);
-
-	data[offsetInBlock][col] = val;
-	bufferManager.writePage(matrixName, blockIndex, data, actualRows);
+	PageHandle page = bufferManager.getPage(matrixName, blockIndex);
+	vector<int> rowData = page->getRowRef(offsetInBlock).toVector();
+	rowData[col] = val;
+	page.modify().setRow(offsetInBlock, rowData);
 }
@@ -1,4 +1,21 @@
 #include "global.h"
+
+/**
+ * @brief Looks up the column count of the table or matrix owning a page. Only
+ * needed when the page file itself cannot tell us (an empty text page).
+ *
+ * @param tableName
+ * @return int column count, 0 if the entity is not in any catalogue
+ */
+static int catalogueColumnCount(const string &tableName)
+{
+	if (tableCatalogue.isTable(tableName))
+		return tableCatalogue.getTable(tableName)->columnCount;
+	if (matrixCatalogue.isMatrix(tableName))
+		return matrixCatalogue.getMatrix(tableName)->dimension;
+	return 0;
+}
+
 /**
  * @brief Construct a new Page object. Never used as part of the code
  *
@@ -10,154 +27,195 @@ Page::Page()
 	this->pageIndex = -1;
 	this->rowCount = 0;
 	this->columnCount = 0;
-	this->rows.clear();
 }
 
 /**
  * @brief Construct a new Page:: Page object given the table name and page
  * index. When tables are loaded they are broken up into blocks of BLOCK_SIZE
- * and each block is stored in a different file named
- * "<tablename>_Page<pageindex>". For example, If the Page being loaded is of
- * table "R" and the pageIndex is 2 then the file name is "R_Page2". The page
- * loads the rows (or tuples) into a vector of rows (where each row is a vector
- * of integers).
+ * and each block is stored as one slot of the table's segment file
+ * "<tablename>.seg" (see StorageManager). The page loads the rows (or tuples)
+ * into one contiguous row-major buffer of integers.
+ *
+ * The whole page is pulled in with a single read. Binary pages carry their own
+ * dimensions in the PageHeader; text pages (TEXT_PAGES debug mode, one
+ * "<tablename>_Page<pageindex>" file per page) are parsed one line per row.
  *
  * @param tableName
  * @param pageIndex
  */
 Page::Page(string tableName, int pageIndex)
 {
-	logger.log("Page::Page");
+	LOG_DEBUG("Page::Page");
+	vector<char> buffer;
+	if (!storageManager.readPage(tableName, pageIndex, buffer))
+	{
+		this->tableName = tableName;
+		this->pageIndex = pageIndex;
+		this->pageName = "../data/temp/" + this->tableName + "_Page" + to_string(pageIndex);
+		this->rowCount = 0;
+		this->columnCount = catalogueColumnCount(tableName);
+		LOG_ERROR("Page::Page - ERROR: Could not read page: " + this->pageName + ". Page will be empty.");
+		return;
+	}
+	*this = Page(tableName, pageIndex, buffer);
+}
+
+/**
+ * @brief Construct a new Page:: Page object from a page image that has already
+ * been read from storage (by the read-ahead thread, see
+ * BufferManager::readAhead).
+ *
+ * @param tableName
+ * @param pageIndex
+ * @param buffer the raw bytes of the page
+ */
+Page::Page(string tableName, int pageIndex, const vector<char> &buffer)
+{
 	this->tableName = tableName;
 	this->pageIndex = pageIndex;
 	this->pageName = "../data/temp/" + this->tableName + "_Page" + to_string(pageIndex);
+	this->rowCount = 0;
+	this->columnCount = 0;
 
-    // Attempt to get Table metadata
-    if (tableCatalogue.isTable(tableName)) // Check if it's a table
-    {
-        Table* table_obj_ptr = tableCatalogue.getTable(tableName); // Get pointer, NO DEREFERENCE/COPY
-        if (!table_obj_ptr) { 
-            logger.log("Page::Page - ERROR: Table " + tableName + " reported by catalogue but getTable returned null.");
-            this->rowCount = 0; this->columnCount = 0; this->rows.clear(); return;
-        }
-        this->columnCount = table_obj_ptr->columnCount;
-
-        if (this->columnCount == 0 && pageIndex >=0) { // Table exists but has no columns
-             logger.log("Page::Page - Warning: Table " + tableName + " has 0 columns. Page will be empty.");
-             this->rowCount = 0;
-             // this->rows.clear(); // rows is already empty or will be correctly sized if maxRowsPerBlock is 0
-             return;
-        }
-
-
-        // Validate pageIndex before accessing rowsPerBlockCount
-        if (pageIndex < 0 || pageIndex >= table_obj_ptr->blockCount) {
-            logger.log("Page::Page - ERROR: Invalid pageIndex " + std::to_string(pageIndex) + " for table " + tableName + " (blockCount: " + std::to_string(table_obj_ptr->blockCount) + "). Page will be empty.");
-            this->rowCount = 0;
-            // Ensure rows is empty or sized for 0 rows but with correct column count if needed by other parts of system
-            if(this->columnCount > 0) {
-                vector<int> row_template(this->columnCount, 0);
-                this->rows.assign(0, row_template); // 0 rows, but columns are defined
-            } else {
-                this->rows.clear();
-            }
-            return; 
-        }
-        
-        uint max_rows_curr_page = table_obj_ptr->maxRowsPerBlock; 
-        this->rowCount = table_obj_ptr->rowsPerBlockCount[pageIndex];
-
-        if (this->columnCount > 0) { // Only proceed if columns are defined
-            vector<int> row_template(this->columnCount, 0);
-            this->rows.assign(max_rows_curr_page > 0 ? max_rows_curr_page : 1, row_template); // Pre-allocate buffer, ensure at least 1 row capacity if maxRowsPerBlock is 0 but columnCount > 0
-
-            ifstream fin(this->pageName, ios::in);
-            if (!fin.is_open()) {
-                logger.log("Page::Page - ERROR: Could not open page file: " + this->pageName + ". Page will be empty.");
-                this->rowCount = 0; 
-                return;
-            }
-
-            int number;
-            for (uint rowCounter = 0; rowCounter < this->rowCount; rowCounter++) {
-                if (rowCounter >= this->rows.size()) { // Defensive check against pre-allocation mismatch
-                    logger.log("Page::Page - ERROR: rowCounter exceeds allocated rows size in " + this->pageName);
-                    this->rowCount = rowCounter;
-                    break;
-                }
-                for (int colCounter = 0; colCounter < this->columnCount; colCounter++) {
-                    if (!(fin >> number)) {
-                        logger.log("Page::Page - ERROR: File format error or premature EOF in " + this->pageName + " at row " + std::to_string(rowCounter) + ", col " + std::to_string(colCounter) + ". Read " + std::to_string(rowCounter) + " rows.");
-                        this->rowCount = rowCounter; 
-                        fin.close();
-                        return;
-                    }
-                    this->rows[rowCounter][colCounter] = number;
-                }
-            }
-            fin.close();
-        } else { // columnCount is 0
-             this->rowCount = 0; // No columns means no data rows
-             this->rows.clear();
-        }
-    }
-    else if (matrixCatalogue.isMatrix(tableName)) // Check if it's a matrix
-    {
-        Matrix* matrix_obj_ptr = matrixCatalogue.getMatrix(tableName); 
-        if (!matrix_obj_ptr) {
-             logger.log("Page::Page - ERROR: Matrix " + tableName + " reported by catalogue but getMatrix returned null.");
-            this->rowCount = 0; this->columnCount = 0; this->rows.clear(); return;
-        }
-        this->columnCount = matrix_obj_ptr->dimension;
-
-        if (this->columnCount == 0 && pageIndex >=0) {
-             logger.log("Page::Page - Warning: Matrix " + tableName + " has 0 dimension. Page will be empty.");
-             this->rowCount = 0;
-             return;
-        }
-
-        if (pageIndex < 0 || pageIndex >= matrix_obj_ptr->blockCount) {
-            logger.log("Page::Page - ERROR: Invalid pageIndex " + std::to_string(pageIndex) + " for matrix " + tableName + " (blockCount: " + std::to_string(matrix_obj_ptr->blockCount) + "). Page will be empty.");
-            this->rowCount = 0;
-            if(this->columnCount > 0) {
-                 vector<int> row_template(this->columnCount, 0);
-                 this->rows.assign(0, row_template);
-            } else {
-                this->rows.clear();
-            }
-            return;
-        }
-
-        uint max_rows_curr_page = matrix_obj_ptr->maxRowsPerBlock;
-        this->rowCount = matrix_obj_ptr->rowsPerBlockCount[pageIndex];
-        
-        if (this->columnCount > 0) {
-            vector<int> row_template(this->columnCount, 0);
-            this->rows.assign(max_rows_curr_page > 0 ? max_rows_curr_page : 1, row_template);
-            
-            ifstream fin(this->pageName, ios::in);
-            if (!fin.is_open()) { logger.log("Page::Page - ERROR: Could not open page file: " + this->pageName + ". Page will be empty."); this->rowCount = 0; return; }
-            int number;
-            for (uint rowCounter = 0; rowCounter < this->rowCount; rowCounter++) {
-                 if (rowCounter >= this->rows.size()) { logger.log("Page::Page - ERROR: rowCounter exceeds allocated rows size in " + this->pageName); this->rowCount = rowCounter; break; }
-                for (int colCounter = 0; colCounter < this->columnCount; colCounter++) {
-                    if (!(fin >> number)) { logger.log("Page::Page - ERROR: File format error or premature EOF in " + this->pageName + " at row " + std::to_string(rowCounter) + ", col " + std::to_string(colCounter) + ". Read " + std::to_string(rowCounter) + " rows."); this->rowCount = rowCounter; fin.close(); return; }
-                    this->rows[rowCounter][colCounter] = number;
-                }
-            }
-            fin.close();
-        } else {
-            this->rowCount = 0;
-            this->rows.clear();
-        }
-    }
-    else 
-    {
-        logger.log("Page::Page - ERROR: Entity " + tableName + " not found in any catalogue for page loading.");
-        this->rowCount = 0;
-        this->columnCount = 0;
-        this->rows.clear();
-    }
+	PageHeader header;
+	if (buffer.size() >= sizeof(PageHeader))
+		memcpy(&header, buffer.data(), sizeof(PageHeader));
+	if (buffer.size() >= sizeof(PageHeader) && header.magic == PAGE_MAGIC)
+	{
+		if (header.version != PAGE_VERSION)
+		{
+			LOG_ERROR("Page::Page - ERROR: Unsupported page version " + to_string(header.version) + " in " + this->pageName);
+			return;
+		}
+		this->columnCount = header.columnCount;
+		this->rowCount = header.rowCount;
+		if (header.flags & PAGE_FLAG_PAX)
+			this->layout = PAX_LAYOUT;
+		if (header.flags & PAGE_FLAG_COMPRESSED)
+		{
+			if (!this->decompress(buffer.data() + sizeof(PageHeader), buffer.data() + buffer.size()))
+			{
+				LOG_ERROR("Page::Page - ERROR: Corrupt compressed page " + this->pageName + ". Page will be empty.");
+				this->rowCount = 0;
+				this->values.clear();
+			}
+			return;
+		}
+		size_t payloadBytes = (size_t)this->rowCount * this->columnCount * sizeof(int32_t);
+		if (buffer.size() < sizeof(PageHeader) + payloadBytes)
+		{
+			LOG_ERROR("Page::Page - ERROR: Truncated page file " + this->pageName + ". Page will be empty.");
+			this->rowCount = 0;
+			return;
+		}
+		const int32_t *payload = (const int32_t *)(buffer.data() + sizeof(PageHeader));
+		size_t valueCount = (size_t)this->rowCount * this->columnCount;
+		if (this->layout == PAX_LAYOUT)
+		{
+			this->values.resize(valueCount);
+			for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+				for (int rowCounter = 0; rowCounter < this->rowCount; rowCounter++)
+					this->values[(size_t)rowCounter * this->columnCount + columnCounter] = payload[(size_t)columnCounter * this->rowCount + rowCounter];
+			return;
+		}
+		this->values.assign(payload, payload + valueCount);
+		return;
+	}
+
+	// Text page: one whitespace separated row per line
+	const char *cursor = buffer.data();
+	const char *end = buffer.data() + buffer.size();
+	while (cursor < end)
+	{
+		const char *lineEnd = (const char *)memchr(cursor, '\n', end - cursor);
+		if (!lineEnd)
+			lineEnd = end;
+		string line(cursor, lineEnd);
+		istringstream lineStream(line);
+		int number;
+		int rowLength = 0;
+		while (lineStream >> number)
+		{
+			this->values.push_back(number);
+			rowLength++;
+		}
+		if (rowLength > 0)
+		{
+			if (this->rowCount == 0)
+				this->columnCount = rowLength;
+			this->rowCount++;
+		}
+		cursor = lineEnd + 1;
+	}
+	if (this->rowCount == 0)
+		this->columnCount = catalogueColumnCount(tableName);
+}
+
+/**
+ * @brief Decodes the columns of a compressed page image (everything after the
+ * PageHeader) straight into the page's row-major buffer.
+ *
+ * @param data
+ * @param end
+ * @return false if the image is corrupt
+ */
+bool Page::decompress(const char *data, const char *end)
+{
+	this->values.resize((size_t)this->rowCount * this->columnCount);
+	for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+		if (!decodeColumn(data, end, this->rowCount, this->values.data() + columnCounter, this->columnCount))
+			return false;
+	return true;
+}
+
+/**
+ * @brief Appends the page's columns to buffer, each in its smallest
+ * ColumnEncoding.
+ *
+ * @param buffer holds the PageHeader on entry
+ * @return false if compressing saves less than a quarter of the page, in
+ * which case it is written out uncompressed: a page that barely shrinks is
+ * not worth decoding on every read, and only uncompressed pages can be
+ * scanned in place (see viewPage)
+ */
+bool Page::compress(vector<char> &buffer) const
+{
+	// Columns of a single value (B+ tree node pages are one long row) never shrink
+	if (this->rowCount < 2)
+		return false;
+	size_t plainSize = sizeof(PageHeader) + (size_t)this->rowCount * this->columnCount * sizeof(int32_t);
+	size_t worthwhileSize = plainSize - plainSize / 4;
+	for (int columnCounter = 0; columnCounter < this->columnCount && buffer.size() < worthwhileSize; columnCounter++)
+		encodeColumn(this->values.data() + columnCounter, this->columnCount, this->rowCount, buffer);
+	return buffer.size() <= worthwhileSize;
+}
+
+/**
+ * @brief Fills view with the rows of page pageIndex of tableName straight out
+ * of the memory mapped segment, without reading or parsing anything.
+ *
+ * @param tableName
+ * @param pageIndex
+ * @param view
+ * @return false if the page cannot be mapped or is not an uncompressed binary
+ * page
+ */
+bool viewPage(const string &tableName, int pageIndex, PageView &view)
+{
+	const char *data;
+	size_t length;
+	if (!storageManager.mapPage(tableName, pageIndex, data, length) || length < sizeof(PageHeader))
+		return false;
+	PageHeader header;
+	memcpy(&header, data, sizeof(PageHeader));
+	if (header.magic != PAGE_MAGIC || header.version != PAGE_VERSION || (header.flags & PAGE_FLAG_COMPRESSED) ||
+		length < sizeof(PageHeader) + (size_t)header.rowCount * header.columnCount * sizeof(int32_t))
+		return false;
+	view.values = (const int32_t *)(data + sizeof(PageHeader));
+	view.rowCount = header.rowCount;
+	view.columnCount = header.columnCount;
+	view.layout = (header.flags & PAGE_FLAG_PAX) ? PAX_LAYOUT : ROW_LAYOUT;
+	return true;
 }
 
 /**
@@ -168,76 +226,172 @@ Page::Page(string tableName, int pageIndex)
  */
 vector<int> Page::getRow(int rowIndex)
 {
-	logger.log("Page::getRow");
-	vector<int> result;
-	// result.clear(); // Not needed as it's default constructed to empty
-	if (rowIndex < 0 || rowIndex >= this->rowCount || rowIndex >= this->rows.size()) // Added rowIndex < 0 and rows.size() check
-		return result; // Return empty vector
-	return this->rows[rowIndex];
+	LOG_DEBUG("Page::getRow");
+	return this->getRowRef(rowIndex).toVector();
+}
+
+/**
+ * @brief Same as getRow but returns a span into the page's buffer instead of
+ * a copy. The span is only valid while the page (or the PageHandle pinning
+ * it) is alive and unchanged. Out of range indices yield an empty row.
+ *
+ * @param rowIndex
+ * @return RowSpan
+ */
+RowSpan Page::getRowRef(int rowIndex) const
+{
+	if (rowIndex < 0 || rowIndex >= this->rowCount)
+		return RowSpan();
+	return RowSpan{this->values.data() + (size_t)rowIndex * this->columnCount, this->columnCount};
+}
+
+/**
+ * @brief Overwrites the row at rowIndex in memory. Only meant to be used on a
+ * page obtained through PageHandle::modify so the change reaches the file.
+ *
+ * @param rowIndex
+ * @param row
+ */
+void Page::setRow(int rowIndex, const vector<int> &row)
+{
+	if (rowIndex < 0 || rowIndex >= this->rowCount || row.size() != this->columnCount)
+		return;
+	copy(row.begin(), row.end(), this->values.begin() + (size_t)rowIndex * this->columnCount);
+}
+
+/**
+ * @brief Adds a row after the last one in memory. Only meant to be used on a
+ * page obtained through PageHandle::modify so the change reaches the file.
+ *
+ * @param row
+ */
+void Page::appendRow(const vector<int> &row)
+{
+	if (this->columnCount == 0)
+		this->columnCount = row.size();
+	if (row.size() != this->columnCount)
+	{
+		LOG_ERROR("Page::appendRow - ERROR: Row has " + to_string(row.size()) + " values, page has " + to_string(this->columnCount) + " columns.");
+		return;
+	}
+	this->values.insert(this->values.end(), row.begin(), row.end());
+	this->rowCount++;
 }
 
-Page::Page(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount)
+/**
+ * @brief Construct a new Page:: Page object holding the first rowCount rows
+ * of values, a row-major buffer of rows that are columnCount ints wide. The
+ * buffer is taken over as is (anything past the first rowCount rows is cut
+ * off), so building a page is a single allocation at most.
+ *
+ * @param tableName
+ * @param pageIndex
+ * @param values
+ * @param rowCount
+ * @param columnCount
+ * @param layout how the page is laid out when it is written
+ */
+Page::Page(string tableName, int pageIndex, vector<int> values, int rowCount, int columnCount, PageLayout layout)
 {
-	logger.log("Page::Page");
+	LOG_DEBUG("Page::Page");
 	this->tableName = tableName;
 	this->pageIndex = pageIndex;
-	this->rows = rows;
+	this->layout = layout;
 	this->rowCount = rowCount;
-
-    if (this->rowCount > 0 && !this->rows.empty() && !this->rows[0].empty()) {
-        this->columnCount = this->rows[0].size();
-    } else {
-        // If rows are empty or rowCount is 0, get columnCount from catalogue
-        Table* table_obj = tableCatalogue.getTable(this->tableName);
-        if (table_obj) {
-            this->columnCount = table_obj->columnCount;
-        } else {
-            Matrix* matrix_obj = matrixCatalogue.getMatrix(this->tableName);
-            if (matrix_obj) {
-                this->columnCount = matrix_obj->dimension;
-            } else {
-                logger.log("Page::Page - Warning: Could not determine columnCount for page " + this->tableName + "_Page" + to_string(pageIndex) + " from catalogue. Setting to 0 as rows are empty/rowCount is 0.");
-                this->columnCount = 0; 
-                 // If rows vector was somehow provided (e.g. pre-allocated but empty data), attempt to use its structure
-                 if (!this->rows.empty() && !this->rows[0].empty()) {
-                     this->columnCount = this->rows[0].size();
-                 }
-            }
-        }
-    }
+	this->columnCount = columnCount;
+	if (this->columnCount == 0 && this->rowCount == 0)
+		this->columnCount = catalogueColumnCount(tableName);
+	this->values = move(values);
+	if (this->values.size() < (size_t)this->rowCount * this->columnCount)
+	{
+		LOG_ERROR("Page::Page - ERROR: " + to_string(this->values.size()) + " values given for " + to_string(this->rowCount) + " rows of " + to_string(this->columnCount) + " columns. Truncating.");
+		this->rowCount = this->columnCount ? this->values.size() / this->columnCount : 0;
+	}
+	this->values.resize((size_t)this->rowCount * this->columnCount);
 	this->pageName = "../data/temp/" + this->tableName + "_Page" + to_string(pageIndex);
 }
 
 /**
- * @brief writes current page contents to file.
+ * @brief writes current page contents to its segment slot. By default the
+ * page is laid out as a PageHeader followed by the rows packed as row-major
+ * int32s (column-major for PAX pages), which is what memory mapped scans
+ * read in place. With COMPRESS_PAGES set the header is instead followed by
+ * its columns, each compressed with whichever of frame of reference, delta or
+ * run length encoding (see compression.h) makes it smallest, unless that
+ * saves less than a quarter of the page. Either way the whole image goes out in a single write.
+ * With TEXT_PAGES set the legacy space separated format is written instead,
+ * which is handy for eyeballing temp files while debugging.
  *
  */
 void Page::writePage()
 {
-	logger.log("Page::writePage");
-	ofstream fout(this->pageName, ios::trunc);
+	LOG_DEBUG("Page::writePage");
+	if (TEXT_PAGES)
+	{
+		this->writeTextPage();
+		return;
+	}
+
+	PageHeader header;
+	header.magic = PAGE_MAGIC;
+	header.version = PAGE_VERSION;
+	header.flags = this->layout == PAX_LAYOUT ? PAGE_FLAG_PAX : 0;
+	header.rowCount = this->rowCount;
+	header.columnCount = this->columnCount;
+
+	vector<char> buffer(sizeof(PageHeader));
+	if (COMPRESS_PAGES && this->compress(buffer))
+	{
+		header.flags |= PAGE_FLAG_COMPRESSED;
+		memcpy(buffer.data(), &header, sizeof(PageHeader));
+		if (!storageManager.writePage(this->tableName, this->pageIndex, buffer.data(), buffer.size()))
+			LOG_ERROR("Page::writePage - ERROR: Could not write " + this->pageName);
+		return;
+	}
+
+	size_t valueCount = (size_t)this->rowCount * this->columnCount;
+	buffer.assign(sizeof(PageHeader) + valueCount * sizeof(int32_t), 0);
+	int32_t *payload = (int32_t *)(buffer.data() + sizeof(PageHeader));
+	if (this->layout == PAX_LAYOUT)
+	{
+		// One minipage per column
+		for (int rowCounter = 0; rowCounter < this->rowCount; rowCounter++)
+			for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+				payload[(size_t)columnCounter * this->rowCount + rowCounter] = this->values[(size_t)rowCounter * this->columnCount + columnCounter];
+	}
+	else if (valueCount)
+		memcpy(payload, this->values.data(), valueCount * sizeof(int32_t));
+	memcpy(buffer.data(), &header, sizeof(PageHeader));
+
+	if (!storageManager.writePage(this->tableName, this->pageIndex, buffer.data(), buffer.size()))
+		LOG_ERROR("Page::writePage - ERROR: Could not write " + this->pageName);
+}
+
+/**
+ * @brief Writes the page in the legacy whitespace separated text format, one
+ * row per line. Only used when TEXT_PAGES is set.
+ *
+ */
+void Page::writeTextPage()
+{
+	LOG_DEBUG("Page::writeTextPage");
+	ostringstream fout;
 	for (int rowCounter = 0; rowCounter < this->rowCount; rowCounter++)
 	{
-        if (rowCounter >= this->rows.size()) { // Defensive check
-            logger.log("Page::writePage - ERROR: rowCounter out of bounds for this->rows. Skipping remaining rows.");
-            break;
-        }
-        if (this->columnCount > 0 && this->rows[rowCounter].size() != this->columnCount) { // Defensive check
-             logger.log("Page::writePage - ERROR: Mismatch between page columnCount and actual row columnCount at row " + to_string(rowCounter) + ". Skipping row.");
-             continue;
-        }
 		for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
 		{
 			if (columnCounter != 0)
 				fout << " ";
-			fout << this->rows[rowCounter][columnCounter];
+			fout << this->values[(size_t)rowCounter * this->columnCount + columnCounter];
 		}
 		fout << endl;
 	}
-	fout.close();
+	string text = fout.str();
+	if (!storageManager.writePage(this->tableName, this->pageIndex, text.data(), text.size()))
+		LOG_ERROR("Page::writeTextPage - ERROR: Could not write " + this->pageName);
 }
 
 int Page::getRowCount() const
 {
 	return this->rowCount;
-}
\ No newline at end of file
+}
@@ -2,7 +2,78 @@
 #define PAGE_H
 
 #pragma once
-#include "logger.h"
+#include "segment.h"
+#include "compression.h"
+
+/**
+ * @brief On-disk header of a binary page file. It is followed by rowCount *
+ * columnCount int32 values in row-major order, so a page can be read or
+ * written with a single syscall and without any text formatting. If
+ * PAGE_FLAG_COMPRESSED is set it is instead followed by one ColumnHeader and
+ * the encoded values for each column in turn (see compression.h).
+ */
+struct PageHeader
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t flags;
+	uint32_t rowCount;
+	uint32_t columnCount;
+};
+
+const uint32_t PAGE_MAGIC = 0x50415253; // "SRAP" on little-endian machines
+const uint16_t PAGE_VERSION = 1;
+const uint16_t PAGE_FLAG_PAX = 0x1;		 // payload is column-major, see PageLayout
+const uint16_t PAGE_FLAG_COMPRESSED = 0x2; // payload is compressed column by column
+
+/**
+ * @brief How rows are laid out in a binary page. ROW_LAYOUT (N-ary) stores
+ * whole rows one after the other. PAX_LAYOUT stores one minipage per column:
+ * all values of column 0, then all values of column 1, and so on, so a scan
+ * that needs a few columns of a wide table only touches those minipages. The
+ * layout is recorded in every page header, so pages of both kinds can be read
+ * back whatever the table's current layout is.
+ */
+enum PageLayout
+{
+	ROW_LAYOUT,
+	PAX_LAYOUT
+};
+
+/**
+ * @brief Read-only view of the rows of a binary page where they already lie in
+ * memory (in practice a memory mapped segment), used to scan a page without
+ * building a Page. Value (r, c) is at values[r * columnCount + c] in a row
+ * layout page and at values[c * rowCount + r] in a PAX page.
+ */
+struct PageView
+{
+	const int32_t *values = nullptr;
+	int rowCount = 0;
+	int columnCount = 0;
+	PageLayout layout = ROW_LAYOUT;
+};
+
+bool viewPage(const string &tableName, int pageIndex, PageView &view);
+
+/**
+ * @brief A row of a Page: a pointer to its first value and the number of
+ * values, pointing into the page's buffer. Only valid while the page (or the
+ * PageHandle pinning it) is alive and unchanged.
+ */
+struct RowSpan
+{
+	const int *values = nullptr;
+	int columnCount = 0;
+
+	int size() const { return this->columnCount; }
+	bool empty() const { return this->columnCount == 0; }
+	int operator[](int columnIndex) const { return this->values[columnIndex]; }
+	const int *begin() const { return this->values; }
+	const int *end() const { return this->values + this->columnCount; }
+	vector<int> toVector() const { return vector<int>(this->begin(), this->end()); }
+};
+
 /**
  * @brief The Page object is the main memory representation of a physical page
  * (equivalent to a block). The page class and the page.h header file are at the
@@ -18,19 +89,29 @@ class Page
 {
 
 	string tableName;
-	string pageIndex;
+	int pageIndex;
 	int columnCount;
 	int rowCount;
-	vector<vector<int>> rows;
+	vector<int> values; // rowCount * columnCount ints, row-major, whatever the on-disk layout
+	PageLayout layout = ROW_LAYOUT;
+	void writeTextPage();
+	bool decompress(const char *data, const char *end);
+	bool compress(vector<char> &buffer) const;
 
 public:
 	string pageName = "";
 	Page();
 	Page(string tableName, int pageIndex);
-	Page(string tableName, int pageIndex, vector<vector<int>> rows, int rowCount);
+	Page(string tableName, int pageIndex, const vector<char> &buffer);
+	Page(string tableName, int pageIndex, vector<int> values, int rowCount, int columnCount, PageLayout layout = ROW_LAYOUT);
 	vector<int> getRow(int rowIndex);
+	RowSpan getRowRef(int rowIndex) const;
+	const int *getValues() const { return this->values.data(); }
+	void setRow(int rowIndex, const vector<int> &row);
+	void appendRow(const vector<int> &row);
 	void writePage();
 	int getRowCount() const;
+	int getColumnCount() const { return this->columnCount; }
 };
 
 #endif
@@ -0,0 +1,424 @@
+#include "global.h"
+
+string accessMethodName(AccessMethod method)
+{
+	switch (method)
+	{
+	case INDEX_PROBE:
+		return "Index probe";
+	case BITMAP_HEAP_SCAN:
+		return "Bitmap heap scan";
+	default:
+		return "Table scan";
+	}
+}
+
+/**
+ * @brief Inclusive range of values that satisfy "column op value", in 64 bits
+ * so that the ends of the int range need no special cases. NOT_EQUAL is left
+ * to the callers.
+ */
+static void predicateRange(BinaryOperator binaryOperator, int value, int64_t &low, int64_t &high)
+{
+	low = INT_MIN;
+	high = INT_MAX;
+	if (binaryOperator == LESS_THAN)
+		high = (int64_t)value - 1;
+	else if (binaryOperator == LEQ)
+		high = value;
+	else if (binaryOperator == GREATER_THAN)
+		low = (int64_t)value + 1;
+	else if (binaryOperator == GEQ)
+		low = value;
+	else if (binaryOperator == EQUAL)
+		low = high = value;
+}
+
+/**
+ * @brief Estimated fraction of the table's rows for which "column op value"
+ * holds. Uses the statistics of ANALYZE when there are some; otherwise
+ * assumes the values are spread evenly between the smallest and largest value
+ * in the zone maps, with every distinct value equally common.
+ */
+static double estimateSelectivity(Table *table, int columnIndex, BinaryOperator binaryOperator, int value, bool &fromStatistics)
+{
+	int64_t low, high;
+	predicateRange(binaryOperator, value, low, high);
+	fromStatistics = columnIndex < (int)table->columnStatistics.size();
+	if (fromStatistics)
+	{
+		const ColumnStatistics &statistics = table->columnStatistics[columnIndex];
+		if (binaryOperator == NOT_EQUAL)
+			return 1 - statistics.equalFraction(value);
+		if (binaryOperator == EQUAL)
+			return statistics.equalFraction(value);
+		return statistics.rangeFraction(low, high);
+	}
+
+	ZoneMap column;
+	for (auto &pageZoneMaps : table->zoneMaps)
+		if (columnIndex < (int)pageZoneMaps.size() && pageZoneMaps[columnIndex].minimum <= pageZoneMaps[columnIndex].maximum)
+		{
+			column.include(pageZoneMaps[columnIndex].minimum);
+			column.include(pageZoneMaps[columnIndex].maximum);
+		}
+	if (column.minimum > column.maximum)
+		return 0;
+	double distinctCount = 1;
+	if (columnIndex < (int)table->distinctValuesPerColumnCount.size())
+		distinctCount = max<double>(1, table->distinctValuesPerColumnCount[columnIndex]);
+	double equalFraction = (value < column.minimum || value > column.maximum) ? 0 : 1 / distinctCount;
+	if (binaryOperator == NOT_EQUAL)
+		return 1 - equalFraction;
+	if (binaryOperator == EQUAL)
+		return equalFraction;
+	low = max<int64_t>(low, column.minimum);
+	high = min<int64_t>(high, column.maximum);
+	if (low > high)
+		return 0;
+	return (double)(high - low + 1) / ((int64_t)column.maximum - column.minimum + 1);
+}
+
+// Pages that rows spread at random over pageCount pages land on (Cardenas' formula)
+static double pagesTouched(double pageCount, double rows)
+{
+	return pageCount > 0 ? pageCount * (1 - pow(1 - 1.0 / pageCount, rows)) : 0;
+}
+
+/**
+ * @brief What index can look up of the conditions: the key ranges, and which
+ * conditions they answer. Leading key columns pinned to one value by == become
+ * the prefix of every range; the conditions on the next key column become
+ * ranges of it, split around the values != excludes. Further key columns only
+ * narrow the rows down once fetched. Returns false if the index does not
+ * narrow the rows down at all, which for a hash index is anything but == on
+ * its column.
+ */
+static bool indexKeyRanges(Index *index, const vector<Condition> &conditions, vector<KeyRange> &keyRanges, vector<bool> &answered)
+{
+	const vector<int> &keyColumns = index->getKeyColumns();
+	keyRanges.clear();
+	answered.assign(conditions.size(), false);
+	if (!index->isOrdered() && keyColumns.size() > 1)
+		return false;
+	KeyRange prefix;
+	for (size_t position = 0; position < keyColumns.size(); position++)
+	{
+		int64_t low = INT_MIN, high = INT_MAX;
+		vector<int> excluded;
+		bool restricted = false;
+		for (const Condition &condition : conditions)
+		{
+			if (condition.columnIndex != keyColumns[position])
+				continue;
+			restricted = true;
+			if (condition.binaryOperator == NOT_EQUAL)
+			{
+				excluded.push_back(condition.value);
+				continue;
+			}
+			int64_t conditionLow, conditionHigh;
+			predicateRange(condition.binaryOperator, condition.value, conditionLow, conditionHigh);
+			low = max(low, conditionLow);
+			high = min(high, conditionHigh);
+		}
+		if (!restricted)
+			break;
+		bool point = low == high && find(excluded.begin(), excluded.end(), low) == excluded.end();
+		if (!index->isOrdered() && !point && low <= high)
+			return false;
+		for (size_t i = 0; i < conditions.size(); i++)
+			answered[i] = answered[i] || conditions[i].columnIndex == keyColumns[position];
+		if (point && position + 1 < keyColumns.size())
+		{
+			prefix.prefix[position] = low;
+			prefix.prefixLength++;
+			continue;
+		}
+
+		sort(excluded.begin(), excluded.end());
+		for (int value : excluded)
+		{
+			if (value < low || value > high)
+				continue;
+			if (value > low)
+				keyRanges.push_back(prefix), keyRanges.back().low = low, keyRanges.back().high = value - 1;
+			low = (int64_t)value + 1;
+		}
+		if (low <= high)
+			keyRanges.push_back(prefix), keyRanges.back().low = low, keyRanges.back().high = high;
+		return true;
+	}
+	if (prefix.prefixLength == 0)
+		return false;
+	keyRanges.push_back(prefix);
+	return true;
+}
+
+/**
+ * @brief Estimates what each way of evaluating the conditions on table costs
+ * and picks the cheapest. Costs count page reads, weighted by
+ * SEQUENTIAL_PAGE_COST or RANDOM_PAGE_COST, plus a little CPU per row.
+ *
+ * A table scan reads the pages the zone maps cannot rule out and tests all
+ * their rows. Both index methods first look the conditions up in an index
+ * (see Index::estimateLookupPages): a B+ tree reads one node per level down
+ * to the first leaf, then the leaves holding matching keys; a hash index
+ * reads the bucket the key hashes to and its overflow pages, and can only be
+ * used for ==. A B+ tree on several columns answers == on its leading columns
+ * plus conditions on the next one (see indexKeyRanges); the rows it finds are
+ * tested for the other conditions. An index probe then fetches the page of
+ * every pointer as it comes; once the rows are spread over more pages than
+ * the buffer pool holds, most of those fetches miss. A bitmap heap scan marks
+ * the pointers in a RowBitmap and reads every page holding them once, which
+ * gets closer to a sequential scan the more of the table's pages it touches.
+ * Of several indexes that answer some of the conditions, the cheapest is
+ * used.
+ *
+ * @param table
+ * @param conditions all of which have to hold
+ * @return AccessPlan
+ */
+AccessPlan planAccess(Table *table, const vector<Condition> &conditions)
+{
+	LOG_DEBUG("planAccess");
+	AccessPlan plan;
+	vector<Condition> resolved = conditions;
+	vector<double> selectivities;
+	plan.fromStatistics = true;
+	for (Condition &condition : resolved)
+	{
+		if (condition.columnIndex < 0)
+			condition.columnIndex = table->getColumnIndex(condition.columnName);
+		bool fromStatistics;
+		selectivities.push_back(min(1.0, max(0.0, estimateSelectivity(table, condition.columnIndex, condition.binaryOperator, condition.value, fromStatistics))));
+		plan.selectivity *= selectivities.back();
+		plan.fromStatistics = plan.fromStatistics && fromStatistics;
+	}
+
+	long long candidateRows = 0;
+	for (uint pageIndex = 0; pageIndex < table->blockCount; pageIndex++)
+	{
+		if (!pageMayMatch(table, pageIndex, resolved))
+			continue;
+		plan.candidatePages++;
+		if (pageIndex < table->rowsPerBlockCount.size())
+			candidateRows += table->rowsPerBlockCount[pageIndex];
+	}
+	plan.matchingRows = min<double>(plan.selectivity * table->rowCount, candidateRows);
+	// Pages the matching rows land on when they are spread at random over the
+	// candidate pages
+	plan.matchingPages = pagesTouched(plan.candidatePages, plan.matchingRows);
+	plan.scanCost = plan.candidatePages * SEQUENTIAL_PAGE_COST + candidateRows * CPU_OPERATOR_COST + plan.matchingRows * CPU_TUPLE_COST;
+
+	// Indexes in the order of their key columns, so ties go the same way every time
+	vector<Index *> indexes;
+	for (const auto &[columnName, index] : table->indexes)
+		indexes.push_back(index);
+	sort(indexes.begin(), indexes.end(), [](Index *a, Index *b)
+		 { return a->getKeyColumns() < b->getKeyColumns(); });
+	for (Index *index : indexes)
+	{
+		vector<KeyRange> keyRanges;
+		vector<bool> answered;
+		if (!indexKeyRanges(index, resolved, keyRanges, answered))
+			continue;
+
+		// Rows the lookup finds; with every condition answered, exactly the matching ones
+		double indexSelectivity = 1;
+		vector<Condition> indexConditions;
+		for (size_t i = 0; i < resolved.size(); i++)
+			if (answered[i])
+			{
+				indexSelectivity *= selectivities[i];
+				indexConditions.push_back(resolved[i]);
+			}
+		bool answersAll = indexConditions.size() == resolved.size();
+		double indexRows = answersAll ? plan.matchingRows : min<double>(table->rowCount, max(plan.matchingRows, indexSelectivity * table->rowCount));
+		double indexPages = answersAll ? plan.matchingPages : pagesTouched(table->blockCount, indexRows);
+
+		double indexCost = index->estimateLookupPages(table->rowCount, indexRows) * RANDOM_PAGE_COST + indexRows * (CPU_OPERATOR_COST + CPU_TUPLE_COST);
+
+		double missRate = indexPages > BLOCK_COUNT ? 1 - BLOCK_COUNT / indexPages : 0;
+		double probeReads = max(indexPages, indexRows * missRate);
+		double probeCost = indexCost + probeReads * RANDOM_PAGE_COST;
+
+		// The first page is a random read; each later one is read ahead when it
+		// directly follows the previous one, which gets likelier the more of the
+		// other pages are touched
+		double touchedShare = table->blockCount > 1 ? max(0.0, indexPages - 1) / (table->blockCount - 1) : 0;
+		double bitmapPageCost = RANDOM_PAGE_COST - (RANDOM_PAGE_COST - SEQUENTIAL_PAGE_COST) * touchedShare;
+		double bitmapReads = min(1.0, indexPages) * RANDOM_PAGE_COST + max(0.0, indexPages - 1) * bitmapPageCost;
+		// Setting and later finding every pointer's bit, plus walking the bitmap
+		double bitmapCost = 2 * indexRows * CPU_OPERATOR_COST + table->blockCount * CPU_OPERATOR_COST;
+		double bitmapScanCost = indexCost + bitmapCost + bitmapReads;
+
+		if (plan.probeCost >= 0 && min(probeCost, bitmapScanCost) >= min(plan.probeCost, plan.bitmapScanCost))
+			continue;
+		plan.index = index;
+		plan.keyRanges = keyRanges;
+		plan.indexConditions = indexConditions;
+		plan.indexRows = indexRows;
+		plan.probeCost = probeCost;
+		plan.bitmapScanCost = bitmapScanCost;
+	}
+	// A hash index on the column of a lone condition it cannot answer, for EXPLAIN to point out
+	if (plan.index == nullptr && resolved.size() == 1 && resolved[0].columnIndex >= 0 && resolved[0].columnIndex < (int)table->columns.size())
+		plan.index = table->getIndex(table->columns[resolved[0].columnIndex]);
+	if (plan.probeCost < 0)
+		return plan;
+
+	if (plan.probeCost < plan.scanCost && plan.probeCost <= plan.bitmapScanCost)
+		plan.method = INDEX_PROBE;
+	else if (plan.bitmapScanCost < plan.scanCost)
+		plan.method = BITMAP_HEAP_SCAN;
+	return plan;
+}
+
+/**
+ * @brief planAccess for the single condition "column op value".
+ */
+AccessPlan planAccess(Table *table, int columnIndex, BinaryOperator binaryOperator, int value)
+{
+	Condition condition;
+	if (columnIndex >= 0 && columnIndex < (int)table->columns.size())
+		condition.columnName = table->columns[columnIndex];
+	condition.binaryOperator = binaryOperator;
+	condition.value = value;
+	condition.columnIndex = columnIndex;
+	return planAccess(table, vector<Condition>{condition});
+}
+
+/**
+ * @brief Record pointers of the rows in the key ranges of the plan, range by
+ * range in key order, from the plan's index. A range of a single full key is
+ * looked up as such, which is all a hash index can do.
+ *
+ * @param plan made by planAccess, with an index
+ * @return vector<RecordPointer>
+ */
+vector<RecordPointer> indexLookup(const AccessPlan &plan)
+{
+	LOG_DEBUG("indexLookup");
+	vector<RecordPointer> pointers;
+	if (plan.index == nullptr)
+		return pointers;
+	int keyColumnCount = plan.index->getKeyColumns().size();
+	BTree *tree = dynamic_cast<BTree *>(plan.index);
+	for (const KeyRange &range : plan.keyRanges)
+	{
+		vector<RecordPointer> found;
+		if (range.low == range.high && range.prefixLength + 1 == keyColumnCount)
+		{
+			IndexKey key = range.prefix;
+			key[range.prefixLength] = range.low;
+			found = plan.index->searchKey(key);
+		}
+		else if (tree != nullptr)
+			found = tree->searchPrefixRange(range.prefix, range.prefixLength, range.low, range.high);
+		else
+		{
+			LOG_WARNING("indexLookup: Warning - Index " + plan.index->getIndexName() + " cannot answer range predicates");
+			continue;
+		}
+		pointers.insert(pointers.end(), found.begin(), found.end());
+	}
+	return pointers;
+}
+
+/**
+ * @brief The rows the record pointers lead to as a RowBitmap over the table's
+ * pages (an empty one without pointers). Pointers outside the table are
+ * skipped.
+ *
+ * @param table
+ * @param pointers
+ * @return RowBitmap
+ */
+RowBitmap pointerBitmap(Table *table, const vector<RecordPointer> &pointers)
+{
+	uint rowsPerPage = table->maxRowsPerBlock;
+	for (uint rowCount : table->rowsPerBlockCount)
+		rowsPerPage = max(rowsPerPage, rowCount);
+	RowBitmap rows(table->blockCount, rowsPerPage);
+	for (const RecordPointer &pointer : pointers)
+	{
+		bool valid = pointer.first >= 0 && pointer.first < (int)table->blockCount && pointer.first < (int)table->rowsPerBlockCount.size() &&
+					 pointer.second >= 0 && pointer.second < (int)table->rowsPerBlockCount[pointer.first];
+		if (!valid || !rows.set(pointer.first, pointer.second))
+			LOG_WARNING("pointerBitmap: Warning - Skipping invalid pointer {page=" + to_string(pointer.first) + ", row=" + to_string(pointer.second) + "} of " + table->tableName);
+	}
+	return rows;
+}
+
+/**
+ * @brief Bitmap heap scan: calls visit with every row in the bitmap, in
+ * storage order. The marked pages are read with a cursor restricted to them,
+ * so each is read once and runs of neighbouring pages are read ahead, and the
+ * marked rows of a page are picked out of it in one pass.
+ *
+ * @param table
+ * @param rows
+ * @param visit called with the row's pointer and the row
+ * @return long long number of rows visited
+ */
+long long fetchRows(Table *table, const RowBitmap &rows, const function<void(const RecordPointer &, const vector<int> &)> &visit)
+{
+	LOG_DEBUG("fetchRows");
+	long long rowsVisited = 0;
+	vector<int> pages = rows.getPages();
+	if (pages.empty())
+		return rowsVisited;
+	Cursor cursor(table->tableName, pages.front());
+	cursor.setPageFilter([&](int pageIndex)
+						 { return binary_search(pages.begin(), pages.end(), pageIndex); });
+	RowBlock block;
+	vector<int> row;
+	while (cursor.getNextBlock(block))
+	{
+		int firstRow = cursor.pagePointer - block.rowCount;
+		for (int rowIndex = rows.nextRow(cursor.pageIndex, firstRow); rowIndex != -1 && rowIndex - firstRow < block.rowCount; rowIndex = rows.nextRow(cursor.pageIndex, rowIndex + 1))
+		{
+			block.copyRow(rowIndex - firstRow, row);
+			visit({cursor.pageIndex, rowIndex}, row);
+			rowsVisited++;
+		}
+	}
+	return rowsVisited;
+}
+
+/**
+ * @brief Calls visit with every row the record pointers lead to. INDEX_PROBE
+ * fetches the pointers one at a time in the order given, BITMAP_HEAP_SCAN
+ * goes through a RowBitmap and visits the rows in storage order. Pointers
+ * outside the table are skipped.
+ *
+ * @param table
+ * @param pointers
+ * @param method INDEX_PROBE or BITMAP_HEAP_SCAN
+ * @param visit called with the pointer and the row
+ * @return long long number of rows visited
+ */
+long long fetchRows(Table *table, const vector<RecordPointer> &pointers, AccessMethod method, const function<void(const RecordPointer &, const vector<int> &)> &visit)
+{
+	if (method == BITMAP_HEAP_SCAN)
+		return fetchRows(table, pointerBitmap(table, pointers), visit);
+
+	long long rowsVisited = 0;
+	for (const RecordPointer &pointer : pointers)
+	{
+		if (pointer.first < 0 || pointer.first >= (int)table->blockCount || pointer.first >= (int)table->rowsPerBlockCount.size() ||
+			pointer.second < 0 || pointer.second >= (int)table->rowsPerBlockCount[pointer.first])
+		{
+			LOG_WARNING("fetchRows: Warning - Skipping invalid pointer {page=" + to_string(pointer.first) + ", row=" + to_string(pointer.second) + "} of " + table->tableName);
+			continue;
+		}
+		PageHandle page = bufferManager.getPage(table->tableName, pointer.first);
+		RowSpan row = page->getRowRef(pointer.second);
+		if (row.empty())
+			continue;
+		visit(pointer, row.toVector());
+		rowsVisited++;
+	}
+	return rowsVisited;
+}
@@ -0,0 +1,78 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#pragma once
+#include "syntacticParser.h"
+#include "rowBitmap.h"
+
+// Costs are in units of one sequential page read
+const double SEQUENTIAL_PAGE_COST = 1.0; // page read as part of a scan, usually read ahead
+const double RANDOM_PAGE_COST = 4.0;	 // page read on its own
+const double CPU_TUPLE_COST = 0.01;		 // handing one row to the result
+const double CPU_OPERATOR_COST = 0.0025; // one comparison or index entry
+
+/**
+ * @brief The ways a WHERE clause of "column op value" conditions can find its
+ * rows.
+ *
+ * TABLE_SCAN			read every page the zone maps cannot rule out and test
+ *						each row.
+ * INDEX_PROBE			look the conditions up in an index and fetch
+ *						the row behind every record pointer as it comes, in key
+ *						order. Cheap for a handful of rows, but a page can be
+ *						read many times once the rows are spread out.
+ * BITMAP_HEAP_SCAN	look the predicate up in the index, set the row of every
+ *						record pointer in a RowBitmap and read each page it
+ *						marks once, front to back.
+ */
+enum AccessMethod
+{
+	TABLE_SCAN,
+	INDEX_PROBE,
+	BITMAP_HEAP_SCAN
+};
+
+/**
+ * @brief Keys an index lookup reads: those whose first prefixLength columns
+ * are prefix's and whose next column is in [low, high], see
+ * BTree::searchPrefixRange.
+ */
+struct KeyRange
+{
+	IndexKey prefix;
+	int prefixLength = 0;
+	int low = INT_MIN;
+	int high = INT_MAX;
+};
+
+/**
+ * @brief The access method picked for a WHERE clause along with the estimates
+ * it was picked on. Costs of methods that are not available (no index that
+ * answers the conditions) are left negative.
+ */
+struct AccessPlan
+{
+	AccessMethod method = TABLE_SCAN;
+	Index *index = nullptr;
+	vector<KeyRange> keyRanges;		   // what to look up in index
+	vector<Condition> indexConditions; // the conditions the lookup answers; the rows it finds are tested for the rest
+	double indexRows = 0;			   // estimated entries the lookup finds
+	bool fromStatistics = false; // selectivity from ANALYZE rather than zone maps and distinct counts
+	double selectivity = 1;		 // estimated fraction of rows matching
+	double matchingRows = 0;
+	uint candidatePages = 0;  // pages the zone maps cannot rule out
+	double matchingPages = 0; // estimated pages holding matching rows
+	double scanCost = 0;
+	double probeCost = -1;
+	double bitmapScanCost = -1;
+};
+
+string accessMethodName(AccessMethod method);
+AccessPlan planAccess(Table *table, const vector<Condition> &conditions);
+AccessPlan planAccess(Table *table, int columnIndex, BinaryOperator binaryOperator, int value);
+vector<RecordPointer> indexLookup(const AccessPlan &plan);
+RowBitmap pointerBitmap(Table *table, const vector<RecordPointer> &pointers = {});
+long long fetchRows(Table *table, const RowBitmap &rows, const function<void(const RecordPointer &, const vector<int> &)> &visit);
+long long fetchRows(Table *table, const vector<RecordPointer> &pointers, AccessMethod method, const function<void(const RecordPointer &, const vector<int> &)> &visit);
+
+#endif
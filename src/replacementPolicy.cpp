@@ -0,0 +1,184 @@
+#include "replacementPolicy.h"
+
+void FIFOPolicy::recordLoad(int frame, uint64_t pageKey)
+{
+	this->remove(frame);
+	this->position[frame] = this->queue.insert(this->queue.end(), frame);
+}
+
+void FIFOPolicy::remove(int frame)
+{
+	auto it = this->position.find(frame);
+	if (it == this->position.end())
+		return;
+	this->queue.erase(it->second);
+	this->position.erase(it);
+}
+
+int FIFOPolicy::chooseVictim(const function<bool(int)> &evictable)
+{
+	for (int frame : this->queue)
+	{
+		if (evictable(frame))
+		{
+			this->remove(frame);
+			return frame;
+		}
+	}
+	return -1;
+}
+
+void LRUPolicy::recordAccess(int frame)
+{
+	auto it = this->position.find(frame);
+	if (it == this->position.end())
+		return;
+	this->queue.splice(this->queue.end(), this->queue, it->second);
+}
+
+void ClockPolicy::recordLoad(int frame, uint64_t pageKey)
+{
+	if (frame >= this->present.size())
+	{
+		this->present.resize(frame + 1, false);
+		this->referenced.resize(frame + 1, false);
+	}
+	this->present[frame] = true;
+	this->referenced[frame] = true;
+}
+
+void ClockPolicy::recordAccess(int frame)
+{
+	if (frame < this->present.size() && this->present[frame])
+		this->referenced[frame] = true;
+}
+
+void ClockPolicy::remove(int frame)
+{
+	if (frame < this->present.size())
+		this->present[frame] = false;
+}
+
+/**
+ * @brief Sweeps the clock hand at most twice around the frames: the first pass
+ * may only clear reference bits, the second is then guaranteed to find an
+ * unreferenced evictable frame if there is one.
+ */
+int ClockPolicy::chooseVictim(const function<bool(int)> &evictable)
+{
+	int frameCount = this->present.size();
+	if (frameCount == 0)
+		return -1;
+	for (int step = 0; step <= 2 * frameCount; step++)
+	{
+		int frame = this->hand;
+		this->hand = (this->hand + 1) % frameCount;
+		if (!this->present[frame] || !evictable(frame))
+			continue;
+		if (this->referenced[frame])
+		{
+			this->referenced[frame] = false;
+			continue;
+		}
+		this->present[frame] = false;
+		return frame;
+	}
+	return -1;
+}
+
+void TwoQPolicy::recordLoad(int frame, uint64_t pageKey)
+{
+	this->remove(frame);
+	this->frameKeys[frame] = pageKey;
+	auto ghost = this->ghosts.find(pageKey);
+	if (ghost != this->ghosts.end())
+	{
+		// Re-referenced after leaving probation: this page is hot
+		this->a1out.erase(ghost->second);
+		this->ghosts.erase(ghost);
+		this->position[frame] = {true, this->am.insert(this->am.end(), frame)};
+	}
+	else
+		this->position[frame] = {false, this->a1in.insert(this->a1in.end(), frame)};
+}
+
+void TwoQPolicy::recordAccess(int frame)
+{
+	auto it = this->position.find(frame);
+	if (it == this->position.end() || !it->second.first)
+		return; // hits in A1in do not promote, that is what makes 2Q scan resistant
+	this->am.splice(this->am.end(), this->am, it->second.second);
+}
+
+void TwoQPolicy::remove(int frame)
+{
+	auto it = this->position.find(frame);
+	if (it == this->position.end())
+		return;
+	(it->second.first ? this->am : this->a1in).erase(it->second.second);
+	this->position.erase(it);
+	this->frameKeys.erase(frame);
+}
+
+int TwoQPolicy::takeVictim(list<int> &queue, const function<bool(int)> &evictable)
+{
+	for (int frame : queue)
+	{
+		if (!evictable(frame))
+			continue;
+		if (&queue == &this->a1in)
+		{
+			uint64_t pageKey = this->frameKeys[frame];
+			this->ghosts[pageKey] = this->a1out.insert(this->a1out.end(), pageKey);
+			uint maxGhosts = max(1u, this->capacity / 2);
+			while (this->a1out.size() > maxGhosts)
+			{
+				this->ghosts.erase(this->a1out.front());
+				this->a1out.pop_front();
+			}
+		}
+		this->remove(frame);
+		return frame;
+	}
+	return -1;
+}
+
+/**
+ * @brief Takes from A1in while it is over its share (a quarter of the pool),
+ * otherwise from the LRU end of Am, falling back to the other queue if every
+ * frame in the preferred one is pinned.
+ */
+int TwoQPolicy::chooseVictim(const function<bool(int)> &evictable)
+{
+	int frame = -1;
+	if (this->a1in.size() > max(1u, this->capacity / 4))
+		frame = this->takeVictim(this->a1in, evictable);
+	if (frame == -1)
+		frame = this->takeVictim(this->am, evictable);
+	if (frame == -1)
+		frame = this->takeVictim(this->a1in, evictable);
+	return frame;
+}
+
+/**
+ * @brief Builds the policy named policyName (FIFO, LRU, CLOCK or 2Q, case
+ * insensitive) for a pool of capacity frames.
+ *
+ * @param policyName
+ * @param capacity
+ * @return ReplacementPolicy* nullptr if the name is not recognised
+ */
+ReplacementPolicy *createReplacementPolicy(const string &policyName, uint capacity)
+{
+	string name = policyName;
+	transform(name.begin(), name.end(), name.begin(), ::toupper);
+	if (name == "FIFO")
+		return new FIFOPolicy();
+	if (name == "LRU")
+		return new LRUPolicy();
+	if (name == "CLOCK")
+		return new ClockPolicy();
+	if (name == "2Q")
+		return new TwoQPolicy(capacity);
+	return nullptr;
+}
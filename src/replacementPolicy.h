@@ -0,0 +1,106 @@
+#ifndef REPLACEMENTPOLICY_H
+#define REPLACEMENTPOLICY_H
+
+#pragma once
+#include "logger.h"
+
+/**
+ * @brief Decides which buffer pool frame gives up its page when a new page has
+ * to be read in. The buffer manager tells the policy whenever a page is loaded
+ * into a frame, whenever a resident page is accessed again and whenever a frame
+ * is emptied; the policy keeps whatever bookkeeping it needs over frame ids.
+ *
+ * chooseVictim is asked for a frame to reuse and must only return a frame for
+ * which evictable(frame) is true (i.e. one that is not pinned). The chosen
+ * frame is forgotten by the policy. If no frame qualifies it returns -1.
+ */
+class ReplacementPolicy
+{
+public:
+	virtual ~ReplacementPolicy() {}
+	virtual string getName() const = 0;
+	virtual void recordLoad(int frame, uint64_t pageKey) = 0;
+	virtual void recordAccess(int frame) = 0;
+	virtual void remove(int frame) = 0;
+	virtual int chooseVictim(const function<bool(int)> &evictable) = 0;
+};
+
+/**
+ * @brief Evicts frames in the order their pages were read in, ignoring later
+ * accesses. This is what the buffer manager has always done.
+ */
+class FIFOPolicy : public ReplacementPolicy
+{
+protected:
+	list<int> queue;
+	unordered_map<int, list<int>::iterator> position;
+
+public:
+	string getName() const override { return "FIFO"; }
+	void recordLoad(int frame, uint64_t pageKey) override;
+	void recordAccess(int frame) override {}
+	void remove(int frame) override;
+	int chooseVictim(const function<bool(int)> &evictable) override;
+};
+
+/**
+ * @brief Evicts the least recently used frame. Shares FIFO's queue but moves a
+ * frame to the back on every access.
+ */
+class LRUPolicy : public FIFOPolicy
+{
+public:
+	string getName() const override { return "LRU"; }
+	void recordAccess(int frame) override;
+};
+
+/**
+ * @brief Second chance approximation of LRU: every frame has a reference bit
+ * that is set on access, and a clock hand sweeps the frames clearing bits until
+ * it finds one that is unset.
+ */
+class ClockPolicy : public ReplacementPolicy
+{
+	vector<bool> present;
+	vector<bool> referenced;
+	int hand = 0;
+
+public:
+	string getName() const override { return "CLOCK"; }
+	void recordLoad(int frame, uint64_t pageKey) override;
+	void recordAccess(int frame) override;
+	void remove(int frame) override;
+	int chooseVictim(const function<bool(int)> &evictable) override;
+};
+
+/**
+ * @brief Simplified 2Q (Johnson & Shasha). Pages seen once live in a FIFO
+ * probation queue (A1in); only pages that are re-referenced after falling out
+ * of it (tracked by key in the ghost queue A1out) are admitted to the main LRU
+ * queue (Am). A single sequential scan therefore only churns A1in and does not
+ * flush the hot pages out of Am.
+ */
+class TwoQPolicy : public ReplacementPolicy
+{
+	uint capacity;
+	list<int> a1in;
+	list<int> am;
+	unordered_map<int, pair<bool, list<int>::iterator>> position; // frame -> (in Am?, position)
+	unordered_map<int, uint64_t> frameKeys;
+	list<uint64_t> a1out;
+	unordered_map<uint64_t, list<uint64_t>::iterator> ghosts;
+
+	int takeVictim(list<int> &queue, const function<bool(int)> &evictable);
+
+public:
+	TwoQPolicy(uint capacity) : capacity(capacity) {}
+	string getName() const override { return "2Q"; }
+	void recordLoad(int frame, uint64_t pageKey) override;
+	void recordAccess(int frame) override;
+	void remove(int frame) override;
+	int chooseVictim(const function<bool(int)> &evictable) override;
+};
+
+ReplacementPolicy *createReplacementPolicy(const string &policyName, uint capacity);
+
+#endif
@@ -0,0 +1,71 @@
+#include "global.h"
+
+RowBitmap::RowBitmap(uint pageCount, uint rowsPerPage)
+{
+	this->pageCount = pageCount;
+	this->wordsPerPage = max(1u, (rowsPerPage + 63) / 64);
+	this->words.assign((size_t)pageCount * this->wordsPerPage, 0);
+}
+
+/**
+ * @brief Adds row rowIndex of page pageIndex to the set.
+ *
+ * @param pageIndex
+ * @param rowIndex
+ * @return false if the row lies outside the pages and rows the bitmap was
+ * made for
+ */
+bool RowBitmap::set(int pageIndex, int rowIndex)
+{
+	if (pageIndex < 0 || pageIndex >= (int)this->pageCount || rowIndex < 0 || rowIndex >= (int)this->wordsPerPage * 64)
+		return false;
+	uint64_t &word = this->words[(size_t)pageIndex * this->wordsPerPage + rowIndex / 64];
+	uint64_t bit = 1ULL << (rowIndex % 64);
+	if (!(word & bit))
+		this->rowCount++;
+	word |= bit;
+	return true;
+}
+
+bool RowBitmap::test(int pageIndex, int rowIndex) const
+{
+	if (pageIndex < 0 || pageIndex >= (int)this->pageCount || rowIndex < 0 || rowIndex >= (int)this->wordsPerPage * 64)
+		return false;
+	return this->words[(size_t)pageIndex * this->wordsPerPage + rowIndex / 64] >> (rowIndex % 64) & 1;
+}
+
+/**
+ * @brief First row of page pageIndex from rowIndex on that is in the set,
+ * skipping 64 rows at a time over empty words.
+ *
+ * @param pageIndex
+ * @param rowIndex
+ * @return int -1 if there is none
+ */
+int RowBitmap::nextRow(int pageIndex, int rowIndex) const
+{
+	if (pageIndex < 0 || pageIndex >= (int)this->pageCount || rowIndex < 0)
+		return -1;
+	const uint64_t *pageWords = this->words.data() + (size_t)pageIndex * this->wordsPerPage;
+	for (uint wordIndex = rowIndex / 64; wordIndex < this->wordsPerPage; wordIndex++)
+	{
+		uint64_t word = pageWords[wordIndex];
+		if (wordIndex == (uint)rowIndex / 64)
+			word &= ~0ULL << (rowIndex % 64);
+		if (word)
+			return wordIndex * 64 + __builtin_ctzll(word);
+	}
+	return -1;
+}
+
+/**
+ * @brief Pages holding at least one row of the set, in ascending order.
+ */
+vector<int> RowBitmap::getPages() const
+{
+	vector<int> pages;
+	for (uint pageIndex = 0; pageIndex < this->pageCount; pageIndex++)
+		if (this->nextRow(pageIndex, 0) != -1)
+			pages.push_back(pageIndex);
+	return pages;
+}
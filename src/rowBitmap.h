@@ -0,0 +1,31 @@
+#ifndef ROWBITMAP_H
+#define ROWBITMAP_H
+
+#pragma once
+#include "index.h"
+
+/**
+ * @brief A set of rows of a table kept as one bit per row of every page, for
+ * reading the rows an index lookup returned the way a bitmap heap scan does:
+ * every page holding one of them is read once, in page order, and its rows
+ * are taken out in a single pass, however the record pointers were ordered
+ * and however many of them point into the same page. Setting the same row
+ * twice keeps one copy.
+ */
+class RowBitmap
+{
+	uint pageCount = 0;
+	uint wordsPerPage = 0;
+	vector<uint64_t> words; // wordsPerPage words per page, bit r of a page is row r
+	long long rowCount = 0;
+
+public:
+	RowBitmap(uint pageCount, uint rowsPerPage);
+	bool set(int pageIndex, int rowIndex);
+	bool test(int pageIndex, int rowIndex) const;
+	int nextRow(int pageIndex, int rowIndex) const;
+	vector<int> getPages() const;
+	long long getRowCount() const { return this->rowCount; }
+};
+
+#endif
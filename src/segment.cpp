@@ -0,0 +1,454 @@
+#include "global.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/**
+ * @brief Rounds up to the next multiple of 64 bytes.
+ */
+static uint32_t roundSlotSize(size_t bytes)
+{
+	return (bytes + 63) / 64 * 64;
+}
+
+/**
+ * @brief Opens the segment file if it already exists and rebuilds the page
+ * directory from the slot headers. A segment that does not exist yet is only
+ * created on the first write.
+ *
+ * @param fileName
+ */
+Segment::Segment(const string &fileName)
+{
+	LOG_DEBUG("Segment::Segment");
+	this->fileName = fileName;
+	this->fd = open(fileName.c_str(), O_RDWR);
+	if (this->fd >= 0 && !this->rebuildDirectory())
+	{
+		LOG_ERROR("Segment::Segment - ERROR: " + fileName + " is not a valid segment, ignoring it");
+		close(this->fd);
+		this->fd = -1;
+	}
+}
+
+Segment::~Segment()
+{
+	this->unmap();
+	if (this->fd >= 0)
+		close(this->fd);
+}
+
+/**
+ * @brief Creates (or truncates) the segment file with the given slot size.
+ *
+ * @param slotSize
+ * @return true on success
+ */
+bool Segment::create(uint32_t slotSize)
+{
+	this->unmap();
+	if (this->fd >= 0)
+		close(this->fd);
+	this->fd = open(this->fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (this->fd < 0)
+	{
+		LOG_ERROR("Segment::create - ERROR: Could not create " + this->fileName);
+		return false;
+	}
+	this->slotSize = slotSize;
+	this->slotCount = 0;
+	this->directory.clear();
+	this->freeSlots.clear();
+	SegmentHeader header = {SEGMENT_MAGIC, SEGMENT_VERSION, slotSize};
+	return pwrite(this->fd, &header, sizeof(header), 0) == sizeof(header);
+}
+
+/**
+ * @brief Reads the segment header and every slot header to work out which
+ * slot holds which page and which slots are free.
+ *
+ * @return false if the file does not look like a segment
+ */
+bool Segment::rebuildDirectory()
+{
+	SegmentHeader header;
+	if (pread(this->fd, &header, sizeof(header), 0) != sizeof(header) ||
+		header.magic != SEGMENT_MAGIC || header.version != SEGMENT_VERSION || header.slotSize <= sizeof(SlotHeader))
+		return false;
+	this->slotSize = header.slotSize;
+
+	struct stat fileStat;
+	fstat(this->fd, &fileStat);
+	this->slotCount = fileStat.st_size <= SEGMENT_HEADER_SIZE ? 0 : (fileStat.st_size - SEGMENT_HEADER_SIZE + this->slotSize - 1) / this->slotSize;
+	for (int slot = 0; slot < this->slotCount; slot++)
+	{
+		SlotHeader slotHeader;
+		if (pread(this->fd, &slotHeader, sizeof(slotHeader), this->slotOffset(slot)) != sizeof(slotHeader) || slotHeader.pageIndex < 0)
+			this->freeSlots.push_back(slot);
+		else
+			this->directory[slotHeader.pageIndex] = slot;
+	}
+	return true;
+}
+
+/**
+ * @brief Rewrites the segment with slots of at least minimumSlotSize bytes.
+ * Only happens when a page turns out bigger than a full uncompressed page,
+ * which the slots are always sized for. Slots are copied one at a time into a
+ * new file that then replaces the old one, so only one slot is ever held in
+ * memory. Every slot keeps its number, so the directory and the free slots
+ * stay as they are.
+ *
+ * @param minimumSlotSize
+ * @return true on success
+ */
+bool Segment::growSlots(uint32_t minimumSlotSize)
+{
+	uint32_t newSlotSize = max(2 * this->slotSize, roundSlotSize(minimumSlotSize));
+	LOG_DEBUG("Segment::growSlots - " + this->fileName + " slots " + to_string(this->slotSize) + " -> " + to_string(newSlotSize));
+
+	string grownFileName = this->fileName + ".grow";
+	int grownFd = open(grownFileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (grownFd < 0)
+	{
+		LOG_ERROR("Segment::growSlots - ERROR: Could not create " + grownFileName);
+		return false;
+	}
+	SegmentHeader header = {SEGMENT_MAGIC, SEGMENT_VERSION, newSlotSize};
+	bool written = pwrite(grownFd, &header, sizeof(header), 0) == sizeof(header);
+	vector<char> buffer(this->slotSize);
+	for (int slot = 0; written && slot < this->slotCount; slot++)
+	{
+		ssize_t bytesRead = pread(this->fd, buffer.data(), this->slotSize, this->slotOffset(slot));
+		SlotHeader slotHeader = {-1, 0};
+		if (bytesRead >= (ssize_t)sizeof(SlotHeader))
+			memcpy(&slotHeader, buffer.data(), sizeof(SlotHeader));
+		size_t usedBytes = sizeof(SlotHeader);
+		if (slotHeader.pageIndex >= 0)
+			usedBytes = min((size_t)bytesRead, sizeof(SlotHeader) + slotHeader.length);
+		else
+			memcpy(buffer.data(), &slotHeader, sizeof(SlotHeader));
+		written = pwrite(grownFd, buffer.data(), usedBytes, SEGMENT_HEADER_SIZE + (off_t)slot * newSlotSize) == (ssize_t)usedBytes;
+	}
+	if (!written || rename(grownFileName.c_str(), this->fileName.c_str()) != 0)
+	{
+		LOG_ERROR("Segment::growSlots - ERROR: Could not rewrite " + this->fileName);
+		close(grownFd);
+		remove(grownFileName.c_str());
+		return false;
+	}
+	this->unmap();
+	close(this->fd);
+	this->fd = grownFd;
+	this->slotSize = newSlotSize;
+	return true;
+}
+
+/**
+ * @brief Reads the payload of page pageIndex into buffer with a single pread.
+ *
+ * @param pageIndex
+ * @param buffer
+ * @return false if the segment has no such page
+ */
+bool Segment::readPage(int pageIndex, vector<char> &buffer)
+{
+	auto it = this->directory.find(pageIndex);
+	if (this->fd < 0 || it == this->directory.end())
+		return false;
+	buffer.resize(this->slotSize);
+	ssize_t bytesRead = pread(this->fd, buffer.data(), this->slotSize, this->slotOffset(it->second));
+	SlotHeader slotHeader;
+	if (bytesRead < (ssize_t)sizeof(SlotHeader))
+		return false;
+	memcpy(&slotHeader, buffer.data(), sizeof(SlotHeader));
+	if (slotHeader.pageIndex != pageIndex || sizeof(SlotHeader) + slotHeader.length > (size_t)bytesRead)
+	{
+		LOG_ERROR("Segment::readPage - ERROR: Corrupt slot for page " + to_string(pageIndex) + " in " + this->fileName);
+		return false;
+	}
+	buffer.erase(buffer.begin(), buffer.begin() + sizeof(SlotHeader));
+	buffer.resize(slotHeader.length);
+	return true;
+}
+
+/**
+ * @brief Writes page pageIndex with a single pwritev, reusing its slot if the
+ * page already exists, otherwise a free slot, otherwise a new slot at the end.
+ *
+ * @param pageIndex
+ * @param data
+ * @param length
+ * @return true on success
+ */
+bool Segment::writePage(int pageIndex, const char *data, size_t length)
+{
+	size_t needed = sizeof(SlotHeader) + length;
+	// Slots always fit an uncompressed full page, so a later page that does not
+	// compress as well as the first one never makes the segment grow
+	uint32_t fullPageSlotSize = roundSlotSize(BLOCK_SIZE * 1000 + 64);
+	if (this->fd < 0 && !this->create(max(roundSlotSize(needed), fullPageSlotSize)))
+		return false;
+	if (needed > this->slotSize && !this->growSlots(needed))
+		return false;
+
+	int slot;
+	auto it = this->directory.find(pageIndex);
+	if (it != this->directory.end())
+		slot = it->second;
+	else if (!this->freeSlots.empty())
+	{
+		slot = this->freeSlots.back();
+		this->freeSlots.pop_back();
+	}
+	else
+		slot = this->slotCount++;
+	this->directory[pageIndex] = slot;
+
+	SlotHeader slotHeader = {pageIndex, (uint32_t)length};
+	struct iovec parts[2] = {{&slotHeader, sizeof(slotHeader)}, {(void *)data, length}};
+	if (pwritev(this->fd, parts, 2, this->slotOffset(slot)) != (ssize_t)needed)
+	{
+		LOG_ERROR("Segment::writePage - ERROR: Short write of page " + to_string(pageIndex) + " to " + this->fileName);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Points data at the payload of page pageIndex inside a read-only
+ * mapping of the segment file, so the page can be scanned without a read or a
+ * copy. The mapping covers the whole file and is redone when a page lies past
+ * its end (the file grew since it was mapped). Since it is MAP_SHARED, later
+ * pwrites to the file show through; the pointer stays valid until the segment
+ * is rewritten or removed.
+ *
+ * @param pageIndex
+ * @param data receives a pointer to the payload
+ * @param length receives the payload size in bytes
+ * @return false if the segment has no such page or cannot be mapped
+ */
+bool Segment::mapPage(int pageIndex, const char *&data, size_t &length)
+{
+	auto it = this->directory.find(pageIndex);
+	if (this->fd < 0 || it == this->directory.end())
+		return false;
+	size_t offset = this->slotOffset(it->second);
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		if (offset + sizeof(SlotHeader) <= this->mappedLength)
+		{
+			SlotHeader slotHeader;
+			memcpy(&slotHeader, this->mapping + offset, sizeof(SlotHeader));
+			if (slotHeader.pageIndex == pageIndex && offset + sizeof(SlotHeader) + slotHeader.length <= this->mappedLength)
+			{
+				data = this->mapping + offset + sizeof(SlotHeader);
+				length = slotHeader.length;
+				return true;
+			}
+		}
+		if (attempt == 0 && !this->remap())
+			return false;
+	}
+	LOG_ERROR("Segment::mapPage - ERROR: Corrupt slot for page " + to_string(pageIndex) + " in " + this->fileName);
+	return false;
+}
+
+/**
+ * @brief Replaces the current mapping with one covering the file as it is now.
+ *
+ * @return true on success
+ */
+bool Segment::remap()
+{
+	this->unmap();
+	struct stat fileStat;
+	if (fstat(this->fd, &fileStat) != 0 || fileStat.st_size == 0)
+		return false;
+	void *address = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, this->fd, 0);
+	if (address == MAP_FAILED)
+	{
+		LOG_ERROR("Segment::remap - ERROR: Could not map " + this->fileName);
+		return false;
+	}
+	this->mapping = (char *)address;
+	this->mappedLength = fileStat.st_size;
+	return true;
+}
+
+void Segment::unmap()
+{
+	if (this->mapping)
+		munmap(this->mapping, this->mappedLength);
+	this->mapping = nullptr;
+	this->mappedLength = 0;
+}
+
+/**
+ * @brief Deallocates the slot holding pageIndex so a later write can reuse it.
+ *
+ * @param pageIndex
+ * @return false if there was no such page
+ */
+bool Segment::freePage(int pageIndex)
+{
+	auto it = this->directory.find(pageIndex);
+	if (it == this->directory.end())
+		return false;
+	SlotHeader slotHeader = {-1, 0};
+	pwrite(this->fd, &slotHeader, sizeof(slotHeader), this->slotOffset(it->second));
+	this->freeSlots.push_back(it->second);
+	this->directory.erase(it);
+	return true;
+}
+
+/**
+ * @brief Closes and deletes the segment file.
+ *
+ */
+void Segment::removeFile()
+{
+	this->unmap();
+	if (this->fd >= 0)
+		close(this->fd);
+	this->fd = -1;
+	this->directory.clear();
+	this->freeSlots.clear();
+	this->slotCount = 0;
+	remove(this->fileName.c_str());
+}
+
+string StorageManager::segmentFileName(const string &name)
+{
+	return "../data/temp/" + name + ".seg";
+}
+
+string StorageManager::pageFileName(const string &name, int pageIndex)
+{
+	return "../data/temp/" + name + "_Page" + to_string(pageIndex);
+}
+
+/**
+ * @brief Returns the open segment for name, opening an existing segment file
+ * if needed. With create set a segment object is made even if there is no
+ * file yet (the file appears on the first write).
+ *
+ * @param name
+ * @param create
+ * @return Segment* nullptr if there is no such segment and create is false
+ */
+Segment *StorageManager::getSegment(const string &name, bool create)
+{
+	auto it = this->segments.find(name);
+	if (it != this->segments.end())
+		return it->second.get();
+	unique_ptr<Segment> segment(new Segment(segmentFileName(name)));
+	if (!create && !segment->isOpen())
+		return nullptr;
+	Segment *result = segment.get();
+	this->segments[name] = move(segment);
+	return result;
+}
+
+/**
+ * @brief Reads the raw bytes of page pageIndex of relation name.
+ *
+ * @param name
+ * @param pageIndex
+ * @param buffer receives the page image
+ * @return false if the page does not exist
+ */
+bool StorageManager::readPage(const string &name, int pageIndex, vector<char> &buffer)
+{
+	lock_guard<mutex> lock(this->storageMutex);
+	buffer.clear();
+	if (TEXT_PAGES)
+	{
+		int fd = open(pageFileName(name, pageIndex).c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat fileStat;
+		if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+		{
+			buffer.resize(fileStat.st_size);
+			ssize_t bytesRead = read(fd, buffer.data(), buffer.size());
+			buffer.resize(bytesRead > 0 ? bytesRead : 0);
+		}
+		close(fd);
+		return true;
+	}
+	Segment *segment = this->getSegment(name, false);
+	return segment && segment->readPage(pageIndex, buffer);
+}
+
+/**
+ * @brief Writes the raw bytes of page pageIndex of relation name.
+ *
+ * @param name
+ * @param pageIndex
+ * @param data
+ * @param length
+ * @return true on success
+ */
+bool StorageManager::writePage(const string &name, int pageIndex, const char *data, size_t length)
+{
+	lock_guard<mutex> lock(this->storageMutex);
+	if (TEXT_PAGES)
+	{
+		int fd = open(pageFileName(name, pageIndex).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+			return false;
+		bool written = write(fd, data, length) == (ssize_t)length;
+		close(fd);
+		return written;
+	}
+	return this->getSegment(name, true)->writePage(pageIndex, data, length);
+}
+
+/**
+ * @brief Gives a pointer to the raw bytes of page pageIndex of relation name
+ * inside a memory mapping of its segment (see Segment::mapPage). Not available
+ * with TEXT_PAGES.
+ *
+ * @param name
+ * @param pageIndex
+ * @param data
+ * @param length
+ * @return false if the page cannot be mapped
+ */
+bool StorageManager::mapPage(const string &name, int pageIndex, const char *&data, size_t &length)
+{
+	lock_guard<mutex> lock(this->storageMutex);
+	if (TEXT_PAGES)
+		return false;
+	Segment *segment = this->getSegment(name, false);
+	return segment && segment->mapPage(pageIndex, data, length);
+}
+
+/**
+ * @brief Deallocates page pageIndex of relation name. Once a segment holds no
+ * pages its file is removed.
+ *
+ * @param name
+ * @param pageIndex
+ */
+void StorageManager::freePage(const string &name, int pageIndex)
+{
+	lock_guard<mutex> lock(this->storageMutex);
+	if (TEXT_PAGES)
+	{
+		remove(pageFileName(name, pageIndex).c_str());
+		return;
+	}
+	Segment *segment = this->getSegment(name, false);
+	if (!segment)
+		return;
+	segment->freePage(pageIndex);
+	if (segment->getPageCount() == 0)
+	{
+		segment->removeFile();
+		this->segments.erase(name);
+	}
+}
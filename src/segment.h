@@ -0,0 +1,94 @@
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#pragma once
+#include "logger.h"
+
+/**
+ * @brief On-disk header at the start of every segment file.
+ */
+struct SegmentHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slotSize; // bytes per slot, including the SlotHeader
+};
+
+/**
+ * @brief Precedes the payload in every slot. pageIndex is -1 for a free slot,
+ * which is what lets the page directory be rebuilt by scanning the file.
+ */
+struct SlotHeader
+{
+	int32_t pageIndex;
+	uint32_t length; // payload bytes actually used
+};
+
+const uint32_t SEGMENT_MAGIC = 0x47455352; // "RSEG" on little-endian machines
+const uint32_t SEGMENT_VERSION = 1;
+const int SEGMENT_HEADER_SIZE = 64; // slots start here
+
+/**
+ * @brief All pages of one relation (table, matrix or index) stored in a single
+ * file "../data/temp/<name>.seg" as fixed size slots, so page i is read or
+ * written with one pread/pwrite at a known offset instead of opening its own
+ * file. A page does not have to live in slot i: the directory maps page
+ * indices to slots, and slots given up by freePage are reused by later
+ * writes. If a page ever outgrows the slot size the segment is rewritten with
+ * larger slots.
+ */
+class Segment
+{
+	string fileName;
+	int fd = -1;
+	uint32_t slotSize = 0;
+	int slotCount = 0;
+	unordered_map<int, int> directory; // page index -> slot
+	vector<int> freeSlots;
+	char *mapping = nullptr; // read-only MAP_SHARED view of the whole file, see mapPage
+	size_t mappedLength = 0;
+
+	off_t slotOffset(int slot) const { return SEGMENT_HEADER_SIZE + (off_t)slot * this->slotSize; }
+	bool create(uint32_t slotSize);
+	bool rebuildDirectory();
+	bool growSlots(uint32_t minimumSlotSize);
+	bool remap();
+	void unmap();
+
+public:
+	Segment(const string &fileName);
+	~Segment();
+	bool isOpen() const { return this->fd >= 0; }
+	bool readPage(int pageIndex, vector<char> &buffer);
+	bool writePage(int pageIndex, const char *data, size_t length);
+	bool mapPage(int pageIndex, const char *&data, size_t &length);
+	bool freePage(int pageIndex);
+	int getPageCount() const { return this->directory.size(); }
+	void removeFile();
+};
+
+/**
+ * @brief Owns the open segments and maps relation names to them. Page and the
+ * B+ tree go through here for all page I/O. With TEXT_PAGES set every page is
+ * instead kept in its own "<name>_Page<i>" file, as it used to be.
+ *
+ * The read-ahead thread reads pages through here as well, so every call is
+ * serialised on a mutex; pages are read and written whole, so a reader never
+ * sees a half written page.
+ */
+class StorageManager
+{
+	unordered_map<string, unique_ptr<Segment>> segments;
+	mutex storageMutex;
+	Segment *getSegment(const string &name, bool create);
+
+public:
+	static string segmentFileName(const string &name);
+	static string pageFileName(const string &name, int pageIndex);
+	bool readPage(const string &name, int pageIndex, vector<char> &buffer);
+	bool writePage(const string &name, int pageIndex, const char *data, size_t length);
+	bool mapPage(const string &name, int pageIndex, const char *&data, size_t &length);
+	void freePage(const string &name, int pageIndex);
+};
+
+#endif
@@ -3,7 +3,7 @@
 
 bool semanticParse()
 {
-	logger.log("semanticParse");
+	LOG_DEBUG("semanticParse");
 	switch (parsedQuery.queryType)
 	{
 	case CLEAR:
@@ -58,6 +58,12 @@ bool semanticParse()
 		return semanticParseDELETE();
 	case SEARCH:
 		return semanticParseSEARCH();
+	case FLUSH:
+		return semanticParseFLUSH();
+	case ANALYZE:
+		return semanticParseANALYZE();
+	case EXPLAIN:
+		return semanticParseEXPLAIN();
 	case QUIT:
 	  return semanticParseQUIT();
 	default:
@@ -32,6 +32,9 @@ bool semanticParseINSERT();
 bool semanticParseUPDATE();
 bool semanticParseDELETE();
 bool semanticParseSEARCH();
+bool semanticParseFLUSH();
+bool semanticParseANALYZE();
+bool semanticParseEXPLAIN();
 bool semanticParseQUIT();
 
 #endif
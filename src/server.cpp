@@ -6,22 +6,67 @@ using namespace std;
 float BLOCK_SIZE = 1;
 uint BLOCK_COUNT = 2;
 uint PRINT_COUNT = 20;
+bool TEXT_PAGES = false; // write temp pages as text instead of binary (debugging aid)
+bool COMPRESS_PAGES = false; // compress binary pages column by column, see compression.h
+bool EXACT_DISTINCT = false; // count distinct values with hash sets instead of HyperLogLog sketches
+int HLL_PRECISION = 12;		 // HyperLogLog sketches have 2^HLL_PRECISION registers
+uint READ_AHEAD = 4;	 // pages a sequential cursor has read ahead of it, 0 turns read-ahead off
+uint INDEX_FILL_FACTOR = 90; // percent of a B+ tree node or hash bucket filled when an index is bulk loaded
 Logger logger;
 vector<string> tokenizedQuery;
 ParsedQuery parsedQuery;
+StorageManager storageManager;
+BufferManager bufferManager; // defined before the catalogue so it outlives the tables unloading through it
 TableCatalogue tableCatalogue;
-BufferManager bufferManager;
 
 void doCommand()
 {
-	logger.log("doCommand");
+	LOG_DEBUG("doCommand");
 	if (syntacticParse() && semanticParse())
 		executeCommand();
 	return;
 }
 
-int main(void)
+int main(int argc, char *argv[])
 {
+	string policyName = "FIFO";
+	LogLevel logLevel;
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--text-pages")
+			TEXT_PAGES = true;
+		else if (arg == "--compress-pages")
+			COMPRESS_PAGES = true;
+		else if (arg == "--block-count" && i + 1 < argc && atoi(argv[i + 1]) > 0)
+			BLOCK_COUNT = atoi(argv[++i]);
+		else if (arg == "--exact-distinct")
+			EXACT_DISTINCT = true;
+		else if (arg == "--hll-precision" && i + 1 < argc && atoi(argv[i + 1]) >= HyperLogLog::MIN_PRECISION && atoi(argv[i + 1]) <= HyperLogLog::MAX_PRECISION)
+			HLL_PRECISION = atoi(argv[++i]);
+		else if (arg == "--read-ahead" && i + 1 < argc && atoi(argv[i + 1]) >= 0)
+			READ_AHEAD = atoi(argv[++i]);
+		else if (arg == "--index-fill-factor" && i + 1 < argc && atoi(argv[i + 1]) >= 10 && atoi(argv[i + 1]) <= 100)
+			INDEX_FILL_FACTOR = atoi(argv[++i]);
+		else if (arg == "--policy" && i + 1 < argc)
+			policyName = argv[++i];
+		else if (arg == "--log-level" && i + 1 < argc && parseLogLevel(argv[i + 1], logLevel))
+		{
+			logger.setLevel(logLevel);
+			i++;
+		}
+		else
+		{
+			cout << "Usage: ./server [--text-pages] [--compress-pages] [--exact-distinct] [--hll-precision 4-16] [--block-count N] [--read-ahead N] [--index-fill-factor 10-100] [--policy FIFO|LRU|CLOCK|2Q] [--log-level DEBUG|INFO|WARNING|ERROR|OFF]" << endl;
+			return 1;
+		}
+	}
+	// Policies such as 2Q size their queues from BLOCK_COUNT, so set it up once all flags are read
+	if (!bufferManager.setReplacementPolicy(policyName))
+	{
+		cout << "Unknown replacement policy: " << policyName << endl;
+		return 1;
+	}
 
 	regex delim("[^\\s,]+");
 	string command;
@@ -33,9 +78,8 @@ int main(void)
 		cout << "\n> ";
 		tokenizedQuery.clear();
 		parsedQuery.clear();
-		logger.log("\nReading New Command: ");
 		getline(cin, command);
-		logger.log(command);
+		LOG_INFO("\nReading New Command: " + command);
 
 		auto words_begin = std::sregex_iterator(command.begin(), command.end(), delim);
 		auto words_end = std::sregex_iterator();
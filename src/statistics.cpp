@@ -0,0 +1,121 @@
+#include "global.h"
+
+/**
+ * @brief Builds the statistics of a column from a sample of its values.
+ *
+ * @param sample values of the column in the sampled rows
+ * @param distinctCount estimated distinct values in the whole column
+ * @return ColumnStatistics
+ */
+ColumnStatistics ColumnStatistics::build(vector<int> sample, uint distinctCount)
+{
+	ColumnStatistics statistics;
+	statistics.distinctCount = distinctCount;
+	if (sample.empty())
+		return statistics;
+	sort(sample.begin(), sample.end());
+
+	// Count every value of the sample; values seen well above the average
+	// count (or all of them if there are only a few) become common values
+	vector<pair<int, int>> counts;
+	for (int value : sample)
+	{
+		if (counts.empty() || counts.back().first != value)
+			counts.emplace_back(value, 0);
+		counts.back().second++;
+	}
+	double averageCount = (double)sample.size() / counts.size();
+	vector<pair<int, int>> candidates = counts;
+	stable_sort(candidates.begin(), candidates.end(), [](const pair<int, int> &a, const pair<int, int> &b)
+				{ return a.second > b.second; });
+	unordered_set<int> mostCommon;
+	for (auto &[value, count] : candidates)
+	{
+		if (statistics.mostCommonValues.size() == MOST_COMMON_VALUE_COUNT)
+			break;
+		if (counts.size() > MOST_COMMON_VALUE_COUNT && (count < 2 || count < 1.25 * averageCount))
+			break;
+		statistics.mostCommonValues.emplace_back(value, (double)count / sample.size());
+		mostCommon.insert(value);
+	}
+
+	vector<int> rest;
+	for (int value : sample)
+		if (!mostCommon.count(value))
+			rest.push_back(value);
+	if (rest.empty())
+		return statistics;
+	int bucketCount = min<int>(HISTOGRAM_BUCKET_COUNT, rest.size());
+	for (int boundCounter = 0; boundCounter <= bucketCount; boundCounter++)
+		statistics.histogramBounds.push_back(rest[(size_t)boundCounter * (rest.size() - 1) / bucketCount]);
+	return statistics;
+}
+
+/**
+ * @brief Fraction of rows holding one of the most common values.
+ */
+double ColumnStatistics::mostCommonFraction() const
+{
+	double fraction = 0;
+	for (auto &[value, valueFraction] : this->mostCommonValues)
+		fraction += valueFraction;
+	return fraction;
+}
+
+/**
+ * @brief Estimated fraction of rows where the column equals value: its own
+ * fraction for a common value, otherwise an even share of the rows left over
+ * by the common values.
+ *
+ * @param value
+ * @return double
+ */
+double ColumnStatistics::equalFraction(int value) const
+{
+	for (auto &[commonValue, fraction] : this->mostCommonValues)
+		if (commonValue == value)
+			return fraction;
+	if (this->histogramBounds.empty())
+		return 0;
+	double otherDistinct = max<double>(1, (double)this->distinctCount - this->mostCommonValues.size());
+	return (1 - this->mostCommonFraction()) / otherDistinct;
+}
+
+/**
+ * @brief Estimated fraction of rows where the column lies in [low, high]. Within
+ * a histogram bucket values are assumed to be spread evenly.
+ *
+ * @param low
+ * @param high
+ * @return double
+ */
+double ColumnStatistics::rangeFraction(int64_t low, int64_t high) const
+{
+	if (low > high)
+		return 0;
+	double fraction = 0;
+	for (auto &[value, valueFraction] : this->mostCommonValues)
+		if (low <= value && value <= high)
+			fraction += valueFraction;
+	if (this->histogramBounds.size() < 2)
+		return fraction;
+
+	int bucketCount = this->histogramBounds.size() - 1;
+	double bucketsCovered = 0;
+	for (int bucket = 0; bucket < bucketCount; bucket++)
+	{
+		// Buckets are half-open except the last, so a bound shared by two
+		// buckets is counted once; a bucket whose bounds are equal holds only
+		// that value
+		int64_t bucketLow = this->histogramBounds[bucket];
+		int64_t bucketHigh = this->histogramBounds[bucket + 1];
+		if (bucket < bucketCount - 1 && bucketHigh > bucketLow)
+			bucketHigh--;
+		int64_t overlapLow = max(low, bucketLow);
+		int64_t overlapHigh = min(high, bucketHigh);
+		if (overlapLow > overlapHigh)
+			continue;
+		bucketsCovered += (double)(overlapHigh - overlapLow + 1) / (bucketHigh - bucketLow + 1);
+	}
+	return fraction + (1 - this->mostCommonFraction()) * bucketsCovered / bucketCount;
+}
@@ -0,0 +1,35 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#pragma once
+#include "logger.h"
+
+const int HISTOGRAM_BUCKET_COUNT = 32;	// buckets per equi-depth histogram
+const int MOST_COMMON_VALUE_COUNT = 10; // most common values kept per column
+const int ANALYZE_SAMPLE_PAGES = 100;	// pages ANALYZE reads at most per table
+
+/**
+ * @brief Distribution of the values of one column, built by ANALYZE from a
+ * sample of the table's pages and used to estimate how many rows a predicate
+ * selects.
+ *
+ * The most common values are kept with the fraction of rows holding each.
+ * The remaining values are described by an equi-depth histogram: bucket i
+ * covers [histogramBounds[i], histogramBounds[i + 1]) and holds the same
+ * share of those rows as every other bucket, so ranges of frequent values get
+ * narrow buckets and sparse ranges wide ones. Only the last bucket includes its
+ * upper bound, so a bound shared by two buckets is counted once.
+ */
+struct ColumnStatistics
+{
+	uint distinctCount = 0;
+	vector<pair<int, double>> mostCommonValues; // value, fraction of rows
+	vector<int> histogramBounds;				// bucket count + 1 bounds, empty if every value is a common one
+
+	static ColumnStatistics build(vector<int> sample, uint distinctCount);
+	double mostCommonFraction() const;
+	double equalFraction(int value) const;
+	double rangeFraction(int64_t low, int64_t high) const;
+};
+
+#endif
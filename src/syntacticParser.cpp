@@ -2,11 +2,13 @@
 
 bool syntacticParse()
 {
-	logger.log("syntacticParse");
+	LOG_DEBUG("syntacticParse");
 	string possibleQueryType = tokenizedQuery[0];
 	
 	if (tokenizedQuery.size() == 1 && tokenizedQuery[0] == "QUIT")
 	  return syntacticParseQUIT();
+	if (tokenizedQuery.size() == 1 && tokenizedQuery[0] == "FLUSH")
+		return syntacticParseFLUSH();
 
 	if (tokenizedQuery.size() < 2)
 	{
@@ -59,6 +61,10 @@ bool syntacticParse()
 		return syntacticParseCHECKANTISYM();
 	else if (possibleQueryType == "SORT")
 		return syntacticParseSORT();
+	else if (possibleQueryType == "ANALYZE")
+		return syntacticParseANALYZE();
+	else if (possibleQueryType == "EXPLAIN")
+		return syntacticParseEXPLAIN();
 	else
 	{
 		string resultantRelationName = possibleQueryType;
@@ -99,7 +105,7 @@ ParsedQuery::ParsedQuery()
 
 void ParsedQuery::clear()
 {
-	logger.log("ParseQuery::clear");
+	LOG_DEBUG("ParseQuery::clear");
 	this->queryType = UNDETERMINED;
 
 	this->clearRelationName = "";
@@ -113,7 +119,12 @@ void ParsedQuery::clear()
 
 	this->exportRelationName = "";
 
+	this->analyzeRelationName = "";
+
+	this->explainQueryType = UNDETERMINED;
+
 	this->indexingStrategy = NOTHING;
+	this->indexColumnNames.clear();
 	this->indexColumnName = "";
 	this->indexRelationName = "";
 
@@ -124,7 +135,10 @@ void ParsedQuery::clear()
 	this->joinFirstColumnName = "";
 	this->joinSecondColumnName = "";
 
+	this->listTarget = "";
+
 	this->loadRelationName = "";
+	this->loadPageLayout = ROW_LAYOUT;
 
 	this->printRelationName = "";
 
@@ -143,6 +157,7 @@ void ParsedQuery::clear()
 	this->selectionFirstColumnName = "";
 	this->selectionSecondColumnName = "";
 	this->selectionIntLiteral = 0;
+	this->selectionConditions.clear();
 
 	this->sortingStrategy = NO_SORT_CLAUSE;
 	this->sortResultRelationName = "";
@@ -183,9 +198,7 @@ void ParsedQuery::clear()
 	/* SEARCH */
     searchResultRelationName = "";
     searchRelationName = "";
-    searchColumnName = "";
-    searchOperator = NO_BINOP_CLAUSE;
-    searchLiteralValue = 0;
+    searchConditions.clear();
 }
 
 /**
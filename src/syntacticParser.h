@@ -36,6 +36,9 @@ enum QueryType
 	UPDATE,
 	DELETE,
 	SEARCH,
+	FLUSH,
+	ANALYZE,
+	EXPLAIN,
 	QUIT,
 	UNDETERMINED
 };
@@ -51,6 +54,18 @@ enum BinaryOperator
 	NO_BINOP_CLAUSE
 };
 
+/**
+ * @brief One "column op int_literal" of a WHERE clause; a clause of several
+ * holds when all of them do. columnIndex is filled in by the semantic parser.
+ */
+struct Condition
+{
+	string columnName;
+	BinaryOperator binaryOperator = NO_BINOP_CLAUSE;
+	int value = 0;
+	int columnIndex = -1;
+};
+
 enum SortingStrategy
 {
 	ASC,
@@ -100,8 +115,13 @@ public:
 
 	string exportRelationName = "";
 
+	string analyzeRelationName = "";
+
+	QueryType explainQueryType = UNDETERMINED;
+
 	IndexingStrategy indexingStrategy = NOTHING;
-	string indexColumnName = "";
+	vector<string> indexColumnNames;
+	string indexColumnName = ""; // The columns joined by ',', see Index::columnListName
 	string indexRelationName = "";
 
 	BinaryOperator joinBinaryOperator = NO_BINOP_CLAUSE;
@@ -111,7 +131,10 @@ public:
 	string joinFirstColumnName = "";
 	string joinSecondColumnName = "";
 
+	string listTarget = ""; // TABLES or BUFFER
+
 	string loadRelationName = "";
+	PageLayout loadPageLayout = ROW_LAYOUT;
 
 	string printRelationName = "";
 
@@ -130,6 +153,7 @@ public:
 	string selectionFirstColumnName = "";
 	string selectionSecondColumnName = "";
 	int selectionIntLiteral = 0;
+	vector<Condition> selectionConditions; // literal conditions joined by AND, see syntacticParseSELECTION
 
 	SortingStrategy sortingStrategy = NO_SORT_CLAUSE;
 	string sortResultRelationName = "";
@@ -185,9 +209,7 @@ public:
     /* ---------- SEARCH ---------- */ // <-- ADDED BLOCK
     string searchResultRelationName = "";
     string searchRelationName = "";
-    string searchColumnName = "";
-    BinaryOperator searchOperator = NO_BINOP_CLAUSE;
-    int searchLiteralValue = 0;
+    vector<Condition> searchConditions;
 
 	ParsedQuery();
 	void clear();
@@ -220,6 +242,9 @@ bool syntacticParseINSERT();
 bool syntacticParseUPDATE();
 bool syntacticParseDELETE();
 bool syntacticParseSEARCH();
+bool syntacticParseFLUSH();
+bool syntacticParseANALYZE();
+bool syntacticParseEXPLAIN();
 bool syntacticParseQUIT();
 
 bool isFileExists(string tableName);
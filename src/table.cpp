@@ -1,6 +1,7 @@
 #include "global.h"
 #include "table.h" // Ensure table.h is included
 #include "index.h" // Ensure index.h is included for BTree definition
+#include <dirent.h>
 
 /**
  * @brief Construct a new Table:: Table object
@@ -8,7 +9,7 @@
  */
 Table::Table()
 {
-	logger.log("Table::Table");
+	LOG_DEBUG("Table::Table");
     // Ensure index pointer is null initially
     this->index = nullptr;
     this->indexed = false;
@@ -25,7 +26,7 @@ Table::Table()
  */
 Table::Table(string tableName)
 {
-	logger.log("Table::Table");
+	LOG_DEBUG("Table::Table");
 	this->sourceFileName = "../data/" + tableName + ".csv";
 	this->tableName = tableName;
     // Ensure index pointer is null initially
@@ -33,8 +34,6 @@ Table::Table(string tableName)
     this->indexed = false;
     this->indexingStrategy = NOTHING;
     this->indexedColumn = "";
-    // TODO: Add logic here or after load() to check if a persisted index
-    // for this table exists and load it. For now, assumes no persistence.
 }
 
 /**
@@ -47,7 +46,7 @@ Table::Table(string tableName)
  */
 Table::Table(string tableName, vector<string> columns)
 {
-	logger.log("Table::Table");
+	LOG_DEBUG("Table::Table");
 	this->sourceFileName = "../data/temp/" + tableName + ".csv";
 	this->tableName = tableName;
 	this->columns = columns;
@@ -77,7 +76,7 @@ Table::Table(string tableName, vector<string> columns)
  */
 bool Table::load()
 {
-	logger.log("Table::load");
+	LOG_DEBUG("Table::load");
 	fstream fin(this->sourceFileName, ios::in);
 	string line;
 	if (getline(fin, line))
@@ -86,7 +85,7 @@ bool Table::load()
 		if (this->extractColumnNames(line)) // This sets columnCount and maxRowsPerBlock
 			if (this->blockify()) // This reads data and creates pages
             {
-                 // TODO: After successful load, check for and load persisted index if necessary.
+                this->readStatistics(); // statistics from an earlier ANALYZE, if still current
                 return true;
             }
 
@@ -106,7 +105,7 @@ bool Table::load()
  */
 bool Table::extractColumnNames(string firstLine)
 {
-	logger.log("Table::extractColumnNames");
+	LOG_DEBUG("Table::extractColumnNames");
 	unordered_set<string> columnNames;
 	string word;
 	stringstream s(firstLine);
@@ -148,10 +147,10 @@ bool Table::extractColumnNames(string firstLine)
  */
 bool Table::blockify()
 {
-	logger.log("Table::blockify");
+	LOG_DEBUG("Table::blockify");
 	ifstream fin(this->sourceFileName, ios::in);
     if (!fin.is_open()) {
-        logger.log("Table::blockify - ERROR: Could not open source file: " + this->sourceFileName);
+        LOG_ERROR("Table::blockify - ERROR: Could not open source file: " + this->sourceFileName);
         return false;
     }
 
@@ -159,12 +158,19 @@ bool Table::blockify()
     this->blockCount = 0;
     this->rowCount = 0;
     this->rowsPerBlockCount.clear();
+    this->zoneMaps.clear();
     // Keep distinct value stats or clear them? Let's clear and rebuild.
 	if (this->columnCount > 0) {
-        this->distinctValuesInColumns.assign(this->columnCount, unordered_set<int>());
+        // Distinct values are counted either exactly or by sketches, never both
+        this->distinctValuesInColumns.clear();
+        this->distinctValueSketches.clear();
+        if (EXACT_DISTINCT)
+            this->distinctValuesInColumns.assign(this->columnCount, unordered_set<int>());
+        else
+	        this->distinctValueSketches.assign(this->columnCount, HyperLogLog(HLL_PRECISION));
 	    this->distinctValuesPerColumnCount.assign(this->columnCount, 0);
     } else {
-         logger.log("Table::blockify - ERROR: Column count is zero.");
+         LOG_ERROR("Table::blockify - ERROR: Column count is zero.");
          fin.close();
          return false;
     }
@@ -172,7 +178,7 @@ bool Table::blockify()
 
 	string line, word;
 	vector<int> row(this->columnCount, 0);
-	vector<vector<int>> rowsInPage(this->maxRowsPerBlock, row); // Pre-allocate page buffer
+	vector<int> rowsInPage((size_t)this->maxRowsPerBlock * this->columnCount); // Pre-allocate page buffer, row-major
 	int pageCounter = 0;
 
 	getline(fin, line); // Skip header line
@@ -187,7 +193,7 @@ bool Table::blockify()
 		for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
 		{
 			if (!getline(s, word, ',')) {
-                 logger.log("Table::blockify - ERROR: Row has fewer columns than expected. Line: " + line);
+                 LOG_ERROR("Table::blockify - ERROR: Row has fewer columns than expected. Line: " + line);
                  // Decide how to handle: return false, skip row, pad with 0?
                  // Returning false seems safest for now.
                  fin.close();
@@ -197,20 +203,20 @@ bool Table::blockify()
                 // Trim whitespace before converting
                 word.erase(std::remove_if(word.begin(), word.end(), ::isspace), word.end());
 			    row[columnCounter] = stoi(word);
-			    rowsInPage[pageCounter][columnCounter] = row[columnCounter];
+			    rowsInPage[(size_t)pageCounter * this->columnCount + columnCounter] = row[columnCounter];
             } catch (const std::invalid_argument& ia) {
-                 logger.log("Table::blockify - ERROR: Invalid integer value '" + word + "' in line: " + line);
+                 LOG_ERROR("Table::blockify - ERROR: Invalid integer value '" + word + "' in line: " + line);
                  fin.close();
                  return false;
             } catch (const std::out_of_range& oor) {
-                 logger.log("Table::blockify - ERROR: Integer value out of range '" + word + "' in line: " + line);
+                 LOG_ERROR("Table::blockify - ERROR: Integer value out of range '" + word + "' in line: " + line);
                  fin.close();
                  return false;
             }
 		}
         // Check if there are extra columns in the line
         if (getline(s, word, ',')) {
-             logger.log("Table::blockify - ERROR: Row has more columns than expected. Line: " + line);
+             LOG_ERROR("Table::blockify - ERROR: Row has more columns than expected. Line: " + line);
              fin.close();
              return false;
         }
@@ -220,31 +226,29 @@ bool Table::blockify()
 		this->updateStatistics(row); // Updates rowCount and distinct counts
 		if (pageCounter == this->maxRowsPerBlock)
 		{
-			bufferManager.writePage(this->tableName, this->blockCount, rowsInPage, pageCounter);
+			bufferManager.writePage(this->tableName, this->blockCount, rowsInPage, pageCounter, this->columnCount, this->pageLayout);
+			this->setZoneMap(this->blockCount, rowsInPage.data(), pageCounter);
 			this->blockCount++;
 			this->rowsPerBlockCount.emplace_back(pageCounter);
 			pageCounter = 0;
-            // Optionally clear rowsInPage here if concerned about leftover data, but overwriting should be fine.
-            // rowsInPage.assign(this->maxRowsPerBlock, vector<int>(this->columnCount, 0));
 		}
 	}
 	fin.close(); // Close the file stream
 
 	if (pageCounter > 0) // Write the last partially filled page
 	{
-		bufferManager.writePage(this->tableName, this->blockCount, rowsInPage, pageCounter);
+		bufferManager.writePage(this->tableName, this->blockCount, rowsInPage, pageCounter, this->columnCount, this->pageLayout);
+		this->setZoneMap(this->blockCount, rowsInPage.data(), pageCounter);
 		this->blockCount++;
 		this->rowsPerBlockCount.emplace_back(pageCounter);
 	}
 
 	if (this->rowCount == 0) {
-        logger.log("Table::blockify - Warning: Table is empty after blockifying.");
+        LOG_WARNING("Table::blockify - Warning: Table is empty after blockifying.");
 		// It's not necessarily an error for a table to be empty, so return true.
     }
 
-    // Clear the large distinct value sets now that counts are computed
-	this->distinctValuesInColumns.clear();
-    this->distinctValuesInColumns.shrink_to_fit(); // Release memory
+    this->refreshDistinctCounts();
 	return true;
 }
 
@@ -260,25 +264,190 @@ void Table::updateStatistics(vector<int> row)
 {
     // This check should ideally happen before calling updateStatistics
 	if (row.size() != this->columnCount) {
-        logger.log("Table::updateStatistics - ERROR: Row size mismatch.");
+        LOG_ERROR("Table::updateStatistics - ERROR: Row size mismatch.");
         return; // Avoid processing mismatched rows
     }
 
 	this->rowCount++;
-    // Only update distinct counts if the structure is still allocated (it's cleared after blockify)
-    if (!this->distinctValuesInColumns.empty() && this->distinctValuesInColumns.size() == this->columnCount) {
+	this->addDistinctValues(row);
+}
+
+/**
+ * @brief Adds the values of row to the per column distinct value sketches, or
+ * with EXACT_DISTINCT to the exact sets, which are kept for the life of the
+ * table so INSERT and UPDATE keep counting exactly. The counts in
+ * distinctValuesPerColumnCount only change once refreshDistinctCounts is
+ * called, since computing an estimate looks at every register.
+ *
+ * @param row
+ */
+void Table::addDistinctValues(const vector<int> &row)
+{
+	if (this->distinctValueSketches.size() == this->columnCount)
+		for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+			this->distinctValueSketches[columnCounter].add(row[columnCounter]);
+
+    if (this->distinctValuesInColumns.size() == this->columnCount)
 	    for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
-	    {
-		    if (this->distinctValuesInColumns[columnCounter].find(row[columnCounter]) == this->distinctValuesInColumns[columnCounter].end())
-		    {
-			    this->distinctValuesInColumns[columnCounter].insert(row[columnCounter]);
-			    this->distinctValuesPerColumnCount[columnCounter]++;
-		    }
-	    }
-    } else if (this->distinctValuesPerColumnCount.size() != this->columnCount) {
-         // If counts vector isn't ready, maybe initialize or log error
-         // Let's assume distinctValuesPerColumnCount was initialized in blockify/constructor
-    }
+		    this->distinctValuesInColumns[columnCounter].insert(row[columnCounter]);
+}
+
+/**
+ * @brief Sets distinctValuesPerColumnCount from the sketches, or from the
+ * sizes of the exact sets with EXACT_DISTINCT. Values an UPDATE overwrote are
+ * still counted either way.
+ *
+ */
+void Table::refreshDistinctCounts()
+{
+	if (this->distinctValuesInColumns.size() == this->columnCount)
+	{
+		this->distinctValuesPerColumnCount.resize(this->columnCount);
+		for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+			this->distinctValuesPerColumnCount[columnCounter] = this->distinctValuesInColumns[columnCounter].size();
+		return;
+	}
+	if (this->distinctValueSketches.size() != this->columnCount)
+		return;
+	this->distinctValuesPerColumnCount.resize(this->columnCount);
+	for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+		this->distinctValuesPerColumnCount[columnCounter] = this->distinctValueSketches[columnCounter].estimate();
+}
+
+/**
+ * @brief Builds columnStatistics (see ColumnStatistics) from a sample of up to
+ * ANALYZE_SAMPLE_PAGES pages picked at random, read through the buffer
+ * manager, and writes them to the statistics file. Distinct counts come from
+ * the table's sketches rather than the sample.
+ *
+ * @return int number of pages sampled
+ */
+int Table::analyze()
+{
+	LOG_DEBUG("Table::analyze");
+	vector<int> pageIndices(this->blockCount);
+	iota(pageIndices.begin(), pageIndices.end(), 0);
+	if (pageIndices.size() > ANALYZE_SAMPLE_PAGES)
+	{
+		// Fixed seed, so analyzing the same table twice gives the same statistics
+		mt19937 generator(this->blockCount);
+		shuffle(pageIndices.begin(), pageIndices.end(), generator);
+		pageIndices.resize(ANALYZE_SAMPLE_PAGES);
+		sort(pageIndices.begin(), pageIndices.end());
+	}
+
+	vector<vector<int>> samples(this->columnCount);
+	for (int pageIndex : pageIndices)
+	{
+		PageHandle page = bufferManager.getPage(this->tableName, pageIndex);
+		for (int rowCounter = 0; rowCounter < page->getRowCount(); rowCounter++)
+		{
+			RowSpan row = page->getRowRef(rowCounter);
+			for (int columnCounter = 0; columnCounter < this->columnCount && columnCounter < row.size(); columnCounter++)
+				samples[columnCounter].push_back(row[columnCounter]);
+		}
+	}
+
+	this->refreshDistinctCounts();
+	this->columnStatistics.clear();
+	for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+	{
+		uint distinctCount = columnCounter < this->distinctValuesPerColumnCount.size() ? this->distinctValuesPerColumnCount[columnCounter] : 0;
+		this->columnStatistics.push_back(ColumnStatistics::build(move(samples[columnCounter]), distinctCount));
+	}
+	this->writeStatistics();
+	return pageIndices.size();
+}
+
+/**
+ * @brief The statistics file lives next to the table's csv: "<name>.stats"
+ * in the data folder for loaded and exported tables, in the temp folder for
+ * the rest.
+ *
+ * @return string
+ */
+string Table::statisticsFileName()
+{
+	string fileName = this->sourceFileName;
+	if (fileName.size() >= 4 && fileName.compare(fileName.size() - 4, 4, ".csv") == 0)
+		fileName.erase(fileName.size() - 4);
+	return fileName + ".stats";
+}
+
+/**
+ * @brief Writes columnStatistics to the statistics file as text: a line with
+ * the row count, then one line per column with its name, distinct count,
+ * common values (count, then value fraction pairs) and histogram bounds
+ * (count, then the bounds).
+ *
+ * @return true on success
+ */
+bool Table::writeStatistics()
+{
+	ofstream fout(this->statisticsFileName(), ios::trunc);
+	if (!fout.is_open())
+	{
+		LOG_ERROR("Table::writeStatistics - ERROR: Could not open " + this->statisticsFileName());
+		return false;
+	}
+	fout << "rows " << this->rowCount << "\n";
+	for (int columnCounter = 0; columnCounter < this->columnStatistics.size(); columnCounter++)
+	{
+		const ColumnStatistics &statistics = this->columnStatistics[columnCounter];
+		fout << "column " << this->columns[columnCounter] << " " << statistics.distinctCount;
+		fout << " " << statistics.mostCommonValues.size();
+		for (auto &[value, fraction] : statistics.mostCommonValues)
+			fout << " " << value << " " << setprecision(17) << fraction;
+		fout << " " << statistics.histogramBounds.size();
+		for (int bound : statistics.histogramBounds)
+			fout << " " << bound;
+		fout << "\n";
+	}
+	return true;
+}
+
+/**
+ * @brief Reads columnStatistics back from the statistics file. The file is
+ * ignored if it is older than the csv, was written for a different row count
+ * or for different columns, since the statistics would then be stale.
+ *
+ * @return true if statistics were read
+ */
+bool Table::readStatistics()
+{
+	struct stat statisticsStat, sourceStat;
+	string fileName = this->statisticsFileName();
+	if (stat(fileName.c_str(), &statisticsStat) || stat(this->sourceFileName.c_str(), &sourceStat) ||
+		make_pair(statisticsStat.st_mtim.tv_sec, statisticsStat.st_mtim.tv_nsec) < make_pair(sourceStat.st_mtim.tv_sec, sourceStat.st_mtim.tv_nsec))
+		return false;
+	ifstream fin(fileName, ios::in);
+	string word;
+	long long rowCount;
+	if (!(fin >> word >> rowCount) || word != "rows" || rowCount != this->rowCount)
+		return false;
+
+	vector<ColumnStatistics> columnStatistics(this->columnCount);
+	for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+	{
+		ColumnStatistics &statistics = columnStatistics[columnCounter];
+		string columnName;
+		size_t valueCount;
+		if (!(fin >> word >> columnName >> statistics.distinctCount >> valueCount) || word != "column" || columnName != this->columns[columnCounter])
+			return false;
+		statistics.mostCommonValues.resize(valueCount);
+		for (auto &[value, fraction] : statistics.mostCommonValues)
+			if (!(fin >> value >> fraction))
+				return false;
+		if (!(fin >> valueCount))
+			return false;
+		statistics.histogramBounds.resize(valueCount);
+		for (int &bound : statistics.histogramBounds)
+			if (!(fin >> bound))
+				return false;
+	}
+	this->columnStatistics = move(columnStatistics);
+	LOG_DEBUG("Table::readStatistics - Read statistics of " + this->tableName + " from " + fileName);
+	return true;
 }
 
 /**
@@ -290,7 +459,7 @@ void Table::updateStatistics(vector<int> row)
  */
 bool Table::isColumn(string columnName)
 {
-	// logger.log("Table::isColumn"); // Can be very verbose
+	// LOG_DEBUG("Table::isColumn"); // Can be very verbose
 	for (auto const& col : this->columns) // Use const& for efficiency
 	{
 		if (col == columnName)
@@ -311,7 +480,7 @@ bool Table::isColumn(string columnName)
  */
 void Table::renameColumn(string fromColumnName, string toColumnName)
 {
-	logger.log("Table::renameColumn");
+	LOG_DEBUG("Table::renameColumn");
 	bool found = false;
 	for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
 	{
@@ -328,7 +497,7 @@ void Table::renameColumn(string fromColumnName, string toColumnName)
         // If file naming depends on the column name stored here, this could be an issue.
         // Current BTree uses tableName + columnName for indexName, so renaming column
         // *after* index creation might break index loading/finding logic if not handled.
-        logger.log("Table::renameColumn - Warning: Renamed an indexed column. Index file names might be based on the old name.");
+        LOG_WARNING("Table::renameColumn - Warning: Renamed an indexed column. Index file names might be based on the old name.");
     }
 	return;
 }
@@ -341,7 +510,7 @@ void Table::renameColumn(string fromColumnName, string toColumnName)
  */
 void Table::print()
 {
-	logger.log("Table::print");
+	LOG_DEBUG("Table::print");
 	if (this->columnCount == 0 || this->blockCount == 0) {
         cout << "Table " << this->tableName << " is empty or has no columns/blocks." << endl;
         return;
@@ -374,10 +543,10 @@ void Table::print()
  */
 void Table::getNextPage(Cursor *cursor)
 {
-	logger.log("Table::getNextPage"); // Corrected log message
+	LOG_DEBUG("Table::getNextPage"); // Corrected log message
 
 	if (!cursor) {
-        logger.log("Table::getNextPage - Error: Null cursor provided.");
+        LOG_ERROR("Table::getNextPage - Error: Null cursor provided.");
         return;
     }
 
@@ -389,7 +558,7 @@ void Table::getNextPage(Cursor *cursor)
 	} else {
         // No next page exists or invalid state
         // Cursor::nextPage handles loading, maybe just log here or do nothing.
-         logger.log("Table::getNextPage - Cursor is already at the last page or in an invalid state.");
+         LOG_DEBUG("Table::getNextPage - Cursor is already at the last page or in an invalid state.");
          // We could invalidate the cursor here, but nextPage handles loading.
          // The cursor's getNext() method will naturally return empty if no more rows.
     }
@@ -402,7 +571,7 @@ void Table::getNextPage(Cursor *cursor)
  */
 void Table::makePermanent()
 {
-	logger.log("Table::makePermanent");
+	LOG_DEBUG("Table::makePermanent");
     string currentSource = this->sourceFileName; // Keep track of the current source
     bool wasInMemoryOnly = !this->isPermanent(); // Check if it was temporary
 
@@ -415,13 +584,13 @@ void Table::makePermanent()
     // if (wasInMemoryOnly && currentSource != newSourceFile) {
 	//     bufferManager.deleteFile(currentSource); // Delete old temp CSV if different
     // } else if (wasInMemoryOnly) {
-    //      logger.log("Table::makePermanent - Temp source file seems to be the same as permanent? " + currentSource);
+    //      LOG_DEBUG("Table::makePermanent - Temp source file seems to be the same as permanent? " + currentSource);
     // } // If it was already permanent, we just overwrite it below.
 
 
 	ofstream fout(newSourceFile, ios::trunc); // Open in trunc mode to overwrite
     if (!fout.is_open()) {
-         logger.log("Table::makePermanent - ERROR: Could not open permanent file for writing: " + newSourceFile);
+         LOG_ERROR("Table::makePermanent - ERROR: Could not open permanent file for writing: " + newSourceFile);
          return; // Exit if cannot open file
     }
 
@@ -430,7 +599,7 @@ void Table::makePermanent()
     if (!this->columns.empty()) {
 	    this->writeRow(this->columns, fout);
     } else {
-         logger.log("Table::makePermanent - Warning: Table has no columns defined.");
+         LOG_WARNING("Table::makePermanent - Warning: Table has no columns defined.");
     }
 
 	// Read from pages and write to the new file
@@ -442,24 +611,29 @@ void Table::makePermanent()
 	    {
 		    row = cursor.getNext();
             if (row.empty()) {
-                logger.log("Table::makePermanent - Warning: Cursor returned empty row before reaching rowCount. Actual rows: " + std::to_string(rowCounter));
+                LOG_WARNING("Table::makePermanent - Warning: Cursor returned empty row before reaching rowCount. Actual rows: " + std::to_string(rowCounter));
                 break; // Stop if we run out of data
             }
 		    this->writeRow(row, fout);
 	    }
     } else {
-        logger.log("Table::makePermanent - Warning: Table has no blocks to write.");
+        LOG_WARNING("Table::makePermanent - Warning: Table has no blocks to write.");
     }
 
 	fout.close();
 
     // Update the source file name to the permanent location
+    if (wasInMemoryOnly && !this->columnStatistics.empty())
+        bufferManager.deleteFile(this->statisticsFileName());
     this->sourceFileName = newSourceFile;
-    logger.log("Table::makePermanent - Table data written to permanent file: " + this->sourceFileName);
+    if (!this->columnStatistics.empty())
+        this->writeStatistics();
+    this->saveIndexes();
+    LOG_DEBUG("Table::makePermanent - Table data written to permanent file: " + this->sourceFileName);
 
     // Now, delete the temporary page files if they existed
     if (wasInMemoryOnly) {
-         logger.log("Table::makePermanent - Deleting temporary page files for: " + this->tableName);
+         LOG_DEBUG("Table::makePermanent - Deleting temporary page files for: " + this->tableName);
          for (uint i = 0; i < this->blockCount; ++i) {
               bufferManager.deleteFile(this->tableName, i); // Deletes ../data/temp/<tableName>_Page<i>
          }
@@ -467,10 +641,155 @@ void Table::makePermanent()
          if (currentSource != this->sourceFileName && currentSource.find("../data/temp/") != string::npos) {
              bufferManager.deleteFile(currentSource);
          }
+    } else {
+        // The pages stay around, so bring their files up to date with the pool
+        bufferManager.flushTable(this->tableName);
+    }
+}
+
+/**
+ * @brief Indexes of the table saved in the data folder, read off their file
+ * names: "<table>_<columns>_index.idx" for a B+ tree and "..._hash.idx" for a
+ * hash index, columns being the index's column list (see
+ * Index::columnListName). Files of other tables, or naming columns this table
+ * does not have, are skipped. Sorted by key columns, B+ trees first.
+ */
+static vector<pair<vector<int>, IndexingStrategy>> savedIndexes(Table *table)
+{
+    vector<pair<vector<int>, IndexingStrategy>> saved;
+    DIR *directory = opendir("../data");
+    if (!directory)
+        return saved;
+    string prefix = table->tableName + "_";
+    while (dirent *entry = readdir(directory))
+    {
+        string fileName = entry->d_name;
+        for (auto [suffix, strategy] : {make_pair(string("_index.idx"), BTREE), make_pair(string("_hash.idx"), HASH)})
+        {
+            if (fileName.size() <= prefix.size() + suffix.size() || fileName.compare(0, prefix.size(), prefix) ||
+                fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix))
+                continue;
+            stringstream columnList(fileName.substr(prefix.size(), fileName.size() - prefix.size() - suffix.size()));
+            vector<int> keyColumns;
+            string columnName;
+            bool known = true;
+            while (known && getline(columnList, columnName, ','))
+            {
+                auto column = find(table->columns.begin(), table->columns.end(), columnName);
+                known = column != table->columns.end();
+                if (known)
+                    keyColumns.push_back(column - table->columns.begin());
+            }
+            if (known && !keyColumns.empty())
+                saved.push_back({keyColumns, strategy});
+        }
+    }
+    closedir(directory);
+    sort(saved.begin(), saved.end());
+    return saved;
+}
+
+static string columnListName(Table *table, const vector<int> &keyColumns)
+{
+    vector<string> names;
+    for (int column : keyColumns)
+        names.push_back(table->columns[column]);
+    return Index::columnListName(names);
+}
+
+/**
+ * @brief Checksum of the values of the table in page order. Two tables with
+ * the same rows in a different order have different checksums, as record
+ * pointers into them would differ.
+ *
+ * @return uint64_t
+ */
+uint64_t Table::pageChecksum()
+{
+    uint64_t checksum = 0xcbf29ce484222325ULL; // FNV-1a over the values
+    for (uint pageIndex = 0; pageIndex < this->blockCount; pageIndex++)
+    {
+        PageHandle page = bufferManager.getPage(this->tableName, pageIndex);
+        for (int rowCounter = 0; rowCounter < page->getRowCount(); rowCounter++)
+        {
+            RowSpan row = page->getRowRef(rowCounter);
+            for (uint columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+                checksum = (checksum ^ (uint32_t)row[columnCounter]) * 0x100000001b3ULL;
+        }
+    }
+    return checksum;
+}
+
+/**
+ * @brief Saves every index of an exported table next to its csv (see
+ * Index::save) and removes saved indexes the table no longer has (dropped,
+ * or on the same columns but of the other kind now), so the next LOAD
+ * attaches exactly the indexes the table has now. An index that no longer
+ * matches the table's pages (see Index::matchesPages) is built again before
+ * it is saved.
+ */
+void Table::saveIndexes()
+{
+    LOG_DEBUG("Table::saveIndexes");
+    uint64_t checksum = this->indexes.empty() ? 0 : this->pageChecksum();
+    for (const auto &[columnName, index] : this->indexes)
+    {
+        if (!index->matchesPages(this))
+        {
+            LOG_WARNING("Table::saveIndexes - Index on " + columnName + " does not match the pages of " + this->tableName + ", rebuilding it");
+            if (!index->buildIndex(this))
+            {
+                LOG_ERROR("Table::saveIndexes - ERROR: Could not rebuild index on " + columnName);
+                bufferManager.deleteFile(index->persistentFileName());
+                continue;
+            }
+        }
+        if (!index->save(this, checksum))
+            LOG_ERROR("Table::saveIndexes - ERROR: Could not save index on " + columnName);
+    }
+    for (const auto &[keyColumns, strategy] : savedIndexes(this))
+    {
+        Index *index = this->getIndex(columnListName(this, keyColumns));
+        if (index && index->getStrategy() == strategy)
+            continue;
+        unique_ptr<Index> unindexed(Index::create(strategy, this->tableName, columnListName(this, keyColumns), keyColumns));
+        bufferManager.deleteFile(unindexed->persistentFileName());
+    }
+}
+
+/**
+ * @brief Attaches the indexes saved by the last EXPORT of this table. A saved
+ * index that no longer matches the table (the csv changed, so its pages and
+ * their checksum did, or the table was exported with partly filled pages and
+ * now loads packed) is built again from the table instead. Called by LOAD once the table is loaded.
+ *
+ * @return vector<LoadedIndex> every index now on the table, in order of key
+ * columns, and whether it had to be rebuilt
+ */
+vector<LoadedIndex> Table::loadIndexes()
+{
+    LOG_DEBUG("Table::loadIndexes");
+    vector<LoadedIndex> loadedIndexes;
+    vector<pair<vector<int>, IndexingStrategy>> saved = savedIndexes(this);
+    uint64_t checksum = saved.empty() ? 0 : this->pageChecksum();
+    for (const auto &[keyColumns, strategy] : saved)
+    {
+        string columnName = columnListName(this, keyColumns);
+        if (this->isIndexed(columnName) || (strategy == HASH && keyColumns.size() > 1) || keyColumns.size() > IndexKey::MAX_COLUMNS)
+            continue;
+        Index *index = Index::create(strategy, this->tableName, columnName, keyColumns);
+        bool rebuilt = !index->restore(this, checksum);
+        if (rebuilt && !index->buildIndex(this))
+        {
+            LOG_ERROR("Table::loadIndexes - ERROR: Could not rebuild stale saved index on " + columnName);
+            index->dropIndex();
+            delete index;
+            continue;
+        }
+        this->addIndex(columnName, index);
+        loadedIndexes.push_back({index, rebuilt});
     }
-     // TODO: Decide if the index associated with this table should also be made permanent.
-     // This would involve saving the BTree structure (root page index, node count, order etc.)
-     // and potentially moving the BTree node pages from temp to data.
+    return loadedIndexes;
 }
 
 /**
@@ -481,7 +800,7 @@ void Table::makePermanent()
  */
 bool Table::isPermanent()
 {
-	// logger.log("Table::isPermanent"); // Can be verbose
+	// LOG_DEBUG("Table::isPermanent"); // Can be verbose
     // Check if the sourceFileName starts with "../data/" and not "../data/temp/"
 	if (this->sourceFileName.rfind("../data/", 0) == 0 &&
         this->sourceFileName.rfind("../data/temp/", 0) != 0) {
@@ -492,7 +811,7 @@ bool Table::isPermanent()
 
 // Destructor: Cleans up indexes when Table object is destroyed
 Table::~Table() {
-    logger.log("Table::~Table - Destructor called for table: " + this->tableName);
+    LOG_DEBUG("Table::~Table - Destructor called for table: " + this->tableName);
     this->removeAllIndexes(); // Use the helper to clean up
 }
 
@@ -505,11 +824,11 @@ Table::~Table() {
  */
 // void Table::unload()
 // {
-// 	logger.log("Table::unload - Unloading table: " + this->tableName);
+// 	LOG_DEBUG("Table::unload - Unloading table: " + this->tableName);
 
 //     // Delete the B+ Tree index object and its files if it exists
 //     if (this->index != nullptr) {
-//         logger.log("Table::unload - Dropping associated index for column: " + this->indexedColumn);
+//         LOG_DEBUG("Table::unload - Dropping associated index for column: " + this->indexedColumn);
 //         this->index->dropIndex(); // Deletes index node pages
 //         delete this->index;       // Deletes the BTree object itself
 //         this->index = nullptr;
@@ -525,10 +844,10 @@ Table::~Table() {
 
 //     // Delete the source CSV file ONLY if it's temporary (in ../data/temp/)
 // 	if (!isPermanent() && !this->sourceFileName.empty()) {
-//          logger.log("Table::unload - Deleting temporary source file: " + this->sourceFileName);
+//          LOG_DEBUG("Table::unload - Deleting temporary source file: " + this->sourceFileName);
 // 		 bufferManager.deleteFile(this->sourceFileName);
 //     } else {
-//          logger.log("Table::unload - Keeping permanent source file: " + this->sourceFileName);
+//          LOG_DEBUG("Table::unload - Keeping permanent source file: " + this->sourceFileName);
 //     }
 
 //     // Reset table state (optional, as object might be deleted soon after)
@@ -543,7 +862,7 @@ Table::~Table() {
 
 void Table::unload()
 {
-    logger.log("Table::unload - Unloading table: " + this->tableName);
+    LOG_DEBUG("Table::unload - Unloading table: " + this->tableName);
     // Delete page files
     for (int i = 0; i < this->blockCount; i++)
     {
@@ -554,20 +873,65 @@ void Table::unload()
     this->blockCount = 0;
     this->rowCount = 0;
     this->rowsPerBlockCount.clear();
+    this->zoneMaps.clear();
     this->distinctValuesInColumns.clear();
     this->distinctValuesPerColumnCount.clear();
+    this->distinctValueSketches.clear();
 
     // Delete the source CSV file ONLY if it's temporary (in ../data/temp/)
 	if (!isPermanent() && !this->sourceFileName.empty()) {
-         logger.log("Table::unload - Deleting temporary source file: " + this->sourceFileName);
+         LOG_DEBUG("Table::unload - Deleting temporary source file: " + this->sourceFileName);
 		 bufferManager.deleteFile(this->sourceFileName);
+         if (!this->columnStatistics.empty())
+             bufferManager.deleteFile(this->statisticsFileName());
     } else {
-         logger.log("Table::unload - Keeping permanent source file: " + this->sourceFileName);
+         LOG_DEBUG("Table::unload - Keeping permanent source file: " + this->sourceFileName);
     }
+    this->columnStatistics.clear();
 
     // Delete all associated index files and objects
     this->removeAllIndexes();
-    logger.log("Table::unload - Finished unloading: " + this->tableName);
+    LOG_DEBUG("Table::unload - Finished unloading: " + this->tableName);
+}
+
+/**
+ * @brief Recomputes the zone maps of page pageIndex from its rows, for when
+ * the page has just been written as a whole.
+ *
+ * @param pageIndex
+ * @param rows rowCount rows of columnCount ints, row-major
+ * @param rowCount
+ */
+void Table::setZoneMap(uint pageIndex, const int *rows, int rowCount)
+{
+	// Pages skipped over get a zone map that matches anything
+	ZoneMap unknown;
+	unknown.minimum = INT_MIN;
+	unknown.maximum = INT_MAX;
+	if (pageIndex >= this->zoneMaps.size())
+		this->zoneMaps.resize(pageIndex + 1, vector<ZoneMap>(this->columnCount, unknown));
+	vector<ZoneMap> &pageZoneMaps = this->zoneMaps[pageIndex];
+	pageZoneMaps.assign(this->columnCount, ZoneMap());
+	for (int rowCounter = 0; rowCounter < rowCount; rowCounter++)
+		for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
+			pageZoneMaps[columnCounter].include(rows[(size_t)rowCounter * this->columnCount + columnCounter]);
+}
+
+/**
+ * @brief Widens the zone maps of page pageIndex to cover row, for a row that
+ * was added to or changed in the page in place. Zone maps are never narrowed
+ * here, so they may end up wider than the page's actual values, which only
+ * costs the odd page that could have been skipped.
+ *
+ * @param pageIndex
+ * @param row
+ */
+void Table::widenZoneMap(uint pageIndex, const vector<int> &row)
+{
+	if (pageIndex >= this->zoneMaps.size())
+		return; // no zone map, the page is never skipped anyway
+	for (int columnCounter = 0; columnCounter < this->columnCount && columnCounter < row.size(); columnCounter++)
+		this->zoneMaps[pageIndex][columnCounter].include(row[columnCounter]);
 }
 
 /**
@@ -577,10 +941,10 @@ void Table::unload()
  */
 Cursor Table::getCursor()
 {
-	logger.log("Table::getCursor");
+	LOG_DEBUG("Table::getCursor");
     // Check if table has blocks before creating cursor
     if (this->blockCount == 0) {
-         logger.log("Table::getCursor - Warning: Table has no blocks. Returning cursor starting at page 0 (will likely return empty).");
+         LOG_WARNING("Table::getCursor - Warning: Table has no blocks. Returning cursor starting at page 0 (will likely return empty).");
          // Allow creating cursor, but getNext() will likely fail gracefully
     }
 	Cursor cursor(this->tableName, 0); // Always start cursor at page 0
@@ -594,7 +958,7 @@ Cursor Table::getCursor()
  */
 int Table::getColumnIndex(string columnName)
 {
-	// logger.log("Table::getColumnIndex"); // Verbose
+	// LOG_DEBUG("Table::getColumnIndex"); // Verbose
 	for (int columnCounter = 0; columnCounter < this->columnCount; columnCounter++)
 	{
 		if (this->columns[columnCounter] == columnName)
@@ -602,7 +966,7 @@ int Table::getColumnIndex(string columnName)
 	}
     // Return -1 or throw an exception if column not found?
     // Returning -1 allows callers to check.
-     logger.log("Table::getColumnIndex - Warning: Column '" + columnName + "' not found in table '" + this->tableName + "'.");
+     LOG_WARNING("Table::getColumnIndex - Warning: Column '" + columnName + "' not found in table '" + this->tableName + "'.");
     return -1;
 }
 
@@ -613,7 +977,7 @@ int Table::getColumnIndex(string columnName)
  */
 bool Table::reload()
 {
-	logger.log("Table::reload - Reloading table from: " + this->sourceFileName);
+	LOG_DEBUG("Table::reload - Reloading table from: " + this->sourceFileName);
 
 	/* Remove old page files */
     // Don't call unload() as that deletes the index object and potentially the source CSV.
@@ -626,6 +990,7 @@ bool Table::reload()
 	this->rowCount = 0;
 	this->blockCount = 0;
 	this->rowsPerBlockCount.clear();
+	this->zoneMaps.clear();
 	this->distinctValuesPerColumnCount.clear(); // Will be rebuilt by blockify
 	this->distinctValuesInColumns.clear();    // Will be rebuilt by blockify
 
@@ -637,10 +1002,10 @@ bool Table::reload()
 	/* blockify() will re-read the sourceFileName and create new pages */
 	bool success = this->blockify();
     if (success) {
-        logger.log("Table::reload - Successfully reloaded and blockified.");
+        LOG_DEBUG("Table::reload - Successfully reloaded and blockified.");
         // WARNING: If an index exists, its pointers are now likely invalid!
         if (this->indexed) {
-             logger.log("Table::reload - WARNING: Table was reloaded, but an index exists. Index pointers are likely invalid and need rebuilding.");
+             LOG_WARNING("Table::reload - WARNING: Table was reloaded, but an index exists. Index pointers are likely invalid and need rebuilding.");
              // Optionally, automatically drop/invalidate the index here?
              // Or rely on the user/system to rebuild it?
              // Dropping seems safer if reload is used carelessly.
@@ -652,10 +1017,10 @@ bool Table::reload()
              // this->indexed = false;
              // this->indexedColumn = "";
              // this->indexingStrategy = NOTHING;
-             // logger.log("Table::reload - Index for column '" + this->indexedColumn + "' has been invalidated due to reload.");
+             // LOG_DEBUG("Table::reload - Index for column '" + this->indexedColumn + "' has been invalidated due to reload.");
         }
     } else {
-         logger.log("Table::reload - Failed to blockify during reload.");
+         LOG_ERROR("Table::reload - Failed to blockify during reload.");
     }
     return success;
 }
@@ -672,11 +1037,11 @@ bool Table::isIndexed(const string& columnName) const {
 }
 
 /**
- * @brief Retrieves the BTree index object for the specified column.
+ * @brief Retrieves the index object for the specified column.
  * @param columnName The name of the indexed column.
- * @return Pointer to the BTree object, or nullptr if no index exists for the column.
+ * @return Pointer to the index object, or nullptr if no index exists for the column.
  */
-BTree* Table::getIndex(const string& columnName) const {
+Index* Table::getIndex(const string& columnName) const {
     auto it = this->indexes.find(columnName);
     if (it != this->indexes.end()) {
         return it->second; // Return raw pointer from unique_ptr
@@ -686,59 +1051,59 @@ BTree* Table::getIndex(const string& columnName) const {
 
 /**
  * @brief Adds a new index to the table for a specific column.
- * Takes ownership of the provided BTree object via unique_ptr.
+ * Takes ownership of the provided index object.
  * @param columnName The name of the column being indexed.
- * @param index A unique_ptr to the newly created BTree object.
+ * @param index The newly created index object.
  * @return true if the index was added successfully, false if an index already exists for this column.
  */
-bool Table::addIndex(const string& columnName, BTree* index) {
+bool Table::addIndex(const string& columnName, Index* index) {
     if (this->isIndexed(columnName)) {
-        logger.log("Table::addIndex - Error: Index already exists for column '" + columnName + "' in table '" + this->tableName + "'.");
+        LOG_ERROR("Table::addIndex - Error: Index already exists for column '" + columnName + "' in table '" + this->tableName + "'.");
         return false; // Don't overwrite existing index
     }
     if (!index) {
-         logger.log("Table::addIndex - Error: Provided index pointer is null for column '" + columnName + "'.");
+         LOG_ERROR("Table::addIndex - Error: Provided index pointer is null for column '" + columnName + "'.");
          return false;
     }
-    logger.log("Table::addIndex - Adding index for column '" + columnName + "' to table '" + this->tableName + "'.");
+    LOG_DEBUG("Table::addIndex - Adding index for column '" + columnName + "' to table '" + this->tableName + "'.");
     this->indexes[columnName] = index; // Move ownership to the map
     return true;
 }
 
 /**
  * @brief Removes the index for the specified column.
- * Drops the index (deletes files) and deletes the BTree object from memory.
+ * Drops the index (deletes files) and deletes the index object from memory.
  * @param columnName The name of the column whose index should be removed.
  * @return true if the index was found and removed, false otherwise.
  */
 bool Table::removeIndex(const string& columnName) {
     auto it = this->indexes.find(columnName);
     if (it != this->indexes.end()) {
-        logger.log("Table::removeIndex - Removing index for column '" + columnName + "' from table '" + this->tableName + "'.");
-        BTree* indexPtr = it->second;
+        LOG_DEBUG("Table::removeIndex - Removing index for column '" + columnName + "' from table '" + this->tableName + "'.");
+        Index* indexPtr = it->second;
         if (indexPtr) {
             indexPtr->dropIndex(); // Delete associated files
-            delete indexPtr;       // Delete the BTree object itself
+            delete indexPtr;       // Delete the index object itself
         }
         this->indexes.erase(it); // Remove the pointer from the map
         return true;
     } else {
-        logger.log("Table::removeIndex - Warning: No index found for column '" + columnName + "' in table '" + this->tableName + "'.");
+        LOG_WARNING("Table::removeIndex - Warning: No index found for column '" + columnName + "' in table '" + this->tableName + "'.");
         return false;
     }
 }
 
 /**
  * @brief Removes all indexes associated with this table.
- * Drops all index files and deletes all BTree objects.
+ * Drops all index files and deletes all index objects.
  */
 void Table::removeAllIndexes() {
-    logger.log("Table::removeAllIndexes - Removing all indexes for table '" + this->tableName + "'.");
+    LOG_DEBUG("Table::removeAllIndexes - Removing all indexes for table '" + this->tableName + "'.");
     for (auto const& [colName, indexPtr] : this->indexes) {
         if (indexPtr) {
-            logger.log("Table::removeAllIndexes - Dropping and deleting index for column '" + colName + "'.");
+            LOG_DEBUG("Table::removeAllIndexes - Dropping and deleting index for column '" + colName + "'.");
             indexPtr->dropIndex(); // Delete associated files
-            delete indexPtr;       // Delete the BTree object
+            delete indexPtr;       // Delete the index object
         }
     }
     this->indexes.clear(); // Clear the map of pointers
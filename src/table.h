@@ -4,6 +4,8 @@
 #pragma once
 #include "cursor.h"
 #include "index.h" // <-- Include BTree header
+#include "hyperLogLog.h"
+#include "statistics.h"
 #include <string>   // <-- Include for string
 #include <vector>   // <-- Include for vector
 #include <unordered_set> // <-- Include for unordered_set
@@ -16,11 +18,31 @@
 // Forward declare BTree to avoid circular dependency if index.h includes table.h
 // class BTree;
 
-enum IndexingStrategy
+/**
+ * @brief Smallest and largest value of one column within one page (a zone
+ * map). A page whose range cannot satisfy a predicate is skipped by scans, see
+ * pageMayMatch. The defaults describe a page with no rows, which matches
+ * nothing.
+ */
+struct ZoneMap
+{
+	int minimum = INT_MAX;
+	int maximum = INT_MIN;
+	void include(int value)
+	{
+		this->minimum = min(this->minimum, value);
+		this->maximum = max(this->maximum, value);
+	}
+};
+
+/**
+ * @brief An index saved by EXPORT as LOAD found it: attached as saved, or
+ * built again from the table because the saved copy no longer matched it.
+ */
+struct LoadedIndex
 {
-	BTREE,
-	HASH, // HASH remains as a potential strategy type, even if not implemented
-	NOTHING
+	Index *index;
+	bool rebuilt;
 };
 
 /**
@@ -34,18 +56,22 @@ enum IndexingStrategy
  */
 class Table
 {
-	std::vector<std::unordered_set<int>> distinctValuesInColumns; // Make namespace explicit
+	std::vector<std::unordered_set<int>> distinctValuesInColumns; // Make namespace explicit; only kept with EXACT_DISTINCT
 
 public:
 	string sourceFileName = "";
 	string tableName = "";
 	vector<string> columns;
 	vector<uint> distinctValuesPerColumnCount;
+	vector<HyperLogLog> distinctValueSketches; // one per column, distinctValuesPerColumnCount is estimated from these unless EXACT_DISTINCT
+	vector<ColumnStatistics> columnStatistics;	// one per column once ANALYZE has run, empty before
 	uint columnCount = 0;
 	long long int rowCount = 0;
 	uint blockCount = 0;
 	uint maxRowsPerBlock = 0;
 	vector<uint> rowsPerBlockCount;
+	vector<vector<ZoneMap>> zoneMaps; // one per column for every page, kept alongside rowsPerBlockCount
+	PageLayout pageLayout = ROW_LAYOUT; // how blockify lays out pages, picked with LOAD ... USING PAX
 
 	// --- Indexing Information ---
 	bool indexed = false;             // Is the table indexed?
@@ -56,15 +82,29 @@ public:
     // int indexNodeCount = 0;        // Optional: Persist node count here if needed
 	// --- End Indexing Information ---
 
-	unordered_map<string, BTree*> indexes; // Maps column names to their indices
+	unordered_map<string, Index*> indexes; // Maps column names to their indices
 
 	bool extractColumnNames(string firstLine);
 	bool blockify();
 	void updateStatistics(vector<int> row);
+	void addDistinctValues(const vector<int> &row);
+	void refreshDistinctCounts();
+	int analyze();
+	string statisticsFileName();
+	bool writeStatistics();
+	bool readStatistics();
+	uint64_t pageChecksum();
+	void saveIndexes();
+	vector<LoadedIndex> loadIndexes();
+	void setZoneMap(uint pageIndex, const int *rows, int rowCount);
+	void widenZoneMap(uint pageIndex, const vector<int> &row);
 	Table();
 	Table(string tableName);
 	Table(string tableName, vector<string> columns);
 	~Table();
+	// The destructor frees the indexes, so a copy would take them with it
+	Table(const Table &) = delete;
+	Table &operator=(const Table &) = delete;
 	bool load();
 	bool isColumn(string columnName);
 	void renameColumn(string fromColumnName, string toColumnName);
@@ -79,8 +119,8 @@ public:
 
 	// --- Index Management Methods ---
     bool isIndexed(const string& columnName) const;
-    BTree* getIndex(const string& columnName) const;
-    bool addIndex(const string& columnName, BTree* index);
+    Index* getIndex(const string& columnName) const;
+    bool addIndex(const string& columnName, Index* index);
     bool removeIndex(const string& columnName);
     void removeAllIndexes(); // Helper to clear all indexes
     // --- End Index Management Methods ---
@@ -93,9 +133,9 @@ public:
 	 * @param row
 	 */
 	template <typename T>
-	void writeRow(vector<T> row, std::ostream &fout) // Use std::ostream
+	void writeRow(const vector<T> &row, std::ostream &fout) // Use std::ostream
 	{
-		// logger.log("Table::printRow"); // Logger might not be accessible in header easily
+		// LOG_DEBUG("Table::printRow"); // Logger might not be accessible in header easily
 		for (int columnCounter = 0; columnCounter < row.size(); columnCounter++)
 		{
 			if (columnCounter != 0)
@@ -113,9 +153,9 @@ public:
 	 * @param row
 	 */
 	template <typename T>
-	void writeRow(vector<T> row)
+	void writeRow(const vector<T> &row)
 	{
-		// logger.log("Table::printRow");
+		// LOG_DEBUG("Table::printRow");
 		std::ofstream fout(this->sourceFileName, ios::app); // Use std::ofstream
 		this->writeRow(row, fout);
 		fout.close();
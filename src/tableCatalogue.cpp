@@ -2,25 +2,25 @@
 
 void TableCatalogue::insertTable(Table *table)
 {
-	logger.log("TableCatalogue::~insertTable");
+	LOG_DEBUG("TableCatalogue::~insertTable");
 	this->tables[table->tableName] = table;
 }
 void TableCatalogue::deleteTable(string tableName)
 {
-	logger.log("TableCatalogue::deleteTable");
+	LOG_DEBUG("TableCatalogue::deleteTable");
 	this->tables[tableName]->unload();
 	delete this->tables[tableName];
 	this->tables.erase(tableName);
 }
 Table *TableCatalogue::getTable(string tableName)
 {
-	logger.log("TableCatalogue::getTable");
+	LOG_DEBUG("TableCatalogue::getTable");
 	Table *table = this->tables[tableName];
 	return table;
 }
 bool TableCatalogue::isTable(string tableName)
 {
-	logger.log("TableCatalogue::isTable");
+	LOG_DEBUG("TableCatalogue::isTable");
 	if (this->tables.count(tableName))
 		return true;
 	return false;
@@ -28,7 +28,7 @@ bool TableCatalogue::isTable(string tableName)
 
 bool TableCatalogue::isColumnFromTable(string columnName, string tableName)
 {
-	logger.log("TableCatalogue::isColumnFromTable");
+	LOG_DEBUG("TableCatalogue::isColumnFromTable");
 	if (this->isTable(tableName))
 	{
 		Table *table = this->getTable(tableName);
@@ -40,7 +40,7 @@ bool TableCatalogue::isColumnFromTable(string columnName, string tableName)
 
 void TableCatalogue::print()
 {
-	logger.log("TableCatalogue::print");
+	LOG_DEBUG("TableCatalogue::print");
 	cout << "\nRELATIONS" << endl;
 
 	int rowCount = 0;
@@ -54,7 +54,7 @@ void TableCatalogue::print()
 
 TableCatalogue::~TableCatalogue()
 {
-	logger.log("TableCatalogue::~TableCatalogue");
+	LOG_DEBUG("TableCatalogue::~TableCatalogue");
 	for (auto table : this->tables)
 	{
 		table.second->unload();